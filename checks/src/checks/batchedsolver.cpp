@@ -0,0 +1,136 @@
+//==============================================================
+// batchedsolver
+// Runs the same scene of stacked boxes with SOLVER_BATCHED on thread
+// pools of different sizes, and checks that every body ends up in
+// exactly the same place - the batches are meant to give the same
+// result however many threads they're spread over.
+//==============================================================
+#include "jiglib.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+using namespace JigLib;
+
+static tMaterialProperties material(0.0f, 0.8f, 0.7f);
+
+//==============================================================
+// tBoxObject
+//==============================================================
+struct tBoxObject
+{
+  tBody mBody;
+  tCollisionSkin mSkin;
+};
+
+//==============================================================
+// tStackScene
+// 64 towers of 6 boxes, dropped onto a plane slightly rotated so
+// that they jostle.
+//==============================================================
+struct tStackScene
+{
+  enum {numBoxes = 8 * 8 * 6};
+
+  tStackScene(tThreadPool * pool)
+  {
+    mPhysics.SetCollisionSystem(&mCollision);
+    mPhysics.SetSolverType(tPhysicsSystem::SOLVER_BATCHED);
+    mPhysics.SetThreadPool(pool);
+    mCollision.SetThreadPool(pool);
+
+    mGround.AddPrimitive(tPlane(tVector3::Up(), 0.0f), tMaterialTable::USER_DEFINED, material);
+    mCollision.AddCollisionSkin(&mGround);
+
+    tPrimitive::tPrimitiveProperties props(tPrimitive::tPrimitiveProperties::SOLID,
+                                           tPrimitive::tPrimitiveProperties::MASS, 1.0f);
+    // The broadphase orders each pair by skin address, so the boxes
+    // are allocated together to keep that order the same in every
+    // scene
+    mBoxes = new tBoxObject[numBoxes];
+    for (int iBox = 0 ; iBox < numBoxes ; ++iBox)
+    {
+      int i = iBox / 48, j = (iBox / 6) % 8, k = iBox % 6;
+      tBoxObject & box = mBoxes[iBox];
+      box.mSkin.AddPrimitive(tBox(tVector3(-0.5f), tMatrix33::Identity(), tVector3(1.0f)),
+                             tMaterialTable::USER_DEFINED, material);
+      box.mSkin.SetOwner(&box.mBody);
+      box.mBody.SetCollisionSkin(&box.mSkin);
+      tScalar mass;
+      tVector3 centreOfMass;
+      tMatrix33 inertia, inertiaCoM;
+      box.mSkin.GetMassProperties(props, mass, centreOfMass, inertia, inertiaCoM);
+      box.mBody.SetMass(mass);
+      box.mBody.SetBodyInertia(inertiaCoM);
+      box.mBody.MoveTo(tVector3(1.5f * i, 1.5f * j, 0.5f + 1.05f * k),
+                       RotationMatrix(3.0f * (i + j + k), tVector3::Up()));
+      box.mBody.EnableBody(mPhysics);
+    }
+  }
+
+  ~tStackScene()
+  {
+    delete [] mBoxes;
+  }
+
+  /// Runs the scene and returns the time taken in ms. The physics
+  /// shuffles the collisions with rand(), so every run starts from
+  /// the same seed.
+  double Run(int numSteps)
+  {
+    srand(1);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int i = 0 ; i < numSteps ; ++i)
+      mPhysics.Integrate(0.01f);
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  /// Returns true if every body has exactly the same position and
+  /// orientation as in the other scene
+  bool SameAs(const tStackScene & other) const
+  {
+    for (int i = 0 ; i < numBoxes ; ++i)
+    {
+      const tBody & body = mBoxes[i].mBody;
+      const tBody & otherBody = other.mBoxes[i].mBody;
+      if (memcmp(&body.GetPosition(), &otherBody.GetPosition(), sizeof(tVector3)) ||
+          memcmp(&body.GetOrientation(), &otherBody.GetOrientation(), sizeof(tMatrix33)))
+        return false;
+    }
+    return true;
+  }
+
+  tPhysicsSystem mPhysics;
+  tCollisionSystemSAP mCollision;
+  tCollisionSkin mGround;
+  tBoxObject * mBoxes;
+};
+
+//==============================================================
+// main
+//==============================================================
+int main(int argc, char * argv[])
+{
+  const int numSteps = 300;
+  int numDiffer = 0;
+
+  tStackScene serial(0);
+  double serialTime = serial.Run(numSteps);
+  printf("%d boxes, %d steps. No thread pool: %.0fms\n",
+         (int) tStackScene::numBoxes, numSteps, serialTime);
+
+  static const unsigned numThreads[] = {1, 2, 4, 8};
+  for (unsigned i = 0 ; i < sizeof(numThreads) / sizeof(numThreads[0]) ; ++i)
+  {
+    tThreadPool pool(numThreads[i]);
+    tStackScene scene(&pool);
+    double time = scene.Run(numSteps);
+    bool same = scene.SameAs(serial);
+    if (!same)
+      ++numDiffer;
+    printf("%d threads: %.0fms, %s\n", numThreads[i], time, same ? "identical" : "DIFFERENT");
+  }
+  return numDiffer == 0 ? 0 : 1;
+}
@@ -0,0 +1,229 @@
+//==============================================================
+// boxboxsat
+// Compares tCollDetectBoxBox against a plain 15 axis separating axis
+// test that projects both boxes onto each axis with tBox::GetSpan,
+// and times CollDetect over all pairs of a dense and a sparse set of
+// boxes.
+//==============================================================
+#include "jiglib.hpp"
+#include "colldetectboxbox.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+
+using namespace JigLib;
+
+static tMaterialProperties material(0.0f, 0.8f, 0.7f);
+static const tScalar collTolerance = 0.05f;
+
+//==============================================================
+// tDepthFunctor
+// Records the deepest point that CollDetect reports. The skins have
+// no owners, so that is the depth along the chosen axis.
+//==============================================================
+struct tDepthFunctor : public tCollisionFunctor
+{
+  tDepthFunctor() : mNumCollisions(0), mNumPoints(0), mDepth(-SCALAR_HUGE) {}
+
+  virtual void CollisionNotify(const tCollDetectInfo & info,
+                               const tVector3 & dirToBody0,
+                               const tCollPointInfo * pointInfos,
+                               unsigned numCollPts)
+  {
+    ++mNumCollisions;
+    mNumPoints += numCollPts;
+    for (unsigned i = 0 ; i < numCollPts ; ++i)
+      mDepth = Max(mDepth, pointInfos[i].mInitialPenetration);
+  }
+
+  int mNumCollisions;
+  int mNumPoints;
+  tScalar mDepth;
+};
+
+//==============================================================
+// ReferenceSAT
+// Returns false if the boxes are separated by more than the
+// tolerance along any of the 15 axes. Otherwise sets depth to the
+// smallest overlap, and margin to how close the most separating axis
+// came to the tolerance.
+//==============================================================
+static bool ReferenceSAT(tScalar & depth, tScalar & margin,
+                         const tBox & box0, const tBox & box1)
+{
+  const tMatrix33 & dirs0 = box0.GetOrient();
+  const tMatrix33 & dirs1 = box1.GetOrient();
+  tVector3 axes[15];
+  unsigned i, j;
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    axes[i] = dirs0[i];
+    axes[i + 3] = dirs1[i];
+    for (j = 0 ; j < 3 ; ++j)
+      axes[6 + 3 * i + j] = Cross(dirs0[i], dirs1[j]);
+  }
+
+  depth = SCALAR_HUGE;
+  margin = SCALAR_HUGE;
+  bool separated = false;
+  for (i = 0 ; i < 15 ; ++i)
+  {
+    tScalar l2 = axes[i].GetLengthSq();
+    if (l2 < SCALAR_TINY)
+      continue;
+    tScalar min0, max0, min1, max1;
+    box0.GetSpan(min0, max0, axes[i]);
+    box1.GetSpan(min1, max1, axes[i]);
+    tScalar overlap = Min(max0 - min1, max1 - min0);
+    margin = Min(margin, Abs(overlap + collTolerance + SCALAR_TINY));
+    if (overlap < -(collTolerance + SCALAR_TINY))
+      separated = true;
+    depth = Min(depth, overlap / Sqrt(l2));
+  }
+  return !separated;
+}
+
+//==============================================================
+// RandomRotation
+//==============================================================
+static tMatrix33 RandomRotation()
+{
+  return RotationMatrix(RangedRandom(0.0f, 360.0f),
+                        tVector3(RangedRandom(-1.0f, 1.0f), RangedRandom(-1.0f, 1.0f),
+                                 RangedRandom(-1.0f, 1.0f) + 0.01f).Normalise());
+}
+
+//==============================================================
+// SetBox
+//==============================================================
+static void SetBox(tCollisionSkin & skin, const tVector3 & sides,
+                   const tVector3 & pos, const tMatrix33 & orient)
+{
+  skin.RemoveAllPrimitives();
+  skin.AddPrimitive(tBox(-0.5f * sides, tMatrix33::Identity(), sides),
+                    tMaterialTable::USER_DEFINED, material);
+  tTransform3 transform(pos, orient);
+  skin.SetTransform(transform, transform);
+}
+
+//==============================================================
+// CompareRandomPairs
+// Returns the number of pairs where CollDetect and the reference
+// disagree. Every fourth pair shares an axis, and every eighth has
+// the same orientation, so that the degenerate edge axes get used.
+//==============================================================
+static int CompareRandomPairs(int numPairs)
+{
+  tCollDetectBoxBox detector;
+  tCollisionSkin skin0, skin1;
+  int numOverlapping = 0, numBorderline = 0, numDiffer = 0;
+  tScalar maxDepthDiff = 0.0f;
+
+  for (int iPair = 0 ; iPair < numPairs ; ++iPair)
+  {
+    tMatrix33 orient0 = RandomRotation();
+    tMatrix33 orient1 = RandomRotation();
+    if (iPair % 8 == 0)
+      orient1 = orient0;
+    else if (iPair % 4 == 0)
+      orient1 = orient0 * RotationMatrix(RangedRandom(0.0f, 360.0f), tVector3::Up());
+    SetBox(skin0, tVector3(RangedRandom(0.2f, 2.0f), RangedRandom(0.2f, 2.0f), RangedRandom(0.2f, 2.0f)),
+           tVector3::Zero(), orient0);
+    SetBox(skin1, tVector3(RangedRandom(0.2f, 2.0f), RangedRandom(0.2f, 2.0f), RangedRandom(0.2f, 2.0f)),
+           tVector3(RangedRandom(-2.0f, 2.0f), RangedRandom(-2.0f, 2.0f), RangedRandom(-2.0f, 2.0f)), orient1);
+
+    tScalar refDepth, margin;
+    bool refOverlap = ReferenceSAT(refDepth, margin, skin0.GetPrimitiveNewWorld(0)->GetBox(),
+                                   skin1.GetPrimitiveNewWorld(0)->GetBox());
+
+    tCollDetectInfo info;
+    info.skin0 = &skin0;
+    info.skin1 = &skin1;
+    info.iPrim0 = info.iPrim1 = 0;
+    tDepthFunctor functor;
+    detector.CollDetect(info, collTolerance, functor);
+
+    // pairs within rounding of the tolerance can go either way
+    if (margin < SCALAR(0.00001f))
+    {
+      ++numBorderline;
+      continue;
+    }
+    if (refOverlap != (functor.mNumCollisions > 0))
+    {
+      ++numDiffer;
+      continue;
+    }
+    if (refOverlap)
+    {
+      ++numOverlapping;
+      maxDepthDiff = Max(maxDepthDiff, Abs(functor.mDepth - refDepth));
+    }
+  }
+
+  if (maxDepthDiff > SCALAR(0.0001f))
+    ++numDiffer;
+  printf("%d random pairs: %d overlapping, %d differ, %d on the tolerance. Max depth difference %g\n",
+         numPairs, numOverlapping, numDiffer, numBorderline, (double) maxDepthDiff);
+  return numDiffer;
+}
+
+//==============================================================
+// TimeAllPairs
+// Runs CollDetect over every pair of numBoxes boxes scattered through
+// a cube of side spread. The skins are in a collision system, so the
+// separating axis hints get used as they are in a simulation.
+//==============================================================
+static void TimeAllPairs(const char * name, int numBoxes, tScalar spread)
+{
+  const int numPasses = 20;
+  std::vector<tCollisionSkin> skins(numBoxes);
+  tCollisionSystemBrute collSystem;
+  int i, j;
+  for (i = 0 ; i < numBoxes ; ++i)
+  {
+    SetBox(skins[i], tVector3(1.0f, RangedRandom(0.7f, 1.7f), RangedRandom(0.5f, 1.5f)),
+           tVector3(RangedRandom(0.0f, spread), RangedRandom(0.0f, spread), RangedRandom(0.0f, spread)),
+           RandomRotation());
+    collSystem.AddCollisionSkin(&skins[i]);
+  }
+
+  tCollDetectBoxBox detector;
+  tDepthFunctor functor;
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (int iPass = 0 ; iPass < numPasses ; ++iPass)
+  {
+    for (i = 0 ; i < numBoxes ; ++i)
+    {
+      for (j = i + 1 ; j < numBoxes ; ++j)
+      {
+        tCollDetectInfo info;
+        info.skin0 = &skins[i];
+        info.skin1 = &skins[j];
+        info.iPrim0 = info.iPrim1 = 0;
+        detector.CollDetect(info, collTolerance, functor);
+      }
+    }
+  }
+  double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+  double numPairs = numPasses * 0.5 * numBoxes * (numBoxes - 1);
+  printf("%s: %d boxes, %d collisions per pass, %.0f ns/pair\n", name, numBoxes,
+         functor.mNumCollisions / numPasses, ms * 1.0e6 / numPairs);
+
+  for (i = 0 ; i < numBoxes ; ++i)
+    collSystem.RemoveCollisionSkin(&skins[i]);
+}
+
+//==============================================================
+// main
+//==============================================================
+int main(int argc, char * argv[])
+{
+  srand(17);
+  int numDiffer = CompareRandomPairs(200000);
+  TimeAllPairs("Dense", 400, 3.0f);
+  TimeAllPairs("Sparse", 400, 12.0f);
+  return numDiffer == 0 ? 0 : 1;
+}
@@ -0,0 +1,148 @@
+//==============================================================
+// gridsegments
+// Compares tCollisionSystemGrid::SegmentIntersect against
+// tCollisionSystemBrute, and times both. The second scene is a small
+// grid that the skins wrap around many times, with segments that
+// cross it many times over.
+//==============================================================
+#include "jiglib.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <vector>
+
+using namespace JigLib;
+
+static tMaterialProperties material(0.0f, 0.8f, 0.7f);
+
+//==============================================================
+// tScene
+//==============================================================
+struct tScene
+{
+  tScene(unsigned gridSize, tScalar cellSize) 
+    : mGrid(gridSize, gridSize, gridSize, cellSize, cellSize, cellSize) {}
+  // A skin only remembers the last system it was added to, so take it
+  // out of both before deleting it
+  ~tScene()
+  {
+    for (unsigned i = 0 ; i < mSkins.size() ; ++i)
+    {
+      mGrid.RemoveCollisionSkin(mSkins[i]);
+      mBrute.RemoveCollisionSkin(mSkins[i]);
+      delete mSkins[i];
+    }
+  }
+
+  void AddSkin(const tPrimitive & prim, const tVector3 & pos)
+  {
+    tCollisionSkin * skin = new tCollisionSkin;
+    skin->AddPrimitive(prim, tMaterialTable::USER_DEFINED, material);
+    tTransform3 transform(pos, RotationMatrix(RangedRandom(0.0f, 360.0f), 
+                                              tVector3(RangedRandom(-1.0f, 1.0f), 1.0f, 0.5f).Normalise()));
+    skin->SetTransform(transform, transform);
+    mGrid.AddCollisionSkin(skin);
+    mBrute.AddCollisionSkin(skin);
+    mSkins.push_back(skin);
+  }
+
+  tCollisionSystemGrid mGrid;
+  tCollisionSystemBrute mBrute;
+  std::vector<tCollisionSkin *> mSkins;
+};
+
+//==============================================================
+// CompareSegments
+// Returns the number of segments where the grid and brute force
+// disagree
+//==============================================================
+static int CompareSegments(const char * name, tScene & scene, const std::vector<tSegment> & segs)
+{
+  std::vector<tCollisionSkin *> gridSkins(segs.size()), bruteSkins(segs.size());
+  std::vector<tScalar> gridFracs(segs.size()), bruteFracs(segs.size());
+  tVector3 pos, normal;
+
+  std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+  for (unsigned i = 0 ; i < segs.size() ; ++i)
+  {
+    if (!scene.mGrid.SegmentIntersect(gridFracs[i], gridSkins[i], pos, normal, segs[i], 0))
+      gridSkins[i] = 0;
+  }
+  std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+  for (unsigned i = 0 ; i < segs.size() ; ++i)
+  {
+    if (!scene.mBrute.SegmentIntersect(bruteFracs[i], bruteSkins[i], pos, normal, segs[i], 0))
+      bruteSkins[i] = 0;
+  }
+  std::chrono::steady_clock::time_point t2 = std::chrono::steady_clock::now();
+
+  int numHits = 0, numDiffer = 0;
+  for (unsigned i = 0 ; i < segs.size() ; ++i)
+  {
+    if (bruteSkins[i])
+      ++numHits;
+    if (gridSkins[i] != bruteSkins[i] || 
+        (gridSkins[i] && Abs(gridFracs[i] - bruteFracs[i]) > SCALAR(0.0001f)))
+      ++numDiffer;
+  }
+  printf("%s: %d skins, %d segments, %d hits, %d differ. Grid %.1fms, brute force %.1fms\n",
+         name, (int) scene.mSkins.size(), (int) segs.size(), numHits, numDiffer,
+         std::chrono::duration<double, std::milli>(t1 - t0).count(),
+         std::chrono::duration<double, std::milli>(t2 - t1).count());
+  return numDiffer;
+}
+
+//==============================================================
+// main
+//==============================================================
+int main(int argc, char * argv[])
+{
+  srand(11);
+  int numDiffer = 0;
+  unsigned i;
+
+  // Lots of small skins spread through a grid that covers them
+  {
+    tScene scene(32, 2.0f);
+    for (i = 0 ; i < 3000 ; ++i)
+    {
+      tVector3 pos(RangedRandom(0.0f, 64.0f), RangedRandom(0.0f, 64.0f), RangedRandom(0.0f, 64.0f));
+      if (i % 2)
+        scene.AddSkin(tSphere(tVector3::Zero(), RangedRandom(0.2f, 0.8f)), pos);
+      else
+        scene.AddSkin(tBox(tVector3(-0.5f), tMatrix33::Identity(), tVector3(RangedRandom(0.3f, 1.0f))), pos);
+    }
+    std::vector<tSegment> segs;
+    for (i = 0 ; i < 20000 ; ++i)
+    {
+      tVector3 origin(RangedRandom(-5.0f, 69.0f), RangedRandom(-5.0f, 69.0f), RangedRandom(-5.0f, 69.0f));
+      tVector3 delta(RangedRandom(-40.0f, 40.0f), RangedRandom(-40.0f, 40.0f), RangedRandom(-40.0f, 40.0f));
+      segs.push_back(tSegment(origin, delta));
+    }
+    numDiffer += CompareSegments("Covering grid", scene, segs);
+  }
+
+  // A 4x4x4 grid that the skins wrap around, with half the segments
+  // spanning many grid widths
+  {
+    tScene scene(4, 2.0f);
+    for (i = 0 ; i < 50 ; ++i)
+    {
+      tVector3 pos(RangedRandom(0.0f, 37.0f), RangedRandom(0.0f, 37.0f), RangedRandom(0.0f, 37.0f));
+      scene.AddSkin(tSphere(tVector3::Zero(), 0.5f), pos);
+    }
+    std::vector<tSegment> segs;
+    for (i = 0 ; i < 2000 ; ++i)
+    {
+      tVector3 origin(RangedRandom(-5.0f, 12.0f), RangedRandom(-5.0f, 12.0f), RangedRandom(-5.0f, 12.0f));
+      tVector3 delta(RangedRandom(150.0f, 300.0f), RangedRandom(-400.0f, 400.0f), RangedRandom(150.0f, 300.0f));
+      if (i % 2)
+        delta *= 0.01f;
+      segs.push_back(tSegment(origin, delta));
+    }
+    numDiffer += CompareSegments("Wrapped grid", scene, segs);
+  }
+
+  return numDiffer == 0 ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+//==============================================================
+// heightmaprays
+// Compares tHeightmap::SegmentIntersect against dense sampling of
+// GetHeightAndNormal along each segment - including segments that
+// are partly or wholly outside the map, where the surface carries
+// on from the edge triangles.
+//==============================================================
+#include "jiglib.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+using namespace JigLib;
+
+static const int mapSize = 17;
+static const int numRays = 20000;
+static const int numSamples = 4000;
+
+//==============================================================
+// OnGridLine
+// The sampling can step straight over a step in the surface that's
+// exactly on a grid line, so disagreements there are counted
+// separately
+//==============================================================
+static bool OnGridLine(const tVector3 & pos)
+{
+  return Abs(pos.x - floorf(pos.x + 0.5f)) < 0.001f ||
+    Abs(pos.y - floorf(pos.y + 0.5f)) < 0.001f;
+}
+
+//==============================================================
+// SampleSegment
+// Returns the fraction where the segment first goes from above the
+// surface to below it, or -1
+//==============================================================
+static tScalar SampleSegment(const tHeightmap & heightmap, const tSegment & seg)
+{
+  tScalar prevHeight, height;
+  tVector3 normal;
+  heightmap.GetHeightAndNormal(prevHeight, normal, seg.GetPoint(0.0f));
+  for (int i = 1 ; i <= numSamples ; ++i)
+  {
+    heightmap.GetHeightAndNormal(height, normal, seg.GetPoint(i / (tScalar) numSamples));
+    if (prevHeight >= 0.0f && height < 0.0f)
+      return (i - 1 + prevHeight / (prevHeight - height)) / numSamples;
+    prevHeight = height;
+  }
+  return -1.0f;
+}
+
+//==============================================================
+// main
+//==============================================================
+int main(int argc, char * argv[])
+{
+  srand(3);
+  tArray2D<tScalar> heights(mapSize, mapSize);
+  for (int i = 0 ; i < mapSize ; ++i)
+    for (int j = 0 ; j < mapSize ; ++j)
+      heights(i, j) = 1.5f * sinf(0.7f * i) * cosf(0.5f * j) + RangedRandom(0.0f, 0.3f);
+  tHeightmap heightmap(heights, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  int numAgree = 0, numOnGridLine = 0, numHits = 0, numOutsideHits = 0;
+  for (int iRay = 0 ; iRay < numRays ; ++iRay)
+  {
+    tVector3 origin(RangedRandom(-30.0f, 30.0f), RangedRandom(-30.0f, 30.0f), RangedRandom(-3.0f, 7.0f));
+    tVector3 delta(RangedRandom(-20.0f, 20.0f), RangedRandom(-20.0f, 20.0f), RangedRandom(-10.0f, -2.0f));
+    if (iRay % 3 == 0)
+      delta = tVector3(0.0f, 0.0f, -10.0f);
+    tSegment seg(origin, delta);
+
+    tScalar frac;
+    tVector3 pos, normal;
+    bool hit = heightmap.SegmentIntersect(frac, pos, normal, seg);
+    tScalar refFrac = SampleSegment(heightmap, seg);
+
+    if (hit)
+    {
+      ++numHits;
+      if (pos.x < 0.0f || pos.x > mapSize - 1 || pos.y < 0.0f || pos.y > mapSize - 1)
+        ++numOutsideHits;
+    }
+    if (hit == (refFrac >= 0.0f) && (!hit || Abs(frac - refFrac) < 0.002f))
+    {
+      ++numAgree;
+    }
+    else if (hit && OnGridLine(pos))
+    {
+      ++numOnGridLine;
+    }
+    else
+    {
+      printf("Ray %d: hit %d frac %f, sampling gives %f\n", iRay, hit, hit ? frac : -1.0f, refFrac);
+    }
+  }
+  printf("%d rays over a %dx%d map: %d agree, %d differ on a grid line (%d hits, %d outside the map)\n",
+         numRays, mapSize, mapSize, numAgree, numOnGridLine, numHits, numOutsideHits);
+  return numAgree + numOnGridLine == numRays ? 0 : 1;
+}
@@ -10,6 +10,7 @@
 #define JIGCOLLDETECTBOXBOX_HPP
 
 #include "../collision/include/collisionsystem.hpp"
+
 namespace JigLib
 {
   class tCollDetectBoxBox : public tCollDetectFunctor
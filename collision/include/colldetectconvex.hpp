@@ -0,0 +1,51 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvex.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLDETECTCONVEX_HPP
+#define JIGCOLLDETECTCONVEX_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+#include "../geometry/include/gjk.hpp"
+
+namespace JigLib
+{
+  /// Detects collisions between any two convex primitives that
+  /// tSupportShape handles. GJK/EPA gives the normal and depth, and
+  /// then the features of each shape that face the other are clipped
+  /// against each other to get the contact points. Register one of
+  /// these for each pair of types that doesn't have its own functor.
+  class tCollDetectConvex : public tCollDetectFunctor
+  {
+  public:
+    tCollDetectConvex(const std::string & name, unsigned primType0, unsigned primType1);
+
+    void CollDetect(const tCollDetectInfo &info,
+                    tScalar collTolerance,
+                    tCollisionFunctor & collisionFunctor) const;
+  };
+
+  enum {MAX_CONVEX_CONTACT_POINTS = 4};
+
+  /// Gets the contact between two shapes if they're closer than
+  /// collTolerance. N points towards shape0, and each point gets a
+  /// world position and depth (+ve for penetration). Returns the
+  /// number of points (at most MAX_CONVEX_CONTACT_POINTS).
+  unsigned GetConvexContactPoints(tVector3 & N,
+                                  tVector3 * pts,
+                                  tScalar * depths,
+                                  const tSupportShape & shape0,
+                                  const tSupportShape & shape1,
+                                  tScalar collTolerance);
+
+  /// Picks up to maxPts (no more than 4) of the points, keeping the
+  /// deepest and then the ones that cover the biggest area. The kept
+  /// points are moved to the start, and the number kept is returned.
+  unsigned ReduceContactPoints(tVector3 * pts, tScalar * depths, unsigned numPts, unsigned maxPts);
+}
+
+#endif
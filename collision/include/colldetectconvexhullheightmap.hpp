@@ -0,0 +1,26 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullheightmap.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLDETECTCONVEXHULLHEIGHTMAP_HPP
+#define JIGCOLLDETECTCONVEXHULLHEIGHTMAP_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+namespace JigLib
+{
+  class tCollDetectConvexHullHeightmap : public tCollDetectFunctor
+  {
+  public:
+    tCollDetectConvexHullHeightmap();
+    
+    void CollDetect(const tCollDetectInfo &info,
+                    tScalar collTolerance,
+                    tCollisionFunctor & collisionFunctor) const;
+  };
+}
+
+#endif
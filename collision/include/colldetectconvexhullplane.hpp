@@ -0,0 +1,26 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullplane.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLDETECTCONVEXHULLPLANE_HPP
+#define JIGCOLLDETECTCONVEXHULLPLANE_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+namespace JigLib
+{
+  class tCollDetectConvexHullPlane : public tCollDetectFunctor
+  {
+  public:
+    tCollDetectConvexHullPlane();
+    
+    void CollDetect(const tCollDetectInfo &info,
+                    tScalar collTolerance,
+                    tCollisionFunctor & collisionFunctor) const;
+  };
+}
+
+#endif
@@ -0,0 +1,26 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullstaticmesh.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLDETECTCONVEXHULLSTATICMESH_HPP
+#define JIGCOLLDETECTCONVEXHULLSTATICMESH_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+namespace JigLib
+{
+  class tCollDetectConvexHullStaticMesh : public tCollDetectFunctor
+  {
+  public:
+    tCollDetectConvexHullStaticMesh();
+    
+    void CollDetect(const tCollDetectInfo &info,
+                    tScalar collTolerance,
+                    tCollisionFunctor & collisionFunctor) const;
+  };
+}
+
+#endif
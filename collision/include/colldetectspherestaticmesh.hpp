@@ -24,7 +24,8 @@ namespace JigLib
     /// Helper function that will be useful for other classes - collides
     /// a sphere against a static mesh and registers collisions based on the 
     /// skins (skin1 is the mesh, skin0 could be any type if you're using
-    /// spheres to approximate it).
+    /// spheres to approximate it). The spheres are in mesh space, and
+    /// the collisions get reported in world space.
     static void CollDetectSphereStaticMeshSweep(const class tSphere& sphereOld,
                                                 const class tSphere& sphereNew,
                                                 const class tTriangleMesh& mesh,
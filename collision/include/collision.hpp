@@ -23,11 +23,17 @@
 #include "../collision/include/colldetectspherestaticmesh.hpp"
 #include "../collision/include/colldetectcapsulestaticmesh.hpp"
 #include "../collision/include/colldetectboxstaticmesh.hpp"
+#include "../collision/include/colldetectconvex.hpp"
+#include "../collision/include/colldetectconvexhullheightmap.hpp"
+#include "../collision/include/colldetectconvexhullplane.hpp"
+#include "../collision/include/colldetectconvexhullstaticmesh.hpp"
 
 #include "../collision/include/collisioninfo.hpp"
 #include "../collision/include/collisionsystem.hpp"
 #include "../collision/include/collisionsystembrute.hpp"
 #include "../collision/include/collisionsystemgrid.hpp"
+#include "../collision/include/collisionsystemdynamictree.hpp"
+#include "../collision/include/collisionsystemsap.hpp"
 
 #endif
 
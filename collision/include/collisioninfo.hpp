@@ -13,6 +13,7 @@
 #include "../collision/include/collisionskin.hpp"
 #include "../collision/include/materials.hpp"
 #include "../utils/include/fixedvector.hpp"
+#include "../utils/include/framearena.hpp"
 
 #include <vector>
 #include <set>
@@ -79,18 +80,18 @@ namespace JigLib
   public:
     enum {MAX_COLLISION_POINTS = 10};
     
-    /// tCollisionInfos will be given out from a pool.  If more than
+    /// tCollisionInfos are allocated (along with their points) from
+    /// the arena, so they're only valid until it gets reset - normally
+    /// at the start of the next collision detection. If more than
     /// MAX_COLLISION_POINTS are passed in, the input positions will
     /// be silently truncated!
-    static tCollisionInfo & GetCollisionInfo(
+    static tCollisionInfo & Create(
+      tFrameArena & arena,
       const tCollDetectInfo &info, 
       const tVector3 & dirToBody0,
       const tCollPointInfo * pointInfos, ///< array of point infos
       unsigned numPointInfos     ///< size of point info array
       );
-
-    /// Return this info to the pool
-    static void FreeCollisionInfo(tCollisionInfo & info);
     
     /// gets set to true after we've been processed, and to false when the body
     /// we're asociated with has been affected by another constraint/collision
@@ -108,18 +109,20 @@ namespace JigLib
     /// subsequently
     tMaterialPairProperties mMatPairProperties;
     
-    tFixedVector<tCollPointInfo, MAX_COLLISION_POINTS> mPointInfo;
+    /// The points, which live in the arena just after this. The
+    /// number can be reduced (e.g. to keep the deepest) but not
+    /// increased.
+    tCollPointInfo * mPointInfo;
+    unsigned mNumPointInfos;
     
   private:
     tCollisionInfo() {}
     void Init(const tCollDetectInfo &info, 
               const tVector3 & dirToBody0,
+              tCollPointInfo * pointStorage,
               const tCollPointInfo * pointInfos, ///< array of point infos
               unsigned numPointInfos     ///< size of point info array
       );
-    void Destroy();
-    
-    static std::vector<tCollisionInfo *> mFreeInfos;
   };
 }
 
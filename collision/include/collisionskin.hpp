@@ -124,6 +124,24 @@ namespace JigLib
                           tVector3 & normal, 
                           const class tSegment & seg) const;
 
+    /// Sweeps shape (a sphere, capsule or box) by delta against the
+    /// new value of the primitives, returning the earliest hit -
+    /// see SweptPrimitiveIntersection.
+    bool ShapeCast(tScalar & frac,
+                   tVector3 & pos,
+                   tVector3 & normal,
+                   const tPrimitive & shape,
+                   const tVector3 & delta) const;
+
+    /// As SegmentIntersect for each of the segments, but letting the
+    /// primitives handle them together. fracs gets SCALAR_HUGE where
+    /// there's no hit. Returns the number of hits.
+    unsigned SegmentIntersectBatch(tScalar * fracs,
+                                   tVector3 * positions,
+                                   tVector3 * normals,
+                                   const class tSegment * segs,
+                                   unsigned numSegs) const;
+
     /// Intended for internal JigLib use - but not touched by the
     /// collision system
     tCollisionSkinExternalData &GetExternalData() {return mExternalData;}
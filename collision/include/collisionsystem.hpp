@@ -14,6 +14,7 @@
 
 #include <vector>
 #include <string>
+#include <atomic>
 
 /// Currently this class introduces a circular dependency between
 /// tPhysicsSystem and tCollisionSystem - i.e. both use the other (via
@@ -59,6 +60,17 @@ namespace JigLib
     virtual bool ConsiderSkin(class tCollisionSkin * skin0) const = 0;
   };
 
+  /// One of the results of tCollisionSystem::QueryOverlap - the skin,
+  /// and the index of the primitive in the skin that overlaps.
+  struct tOverlapResult
+  {
+    tOverlapResult() {}
+    tOverlapResult(class tCollisionSkin * skin, unsigned iPrimitive)
+      : mSkin(skin), mPrimitive(iPrimitive) {}
+    class tCollisionSkin * mSkin;
+    unsigned mPrimitive;
+  };
+
   /// Used during setup - allow the creator to register functors to do
   /// the actual collision detection. Each functor inherits from this
   /// - has a name to help debugging!  The functor has to be able to
@@ -79,6 +91,40 @@ namespace JigLib
     unsigned mType0, mType1;
   };
 
+  /// Remembers which axis last separated each pair of primitives, for
+  /// the detection functors that do separating axis tests. Each entry
+  /// holds the top bits of a hash of the pair and the axis in the
+  /// bottom 4 bits. The narrowphase threads of one collision system
+  /// can overwrite each other's entries, but a wrong hint just costs
+  /// one extra axis test.
+  class tSeparatingAxisCache
+  {
+  public:
+    enum {SIZE = 1024, NO_AXIS = 0xf};
+
+    tSeparatingAxisCache()
+    {
+      for (unsigned i = 0 ; i < SIZE ; ++i)
+        mEntries[i].store(NO_AXIS, std::memory_order_relaxed);
+    }
+
+    /// The axis last stored for the pair with this hash, or NO_AXIS
+    unsigned GetAxis(unsigned pairHash) const
+    {
+      const unsigned entry = mEntries[pairHash % SIZE].load(std::memory_order_relaxed);
+      return (entry >> 4) == (pairHash >> 4) ? (entry & 0xf) : (unsigned) NO_AXIS;
+    }
+
+    /// axis must be less than NO_AXIS
+    void SetAxis(unsigned pairHash, unsigned axis)
+    {
+      mEntries[pairHash % SIZE].store((pairHash & ~0xfu) | axis, std::memory_order_relaxed);
+    }
+
+  private:
+    std::atomic<unsigned> mEntries[SIZE];
+  };
+
   /// Interface to a class that will contain a list of all the
   /// collision objects in the world, and it will provide ways of
   /// detecting collisions between other objects and these collision
@@ -138,7 +184,13 @@ namespace JigLib
                                                      unsigned type1);
 
     /// Intersect a segment with the world. If non-zero the predicate
-    /// allows certain skins to be excluded
+    /// allows certain skins to be excluded.
+    ///
+    /// This and the other queries below (SegmentIntersectBatch,
+    /// ShapeCast, QueryOverlap and GetSkinsOverlappingAABox) keep
+    /// their working lists in the calling thread's tCollisionScratch,
+    /// so they can be made from any number of threads at once - just
+    /// not whilst skins are being added, removed or moved.
     virtual bool SegmentIntersect(
 				  tScalar & frac, 
 				  tCollisionSkin *& skin, 
@@ -147,6 +199,60 @@ namespace JigLib
 				  const class tSegment & seg, 
 				  const tCollisionSkinPredicate1 * collisionPredicate) = 0;
 
+    /// Intersects each of the segments with the world, with the same
+    /// results as calling SegmentIntersect for each one.
+    /// collisionPredicates can be 0, or else has a predicate (which
+    /// can be 0) for each segment. fracs is SCALAR_HUGE and skins is 0
+    /// for the segments that don't hit anything. The default just
+    /// calls SegmentIntersect, but collision systems can do better by
+    /// tracing groups of segments together. Returns the number of
+    /// segments that hit something.
+    virtual unsigned SegmentIntersectBatch(
+      tScalar * fracs,
+      tCollisionSkin ** skins,
+      tVector3 * positions,
+      tVector3 * normals,
+      const class tSegment * segs,
+      unsigned numSegs,
+      const tCollisionSkinPredicate1 * const * collisionPredicates);
+
+    /// Sweeps shape (a sphere, capsule or box) by delta through the
+    /// world and returns the earliest hit - the fraction of delta,
+    /// the skin, the contact point and the normal. If non-zero the
+    /// predicate allows certain skins to be excluded. See
+    /// SweptPrimitiveIntersection for the details.
+    bool ShapeCast(
+      tScalar & frac,
+      tCollisionSkin *& skin,
+      tVector3 & pos,
+      tVector3 & normal,
+      const tPrimitive & shape,
+      const tVector3 & delta,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    /// Fills results with all the skin primitives (new values) that
+    /// overlap box, and returns how many there are. If non-zero the
+    /// predicate allows certain skins to be excluded. Nothing about
+    /// the skins or their collisions gets changed, so this is the
+    /// thing to use for triggers etc rather than DetectCollisions.
+    unsigned QueryOverlap(
+      std::vector<tOverlapResult> & results,
+      const tAABox & box,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    /// As the other QueryOverlap but for a sphere
+    unsigned QueryOverlap(
+      std::vector<tOverlapResult> & results,
+      const class tSphere & sphere,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    /// Fills skins with all the skins whose bounding boxes overlap
+    /// box. The collision system may use slightly bigger boxes than
+    /// the skins' own.
+    virtual void GetSkinsOverlappingAABox(
+      std::vector<class tCollisionSkin *> & skins,
+      const tAABox & box) = 0;
+
     /// Sets whether collision tests should use sweep or overlap
     void SetUseSweepTests(bool use) {mUseSweepTests = use;}
 
@@ -155,11 +261,72 @@ namespace JigLib
     const tMaterialTable &GetMaterialTable() const {return mMaterialTable;}
     tMaterialTable &GetMaterialTable() {return mMaterialTable;}
 
+    /// If the pool has more than one thread then DetectAllCollisions
+    /// first gathers all the pairs of primitives that need testing,
+    /// and then tests them over the pool. The collision functor still
+    /// only gets called from this thread, and in the same order as
+    /// without a pool. The pool isn't owned by the collision
+    /// system. Zero (the default) means detect everything in this
+    /// thread.
+    void SetThreadPool(class tThreadPool * pool) {mThreadPool = pool;}
+    class tThreadPool * GetThreadPool() const {return mThreadPool;}
+
+    /// Hints for the detection functors - kept here rather than in
+    /// the (shared) functors so that different collision systems
+    /// don't overwrite each other's.
+    tSeparatingAxisCache & GetSeparatingAxisCache() {return mSeparatingAxisCache;}
+
+  protected:
+    /// Starts gathering primitive pairs in DetectSkinPair, if there's
+    /// a thread pool worth using.
+    void BeginNarrowPhase();
+
+    /// Runs the detection functors for all the primitive pairs of
+    /// info.skin0 and info.skin1 - unless we're between
+    /// BeginNarrowPhase and EndNarrowPhase, in which case they just
+    /// get stored.
+    void DetectSkinPair(tCollDetectInfo & info,
+                        tCollisionFunctor & collisionFunctor,
+                        tScalar collTolerance);
+
+    /// Tests all the gathered primitive pairs and passes the results
+    /// on to collisionFunctor.
+    void EndNarrowPhase(tCollisionFunctor & collisionFunctor,
+                        tScalar collTolerance);
+
   private:
+    /// Does the work for QueryOverlap - shapeBox bounds shape
+    unsigned QueryShapeOverlap(
+      std::vector<tOverlapResult> & results,
+      const tPrimitive & shape,
+      const tAABox & shapeBox,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    class tContactBuffer;
+    class tNarrowPhaseJob;
+
+    /// A pair waiting to be tested, and where its results ended up
+    struct tPrimitivePair
+    {
+      tCollDetectInfo mInfo;
+      const tCollDetectFunctor * mFunctor;
+      unsigned mThread;
+      unsigned mFirstContact;
+      unsigned mNumContacts;
+    };
+
     std::vector< std::vector<tCollDetectFunctor *> > mDetectionFunctors;
 
     bool mUseSweepTests;
     tMaterialTable mMaterialTable;
+
+    class tThreadPool * mThreadPool;
+    bool mGatheringPairs;
+    std::vector<tPrimitivePair> mPrimitivePairs;
+    /// one per thread, kept between frames
+    std::vector<tContactBuffer *> mContactBuffers;
+
+    tSeparatingAxisCache mSeparatingAxisCache;
   };
 
 
@@ -12,6 +12,7 @@
 #include "../collision/include/collisionsystem.hpp"
 
 #include <vector>
+#include <atomic>
 
 /// Implements a "brute-force" collision system with no culling other
 /// than bounding volume checks.
@@ -51,12 +52,17 @@ namespace JigLib
       tVector3 & normal, 
       const class tSegment & seg, 
       const tCollisionSkinPredicate1 * collisionPredicate);
+
+    // inherited
+    void GetSkinsOverlappingAABox(
+      std::vector<class tCollisionSkin *> & skins,
+      const tAABox & box);
     
   private:
     typedef std::vector<tCollisionSkin *> tSkins;
     tSkins mSkins;
     
-    bool mDetecting;
+    std::atomic<unsigned> mDetecting;
   };
 }
 
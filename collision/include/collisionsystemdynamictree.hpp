@@ -0,0 +1,134 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionsystemdynamictree.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLISIONSYSTEMDYNAMICTREE_HPP
+#define JIGCOLLISIONSYSTEMDYNAMICTREE_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+
+#include <vector>
+#include <atomic>
+
+namespace JigLib
+{
+  /// Implements a collision system by keeping the skins in a bounding
+  /// volume hierarchy that gets updated incrementally as they
+  /// move. Each skin is stored with a "fat" bounding box, so the tree
+  /// only needs changing when a skin moves outside that. Unlike the
+  /// grid, there's nothing to configure and it copes with objects of
+  /// very different sizes.
+  ///
+  /// Note that the node index of each skin is stored in its external
+  /// data mInt.
+  class tCollisionSystemDynamicTree : public tCollisionSystem
+  {
+  public:
+    /// fatMargin is how much the skin bounding boxes get expanded by
+    /// when they're stored in the tree.
+    tCollisionSystemDynamicTree(tScalar fatMargin = 0.1f);
+    ~tCollisionSystemDynamicTree();
+
+    // inherited
+    void AddCollisionSkin(class tCollisionSkin * skin);
+
+    // inherited
+    bool RemoveCollisionSkin(class tCollisionSkin * skin);
+
+    // inherited
+    void CollisionSkinMoved(const class tCollisionSkin * skin);
+
+    // inherited
+    void DetectCollisions(
+      class tBody & body,
+      tCollisionFunctor & collisionFunctor,
+      const tCollisionSkinPredicate2 * collisionPredicate,
+      tScalar collTolerance);
+
+    // inherited
+    void DetectAllCollisions(
+      const std::vector<class tBody *> & bodies,
+      tCollisionFunctor & collisionFunctor,
+      const tCollisionSkinPredicate2 * collisionPredicate,
+      tScalar collTolerance);
+
+    bool SegmentIntersect(
+      tScalar & frac,
+      tCollisionSkin *& skin,
+      tVector3 & pos,
+      tVector3 & normal,
+      const class tSegment & seg,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    // inherited
+    void GetSkinsOverlappingAABox(
+      std::vector<class tCollisionSkin *> & skins,
+      const tAABox & box);
+
+    // inherited - traces packets of segments through the tree
+    unsigned SegmentIntersectBatch(
+      tScalar * fracs,
+      tCollisionSkin ** skins,
+      tVector3 * positions,
+      tVector3 * normals,
+      const class tSegment * segs,
+      unsigned numSegs,
+      const tCollisionSkinPredicate1 * const * collisionPredicates);
+
+    /// returns the height of the tree (0 if it's empty or just has one
+    /// skin) - useful for checking the balance
+    int GetHeight() const {return mRoot < 0 ? 0 : mNodes[mRoot].mHeight;}
+
+  private:
+    /// Nodes are stored in an array and refer to each other by
+    /// index. Leaves have a skin and no children.
+    struct tNode
+    {
+      bool IsLeaf() const {return mChild0 < 0;}
+      tVector3 mMin;
+      tVector3 mMax;
+      tCollisionSkin * mSkin;
+      /// the parent node, or the next free node when this one is free
+      int mParent;
+      int mChild0;
+      int mChild1;
+      /// 0 for leaves, -1 for free nodes
+      int mHeight;
+    };
+
+    int AllocateNode();
+    void FreeNode(int iNode);
+
+    /// inserts the leaf into the tree, putting it next to the node
+    /// that results in the least extra surface area
+    void InsertLeaf(int iLeaf);
+    void RemoveLeaf(int iLeaf);
+
+    /// does a rotation if the node is unbalanced, and returns the index
+    /// of the node that ends up in its place
+    int Balance(int iNode);
+
+    /// Recalculates the boxes and heights going up from iNode
+    void RefitAncestors(int iNode);
+
+    /// Adds all the skins whose (fat) boxes overlap the box to skins
+    void QueryAABox(std::vector<tCollisionSkin *> & skins,
+                    const tVector3 & minPos, const tVector3 & maxPos) const;
+
+    std::vector<tNode> mNodes;
+    int mRoot;
+    int mFreeNode;
+    tScalar mFatMargin;
+
+    typedef std::vector<tCollisionSkin *> tSkins;
+    tSkins mSkins;
+
+    std::atomic<unsigned> mDetecting;
+  };
+}
+
+#endif
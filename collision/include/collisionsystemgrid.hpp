@@ -12,6 +12,7 @@
 #include "../collision/include/collisionsystem.hpp"
 
 #include <vector>
+#include <atomic>
 
 namespace JigLib
 {
@@ -55,6 +56,11 @@ namespace JigLib
       tVector3 & normal, 
       const class tSegment & seg, 
       const tCollisionSkinPredicate1 * collisionPredicate);
+
+    // inherited
+    void GetSkinsOverlappingAABox(
+      std::vector<class tCollisionSkin *> & skins,
+      const tAABox & box);
     
   private:
     /// calculate the array index for a given i, j, k value, which 
@@ -108,8 +114,11 @@ namespace JigLib
 
     typedef std::vector<tCollisionSkin *> tSkins;
     tSkins mSkins;
+
+    /// lists that are returned from GetListsToCheck
+    std::vector<class tGridEntry *> mListsToCheck;
     
-    bool mDetecting;
+    std::atomic<unsigned> mDetecting;
   };
 }
 
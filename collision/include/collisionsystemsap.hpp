@@ -0,0 +1,199 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionsystemsap.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLISIONSYSTEMSAP_HPP
+#define JIGCOLLISIONSYSTEMSAP_HPP
+
+#include "../collision/include/collisionsystem.hpp"
+#include "../utils/include/pairhashmap.hpp"
+
+#include <vector>
+#include <atomic>
+
+namespace JigLib
+{
+  /// Implements a collision system using "sweep and prune". The ends
+  /// of the skin bounding boxes are kept sorted along each axis, and
+  /// as skins move the ends get moved by insertion sort. Whenever two
+  /// ends pass each other the set of overlapping pairs gets updated,
+  /// so it doesn't need to be worked out from scratch each
+  /// step. Works best when things don't move much from one step to
+  /// the next.
+  ///
+  /// Moves are only applied (lazily) when the next detection
+  /// happens. Note that the proxy index of each skin is stored in its
+  /// external data mInt.
+  ///
+  /// New skins and box/segment queries binary search the sorted ends
+  /// rather than looking at every skin. Each end keeps a count of the
+  /// boxes open across it, so the boxes that start before a range and
+  /// run into it can be found by walking back only until that many
+  /// have been seen. Boxes with no ends (planes, heightmaps) would
+  /// make that walk go back to the start, so they are left out of the
+  /// counts and always checked.
+  class tCollisionSystemSAP : public tCollisionSystem
+  {
+  public:
+    /// The skin bounding boxes get expanded by margin so that small
+    /// movements don't need the ends to be moved. They are also
+    /// expanded by half of the biggest collision tolerance that has
+    /// been used, so that skins closer than that always have a pair
+    /// - the first detection with a bigger tolerance re-expands all
+    /// the boxes.
+    tCollisionSystemSAP(tScalar margin = 0.1f);
+    ~tCollisionSystemSAP();
+
+    // inherited
+    void AddCollisionSkin(class tCollisionSkin * skin);
+
+    // inherited
+    bool RemoveCollisionSkin(class tCollisionSkin * skin);
+
+    // inherited
+    void CollisionSkinMoved(const class tCollisionSkin * skin);
+
+    // inherited
+    void DetectCollisions(
+      class tBody & body,
+      tCollisionFunctor & collisionFunctor,
+      const tCollisionSkinPredicate2 * collisionPredicate,
+      tScalar collTolerance);
+
+    // inherited
+    void DetectAllCollisions(
+      const std::vector<class tBody *> & bodies,
+      tCollisionFunctor & collisionFunctor,
+      const tCollisionSkinPredicate2 * collisionPredicate,
+      tScalar collTolerance);
+
+    bool SegmentIntersect(
+      tScalar & frac,
+      tCollisionSkin *& skin,
+      tVector3 & pos,
+      tVector3 & normal,
+      const class tSegment & seg,
+      const tCollisionSkinPredicate1 * collisionPredicate);
+
+    // inherited
+    void GetSkinsOverlappingAABox(
+      std::vector<class tCollisionSkin *> & skins,
+      const tAABox & box);
+
+    /// Number of pairs of skins whose (expanded) boxes overlap
+    unsigned GetNumOverlappingPairs() const {return mPairs.size();}
+
+  private:
+    /// The start or end of a box along one axis
+    struct tEndPoint
+    {
+      tScalar mValue;
+      /// proxy index * 2, + 1 if it's a max
+      unsigned mData;
+      /// number of bounded boxes that start at or before this end and
+      /// finish after it
+      unsigned mStabbingCount;
+      unsigned GetProxy() const {return mData >> 1;}
+      bool IsMax() const {return (mData & 1) != 0;}
+      /// mins come before maxes with the same value, so touching
+      /// boxes overlap
+      bool operator<(const tEndPoint & other) const {
+        return mValue < other.mValue ||
+          (mValue == other.mValue && (mData & 1) < (other.mData & 1));}
+    };
+
+    struct tProxy
+    {
+      tCollisionSkin * mSkin;
+      /// the expanded box
+      tVector3 mMin;
+      tVector3 mMax;
+      /// where the ends are in the endpoint arrays
+      unsigned mMinIndex[3];
+      unsigned mMaxIndex[3];
+      /// waiting for the ends to be moved
+      bool mDirty;
+      /// set during DetectAllCollisions if the skin belongs to one of
+      /// the bodies that was passed in
+      bool mInBodies;
+      /// the box has no ends along some axis - see mUnboundedProxies
+      bool mUnbounded;
+    };
+
+    struct tPair
+    {
+      unsigned mProxy0;
+      unsigned mProxy1;
+    };
+
+    /// Moves the ends for all the skins that have moved. If
+    /// collTolerance is bigger than any used before all the boxes get
+    /// expanded to allow for it.
+    void UpdateDirtyProxies(tScalar collTolerance = SCALAR(0.0f));
+    void UpdateProxy(unsigned iProxy);
+
+    // The insertion sorts. Each one moves the end of iProxy along
+    // axis until it's in order, adding/removing pairs as it passes
+    // the ends of other boxes.
+    void SortMinDown(unsigned axis, unsigned iProxy);
+    void SortMinUp(unsigned axis, unsigned iProxy);
+    void SortMaxDown(unsigned axis, unsigned iProxy);
+    void SortMaxUp(unsigned axis, unsigned iProxy);
+
+    /// swaps end points i and i+1 along axis, keeping the proxy
+    /// indices and the stabbing counts in step
+    void SwapEndPoints(unsigned axis, unsigned i);
+
+    /// The stabbing count that end point i along axis should have,
+    /// given the one before it
+    unsigned GetStabbingCount(unsigned axis, unsigned i) const;
+
+    /// Sets mUnbounded for the proxy from its expanded box, keeping
+    /// mUnboundedProxies in step. Returns true if it changed.
+    bool UpdateUnbounded(unsigned iProxy);
+
+    /// Adds the skins whose expanded boxes overlap or touch the box
+    /// from min to max, using the axis with the fewest ends to look
+    /// at. If skipDirty then the proxies waiting to be moved (whose
+    /// boxes might be out of date) are all added instead.
+    void GetProxySkins(std::vector<class tCollisionSkin *> & skins,
+                       const tVector3 & min, const tVector3 & max,
+                       bool skipDirty) const;
+
+    /// do the (expanded) boxes overlap
+    bool ProxiesOverlap(unsigned iProxy0, unsigned iProxy1) const;
+
+    void AddPair(unsigned iProxy0, unsigned iProxy1);
+    void RemovePair(unsigned iProxy0, unsigned iProxy1);
+
+    std::vector<tEndPoint> mEndPoints[3];
+    std::vector<tProxy> mProxies;
+    /// proxies that can be reused
+    std::vector<unsigned> mFreeProxies;
+    /// proxies whose boxes are unbounded along some axis. They're not
+    /// in the stabbing counts.
+    std::vector<unsigned> mUnboundedProxies;
+    std::vector<unsigned> mDirtyProxies;
+
+    /// The overlapping pairs - mPairIndices maps from (lower proxy,
+    /// higher proxy) to the index in mPairs
+    std::vector<tPair> mPairs;
+    tPairHashMap<unsigned> mPairIndices;
+
+    tScalar mMargin;
+    /// The biggest collision tolerance used so far. Each skin's
+    /// expanded box contains its bounding box plus half of this.
+    tScalar mPairTolerance;
+
+    typedef std::vector<tCollisionSkin *> tSkins;
+    tSkins mSkins;
+
+    std::atomic<unsigned> mDetecting;
+  };
+}
+
+#endif
@@ -2,8 +2,10 @@
 #define MATERIALS_HPP
 
 #include "../maths/include/precision.hpp"
+#include "../utils/include/pairhashmap.hpp"
 
 #include <map>
+#include <vector>
 #include <algorithm>
 
 namespace JigLib
@@ -29,12 +31,19 @@ namespace JigLib
   
 
   /// This handles the properties of interactions between different
-  /// materials
+  /// materials. The pairs for IDs below MAX_DENSE_MATERIAL_ID are in
+  /// a flat table so that looking them up is just an index - so it's
+  /// best to keep IDs small and close together. Bigger IDs still work
+  /// but go in a hash table. Lookups don't change anything, so they
+  /// can be done from several threads at once (but not whilst
+  /// materials are being set).
   class tMaterialTable
   {
   public:
     typedef unsigned int tMaterialID;
 
+    enum {MAX_DENSE_MATERIAL_ID = 256};
+
     /// Some default materials that get added automatically User
     /// materials should start at NUM_JIGLIB_MATERIAL_TYPES, or else
     /// ignore this and over-ride everything. User-refined values can
@@ -71,11 +80,18 @@ namespace JigLib
     
     /// Returns properties of a material - defaults on inelastic
     /// frictionless.
-    const tMaterialProperties &GetMaterialProperties(tMaterialID id) const {return mMaterials[id];}
+    const tMaterialProperties &GetMaterialProperties(tMaterialID id) const;
     
     /// Gets the properties for a pair of materials. Same result even
-    /// if the two ids are swapped
-    const tMaterialPairProperties &GetPairProperties(tMaterialID id1, tMaterialID id2) const {return mMaterialPairs[std::pair<tMaterialID, tMaterialID>(id1, id2)];}
+    /// if the two ids are swapped. Pairs that haven't been set are
+    /// inelastic and frictionless.
+    const tMaterialPairProperties &GetPairProperties(tMaterialID id1, tMaterialID id2) const
+    {
+      if (id1 < mNumDenseMaterials && id2 < mNumDenseMaterials)
+        return mDensePairs[id1 * mNumDenseMaterials + id2];
+      const tMaterialPairProperties * pair = mSparsePairs.Find(id1, id2);
+      return pair ? *pair : mDefaultPairProperties;
+    }
     
     /// This overrides the result for a single pair of materials. It's
     /// recommended that you add all materials first. Order of ids
@@ -83,13 +99,25 @@ namespace JigLib
     void SetMaterialPairProperties(tMaterialID id1, tMaterialID id2, const tMaterialPairProperties &pairProperties);
     
     private:
-      const tMaterialPairProperties &GetCalculatedPairProperties(tMaterialID id1, tMaterialID id2) const {return mMaterialPairs[std::pair<tMaterialID, tMaterialID>(id1, id2)];}
+      /// Sets one order of the pair
+      void SetPair(tMaterialID id1, tMaterialID id2, const tMaterialPairProperties &pairProperties);
+
+      /// Makes the flat table big enough for ids up to id
+      void GrowDensePairs(tMaterialID id);
 
       typedef std::map<tMaterialID, tMaterialProperties> tMaterials;
-      typedef std::map< std::pair<tMaterialID, tMaterialID>, tMaterialPairProperties> tMaterialPairs;
       
-      mutable tMaterials mMaterials; ///< for default initialisation in lookup
-      mutable tMaterialPairs mMaterialPairs; ///< for default initialisation in lookup
+      tMaterials mMaterials;
+
+      /// mNumDenseMaterials x mNumDenseMaterials, indexed by
+      /// id1 * mNumDenseMaterials + id2
+      std::vector<tMaterialPairProperties> mDensePairs;
+      tMaterialID mNumDenseMaterials;
+      /// pairs where either ID is too big for mDensePairs
+      tPairHashMap<tMaterialPairProperties> mSparsePairs;
+
+      tMaterialProperties mDefaultProperties;
+      tMaterialPairProperties mDefaultPairProperties;
   };
   
 }
@@ -34,43 +34,218 @@ tCollDetectFunctor("BoxBox", tPrimitive::BOX, tPrimitive::BOX)
 {
 }
 
-//========================================================
-// Disjoint Returns true if disjoint.  Returns false if intersecting,
-// and sets the overlap depth, d scaled by the axis length
-//========================================================
-static bool Disjoint(tScalar & d,
-                     const tVector3 & axis, 
-                     const tBox & box0, 
-                     const tBox & box1,
-                     tScalar collTolerance)
+#ifdef USING_SSE
+//==============================================================
+// AbsPS
+//==============================================================
+static inline __m128 AbsPS(__m128 v)
 {
-  tScalar min0, max0, min1, max1;
-  
-  box0.GetSpan(min0, max0, axis);
-  box1.GetSpan(min1, max1, axis);
-  
-  if (min0 > (max1 + collTolerance + SCALAR_TINY) || 
-      min1 > (max0 + collTolerance + SCALAR_TINY))
-    return true;
-  
-  if ( (max0 > max1) && (min1 > min0) )
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), v);
+}
+#endif
+
+//==============================================================
+// tBoxPairSAT
+// Gets the overlap along each of the 15 potential separating axes
+// from the orientation of box1 relative to box0, rather than
+// projecting both boxes onto each axis. Axes 0-2 are box0's faces,
+// 3-5 are box1's faces, and 6 + 3 * i + j is
+// Cross(box0 axis i, box1 axis j). The axes aren't normalised, so
+// the overlaps are scaled by the axis lengths (which are 1 for the
+// face axes).
+//
+// The axes are done in groups of three (box0 faces, box1 faces, and
+// the edges of each box0 axis), and each group is stored in a
+// 4-wide slot so that with USING_SSE it's one packed calculation. The
+// packed versions do the same operations in the same order as the
+// scalar loops, so the results are the same either way.
+//==============================================================
+struct tBoxPairSAT
+{
+  enum {NUM_AXES = 15, NUM_SLOTS = 20};
+
+  tBoxPairSAT(const tBox & box0, const tBox & box1)
+  {
+    const tMatrix33 & dirs0 = box0.GetOrient();
+    const tMatrix33 & dirs1 = box1.GetOrient();
+    const tVector3 T = box1.GetCentre() - box0.GetCentre();
+    unsigned i, j;
+    for (i = 0 ; i < 3 ; ++i)
+    {
+      for (j = 0 ; j < 3 ; ++j)
+      {
+        R[i][j] = Dot(dirs0[i], dirs1[j]);
+        absR[i][j] = Abs(R[i][j]);
+      }
+      R[i][3] = absR[i][3] = 0.0f;
+      t0[i] = Dot(T, dirs0[i]);
+      t1[i] = Dot(T, dirs1[i]);
+      h0[i] = 0.5f * box0.GetSideLengths()[i];
+      h1[i] = 0.5f * box1.GetSideLengths()[i];
+    }
+    t0[3] = t1[3] = h0[3] = h1[3] = 0.0f;
+  }
+
+  /// Where axis iAxis is stored in overlaps and lengthsSq
+  static unsigned Slot(unsigned iAxis) {return iAxis + iAxis / 3;}
+
+  tScalar GetOverlap(unsigned iAxis) const {return overlaps[Slot(iAxis)];}
+  tScalar GetLengthSq(unsigned iAxis) const {return lengthsSq[Slot(iAxis)];}
+
+#ifdef USING_SSE
+  /// Sets axes [0, 3)
+  void GetFace0Overlaps()
   {
-    // box1 is inside - choose the min dist to move it out
-    d = Min(max0 - min1, max1 - min0);
+    // need the columns of absR
+    __m128 c0 = _mm_load_ps(absR[0]);
+    __m128 c1 = _mm_load_ps(absR[1]);
+    __m128 c2 = _mm_load_ps(absR[2]);
+    __m128 c3 = _mm_setzero_ps();
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    __m128 o = _mm_add_ps(_mm_load_ps(h0), _mm_mul_ps(c0, _mm_set1_ps(h1[0])));
+    o = _mm_add_ps(o, _mm_mul_ps(c1, _mm_set1_ps(h1[1])));
+    o = _mm_add_ps(o, _mm_mul_ps(c2, _mm_set1_ps(h1[2])));
+    _mm_store_ps(&overlaps[0], _mm_sub_ps(o, AbsPS(_mm_load_ps(t0))));
+    _mm_store_ps(&lengthsSq[0], _mm_set1_ps(1.0f));
   }
-  else if ( (max1 > max0) && (min0 > min1) )
+
+  /// Sets axes [3, 6)
+  void GetFace1Overlaps()
   {
-    // box0 is inside - choose the min dist to move it out
-    d = Min(max1 - min0, max0 - min1);
+    __m128 o = _mm_add_ps(_mm_load_ps(h1), _mm_mul_ps(_mm_load_ps(absR[0]), _mm_set1_ps(h0[0])));
+    o = _mm_add_ps(o, _mm_mul_ps(_mm_load_ps(absR[1]), _mm_set1_ps(h0[1])));
+    o = _mm_add_ps(o, _mm_mul_ps(_mm_load_ps(absR[2]), _mm_set1_ps(h0[2])));
+    _mm_store_ps(&overlaps[4], _mm_sub_ps(o, AbsPS(_mm_load_ps(t1))));
+    _mm_store_ps(&lengthsSq[4], _mm_set1_ps(1.0f));
   }
-  else
+
+  /// Sets axes [6, 15). Lane j of the slot for box0 axis i is
+  /// Cross(box0 axis i, box1 axis j), so the j + 1 and j + 2 terms
+  /// come from rotating the lanes.
+  void GetEdgeOverlaps()
   {
-    // boxes overlap
-    d  = (max0 < max1) ? max0 : max1;
-    d -= (min0 > min1) ? min0 : min1;
+    const __m128 h1v = _mm_load_ps(h1);
+    const __m128 h1j1 = _mm_shuffle_ps(h1v, h1v, _MM_SHUFFLE(3, 0, 2, 1));
+    const __m128 h1j2 = _mm_shuffle_ps(h1v, h1v, _MM_SHUFFLE(3, 1, 0, 2));
+    for (unsigned i = 0 ; i < 3 ; ++i)
+    {
+      const unsigned i1 = (i + 1) % 3;
+      const unsigned i2 = (i + 2) % 3;
+      const __m128 Ri = _mm_load_ps(R[i]);
+      const __m128 Rij1 = _mm_shuffle_ps(Ri, Ri, _MM_SHUFFLE(3, 0, 2, 1));
+      const __m128 Rij2 = _mm_shuffle_ps(Ri, Ri, _MM_SHUFFLE(3, 1, 0, 2));
+      const __m128 absRi = _mm_load_ps(absR[i]);
+      const __m128 absRij1 = _mm_shuffle_ps(absRi, absRi, _MM_SHUFFLE(3, 0, 2, 1));
+      const __m128 absRij2 = _mm_shuffle_ps(absRi, absRi, _MM_SHUFFLE(3, 1, 0, 2));
+      __m128 o = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(h0[i1]), _mm_load_ps(absR[i2])),
+                            _mm_mul_ps(_mm_set1_ps(h0[i2]), _mm_load_ps(absR[i1])));
+      o = _mm_add_ps(o, _mm_mul_ps(h1j1, absRij2));
+      o = _mm_add_ps(o, _mm_mul_ps(h1j2, absRij1));
+      const __m128 s = _mm_sub_ps(_mm_mul_ps(_mm_set1_ps(t0[i2]), _mm_load_ps(R[i1])),
+                                  _mm_mul_ps(_mm_set1_ps(t0[i1]), _mm_load_ps(R[i2])));
+      _mm_store_ps(&overlaps[8 + 4 * i], _mm_sub_ps(o, AbsPS(s)));
+      // |Cross(a_i, b_j)|^2 from the other components of a_i in
+      // box1's frame, since 1 - R[i][j]^2 is no good when the edges
+      // are nearly parallel
+      _mm_store_ps(&lengthsSq[8 + 4 * i], _mm_add_ps(_mm_mul_ps(Rij1, Rij1), _mm_mul_ps(Rij2, Rij2)));
+    }
   }
-  
-  return false;
+#else
+  /// Sets axes [0, 3)
+  void GetFace0Overlaps()
+  {
+    for (unsigned i = 0 ; i < 3 ; ++i)
+    {
+      overlaps[i] = h0[i] + absR[i][0] * h1[0] + absR[i][1] * h1[1] + absR[i][2] * h1[2] - Abs(t0[i]);
+      lengthsSq[i] = 1.0f;
+    }
+  }
+
+  /// Sets axes [3, 6)
+  void GetFace1Overlaps()
+  {
+    for (unsigned j = 0 ; j < 3 ; ++j)
+    {
+      overlaps[4 + j] = h1[j] + absR[0][j] * h0[0] + absR[1][j] * h0[1] + absR[2][j] * h0[2] - Abs(t1[j]);
+      lengthsSq[4 + j] = 1.0f;
+    }
+  }
+
+  /// Sets axes [6, 15)
+  void GetEdgeOverlaps()
+  {
+    for (unsigned i = 0 ; i < 3 ; ++i)
+    {
+      const unsigned i1 = (i + 1) % 3;
+      const unsigned i2 = (i + 2) % 3;
+      for (unsigned j = 0 ; j < 3 ; ++j)
+      {
+        const unsigned j1 = (j + 1) % 3;
+        const unsigned j2 = (j + 2) % 3;
+        const unsigned iSlot = 8 + 4 * i + j;
+        overlaps[iSlot] =
+          h0[i1] * absR[i2][j] + h0[i2] * absR[i1][j] +
+          h1[j1] * absR[i][j2] + h1[j2] * absR[i][j1] -
+          Abs(t0[i2] * R[i1][j] - t0[i1] * R[i2][j]);
+        // |Cross(a_i, b_j)|^2 from the other components of a_i in
+        // box1's frame, since 1 - R[i][j]^2 is no good when the edges
+        // are nearly parallel
+        lengthsSq[iSlot] = R[i][j1] * R[i][j1] + R[i][j2] * R[i][j2];
+      }
+    }
+  }
+#endif
+
+  /// Gets the overlaps for the group that iAxis is in
+  void GetGroupOverlaps(unsigned iAxis)
+  {
+    if (iAxis < 3)
+      GetFace0Overlaps();
+    else if (iAxis < 6)
+      GetFace1Overlaps();
+    else
+      GetEdgeOverlaps();
+  }
+
+  /// Returns the first axis in [begin, end) that separates the boxes
+  /// by more than tol, or NUM_AXES. Axes that are too short to
+  /// normalise are ignored.
+  unsigned FindSeparatingAxis(unsigned begin, unsigned end, tScalar tol) const
+  {
+    for (unsigned i = begin ; i < end ; ++i)
+    {
+      if (GetOverlap(i) < -tol && GetLengthSq(i) >= SCALAR_TINY)
+        return i;
+    }
+    return NUM_AXES;
+  }
+
+  // Rows and the per-axis values are padded to 4 (with 0) so they
+  // can be loaded as they are.
+  JIGALIGN16 tScalar R[3][4];
+  JIGALIGN16 tScalar absR[3][4];
+  /// centre offset in each box's frame
+  JIGALIGN16 tScalar t0[4];
+  JIGALIGN16 tScalar t1[4];
+  JIGALIGN16 tScalar h0[4];
+  JIGALIGN16 tScalar h1[4];
+  /// indexed by Slot
+  JIGALIGN16 tScalar overlaps[NUM_SLOTS];
+  JIGALIGN16 tScalar lengthsSq[NUM_SLOTS];
+};
+
+//==============================================================
+// GetPairHash
+//==============================================================
+static inline unsigned GetPairHash(const tCollDetectInfo & info)
+{
+  size_t hash = (size_t) info.skin0;
+  hash = hash * 31 + (size_t) info.skin1;
+  hash = hash * 31 + info.iPrim0;
+  hash = hash * 31 + info.iPrim1;
+  hash ^= hash >> 17;
+  hash *= 0x9E3779B1u;
+  return (unsigned) (hash ^ (hash >> 15));
 }
 
 //==============================================================
@@ -210,7 +385,7 @@ static unsigned GetAABox2BoxEdgesIntersectionPoints(
 {
   unsigned num = 0;
   
-  static tVector3 boxPts[8];
+  tVector3 boxPts[8];
   box.GetCornerPoints(boxPts);
   const tBox::tEdge * edges = box.GetAllEdges();
   
@@ -298,70 +473,64 @@ void tCollDetectBoxBox::CollDetect(const tCollDetectInfo &info,
 
   const tMatrix33 & dirs0 = box0.GetOrient();
   const tMatrix33 & dirs1 = box1.GetOrient();
-  
-  // the 15 potential separating axes
-  static const unsigned numAxes = 15;
-  tVector3 axes[numAxes] = {
-    dirs0[0],
-    dirs0[1],
-    dirs0[2],
-    dirs1[0],
-    dirs1[1],
-    dirs1[2],
-    Cross(dirs0[0], dirs1[0]),
-    Cross(dirs0[0], dirs1[1]),
-    Cross(dirs0[0], dirs1[2]),
-    Cross(dirs0[1], dirs1[0]),
-    Cross(dirs0[1], dirs1[1]),
-    Cross(dirs0[1], dirs1[2]),
-    Cross(dirs0[2], dirs1[0]),
-    Cross(dirs0[2], dirs1[1]),
-    Cross(dirs0[2], dirs1[2]),
-  };
-  
-  // the overlap depths along each axis
-  tScalar overlapDepths[numAxes];
-  
-  // see if the boxes are separate along any axis, and if not keep a 
+
+  tBoxPairSAT sat(box0, box1);
+  const tScalar tol = collTolerance + SCALAR_TINY;
+
+  // Try the axis that separated these boxes last time first - most
+  // pairs that get this far are separated, and usually along the
+  // same axis as before. The hints belong to the collision system
+  // (if there is one).
+  tCollisionSystem * collSystem = info.skin0->GetCollisionSystem();
+  tSeparatingAxisCache * axisCache = collSystem ? &collSystem->GetSeparatingAxisCache() : 0;
+  const unsigned pairHash = GetPairHash(info);
+  unsigned cachedAxis = axisCache ? axisCache->GetAxis(pairHash) : (unsigned) tSeparatingAxisCache::NO_AXIS;
+  if (cachedAxis < tBoxPairSAT::NUM_AXES)
+  {
+    sat.GetGroupOverlaps(cachedAxis);
+    if (sat.FindSeparatingAxis(cachedAxis, cachedAxis + 1, tol) == cachedAxis)
+      return;
+  }
+
+  // see if the boxes are separate along any axis, and if not keep a
   // record of the depths along each axis
+  static const unsigned groups[4] = {0, 3, 6, tBoxPairSAT::NUM_AXES};
   unsigned i;
-  for (i = 0 ; i < numAxes ; ++i)
+  for (unsigned iGroup = 0 ; iGroup < 3 ; ++iGroup)
   {
-    // If we can't normalise the axis, skip it
-    tScalar l2 = axes[i].GetLengthSq();
-    if (l2 < SCALAR_TINY)
-      continue;
-    overlapDepths[i] = SCALAR_HUGE;
-    if (Disjoint(overlapDepths[i], axes[i], box0, box1, collTolerance))
+    if (cachedAxis < groups[iGroup] || cachedAxis >= groups[iGroup + 1])
+      sat.GetGroupOverlaps(groups[iGroup]);
+    unsigned iAxis = sat.FindSeparatingAxis(groups[iGroup], groups[iGroup + 1], tol);
+    if (iAxis < tBoxPairSAT::NUM_AXES)
+    {
+      // only write if it's changed, so the entries don't keep
+      // getting dirtied
+      if (axisCache && iAxis != cachedAxis)
+        axisCache->SetAxis(pairHash, iAxis);
       return;
+    }
   }
   
   //-----------------------------------------------------------------
   // The box overlap, find the separation depth closest to 0.
   //-----------------------------------------------------------------
-  tScalar minDepth = SCALAR_HUGE;
+  tScalar depth = SCALAR_HUGE;
   int minAxis = -1;
   
-  for(i = 0; i < numAxes; ++i)
+  for(i = 0; i < tBoxPairSAT::NUM_AXES; ++i)
   {
     // If we can't normalise the axis, skip it
-    tScalar l2 = axes[i].GetLengthSq();
+    tScalar l2 = sat.GetLengthSq(i);
     if (l2 < SCALAR_TINY)
       continue;
     
     //-----------------------------------------------------------------
-    // Normalise the separation axis and the depth
+    // Normalise the depth, and if this axis is the minimum, select it
     //-----------------------------------------------------------------
-    tScalar invl = 1.0f / Sqrt(l2);
-    axes[i] *= invl;
-    overlapDepths[i] *= invl;
-    
-    //-----------------------------------------------------------------
-    // If this axis is the minimum, select it
-    //-----------------------------------------------------------------
-    if (overlapDepths[i] < minDepth)
+    tScalar axisDepth = sat.GetOverlap(i) / Sqrt(l2);
+    if (axisDepth < depth)
     {
-      minDepth = overlapDepths[i];
+      depth = axisDepth;
       minAxis = i;
     }
   }
@@ -374,8 +543,13 @@ void tCollDetectBoxBox::CollDetect(const tCollDetectInfo &info,
   // if not, invert it
   //-----------------------------------------------------------------
   tVector3 D = box1.GetCentre() - box0.GetCentre();
-  tVector3 & N = axes[minAxis];
-  tScalar depth = overlapDepths[minAxis];
+  tVector3 N;
+  if (minAxis < 3)
+    N = dirs0[minAxis];
+  else if (minAxis < 6)
+    N = dirs1[minAxis - 3];
+  else
+    N = Cross(dirs0[(minAxis - 6) / 3], dirs1[(minAxis - 6) % 3]).NormaliseSafe();
   
   if (Dot(D, N) > 0.0f)
     N.Negate();
@@ -524,7 +698,7 @@ void tCollDetectBoxBox::CollDetect(const tCollDetectInfo &info,
     // got some intersection points
     for (i = 0 ; i < numPts ; ++i)
     {
-      static tScalar minDepthScale = 0.0f;
+      const tScalar minDepthScale = 0.0f;
       tScalar dist = PointPointDistance(pts[i].pos, SATPoint);
       tScalar depthScale = (dist - minDist) / (maxDist - minDist);
       tScalar depth = (1.0f - depthScale) * oldDepth + minDepthScale * depthScale * oldDepth;
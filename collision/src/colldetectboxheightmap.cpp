@@ -9,6 +9,7 @@
 #include "colldetectboxheightmap.hpp"
 #include "mathsmisc.hpp"
 #include "heightmap.hpp"
+#include "aabox.hpp"
 #include "body.hpp"
 
 using namespace std;
@@ -49,12 +50,21 @@ void tCollDetectBoxHeightmap::CollDetect(const tCollDetectInfo &infoOrig,
   const tHeightmap & oldHeightmap = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetHeightmap();
   const tHeightmap & newHeightmap = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetHeightmap();
 
-  static tVector3 oldPts[8];
+  // quick check that there's something under the box that's high
+  // enough to touch it
+  tAABox boxBox;
+  boxBox.AddBox(newBox);
+  tScalar hMin, hMax;
+  newHeightmap.GetHeightRange(hMin, hMax, boxBox);
+  if (boxBox.GetMinPos().z > hMax + collTolerance)
+    return;
+
+  tVector3 oldPts[8];
   oldBox.GetCornerPoints(oldPts);
-  static tVector3 newPts[8];
+  tVector3 newPts[8];
   newBox.GetCornerPoints(newPts);
   
-  static tFixedVector<tCollPointInfo, 8> collPts;
+  tFixedVector<tCollPointInfo, 8> collPts;
   collPts.Clear();
 
   tVector3 collNormal(0.0f);
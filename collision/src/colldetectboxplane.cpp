@@ -55,12 +55,12 @@ void tCollDetectBoxPlane::CollDetect(const tCollDetectInfo &infoOrig,
   if (centreDist > collTolerance + newBox.GetBoundingRadiusAboutCentre())
     return;
 
-  static tVector3 newPts[8];
+  tVector3 newPts[8];
   newBox.GetCornerPoints(newPts);
-  static tVector3 oldPts[8];
+  tVector3 oldPts[8];
   oldBox.GetCornerPoints(oldPts);
 
-  static tFixedVector<tCollPointInfo, 8> collPts;
+  tFixedVector<tCollPointInfo, 8> collPts;
   collPts.Clear();
   
   for (unsigned i = 0 ; i < 8 ; ++i)
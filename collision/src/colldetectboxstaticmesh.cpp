@@ -7,266 +7,423 @@
 //                     
 //==============================================================
 #include "colldetectboxstaticmesh.hpp"
+#include "colldetectconvex.hpp"
 #include "mathsmisc.hpp"
+#include "fixedvector.hpp"
 #include "box.hpp"
 #include "trianglemesh.hpp"
+#include "collisionscratch.hpp"
 #include "triangle.hpp"
-#include "intersection.hpp"
+#include "distance.hpp"
 #include "body.hpp"
 
 using namespace std;
 using namespace JigLib;
 
-enum {MAX_PTS_PER_BOX_PAIR = 8};
+enum {MAX_PTS_PER_BOX_TRIANGLE = 8,
+      MAX_CANDIDATE_PTS = 32,
+      MAX_MANIFOLDS = 8,
+      VERTEX_CACHE_SIZE = 64};
 
+/// Normals closer than this (cos of the angle) share a manifold
+static const tScalar manifoldNormalCos = SCALAR(0.99f);
 
-//========================================================
-// AddPoint
-// if pt is less than Sqrt(combinationDistanceSq) from one of the
-// others the original is replaced with the mean of it
-// and pt, and false is returned. true means that pt was
-// added to pts
-//========================================================
-static bool AddPoint(tFixedVector<tVector3, MAX_PTS_PER_BOX_PAIR> & pts,
-                     const tVector3 & pt,
-                     tScalar combinationDistanceSq)
+//==============================================================
+// tBoxFrame
+// The box set up once per test so that the triangles can be tested
+// in its own space, where it's just [-halfSides, halfSides]
+//==============================================================
+struct tBoxFrame
 {
-  for (unsigned i = pts.Size() ; i-- != 0 ; )
+  tBoxFrame(const tBox & box) 
+    : centre(box.GetCentre()), orient(box.GetOrient()), halfSides(box.GetHalfSideLengths()) {}
+
+  tVector3 ToLocal(const tVector3 & pt) const
   {
-    if (PointPointDistanceSq(pts[i], pt) < combinationDistanceSq)
-    {
-      pts[i] = 0.5f * (pts[i] + pt);
-      return false;
-    }
+    const tVector3 delta = pt - centre;
+    return tVector3(Dot(delta, orient[0]), Dot(delta, orient[1]), Dot(delta, orient[2]));
+  }
+  tVector3 DirToLocal(const tVector3 & dir) const
+  {
+    return tVector3(Dot(dir, orient[0]), Dot(dir, orient[1]), Dot(dir, orient[2]));
+  }
+  tVector3 ToWorld(const tVector3 & pt) const {return centre + orient * pt;}
+  tVector3 DirToWorld(const tVector3 & dir) const {return orient * dir;}
+
+  /// Radius of the box when projected onto axis
+  tScalar GetRadius(const tVector3 & axis) const
+  {
+    return halfSides.x * Abs(axis.x) + halfSides.y * Abs(axis.y) + halfSides.z * Abs(axis.z);
   }
-  pts.PushBack(pt);
-  return true;
-}
+
+  tVector3 centre;
+  tMatrix33 orient;
+  tVector3 halfSides;
+};
 
 //==============================================================
-// GetBoxTriangleIntersectionPoints
-// Pushes intersection points onto the back of pts. Returns the
-// number of points found.
-// Points that are close together (compared to 
-// combinationDistance) get combined
+// tVertexCache
+// Mesh vertices in box space. Neighbouring triangles share most of
+// their vertices, and come out of the mesh query close together, so
+// a small direct-mapped cache saves most of the transforms.
 //==============================================================
-static unsigned GetBoxTriangleIntersectionPoints(
-  tFixedVector<tVector3, MAX_PTS_PER_BOX_PAIR> & pts,
-  const tBox & box,
-  const tTriangle& triangle,
-  tScalar combinationDistance)
+class tVertexCache
 {
-  // first intersect each edge of the box with the triangle
-  const tBox::tEdge* edges = box.GetAllEdges();
-  tVector3 boxPts[8];
-  box.GetCornerPoints(boxPts);
-
-  tScalar tS;
-  unsigned iEdge;
-  for (iEdge = 0 ; iEdge < 12 ; ++iEdge)
+public:
+  tVertexCache(const tBoxFrame & frame, const tTriangleMesh & mesh) : mFrame(frame), mMesh(mesh)
   {
-    const tBox::tEdge& edge = edges[iEdge];
-    tSegment seg(boxPts[edge.ind0], boxPts[edge.ind1] - boxPts[edge.ind0]);
-    if (SegmentTriangleIntersection(&tS, 0, 0, seg, triangle))
+    for (unsigned i = 0 ; i < VERTEX_CACHE_SIZE ; ++i)
+      mIndices[i] = ~0u;
+  }
+
+  const tVector3 & GetVertex(unsigned iVertex)
+  {
+    const unsigned slot = iVertex & (VERTEX_CACHE_SIZE - 1);
+    if (mIndices[slot] != iVertex)
     {
-      AddPoint(pts, seg.GetPoint(tS), Sq(combinationDistance));
+      mIndices[slot] = iVertex;
+      mPts[slot] = mFrame.ToLocal(mMesh.GetVertex(iVertex));
     }
+    return mPts[slot];
   }
 
-  tVector3 pos, n;
-  // now each edge of the triangle with the box
-  for (iEdge = 0 ; iEdge < 3 ; ++iEdge)
+private:
+  const tBoxFrame & mFrame;
+  const tTriangleMesh & mMesh;
+  unsigned mIndices[VERTEX_CACHE_SIZE];
+  tVector3 mPts[VERTEX_CACHE_SIZE];
+};
+
+//==============================================================
+// tManifold
+// All the contacts between the box and the mesh that have (roughly)
+// the same normal. These get reported as one collision, so a box
+// lying across many triangles gets a few stable points rather than
+// a few for each triangle.
+//==============================================================
+struct tManifold
+{
+  void Init(const tVector3 & N) {normal = N; normalSum.SetToZero(); numPts = 0;}
+
+  void AddPoint(const tVector3 & pt, tScalar depth)
   {
-    const tVector3 pt0 = triangle.GetPoint(iEdge);
-    const tVector3 pt1 = triangle.GetPoint((iEdge + 1) % 3);
-    if (box.SegmentIntersect(tS, pos, n, tSegment(pt0, pt1 - pt0)))
-      AddPoint(pts, pos, Sq(combinationDistance));
-    if (box.SegmentIntersect(tS, pos, n, tSegment(pt1, pt0 - pt1)))
-      AddPoint(pts, pos, Sq(combinationDistance));
+    if (numPts == MAX_CANDIDATE_PTS)
+      numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+    pts[numPts] = pt;
+    depths[numPts] = depth;
+    ++numPts;
   }
 
-  return pts.Size();
-}
+  /// the normal of the first contact - used for matching
+  tVector3 normal;
+  /// sum of the contact normals, weighted by their number of points
+  tVector3 normalSum;
+  tVector3 pts[MAX_CANDIDATE_PTS];
+  tScalar depths[MAX_CANDIDATE_PTS];
+  unsigned numPts;
+};
 
 //========================================================
-// Disjoint Returns true if disjoint.  Returns false if intersecting,
-// and sets the overlap depth, d scaled by the axis length
+// Disjoint 
+// Returns true if the box, which projects onto [-boxRadius,
+// boxRadius], is separate from [min1, max1]. Otherwise sets d to the
+// overlap, and dir to the direction (+1 or -1 along the axis) that
+// the box should move to get out.
 //========================================================
-static bool Disjoint(tScalar & d,
-                     const tVector3 & axis, 
-                     const tBox & box, 
-                     const tTriangle & triangle,
-                     tScalar collTolerance)
+static inline bool Disjoint(tScalar & d, tScalar & dir,
+                            tScalar boxRadius, tScalar min1, tScalar max1,
+                            tScalar collTolerance)
 {
-  tScalar min0, max0, min1, max1;
-
-  box.GetSpan(min0, max0, axis);
-  triangle.GetSpan(min1, max1, axis);
-
-  if (min0 > (max1 + collTolerance + SCALAR_TINY) || 
-      min1 > (max0 + collTolerance + SCALAR_TINY))
+  if (-boxRadius > (max1 + collTolerance + SCALAR_TINY) || 
+      min1 > (boxRadius + collTolerance + SCALAR_TINY))
     return true;
 
-  if ( (max0 > max1) && (min1 > min0) )
-  {
-    // triangle is inside - choose the min dist to move it out
-    d = Min(max0 - min1, max1 - min0);
-  }
-  else if ( (max1 > max0) && (min0 > min1) )
+  const tScalar dNeg = boxRadius - min1;
+  const tScalar dPos = max1 + boxRadius;
+  if (dNeg < dPos)
   {
-    // box is inside - choose the min dist to move it out
-    d = Min(max1 - min0, max0 - min1);
+    d = dNeg;
+    dir = -SCALAR(1.0f);
   }
   else
   {
-    // objects overlap
-    d  = (max0 < max1) ? max0 : max1;
-    d -= (min0 > min1) ? min0 : min1;
+    d = dPos;
+    dir = SCALAR(1.0f);
   }
-
   return false;
 }
 
-//====================================================================
-// DoOverlapBoxTest
-//====================================================================
-static bool DoOverlapBoxTriangleTest(const tBox & oldBox, 
-                                     const tBox & newBox, 
-                                     const tIndexedTriangle& triangle,
-                                     const tTriangleMesh& mesh,
-                                     const tCollDetectInfo &info,
-                                     tScalar collTolerance,
-                                     tCollisionFunctor & collisionFunctor)
+//==============================================================
+// ClipToPlane
+// Keeps the part of the polygon with Dot(pt, planeN) <= planeD.
+//==============================================================
+static unsigned ClipToPlane(tVector3 * out, const tVector3 * in, unsigned numIn,
+                            const tVector3 & planeN, tScalar planeD)
 {
-  const tMatrix33 & dirs0 = newBox.GetOrient();
-  tTriangle tri(
-    mesh.GetVertex(triangle.GetVertexIndex(0)),
-    mesh.GetVertex(triangle.GetVertexIndex(1)),
-    mesh.GetVertex(triangle.GetVertexIndex(2)));
-  tVector3 triEdge0 = (tri.GetPoint(1) - tri.GetPoint(0)).Normalise();  
-  tVector3 triEdge1 = (tri.GetPoint(2) - tri.GetPoint(1)).Normalise();  
-  tVector3 triEdge2 = (tri.GetPoint(0) - tri.GetPoint(2)).Normalise();  
-  const tVector3& triNormal = triangle.GetPlane().GetN();
-
-  // the 15 potential separating axes
-  static const int numAxes = 13;
-  tVector3 axes[numAxes] = 
-    {
-      triNormal,
-      dirs0[0],
-      dirs0[1],
-      dirs0[2],
-      Cross(dirs0[0], triEdge0),
-      Cross(dirs0[0], triEdge1),
-      Cross(dirs0[0], triEdge2),
-      Cross(dirs0[1], triEdge0),
-      Cross(dirs0[1], triEdge1),
-      Cross(dirs0[1], triEdge2),
-      Cross(dirs0[2], triEdge0),
-      Cross(dirs0[2], triEdge1),
-      Cross(dirs0[2], triEdge2),
-    };
-
-  // the overlap depths along each axis
-  tScalar overlapDepths[numAxes];
-
-  // see if the boxes are separate along any axis, and if not keep a 
-  // record of the depths along each axis
-  int i;
-  for (i = 0 ; i < numAxes ; ++i)
+  unsigned numOut = 0;
+  for (unsigned i = 0 ; i < numIn ; ++i)
   {
-    overlapDepths[i] = 1.0f;
-    if (Disjoint(overlapDepths[i], axes[i], newBox, tri, collTolerance))
-      return false;
+    const tVector3 & prev = in[i == 0 ? numIn - 1 : i - 1];
+    const tVector3 & cur = in[i];
+    const tScalar distPrev = Dot(prev, planeN) - planeD;
+    const tScalar distCur = Dot(cur, planeN) - planeD;
+    if ((distPrev > SCALAR(0.0f)) != (distCur > SCALAR(0.0f)))
+      out[numOut++] = prev + (distPrev / (distPrev - distCur)) * (cur - prev);
+    if (distCur <= SCALAR(0.0f))
+      out[numOut++] = cur;
   }
+  return numOut;
+}
+
+//==============================================================
+// GetBoxTriangleContact
+// Everything is in box space. Does the SAT on the 13 axes and then
+// generates the contact from the features on the minimum axis -
+// clipping against the reference face if it's a face, otherwise
+// taking the closest points of the two edges. N points towards the
+// box. Returns the number of points.
+//==============================================================
+static unsigned GetBoxTriangleContact(tVector3 & N,
+                                      tVector3 * pts,
+                                      tScalar * depths,
+                                      const tBoxFrame & box,
+                                      const tTriangleMesh & mesh,
+                                      unsigned iTriangle,
+                                      const tVector3 tri[3],
+                                      const tVector3 & triNormal,
+                                      tScalar collTolerance)
+{
+  const tVector3 & h = box.halfSides;
+  tScalar d, dir;
 
-  //-----------------------------------------------------------------
-  // The box overlap, find the separation depth closest to 0.
-  //-----------------------------------------------------------------
+  // box faces first - they're the cheapest
   tScalar minDepth = SCALAR_HUGE;
   int minAxis = -1;
+  tScalar minDir = SCALAR(1.0f);
+  unsigned i;
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    const tScalar min1 = Min(tri[0][i], tri[1][i], tri[2][i]);
+    const tScalar max1 = Max(tri[0][i], tri[1][i], tri[2][i]);
+    if (Disjoint(d, dir, h[i], min1, max1, collTolerance))
+      return 0;
+    if (d < minDepth)
+    {
+      minDepth = d;
+      minAxis = 1 + i;
+      minDir = dir;
+    }
+  }
 
-  for(i = 0; i < numAxes; ++i)
+  // triangle normal
+  const tScalar triD = Dot(tri[0], triNormal);
+  tScalar triDepth, triDir;
+  if (Disjoint(triDepth, triDir, box.GetRadius(triNormal), triD, triD, collTolerance))
+    return 0;
+  d = triDepth;
+  dir = triDir;
+  if (d < minDepth)
   {
-    //-----------------------------------------------------------------
-    // If we can't normalise the axis, skip it
-    //-----------------------------------------------------------------
-    tScalar l2 = axes[i].GetLengthSq();
-    if (l2 < SCALAR_TINY)
-      continue;
+    minDepth = d;
+    minAxis = 0;
+    minDir = dir;
+  }
 
-    //-----------------------------------------------------------------
-    // Normalise the separation axis and the depth
-    //-----------------------------------------------------------------
-    tScalar invl = 1.0f / Sqrt(l2);
-    axes[i] *= invl;
-    overlapDepths[i] *= invl;
-
-    //-----------------------------------------------------------------
-    // If this axis is the minimum, select it
-    //-----------------------------------------------------------------
-    if (overlapDepths[i] < minDepth)
+  // box edges with triangle edges. These aren't normalised, so
+  // compare d|d|/lengthSq (which has the same order as the normalised
+  // depth) and only normalise the one that wins
+  const tVector3 triEdges[3] = {tri[1] - tri[0], tri[2] - tri[1], tri[0] - tri[2]};
+  tScalar minEdgeDepthSq = minDepth * Abs(minDepth);
+  tVector3 minEdgeAxis(SCALAR(0.0f));
+  int minEdgeAxisIndex = -1;
+  tScalar minEdgeDir = SCALAR(1.0f);
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    const tVector3 & e = triEdges[i];
+    const tScalar threshold = SCALAR_TINY * e.GetLengthSq();
+    for (unsigned j = 0 ; j < 3 ; ++j)
     {
-      minDepth = overlapDepths[i];
-      minAxis = i;
+      // Cross(box axis j, e)
+      tVector3 axis;
+      if (j == 0)
+        axis.Set(SCALAR(0.0f), -e.z, e.y);
+      else if (j == 1)
+        axis.Set(e.z, SCALAR(0.0f), -e.x);
+      else
+        axis.Set(-e.y, e.x, SCALAR(0.0f));
+      const tScalar lengthSq = axis.GetLengthSq();
+      if (lengthSq < threshold)
+        continue;
+      const tScalar p0 = Dot(tri[0], axis);
+      const tScalar p1 = Dot(tri[1], axis);
+      const tScalar p2 = Dot(tri[2], axis);
+      if (Disjoint(d, dir, box.GetRadius(axis), Min(p0, p1, p2), Max(p0, p1, p2),
+                   collTolerance * Sqrt(lengthSq)))
+        return 0;
+      const tScalar depthSq = d * Abs(d) / lengthSq;
+      if (depthSq < minEdgeDepthSq)
+      {
+        minEdgeDepthSq = depthSq;
+        minEdgeAxis = axis;
+        minEdgeAxisIndex = 3 * i + j;
+        minEdgeDir = dir;
+      }
     }
   }
 
-  if (minAxis == -1)
-    return false;
+  if (minEdgeAxisIndex >= 0)
+  {
+    N = (minEdgeDir / minEdgeAxis.GetLength()) * minEdgeAxis;
+  }
+  else if (minAxis == 0)
+  {
+    N = minDir * triNormal;
+  }
+  else
+  {
+    N.SetToZero();
+    N[minAxis - 1] = minDir;
+  }
 
-  //-----------------------------------------------------------------
-  // Make sure the axis is facing towards the 0th box.
-  // if not, invert it
-  //-----------------------------------------------------------------
-  tVector3 D = newBox.GetCentre() - tri.GetCentre();
-  tVector3 & N = axes[minAxis];
-  tScalar depth = overlapDepths[minAxis];
-
-  if (Dot(D, N) < 0.0f)
-    N.Negate();
-
-  const tVector3& boxOldPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
-  const tVector3& boxNewPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetPosition() : tVector3::Zero();
-  const tVector3& meshPos   = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
-  
-  static tFixedVector<tVector3, MAX_PTS_PER_BOX_PAIR> pts;
-  pts.Clear();
-
-  static const tScalar combinationDist = 0.05f;
-  GetBoxTriangleIntersectionPoints(pts, newBox, tri, depth + combinationDist);
-
-  // adjust the depth 
-  tVector3 delta = boxNewPos - boxOldPos;
-  tScalar oldDepth = depth + Dot(delta, N);
-
-  static tFixedVector<tCollPointInfo, MAX_PTS_PER_BOX_PAIR> collPts;
-  collPts.Clear();
-
-  // report collisions
-  unsigned numPts = pts.Size();
-  if (numPts > 0)
+  // If the normal is for an internal or concave edge/point of the
+  // mesh the neighbouring triangle's face will deal with it. The
+  // points we'd get here are only on this triangle though, so rather
+  // than dropping them use this triangle's face too.
+  bool forcedFace = false;
+  if ((minEdgeAxisIndex >= 0 || minAxis != 0) && 
+      !mesh.IsContactNormalValid(iTriangle, box.DirToWorld(N)))
   {
-    // adjust positions
-    for (unsigned i = 0 ; i < numPts ; ++i)
+    minEdgeAxisIndex = -1;
+    minAxis = 0;
+    minDepth = triDepth;
+    N = triDir * triNormal;
+    forcedFace = true;
+  }
+
+  unsigned numPts = 0;
+  if (minEdgeAxisIndex >= 0)
+  {
+    // edge-edge - one point between the closest points of the edges
+    const tScalar depth = minEdgeDepthSq >= SCALAR(0.0f) ? Sqrt(minEdgeDepthSq) : -Sqrt(-minEdgeDepthSq);
+
+    const unsigned iTriEdge = minEdgeAxisIndex / 3;
+    const unsigned iBoxAxis = minEdgeAxisIndex % 3;
+    // the box edge that's deepest along -N
+    tVector3 boxEdgePt(N.x > SCALAR(0.0f) ? -h.x : h.x,
+                       N.y > SCALAR(0.0f) ? -h.y : h.y,
+                       N.z > SCALAR(0.0f) ? -h.z : h.z);
+    boxEdgePt[iBoxAxis] = -h[iBoxAxis];
+    tVector3 boxEdgeDelta(SCALAR(0.0f));
+    boxEdgeDelta[iBoxAxis] = SCALAR(2.0f) * h[iBoxAxis];
+
+    tScalar t0, t1;
+    const tSegment boxSeg(boxEdgePt, boxEdgeDelta);
+    const tSegment triSeg(tri[iTriEdge], triEdges[iTriEdge]);
+    SegmentSegmentDistanceSq(&t0, &t1, boxSeg, triSeg);
+    pts[0] = SCALAR(0.5f) * (boxSeg.GetPoint(t0) + triSeg.GetPoint(t1));
+    depths[0] = depth;
+    return 1;
+  }
+  else if (minAxis == 0)
+  {
+    // triangle face is the reference - clip the box face that points
+    // most against it
+    unsigned k = 0;
+    if (Abs(N.y) > Abs(N[k])) k = 1;
+    if (Abs(N.z) > Abs(N[k])) k = 2;
+    const unsigned k1 = (k + 1) % 3;
+    const unsigned k2 = (k + 2) % 3;
+    tVector3 face[2][MAX_PTS_PER_BOX_TRIANGLE];
+    for (i = 0 ; i < 4 ; ++i)
     {
-      collPts.PushBack(tCollPointInfo(pts[i] - boxNewPos, pts[i] - meshPos, oldDepth));
+      face[0][i][k] = N[k] > SCALAR(0.0f) ? -h[k] : h[k];
+      face[0][i][k1] = (i == 0 || i == 3) ? -h[k1] : h[k1];
+      face[0][i][k2] = (i < 2) ? -h[k2] : h[k2];
+    }
+    unsigned numClipped = 4;
+    unsigned iIn = 0;
+    const tVector3 triCentre = (tri[0] + tri[1] + tri[2]) / SCALAR(3.0f);
+    for (i = 0 ; i < 3 && numClipped > 0 ; ++i)
+    {
+      tVector3 sideN = Cross(triEdges[i], N);
+      if (Dot(sideN, triCentre - tri[i]) > SCALAR(0.0f))
+        sideN.Negate();
+      numClipped = ClipToPlane(face[1 - iIn], face[iIn], numClipped, sideN, Dot(sideN, tri[i]));
+      iIn = 1 - iIn;
+    }
+    for (i = 0 ; i < numClipped ; ++i)
+    {
+      const tVector3 & pt = face[iIn][i];
+      const tScalar sep = Dot(pt - tri[0], N);
+      if (sep > collTolerance)
+        continue;
+      pts[numPts] = pt - (SCALAR(0.5f) * sep) * N;
+      depths[numPts] = -sep;
+      ++numPts;
+    }
+    if (numPts == 0 && !forcedFace)
+    {
+      // just use the deepest corner
+      const tVector3 corner(N.x > SCALAR(0.0f) ? -h.x : h.x,
+                            N.y > SCALAR(0.0f) ? -h.y : h.y,
+                            N.z > SCALAR(0.0f) ? -h.z : h.z);
+      pts[0] = corner + (SCALAR(0.5f) * minDepth) * N;
+      depths[0] = minDepth;
+      numPts = 1;
     }
-
-    collisionFunctor.CollisionNotify(
-      info,
-      N,
-      &collPts[0],
-      numPts);
-    return true;
   }
   else
   {
-    return false;
+    // a box face is the reference - clip the triangle to the sides of
+    // the face, which in box space is just the slabs on the other two
+    // axes
+    const unsigned k = minAxis - 1;
+    tVector3 poly[2][MAX_PTS_PER_BOX_TRIANGLE];
+    for (i = 0 ; i < 3 ; ++i)
+      poly[0][i] = tri[i];
+    unsigned numClipped = 3;
+    unsigned iIn = 0;
+    for (i = 1 ; i < 3 && numClipped > 0 ; ++i)
+    {
+      tVector3 sideN(SCALAR(0.0f));
+      const unsigned j = (k + i) % 3;
+      sideN[j] = SCALAR(1.0f);
+      numClipped = ClipToPlane(poly[1 - iIn], poly[iIn], numClipped, sideN, h[j]);
+      iIn = 1 - iIn;
+      if (numClipped == 0)
+        break;
+      sideN[j] = -SCALAR(1.0f);
+      numClipped = ClipToPlane(poly[1 - iIn], poly[iIn], numClipped, sideN, h[j]);
+      iIn = 1 - iIn;
+    }
+    for (i = 0 ; i < numClipped ; ++i)
+    {
+      const tVector3 & pt = poly[iIn][i];
+      // distance outside the face, whose outward normal is -N
+      const tScalar sep = -Dot(pt, N) - h[k];
+      if (sep > collTolerance)
+        continue;
+      pts[numPts] = pt + (SCALAR(0.5f) * sep) * N;
+      depths[numPts] = -sep;
+      ++numPts;
+    }
+    if (numPts == 0)
+    {
+      // just use the deepest triangle corner
+      unsigned iDeepest = 0;
+      for (i = 1 ; i < 3 ; ++i)
+      {
+        if (Dot(tri[i], N) > Dot(tri[iDeepest], N))
+          iDeepest = i;
+      }
+      pts[0] = tri[iDeepest] - (SCALAR(0.5f) * minDepth) * N;
+      depths[0] = minDepth;
+      numPts = 1;
+    }
   }
+  return numPts;
 }
 
-
 //==============================================================
 // tCollDetectBoxStaticMesh
 //==============================================================
@@ -276,44 +433,128 @@ tCollDetectBoxStaticMesh::tCollDetectBoxStaticMesh()
 {
 }
 
+//==============================================================
+// BoxToMesh
+//==============================================================
+static tBox BoxToMesh(const tBox & box, const tTriangleMesh & mesh)
+{
+  tTransform3 t;
+  box.GetTransform(t);
+  tBox meshBox(box);
+  meshBox.SetTransform(mesh.TransformToMesh(t));
+  return meshBox;
+}
+
 //====================================================================
 // CollDetectBoxStaticMeshOverlap
+// Tests newBox (in mesh space) against the triangles in
+// potentialTriangles. The contacts are gathered into manifolds by
+// normal, and each one gets reduced to a few points before being
+// reported (in world space).
 //====================================================================
-static bool CollDetectBoxStaticMeshOverlap(const tBox& oldBox,
-                                           const tBox& newBox,
+static bool CollDetectBoxStaticMeshOverlap(const tBox& newBox,
                                            const class tTriangleMesh& mesh,
+                                           const std::vector<unsigned> & potentialTriangles,
+                                           unsigned numTriangles,
                                            const tCollDetectInfo &info,
                                            tScalar collTolerance,
                                            tCollisionFunctor & collisionFunctor)
 {
-  tScalar boxRadius = newBox.GetBoundingRadiusAboutCentre();
-  tVector3 boxCentre = newBox.GetCentre();
+  const tScalar boxRadius = newBox.GetBoundingRadiusAboutCentre();
+  const tBoxFrame box(newBox);
+  tVertexCache vertexCache(box, mesh);
 
-  tAABox boxBox(true);
-  boxBox.AddBox(newBox);
-  static std::vector<unsigned> potentialTriangles;
-  const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, boxBox);
+  tManifold manifolds[MAX_MANIFOLDS];
+  unsigned numManifolds = 0;
 
-  bool collision = false;
   for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
   {
     const tIndexedTriangle& meshTriangle = mesh.GetTriangle(potentialTriangles[iTriangle]);
 
     // quick early test
-    tScalar dist = PointPlaneDistance(boxCentre, meshTriangle.GetPlane());
+    tScalar dist = PointPlaneDistance(box.centre, meshTriangle.GetPlane());
     if (dist > boxRadius || dist < 0.0f)
       continue;
 
-    if (DoOverlapBoxTriangleTest(
-          oldBox, newBox, meshTriangle, mesh,
-          info,
-          collTolerance,
-          collisionFunctor))
+    const tVector3 tri[3] = {
+      vertexCache.GetVertex(meshTriangle.GetVertexIndex(0)),
+      vertexCache.GetVertex(meshTriangle.GetVertexIndex(1)),
+      vertexCache.GetVertex(meshTriangle.GetVertexIndex(2))};
+
+    tVector3 N;
+    tVector3 pts[MAX_PTS_PER_BOX_TRIANGLE];
+    tScalar depths[MAX_PTS_PER_BOX_TRIANGLE];
+    const unsigned numPts = GetBoxTriangleContact(
+      N, pts, depths, box, mesh, potentialTriangles[iTriangle], tri, box.DirToLocal(meshTriangle.GetPlane().GetN()), collTolerance);
+    if (numPts == 0)
+      continue;
+
+    N = box.DirToWorld(N);
+    unsigned iManifold;
+    for (iManifold = 0 ; iManifold < numManifolds ; ++iManifold)
+    {
+      if (Dot(manifolds[iManifold].normal, N) > manifoldNormalCos)
+        break;
+    }
+    if (iManifold == numManifolds)
+    {
+      if (numManifolds < MAX_MANIFOLDS)
+      {
+        manifolds[numManifolds++].Init(N);
+      }
+      else
+      {
+        // run out - put it with the nearest
+        iManifold = 0;
+        for (unsigned i = 1 ; i < numManifolds ; ++i)
+        {
+          if (Dot(manifolds[i].normal, N) > Dot(manifolds[iManifold].normal, N))
+            iManifold = i;
+        }
+      }
+    }
+    tManifold & manifold = manifolds[iManifold];
+    manifold.normalSum += ((tScalar) numPts) * N;
+    for (unsigned i = 0 ; i < numPts ; ++i)
+      manifold.AddPoint(box.ToWorld(pts[i]), depths[i]);
+  }
+
+  if (numManifolds == 0)
+    return false;
+
+  const tVector3& boxOldPos  = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& boxNewPos  = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetPosition() : tVector3::Zero();
+  const tVector3& meshOldPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& meshNewPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetPosition() : tVector3::Zero();
+  // the mesh might be moving too
+  const tVector3 delta = (boxNewPos - boxOldPos) - (meshNewPos - meshOldPos);
+
+  for (unsigned iManifold = 0 ; iManifold < numManifolds ; ++iManifold)
+  {
+    tManifold & manifold = manifolds[iManifold];
+    const tVector3 N = mesh.DirToWorld(manifold.normalSum.GetLengthSq() > SCALAR_TINY ? 
+                                       manifold.normalSum.GetNormalised() : manifold.normal);
+    const unsigned numPts = ReduceContactPoints(
+      manifold.pts, manifold.depths, manifold.numPts, MAX_CONVEX_CONTACT_POINTS);
+
+    // adjust the depth 
+    const tScalar deltaLen = Dot(delta, N);
+
+    tFixedVector<tCollPointInfo, MAX_CONVEX_CONTACT_POINTS> collPts;
+    collPts.Clear();
+    for (unsigned i = 0 ; i < numPts ; ++i)
     {
-      collision = true;
+      const tVector3 pt = mesh.PointToWorld(manifold.pts[i]);
+      collPts.PushBack(tCollPointInfo(pt - boxNewPos, pt - meshNewPos, manifold.depths[i] + deltaLen));
     }
+
+    collisionFunctor.CollisionNotify(
+      info,
+      N,
+      &collPts[0],
+      collPts.Size());
   }
-  return collision;
+  return true;
 }
 
 //==============================================================
@@ -325,13 +566,18 @@ void tCollDetectBoxStaticMesh::CollDetectOverlap(const tCollDetectInfo &info,
 {
   TRACE_METHOD_ONLY(MULTI_FRAME_1);
 
-  // note - mesh is static and its triangles are in world space
   const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
 
-  const tBox & oldBox = info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetBox();
-  const tBox & newBox = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetBox();
+  // work in mesh space
+  const tBox newBox = BoxToMesh(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetBox(), mesh);
 
-  CollDetectBoxStaticMeshOverlap(oldBox, newBox, mesh, info, collTolerance, collisionFunctor);
+  tAABox boxBox(true);
+  boxBox.AddBox(newBox);
+  tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
+  const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, boxBox);
+
+  CollDetectBoxStaticMeshOverlap(newBox, mesh, potentialTriangles, numTriangles, 
+                                 info, collTolerance, collisionFunctor);
 }
 
 
@@ -345,12 +591,13 @@ void tCollDetectBoxStaticMesh::CollDetectSweep(const tCollDetectInfo &info,
   TRACE_METHOD_ONLY(MULTI_FRAME_1);
 
   // todo - proper swept test
-  // note - mesh is static and its triangles are in world space
+  const tTriangleMesh & oldMesh = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetTriangleMesh();
   const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
-  static std::vector<unsigned> potentialTriangles;
 
-  const tBox & oldBox = info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetBox();
-  const tBox & newBox = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetBox();
+  // work in mesh space - each box relative to the mesh at the same
+  // time
+  const tBox oldBox = BoxToMesh(info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetBox(), oldMesh);
+  const tBox newBox = BoxToMesh(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetBox(), mesh);
 
   tVector3 oldCentre = oldBox.GetCentre();
   tVector3 newCentre = newBox.GetCentre();
@@ -366,15 +613,17 @@ void tCollDetectBoxStaticMesh::CollDetectSweep(const tCollDetectInfo &info,
   }
   if (nPositions == 1)
   {
-    CollDetectBoxStaticMeshOverlap(oldBox, newBox, mesh, info, collTolerance, collisionFunctor);
+    CollDetectOverlap(info, collTolerance, collisionFunctor);
   }
   else
   {
     tAABox boxBox(true);
     boxBox.AddBox(oldBox);
     boxBox.AddBox(newBox);
-    static std::vector<unsigned> potentialTriangles;
+    tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
     const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, boxBox);
+    // the triangles for the whole sweep are shared by all the
+    // positions
     if (numTriangles > 0)
     {
       for (int i = 0 ; i <= nPositions ; ++i)
@@ -386,7 +635,8 @@ void tCollDetectBoxStaticMesh::CollDetectSweep(const tCollDetectInfo &info,
         tBox box(centre - 0.5f * orient * newBox.GetSideLengths(), orient, newBox.GetSideLengths());
         // ideally we'd break if we get one collision... but that stops us getting multiple collisions
         // when we enter a corner (two walls meeting) - can let us pass through
-        CollDetectBoxStaticMeshOverlap(oldBox, box, mesh, info, collTolerance, collisionFunctor);
+        CollDetectBoxStaticMeshOverlap(box, mesh, potentialTriangles, numTriangles, 
+                                       info, collTolerance, collisionFunctor);
       }
     }
   }
@@ -83,8 +83,9 @@ void tCollDetectCapsuleBox::CollDetect(const tCollDetectInfo &infoOrig,
     }
     else
     {
-      // todo - make this not random
-      dir = RotationMatrix(RangedRandom(0.0f, 360.0f), tVector3::Up()) * tVector3::Look();
+      // Any direction will do - but not a random one, so the result
+      // doesn't depend on the order that pairs get tested in.
+      dir = tVector3::Look();
     }
     Assert(IsFinite(depth));
     tCollPointInfo collInfo(boxPos - body0Pos, boxPos - body1Pos, depth);
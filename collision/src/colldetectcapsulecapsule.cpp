@@ -70,8 +70,10 @@ void tCollDetectCapsuleCapsule::CollDetect(const tCollDetectInfo &info,
     }
     else
     {
-      // TODO - make this not random...!
-      delta = RotationMatrix(RangedRandom(0.0f, 360.0f), tVector3::Up()) * tVector3::Look();
+      // The axes cross, so push them apart along the normal to
+      // both. Not random, so the result doesn't depend on the order
+      // that pairs get tested in.
+      delta = Cross(oldSeg0.GetDelta(), oldSeg1.GetDelta()).NormaliseSafe(tVector3::Look());
     }
     tVector3 worldPos = pos1 + 
       (oldCapsule1.GetRadius() - 0.5f * depth) * delta;
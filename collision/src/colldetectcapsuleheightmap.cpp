@@ -9,6 +9,7 @@
 #include "colldetectcapsuleheightmap.hpp"
 #include "capsule.hpp"
 #include "heightmap.hpp"
+#include "aabox.hpp"
 #include "mathsmisc.hpp"
 #include "body.hpp"
 
@@ -50,6 +51,16 @@ void tCollDetectCapsuleHeightmap::CollDetect(const tCollDetectInfo &infoOrig,
 
   const tHeightmap & oldHeightmap = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetHeightmap();
   const tHeightmap & newHeightmap = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetHeightmap();
+
+  // The ends are checked at the old and new positions, so both have
+  // to be clear of the highest point underneath
+  tAABox capsuleBox;
+  capsuleBox.AddCapsule(oldCapsule);
+  capsuleBox.AddCapsule(newCapsule);
+  tScalar hMin, hMax;
+  newHeightmap.GetHeightRange(hMin, hMax, capsuleBox);
+  if (capsuleBox.GetMinPos().z > hMax + collTolerance)
+    return;
       
   tFixedVector<tCollPointInfo, 2> pts;
   tVector3 averageNormal(0.0f);
@@ -10,7 +10,9 @@
 #include "colldetectspherestaticmesh.hpp"
 #include "capsule.hpp"
 #include "trianglemesh.hpp"
+#include "collisionscratch.hpp"
 #include "mathsmisc.hpp"
+#include "fixedvector.hpp"
 #include "distance.hpp"
 #include "body.hpp"
 
@@ -41,13 +43,13 @@ void tCollDetectCapsuleStaticMesh::CollDetectCapsuleStaticMeshOverlap(const tCap
   tScalar capsuleTolR = collTolerance + newCapsule.GetRadius();
   tScalar capsuleTolR2 = Sq(capsuleTolR);
 
-  static std::vector<tCollPointInfo> collPts;
-  collPts.resize(0);
+  tFixedVector<tCollPointInfo, tCollisionInfo::MAX_COLLISION_POINTS> collPts;
+  collPts.Clear();
   tVector3 collNormal(0.0f);
 
   tAABox capsuleBox(true);
   capsuleBox.AddCapsule(newCapsule);
-  static std::vector<unsigned> potentialTriangles;
+  tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
   const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, capsuleBox);
 
   for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
@@ -84,18 +86,24 @@ void tCollDetectCapsuleStaticMesh::CollDetectCapsuleStaticMeshOverlap(const tCap
       tVector3 collisionN = d2 > SCALAR_TINY ? 
         (oldSeg.GetPoint(tS) - pt).GetNormalisedSafe() : 
         meshTriangle.GetPlane().GetN();
-      collPts.push_back(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth)) ;
+      // internal and concave edges/points are covered by the
+      // neighbouring triangles
+      if (!mesh.IsContactNormalValid(potentialTriangles[iTriangle], collisionN))
+        continue;
+      pt = mesh.PointToWorld(pt);
+      collPts.PushBack(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth)) ;
       collNormal += collisionN;
     }
   }
-  if (!collPts.empty())
+  if (!collPts.Empty())
   {
+    collNormal = mesh.DirToWorld(collNormal);
     collNormal.NormaliseSafe();
     collisionFunctor.CollisionNotify(
       info,
       collNormal,
       &collPts[0],
-      collPts.size());
+      collPts.Size());
   }
 }
 
@@ -112,10 +120,20 @@ void tCollDetectCapsuleStaticMesh::CollDetectOverlap(const tCollDetectInfo &info
   const tCapsule & newCapsule = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetCapsule();
 
   // todo - proper swept test
-  // note - mesh is static and its triangles are in world space
-  const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
-
-  CollDetectCapsuleStaticMeshOverlap(oldCapsule, newCapsule, mesh, info, collTolerance, collisionFunctor);
+  const tTriangleMesh & oldMesh = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & newMesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+
+  // work in mesh space - each capsule relative to the mesh at the
+  // same time
+  tTransform3 t;
+  tCapsule oldMeshCapsule(oldCapsule);
+  oldCapsule.GetTransform(t);
+  oldMeshCapsule.SetTransform(oldMesh.TransformToMesh(t));
+  tCapsule newMeshCapsule(newCapsule);
+  newCapsule.GetTransform(t);
+  newMeshCapsule.SetTransform(newMesh.TransformToMesh(t));
+
+  CollDetectCapsuleStaticMeshOverlap(oldMeshCapsule, newMeshCapsule, oldMesh, info, collTolerance, collisionFunctor);
 }
 
 //====================================================================
@@ -163,10 +181,20 @@ void tCollDetectCapsuleStaticMesh::CollDetectSweep(const tCollDetectInfo &info,
   const tCapsule & newCapsule = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetCapsule();
 
   // todo - proper swept test
-  // note - mesh is static and its triangles are in world space
-  const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
-
-  CollDetectCapsuleStaticMeshSweep(oldCapsule, newCapsule, mesh, info, collTolerance, collisionFunctor);
+  const tTriangleMesh & oldMesh = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & newMesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+
+  // work in mesh space - each capsule relative to the mesh at the
+  // same time
+  tTransform3 t;
+  tCapsule oldMeshCapsule(oldCapsule);
+  oldCapsule.GetTransform(t);
+  oldMeshCapsule.SetTransform(oldMesh.TransformToMesh(t));
+  tCapsule newMeshCapsule(newCapsule);
+  newCapsule.GetTransform(t);
+  newMeshCapsule.SetTransform(newMesh.TransformToMesh(t));
+
+  CollDetectCapsuleStaticMeshSweep(oldMeshCapsule, newMeshCapsule, oldMesh, info, collTolerance, collisionFunctor);
 }
 
 //====================================================================
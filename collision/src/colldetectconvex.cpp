@@ -0,0 +1,306 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvex.cpp 
+//                     
+//==============================================================
+#include "colldetectconvex.hpp"
+#include "mathsmisc.hpp"
+#include "fixedvector.hpp"
+#include "body.hpp"
+
+using namespace std;
+using namespace JigLib;
+
+enum {MAX_FEATURE_PTS = 32, MAX_CLIP_PTS = 64};
+
+//==============================================================
+// tCollDetectConvex
+//==============================================================
+tCollDetectConvex::tCollDetectConvex(const std::string & name, unsigned primType0, unsigned primType1)
+  :
+  tCollDetectFunctor(name, primType0, primType1)
+{
+}
+
+//==============================================================
+// SwapPoints
+//==============================================================
+static inline void SwapPoints(tVector3 * pts, tScalar * depths, unsigned i, unsigned j)
+{
+  Swap(pts[i], pts[j]);
+  Swap(depths[i], depths[j]);
+}
+
+//==============================================================
+// ReduceContactPoints
+//==============================================================
+unsigned JigLib::ReduceContactPoints(tVector3 * pts, tScalar * depths, unsigned numPts, unsigned maxPts)
+{
+  Assert(maxPts <= 4);
+  if (numPts <= maxPts)
+    return numPts;
+  if (maxPts == 0)
+    return 0;
+  unsigned i, best;
+
+  // deepest
+  best = 0;
+  for (i = 1 ; i < numPts ; ++i)
+  {
+    if (depths[i] > depths[best])
+      best = i;
+  }
+  SwapPoints(pts, depths, 0, best);
+  if (maxPts == 1)
+    return 1;
+
+  // furthest from that
+  best = 1;
+  for (i = 2 ; i < numPts ; ++i)
+  {
+    if ((pts[i] - pts[0]).GetLengthSq() > (pts[best] - pts[0]).GetLengthSq())
+      best = i;
+  }
+  SwapPoints(pts, depths, 1, best);
+  if (maxPts == 2)
+    return 2;
+
+  // biggest triangle
+  best = 2;
+  tScalar bestArea = -SCALAR(1.0f);
+  for (i = 2 ; i < numPts ; ++i)
+  {
+    tScalar area = Cross(pts[i] - pts[0], pts[1] - pts[0]).GetLengthSq();
+    if (area > bestArea)
+    {
+      bestArea = area;
+      best = i;
+    }
+  }
+  SwapPoints(pts, depths, 2, best);
+  if (maxPts == 3)
+    return 3;
+
+  // the one that adds the most area - points inside the triangle
+  // don't add anything
+  best = 3;
+  bestArea = -SCALAR(1.0f);
+  for (i = 3 ; i < numPts ; ++i)
+  {
+    tScalar area =
+      Cross(pts[i] - pts[0], pts[i] - pts[1]).GetLength() +
+      Cross(pts[i] - pts[1], pts[i] - pts[2]).GetLength() +
+      Cross(pts[i] - pts[2], pts[i] - pts[0]).GetLength();
+    if (area > bestArea)
+    {
+      bestArea = area;
+      best = i;
+    }
+  }
+  SwapPoints(pts, depths, 3, best);
+  return 4;
+}
+
+//==============================================================
+// GetPolygonNormal
+// Newell's method, so it copes with points that aren't quite planar
+//==============================================================
+static tVector3 GetPolygonNormal(const tVector3 * pts, unsigned numPts)
+{
+  tVector3 normal(SCALAR(0.0f));
+  for (unsigned i = 0 ; i < numPts ; ++i)
+    normal += Cross(pts[i], pts[(i + 1) % numPts]);
+  return normal.NormaliseSafe();
+}
+
+//==============================================================
+// ClipToPlane
+// Keeps the parts of the polygon (or segment, or point) in with
+// Dot(pt - planePt, planeN) <= 0. Returns the number of points left.
+//==============================================================
+static unsigned ClipToPlane(tVector3 * out, const tVector3 * in, unsigned numIn,
+                            const tVector3 & planePt, const tVector3 & planeN)
+{
+  unsigned numOut = 0;
+  if (numIn == 1)
+  {
+    if (Dot(in[0] - planePt, planeN) <= SCALAR(0.0f))
+      out[numOut++] = in[0];
+    return numOut;
+  }
+  // for a segment just look at the one edge
+  const unsigned numEdges = numIn == 2 ? 1 : numIn;
+  for (unsigned i = 0 ; i < numEdges ; ++i)
+  {
+    const tVector3 & prev = in[i == 0 ? numIn - 1 : i - 1];
+    const tVector3 & cur = in[i];
+    const tScalar distPrev = Dot(prev - planePt, planeN);
+    const tScalar distCur = Dot(cur - planePt, planeN);
+    if (numIn == 2 && distPrev <= SCALAR(0.0f))
+      out[numOut++] = prev;
+    if ((distPrev > SCALAR(0.0f)) != (distCur > SCALAR(0.0f)) && numOut < MAX_CLIP_PTS)
+      out[numOut++] = prev + (distPrev / (distPrev - distCur)) * (cur - prev);
+    if (distCur <= SCALAR(0.0f) && numOut < MAX_CLIP_PTS)
+      out[numOut++] = cur;
+  }
+  return numOut;
+}
+
+//==============================================================
+// GetConvexContactPoints
+//==============================================================
+unsigned JigLib::GetConvexContactPoints(tVector3 & N,
+                                        tVector3 * ptsOut,
+                                        tScalar * depthsOut,
+                                        const tSupportShape & shape0,
+                                        const tSupportShape & shape1,
+                                        tScalar collTolerance)
+{
+  tScalar separation;
+  tVector3 pt0, pt1;
+  if (!ConvexConvexSeparation(separation, N, pt0, pt1, shape0, shape1))
+    return 0;
+  if (separation > collTolerance)
+    return 0;
+
+  tVector3 features[2][MAX_FEATURE_PTS];
+  const unsigned numFeaturePts[2] = {
+    shape0.GetSupportFeature(features[0], MAX_FEATURE_PTS, -N),
+    shape1.GetSupportFeature(features[1], MAX_FEATURE_PTS, N)};
+
+  tVector3 pts[MAX_CLIP_PTS];
+  tScalar depths[MAX_CLIP_PTS];
+  unsigned numPts = 0;
+
+  if (numFeaturePts[0] >= 3 || numFeaturePts[1] >= 3)
+  {
+    // Use the face that's most aligned with the normal as the
+    // reference, and clip the other feature against its sides
+    tVector3 faceNormals[2] = {tVector3(SCALAR(0.0f)), tVector3(SCALAR(0.0f))};
+    tScalar alignments[2] = {-SCALAR(1.0f), -SCALAR(1.0f)};
+    unsigned i;
+    for (i = 0 ; i < 2 ; ++i)
+    {
+      if (numFeaturePts[i] < 3)
+        continue;
+      const tVector3 dir = i == 0 ? -N : N;
+      faceNormals[i] = GetPolygonNormal(features[i], numFeaturePts[i]);
+      if (Dot(faceNormals[i], dir) < SCALAR(0.0f))
+        faceNormals[i].Negate();
+      alignments[i] = Dot(faceNormals[i], dir);
+    }
+    const unsigned iRef = alignments[1] >= alignments[0] ? 1 : 0;
+    const unsigned iInc = 1 - iRef;
+    const tVector3 * ref = features[iRef];
+    const unsigned numRef = numFeaturePts[iRef];
+    const tVector3 & refN = faceNormals[iRef];
+    const tScalar radii = shape0.GetRadius() + shape1.GetRadius();
+    const tScalar incRadius = iInc == 0 ? shape0.GetRadius() : shape1.GetRadius();
+
+    tVector3 refCentre(SCALAR(0.0f));
+    for (i = 0 ; i < numRef ; ++i)
+      refCentre += ref[i];
+    refCentre /= (tScalar) numRef;
+
+    tVector3 clipped[2][MAX_CLIP_PTS];
+    unsigned numClipped = numFeaturePts[iInc];
+    for (i = 0 ; i < numClipped ; ++i)
+      clipped[0][i] = features[iInc][i];
+    unsigned iIn = 0;
+    for (i = 0 ; i < numRef && numClipped > 0 ; ++i)
+    {
+      const tVector3 & edgePt = ref[i];
+      tVector3 sideN = Cross(ref[(i + 1) % numRef] - edgePt, refN);
+      if (Dot(sideN, refCentre - edgePt) > SCALAR(0.0f))
+        sideN.Negate();
+      numClipped = ClipToPlane(clipped[1 - iIn], clipped[iIn], numClipped, edgePt, sideN);
+      iIn = 1 - iIn;
+    }
+
+    for (i = 0 ; i < numClipped ; ++i)
+    {
+      const tVector3 & pt = clipped[iIn][i];
+      const tScalar sep = Dot(pt - ref[0], refN) - radii;
+      if (sep > collTolerance)
+        continue;
+      pts[numPts] = pt - (incRadius + SCALAR(0.5f) * sep) * refN;
+      depths[numPts] = -sep;
+      ++numPts;
+    }
+    if (numPts > 0)
+      N = iRef == 1 ? refN : -refN;
+  }
+
+  if (numPts == 0)
+  {
+    // edges, points, or the clipping didn't leave anything - just
+    // use the closest points
+    ptsOut[0] = SCALAR(0.5f) * (pt0 + pt1);
+    depthsOut[0] = -separation;
+    return 1;
+  }
+
+  numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+  for (unsigned i = 0 ; i < numPts ; ++i)
+  {
+    ptsOut[i] = pts[i];
+    depthsOut[i] = depths[i];
+  }
+  return numPts;
+}
+
+//==============================================================
+// CollDetect
+//==============================================================
+void tCollDetectConvex::CollDetect(const tCollDetectInfo &infoOrig,
+                                   tScalar collTolerance,
+                                   tCollisionFunctor & collisionFunctor) const
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  // get the skins in the order that we're expecting
+  tCollDetectInfo info(infoOrig);
+  if (info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetType() == mType1)
+  {
+    Swap(info.skin0, info.skin1);
+    Swap(info.iPrim0, info.iPrim1);
+  }
+
+  tSupportShape shape0, shape1;
+  if (!shape0.SetPrimitive(*info.skin0->GetPrimitiveNewWorld(info.iPrim0)) ||
+      !shape1.SetPrimitive(*info.skin1->GetPrimitiveNewWorld(info.iPrim1)))
+    return;
+
+  tVector3 N;
+  tVector3 pts[MAX_CONVEX_CONTACT_POINTS];
+  tScalar depths[MAX_CONVEX_CONTACT_POINTS];
+  const unsigned numPts = GetConvexContactPoints(N, pts, depths, shape0, shape1, collTolerance);
+  if (numPts == 0)
+    return;
+
+  const tVector3& body0OldPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& body1OldPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& body0NewPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetPosition() : tVector3::Zero();
+  const tVector3& body1NewPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetPosition() : tVector3::Zero();
+
+  // the depths are for the new positions - estimate the old ones
+  const tVector3 bodyDelta = (body0NewPos - body0OldPos) - (body1NewPos - body1OldPos);
+  const tScalar bodyDeltaLen = Dot(bodyDelta, N);
+
+  tFixedVector<tCollPointInfo, MAX_CONVEX_CONTACT_POINTS> collPts;
+  collPts.Clear();
+  for (unsigned i = 0 ; i < numPts ; ++i)
+  {
+    collPts.PushBack(tCollPointInfo(pts[i] - body0NewPos,
+                                    pts[i] - body1NewPos,
+                                    depths[i] + bodyDeltaLen));
+  }
+
+  collisionFunctor.CollisionNotify(
+    info,
+    N,
+    &collPts[0],
+    collPts.Size());
+}
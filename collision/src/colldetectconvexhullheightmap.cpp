@@ -0,0 +1,102 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullheightmap.cpp 
+//                     
+//==============================================================
+#include "colldetectconvexhullheightmap.hpp"
+#include "colldetectconvex.hpp"
+#include "convexhull.hpp"
+#include "mathsmisc.hpp"
+#include "fixedvector.hpp"
+#include "heightmap.hpp"
+#include "body.hpp"
+
+using namespace std;
+using namespace JigLib;
+
+enum {MAX_HULL_HEIGHTMAP_PTS = 32};
+
+//==============================================================
+// tCollDetectConvexHullHeightmap
+//==============================================================
+tCollDetectConvexHullHeightmap::tCollDetectConvexHullHeightmap() :
+tCollDetectFunctor("ConvexHullHeightmap", tPrimitive::CONVEXHULL, tPrimitive::HEIGHTMAP)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+}
+
+//==============================================================
+// CollDetect
+//==============================================================
+void tCollDetectConvexHullHeightmap::CollDetect(const tCollDetectInfo &infoOrig,
+                                                tScalar collTolerance,
+                                                tCollisionFunctor & collisionFunctor) const
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  // get the skins in the order that we're expecting
+  tCollDetectInfo info(infoOrig);
+  if (info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetType() == mType1)
+  {
+    Swap(info.skin0, info.skin1); 
+    Swap(info.iPrim0, info.iPrim1);
+  }
+
+  const tVector3& body0Pos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& body1Pos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
+
+  // todo - proper swept test
+  const tConvexHull & oldHull = info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetConvexHull();
+  const tConvexHull & newHull = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetConvexHull();
+
+  const tHeightmap & oldHeightmap = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetHeightmap();
+  const tHeightmap & newHeightmap = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetHeightmap();
+
+  // quick check that there's something under the hull that's high
+  // enough to touch it
+  tScalar hMin, hMax;
+  newHeightmap.GetHeightRange(hMin, hMax, newHull.GetBoundingBox());
+  if (newHull.GetBoundingBox().GetMinPos().z > hMax + collTolerance)
+    return;
+
+  tVector3 pts[MAX_HULL_HEIGHTMAP_PTS];
+  tScalar depths[MAX_HULL_HEIGHTMAP_PTS];
+  unsigned numPts = 0;
+  tVector3 collNormal(0.0f);
+
+  const unsigned numVertices = newHull.GetNumVertices();
+  for (unsigned i = 0 ; i < numVertices ; ++i)
+  {
+    tScalar newDist;
+    tVector3 normal;
+    newHeightmap.GetHeightAndNormal(newDist, normal, newHull.GetVertex(i));
+    
+    if (newDist < collTolerance)
+    {
+      if (numPts == MAX_HULL_HEIGHTMAP_PTS)
+        numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+      const tVector3 & oldPt = oldHull.GetVertex(i);
+      pts[numPts] = oldPt;
+      depths[numPts] = -oldHeightmap.GetHeight(oldPt);
+      ++numPts;
+      collNormal += normal;
+    }
+  }
+  if (numPts == 0)
+    return;
+  numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+
+  tFixedVector<tCollPointInfo, MAX_CONVEX_CONTACT_POINTS> collPts;
+  collPts.Clear();
+  for (unsigned i = 0 ; i < numPts ; ++i)
+    collPts.PushBack(tCollPointInfo(pts[i] - body0Pos, pts[i] - body1Pos, depths[i]));
+
+  collNormal.NormaliseSafe();
+  collisionFunctor.CollisionNotify(
+    info,
+    collNormal,
+    &collPts[0],
+    collPts.Size());
+}
@@ -0,0 +1,95 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullplane.cpp 
+//                     
+//==============================================================
+#include "colldetectconvexhullplane.hpp"
+#include "colldetectconvex.hpp"
+#include "convexhull.hpp"
+#include "mathsmisc.hpp"
+#include "fixedvector.hpp"
+#include "body.hpp"
+#include "distance.hpp"
+
+using namespace std;
+using namespace JigLib;
+
+enum {MAX_HULL_PLANE_PTS = 32};
+
+//==============================================================
+// tCollDetectConvexHullPlane
+//==============================================================
+tCollDetectConvexHullPlane::tCollDetectConvexHullPlane()
+  :
+  tCollDetectFunctor("ConvexHullPlane", tPrimitive::CONVEXHULL, tPrimitive::PLANE)
+{
+}
+
+//==============================================================
+// CollDetect
+//==============================================================
+void tCollDetectConvexHullPlane::CollDetect(const tCollDetectInfo &infoOrig,
+                                            tScalar collTolerance,
+                                            tCollisionFunctor & collisionFunctor) const
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  // get the skins in the order that we're expecting
+  tCollDetectInfo info(infoOrig);
+  if (info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetType() == mType1)
+  {
+    Swap(info.skin0, info.skin1); 
+    Swap(info.iPrim0, info.iPrim1);
+  }
+
+  const tVector3& body0Pos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& body1Pos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
+
+  const tConvexHull & oldHull = info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetConvexHull();
+  const tConvexHull & newHull = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetConvexHull();
+
+  const tPlane & oldPlane = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetPlane();
+  const tPlane & newPlane = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetPlane();
+
+  // quick check
+  if (PointPlaneDistance(newHull.GetVertex(newHull.GetSupportVertex(-newPlane.GetN())), newPlane) > collTolerance)
+    return;
+
+  // Test the vertices, and if there are lots of them in contact
+  // (e.g. a face with many edges) only keep a few
+  tVector3 pts[MAX_HULL_PLANE_PTS];
+  tScalar depths[MAX_HULL_PLANE_PTS];
+  unsigned numPts = 0;
+  const unsigned numVertices = newHull.GetNumVertices();
+  for (unsigned i = 0 ; i < numVertices ; ++i)
+  {
+    const tVector3 & oldPt = oldHull.GetVertex(i);
+    tScalar oldDepth = -PointPlaneDistance(oldPt, oldPlane);
+    tScalar newDepth = -PointPlaneDistance(newHull.GetVertex(i), newPlane);
+    if (Max(oldDepth, newDepth) > -collTolerance)
+    {
+      if (numPts == MAX_HULL_PLANE_PTS)
+        numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+      pts[numPts] = oldPt;
+      depths[numPts] = oldDepth;
+      ++numPts;
+    }
+  }
+  numPts = ReduceContactPoints(pts, depths, numPts, MAX_CONVEX_CONTACT_POINTS);
+
+  tFixedVector<tCollPointInfo, MAX_CONVEX_CONTACT_POINTS> collPts;
+  collPts.Clear();
+  for (unsigned i = 0 ; i < numPts ; ++i)
+    collPts.PushBack(tCollPointInfo(pts[i] - body0Pos, pts[i] - body1Pos, depths[i]));
+
+  if (!collPts.Empty())
+  {
+    collisionFunctor.CollisionNotify(
+      info,
+      oldPlane.GetN(),
+      &collPts[0],
+      collPts.Size());
+  }
+}
@@ -0,0 +1,137 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file colldetectconvexhullstaticmesh.cpp 
+//                     
+//==============================================================
+#include "colldetectconvexhullstaticmesh.hpp"
+#include "colldetectconvex.hpp"
+#include "convexhull.hpp"
+#include "mathsmisc.hpp"
+#include "fixedvector.hpp"
+#include "trianglemesh.hpp"
+#include "collisionscratch.hpp"
+#include "triangle.hpp"
+#include "distance.hpp"
+#include "body.hpp"
+
+using namespace std;
+using namespace JigLib;
+
+//==============================================================
+// tCollDetectConvexHullStaticMesh
+//==============================================================
+tCollDetectConvexHullStaticMesh::tCollDetectConvexHullStaticMesh()
+  :
+  tCollDetectFunctor("ConvexHullMesh", tPrimitive::CONVEXHULL, tPrimitive::TRIANGLEMESH)
+{
+}
+
+//====================================================================
+// CollDetectHullStaticMesh
+// Each triangle near the hull (which is in mesh space) is treated as
+// a convex shape of its own, so there's a separate collision for
+// each one
+//====================================================================
+static void CollDetectHullStaticMesh(const tConvexHull & hull,
+                                     const tTriangleMesh & mesh,
+                                     const tCollDetectInfo &info,
+                                     tScalar collTolerance,
+                                     tCollisionFunctor & collisionFunctor)
+{
+  const tVector3& hullOldPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& hullNewPos = info.skin0->GetOwner() ? info.skin0->GetOwner()->GetPosition() : tVector3::Zero();
+  const tVector3& meshOldPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetOldPosition() : tVector3::Zero();
+  const tVector3& meshNewPos = info.skin1->GetOwner() ? info.skin1->GetOwner()->GetPosition() : tVector3::Zero();
+  // the mesh might be moving too
+  const tVector3 delta = (hullNewPos - hullOldPos) - (meshNewPos - meshOldPos);
+
+  const tAABox hullBox(hull.GetBoundingBox().GetMinPos() - tVector3(collTolerance),
+                       hull.GetBoundingBox().GetMaxPos() + tVector3(collTolerance));
+  const tVector3 hullCentre = hull.GetCentre();
+  const tScalar hullRadius = hullBox.GetRadiusAboutCentre();
+
+  tSupportShape hullShape;
+  hullShape.SetPrimitive(hull);
+  tSupportShape triangleShape;
+
+  tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
+  const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, hullBox);
+
+  for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+  {
+    const tIndexedTriangle& meshTriangle = mesh.GetTriangle(potentialTriangles[iTriangle]);
+
+    // quick early test - and triangles are only solid from the front
+    tScalar dist = PointPlaneDistance(hullCentre, meshTriangle.GetPlane());
+    if (dist > hullRadius || dist < 0.0f)
+      continue;
+
+    tTriangle triangle(
+      mesh.GetVertex(meshTriangle.GetVertexIndex(0)),
+      mesh.GetVertex(meshTriangle.GetVertexIndex(1)),
+      mesh.GetVertex(meshTriangle.GetVertexIndex(2)));
+    triangleShape.SetTriangle(triangle);
+
+    tVector3 N;
+    tVector3 pts[MAX_CONVEX_CONTACT_POINTS];
+    tScalar depths[MAX_CONVEX_CONTACT_POINTS];
+    const unsigned numPts = GetConvexContactPoints(N, pts, depths, hullShape, triangleShape, collTolerance);
+    if (numPts == 0 || Dot(N, meshTriangle.GetPlane().GetN()) <= 0.0f)
+      continue;
+    N = mesh.DirToWorld(N);
+
+    // adjust the depth 
+    const tScalar deltaLen = Dot(delta, N);
+
+    tFixedVector<tCollPointInfo, MAX_CONVEX_CONTACT_POINTS> collPts;
+    collPts.Clear();
+    for (unsigned i = 0 ; i < numPts ; ++i)
+    {
+      const tVector3 pt = mesh.PointToWorld(pts[i]);
+      collPts.PushBack(tCollPointInfo(pt - hullNewPos, pt - meshNewPos, depths[i] + deltaLen));
+    }
+
+    collisionFunctor.CollisionNotify(
+      info,
+      N,
+      &collPts[0],
+      collPts.Size());
+  }
+}
+
+//====================================================================
+// CollDetect
+//====================================================================
+void tCollDetectConvexHullStaticMesh::CollDetect(const tCollDetectInfo &infoOrig,
+                                                 tScalar collTolerance,
+                                                 tCollisionFunctor & collisionFunctor) const
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  // get the skins in the order that we're expecting
+  tCollDetectInfo info(infoOrig);
+  if (info.skin0->GetPrimitiveOldWorld(info.iPrim0)->GetType() == mType1)
+  {
+    Swap(info.skin0, info.skin1); 
+    Swap(info.iPrim0, info.iPrim1);
+  }
+
+  // todo - proper swept test
+  const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+  const tConvexHull & hull = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetConvexHull();
+
+  if (!mesh.HasTransform())
+  {
+    CollDetectHullStaticMesh(hull, mesh, info, collTolerance, collisionFunctor);
+    return;
+  }
+
+  // work in mesh space
+  tTransform3 t;
+  hull.GetTransform(t);
+  tConvexHull meshHull(hull);
+  meshHull.SetTransform(mesh.TransformToMesh(t));
+  CollDetectHullStaticMesh(meshHull, mesh, info, collTolerance, collisionFunctor);
+}
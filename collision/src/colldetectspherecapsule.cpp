@@ -74,8 +74,9 @@ void tCollDetectSphereCapsule::CollDetect(const tCollDetectInfo &infoOrig,
     }
     else
     {
-      // TODO - make this not random...!
-      delta = RotationMatrix(RangedRandom(0.0f, 360.0f), tVector3::Up()) * tVector3::Look();
+      // Any direction will do - but not a random one, so the result
+      // doesn't depend on the order that pairs get tested in.
+      delta = tVector3::Look();
     }
     tVector3 worldPos = segPos + 
       (oldCapsule.GetRadius() - 0.5f * depth) * delta;
@@ -9,6 +9,7 @@
 #include "colldetectsphereheightmap.hpp"
 #include "sphere.hpp"
 #include "heightmap.hpp"
+#include "aabox.hpp"
 #include "mathsmisc.hpp"
 #include "body.hpp"
 
@@ -50,6 +51,15 @@ void tCollDetectSphereHeightmap::CollDetect(const tCollDetectInfo &infoOrig,
 
   const tHeightmap & oldHeightmap = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetHeightmap();
   const tHeightmap & newHeightmap = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetHeightmap();
+
+  // quick check that there's something under the sphere that's high
+  // enough to touch it
+  tAABox sphereBox;
+  sphereBox.AddSphere(newSphere);
+  tScalar hMin, hMax;
+  newHeightmap.GetHeightRange(hMin, hMax, sphereBox);
+  if (sphereBox.GetMinPos().z > hMax + collTolerance)
+    return;
       
   tScalar newDist;
   tVector3 normal;
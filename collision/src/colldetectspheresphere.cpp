@@ -59,8 +59,9 @@ void tCollDetectSphereSphere::CollDetect(const tCollDetectInfo &info,
     }
     else
     {
-      // TODO - make this not random...!
-      oldDelta = RotationMatrix(RangedRandom(0.0f, 360.0f), tVector3::Up()) * tVector3::Look();
+      // Any direction will do - but not a random one, so the result
+      // doesn't depend on the order that pairs get tested in.
+      oldDelta = tVector3::Look();
     }
     tVector3 worldPos = oldSphere1.GetPos() + 
       (oldSphere1.GetRadius() - 0.5f * depth) * oldDelta;
@@ -9,7 +9,9 @@
 #include "colldetectspherestaticmesh.hpp"
 #include "sphere.hpp"
 #include "trianglemesh.hpp"
+#include "collisionscratch.hpp"
 #include "mathsmisc.hpp"
+#include "fixedvector.hpp"
 #include "distance.hpp"
 #include "intersection.hpp"
 #include "body.hpp"
@@ -42,13 +44,13 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshOverlap(const tSpher
   tScalar sphereTolR = collTolerance + newSphere.GetRadius();
   tScalar sphereTolR2 = Sq(sphereTolR);
 
-  static std::vector<tCollPointInfo> collPts;
-  collPts.resize(0);
+  tFixedVector<tCollPointInfo, tCollisionInfo::MAX_COLLISION_POINTS> collPts;
+  collPts.Clear();
   tVector3 collNormal(0.0f);
 
   tAABox sphereBox(true);
   sphereBox.AddSphere(newSphere);
-  static std::vector<unsigned> potentialTriangles;
+  tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
   const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, sphereBox);
 
   for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
@@ -74,20 +76,25 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshOverlap(const tSpher
       tScalar depth = oldSphere.GetRadius() - dist;
       tVector3 collisionN = dist > SCALAR_TINY ? 
         (oldSphere.GetPos() - triangle.GetPoint(s, t)).GetNormalisedSafe() : triangle.GetNormal();
+      // internal and concave edges/points are covered by the
+      // neighbouring triangles
+      if (!mesh.IsContactNormalValid(potentialTriangles[iTriangle], collisionN))
+        continue;
       // since impulse get applied at the old position
-      tVector3 pt = oldSphere.GetPos() - oldSphere.GetRadius() * collisionN;
-      collPts.push_back(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth)) ;
+      tVector3 pt = mesh.PointToWorld(oldSphere.GetPos() - oldSphere.GetRadius() * collisionN);
+      collPts.PushBack(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth)) ;
       collNormal += collisionN;
     }
   }
-  if (!collPts.empty())
+  if (!collPts.Empty())
   {
+    collNormal = mesh.DirToWorld(collNormal);
     collNormal.NormaliseSafe();
     collisionFunctor.CollisionNotify(
       info,
       collNormal,
       &collPts[0],
-      collPts.size());
+      collPts.Size());
   }
 }
 
@@ -106,10 +113,15 @@ void tCollDetectSphereStaticMesh::CollDetectOverlap(const tCollDetectInfo &info,
   const tSphere & newSphere = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetSphere();
 
   // todo - proper swept test
-  // note - mesh is static and its triangles are in world space
-  const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & oldMesh = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & newMesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+
+  // work in mesh space - each sphere relative to the mesh at the same
+  // time
+  const tSphere oldMeshSphere(oldMesh.PointToMesh(oldSphere.GetPos()), oldSphere.GetRadius());
+  const tSphere newMeshSphere(newMesh.PointToMesh(newSphere.GetPos()), newSphere.GetRadius());
 
-  CollDetectSphereStaticMeshOverlap(oldSphere, newSphere, mesh, info, collTolerance, collisionFunctor);
+  CollDetectSphereStaticMeshOverlap(oldMeshSphere, newMeshSphere, oldMesh, info, collTolerance, collisionFunctor);
 }
 
 //====================================================================
@@ -136,15 +148,15 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshSweep(const tSphere&
     tScalar sphereTolR = collTolerance + oldSphere.GetRadius();
     tScalar sphereTolR2 = Sq(sphereTolR);
 
-    static std::vector<tCollPointInfo> collPts;
-    collPts.resize(0);
+    tFixedVector<tCollPointInfo, tCollisionInfo::MAX_COLLISION_POINTS> collPts;
+    collPts.Clear();
     tVector3 collNormal(0.0f);
 
     tAABox sphereBox(true);
     sphereBox.AddSphere(oldSphere);
     sphereBox.AddSphere(newSphere);
 
-    static std::vector<unsigned> potentialTriangles;
+    tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
     const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, sphereBox);
 
     for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
@@ -173,9 +185,13 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshSweep(const tSphere&
         tScalar depth = oldSphere.GetRadius() - dist;
         tVector3 triangleN = triangle.GetNormal();
         tVector3 collisionN = dist > SCALAR_TINY ? (oldSphere.GetPos() - triangle.GetPoint(s, t)).GetNormalisedSafe() : triangleN;
+        // internal and concave edges/points are covered by the
+        // neighbouring triangles
+        if (!mesh.IsContactNormalValid(potentialTriangles[iTriangle], collisionN))
+          continue;
         // since impulse gets applied at the old position
-        tVector3 pt = oldSphere.GetPos() - oldSphere.GetRadius() * collisionN;
-        collPts.push_back(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth));
+        tVector3 pt = mesh.PointToWorld(oldSphere.GetPos() - oldSphere.GetRadius() * collisionN);
+        collPts.PushBack(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth));
         collNormal += collisionN;
       }
       else if (distToCentreNew < distToCentreOld)
@@ -187,7 +203,8 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshSweep(const tSphere&
         if (SweptSphereTriangleIntersection(pt, N, depth, 
                                             oldSphere, newSphere, triangle, 
                                             &distToCentreOld, &distToCentreNew, 
-                                            EDGE_ALL, CORNER_ALL))
+                                            (tEdgesToTest) meshTriangle.GetConvexEdges(), 
+                                            (tCornersToTest) meshTriangle.GetConvexPoints()))
         {
           // collision point etc must be relative to the old position because that's
           //where the impulses are applied
@@ -196,20 +213,21 @@ void tCollDetectSphereStaticMesh::CollDetectSphereStaticMeshSweep(const tSphere&
           tVector3 triangleN = triangle.GetNormal();
           tVector3 collisionN = dist > SCALAR_TINY ? (oldSphere.GetPos() - triangle.GetPoint(s, t)).GetNormalisedSafe() : triangleN;
           // since impulse gets applied at the old position
-          tVector3 pt = oldSphere.GetPos() - oldSphere.GetRadius() * collisionN;
-          collPts.push_back(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth));
+          tVector3 pt = mesh.PointToWorld(oldSphere.GetPos() - oldSphere.GetRadius() * collisionN);
+          collPts.PushBack(tCollPointInfo(pt - body0Pos, pt - body1Pos, depth));
           collNormal += collisionN;
         }
       }
     }
-    if (!collPts.empty())
+    if (!collPts.Empty())
     {
+      collNormal = mesh.DirToWorld(collNormal);
       collNormal.NormaliseSafe();
       collisionFunctor.CollisionNotify(
         info,
         collNormal,
         &collPts[0],
-        collPts.size());
+        collPts.Size());
     }
   }
 }
@@ -230,10 +248,15 @@ void tCollDetectSphereStaticMesh::CollDetectSweep(const tCollDetectInfo &info,
   const tSphere & newSphere = info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetSphere();
 
   // todo - proper swept test
-  // note - mesh is static and its triangles are in world space
-  const tTriangleMesh & mesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & oldMesh = info.skin1->GetPrimitiveOldWorld(info.iPrim1)->GetTriangleMesh();
+  const tTriangleMesh & newMesh = info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetTriangleMesh();
+
+  // work in mesh space - each sphere relative to the mesh at the same
+  // time
+  const tSphere oldMeshSphere(oldMesh.PointToMesh(oldSphere.GetPos()), oldSphere.GetRadius());
+  const tSphere newMeshSphere(newMesh.PointToMesh(newSphere.GetPos()), newSphere.GetRadius());
 
-  CollDetectSphereStaticMeshSweep(oldSphere, newSphere, mesh, info, collTolerance, collisionFunctor);
+  CollDetectSphereStaticMeshSweep(oldMeshSphere, newMeshSphere, oldMesh, info, collTolerance, collisionFunctor);
 }
 
 
@@ -9,17 +9,18 @@
 #include "collisioninfo.hpp"
 #include "collisionsystem.hpp"
 
+#include <new>
+
 
 using namespace std;
 using namespace JigLib;
 
-vector<tCollisionInfo *> tCollisionInfo::mFreeInfos;
-
 //==============================================================
 // Init
 //==============================================================
 void tCollisionInfo::Init(const tCollDetectInfo &info,
                           const tVector3 & dirToBody0,
+                          tCollPointInfo * pointStorage,
                           const tCollPointInfo * pointInfos,
                           unsigned numPointInfos)
 {
@@ -47,51 +48,26 @@ void tCollisionInfo::Init(const tCollDetectInfo &info,
     mMatPairProperties = matTable.GetPairProperties(ID0, ID1); 
   }
   
-  if (numPointInfos > MAX_COLLISION_POINTS)
-    numPointInfos = MAX_COLLISION_POINTS;
-  mPointInfo.Resize(numPointInfos);
+  mPointInfo = pointStorage;
+  mNumPointInfos = numPointInfos;
   for (unsigned i = 0 ; i < numPointInfos ; ++i)
     mPointInfo[i] = pointInfos[i];
 }
 
 //==============================================================
-// Destroy
+// Create
 //==============================================================
-void tCollisionInfo::Destroy()
-{
-  TRACE_METHOD_ONLY(MULTI_FRAME_2);
-  mSkinInfo.skin0 = (tCollisionSkin *) 0xDEADBEAF;
-  mSkinInfo.skin1 = mSkinInfo.skin0;
-}
-
-//==============================================================
-// GetCollisionInfo
-//==============================================================
-tCollisionInfo & tCollisionInfo::GetCollisionInfo(const tCollDetectInfo &info,
-                                                  const tVector3 & dirToBody0,
-                                                  const tCollPointInfo * pointInfos,
-                                                  unsigned numPointInfos)
+tCollisionInfo & tCollisionInfo::Create(tFrameArena & arena,
+                                        const tCollDetectInfo &info,
+                                        const tVector3 & dirToBody0,
+                                        const tCollPointInfo * pointInfos,
+                                        unsigned numPointInfos)
 {
   TRACE_FUNCTION_ONLY(MULTI_FRAME_2);
-  if (mFreeInfos.empty())
-    mFreeInfos.push_back(new tCollisionInfo);
-  tCollisionInfo *collInfo = mFreeInfos.back();
-  Assert(0 != collInfo);
-  collInfo->Init(info, dirToBody0, pointInfos, numPointInfos);
-  mFreeInfos.pop_back();
+  if (numPointInfos > MAX_COLLISION_POINTS)
+    numPointInfos = MAX_COLLISION_POINTS;
+  tCollisionInfo *collInfo = new (arena.Alloc<tCollisionInfo>()) tCollisionInfo;
+  tCollPointInfo *points = arena.Alloc<tCollPointInfo>(numPointInfos);
+  collInfo->Init(info, dirToBody0, points, pointInfos, numPointInfos);
   return *collInfo;
 }
-
-//==============================================================
-// FreeCollisionInfo
-//==============================================================
-void tCollisionInfo::FreeCollisionInfo(tCollisionInfo & info)
-{
-  TRACE_FUNCTION_ONLY(MULTI_FRAME_2);
-  info.Destroy();
-  mFreeInfos.push_back(&info);
-}
-
-
-
-
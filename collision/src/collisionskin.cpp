@@ -9,6 +9,8 @@
 #include "collisionskin.hpp"
 #include "collisionsystem.hpp"
 #include "body.hpp"
+#include "segmentpacket.hpp"
+#include "intersection.hpp"
 
 using namespace JigLib;
 
@@ -164,6 +166,91 @@ bool tCollisionSkin::SegmentIntersect(tScalar & frac,
     return false;
 }
 
+//==============================================================
+// ShapeCast
+//==============================================================
+bool tCollisionSkin::ShapeCast(tScalar & frac,
+                               tVector3 & pos,
+                               tVector3 & normal,
+                               const tPrimitive & shape,
+                               const tVector3 & delta) const
+{
+  frac = SCALAR_HUGE;
+  tScalar thisFrac;
+  tVector3 thisPos, thisNormal;
+  for (unsigned iPrim = mPrimitivesNewWorld.size() ; iPrim-- != 0 ; )
+  {
+    if (SweptPrimitiveIntersection(thisFrac, thisPos, thisNormal, 
+                                   shape, delta, *mPrimitivesNewWorld[iPrim]) &&
+        thisFrac < frac)
+    {
+      frac = thisFrac;
+      pos = thisPos;
+      normal = thisNormal;
+    }
+  }
+  return frac <= 1.0f;
+}
+
+//==============================================================
+// SegmentIntersectBatch
+// Same as SegmentIntersect, but passing groups of segments to each
+// primitive
+//==============================================================
+unsigned tCollisionSkin::SegmentIntersectBatch(tScalar * fracs,
+                                               tVector3 * positions,
+                                               tVector3 * normals,
+                                               const tSegment * segs,
+                                               unsigned numSegs) const
+{
+  const unsigned maxSegs = tSegmentPacket::SIZE;
+  tSegment segCopies[maxSegs];
+  tScalar thisSegLenRelToOrig[maxSegs];
+  tScalar thisFracs[maxSegs];
+  tVector3 thisPositions[maxSegs];
+  tVector3 thisNormals[maxSegs];
+
+  unsigned numHits = 0;
+  for (unsigned iFirst = 0 ; iFirst < numSegs ; iFirst += maxSegs)
+  {
+    const unsigned num = Min(numSegs - iFirst, maxSegs);
+    unsigned iSeg;
+    for (iSeg = 0 ; iSeg < num ; ++iSeg)
+    {
+      fracs[iFirst + iSeg] = SCALAR_HUGE;
+      thisSegLenRelToOrig[iSeg] = 1.0f;
+      segCopies[iSeg] = segs[iFirst + iSeg];
+    }
+
+    for (unsigned iPrim = mPrimitivesNewWorld.size() ; iPrim-- != 0 ; )
+    {
+      if (0 == mPrimitivesNewWorld[iPrim]->SegmentIntersectBatch(
+            thisFracs, thisPositions, thisNormals, segCopies, num))
+        continue;
+      for (iSeg = 0 ; iSeg < num ; ++iSeg)
+      {
+        if (thisFracs[iSeg] == SCALAR_HUGE)
+          continue;
+        tScalar & frac = fracs[iFirst + iSeg];
+        frac = thisFracs[iSeg] * thisSegLenRelToOrig[iSeg];
+        segCopies[iSeg].mDelta *= thisFracs[iSeg];
+        thisSegLenRelToOrig[iSeg] *= frac;
+        positions[iFirst + iSeg] = thisPositions[iSeg];
+        normals[iFirst + iSeg] = thisNormals[iSeg];
+      }
+    }
+
+    for (iSeg = 0 ; iSeg < num ; ++iSeg)
+    {
+      if (fracs[iFirst + iSeg] <= 1.0f)
+        ++numHits;
+      else
+        fracs[iFirst + iSeg] = SCALAR_HUGE;
+    }
+  }
+  return numHits;
+}
+
 //==============================================================
 // ~tCollisionSkin
 //==============================================================
@@ -8,15 +8,79 @@
 //==============================================================
 #include "collisionsystem.hpp"
 #include "jiglib.hpp"
+#include "collisionscratch.hpp"
 
 using namespace JigLib;
 using namespace std;
 
+//==============================================================
+// tContactBuffer
+// Stands in for the user's functor on the worker threads, keeping
+// the results so they can be passed on afterwards.
+//==============================================================
+class tCollisionSystem::tContactBuffer : public tCollisionFunctor
+{
+public:
+  struct tContact
+  {
+    tCollDetectInfo mInfo;
+    tVector3 mDirToBody0;
+    unsigned mFirstPoint;
+    unsigned mNumPoints;
+  };
+
+  void CollisionNotify(const tCollDetectInfo &collDetectInfo,
+                       const tVector3 & dirToBody0,
+                       const tCollPointInfo * pointInfos,
+                       unsigned numPointInfos)
+  {
+    tContact contact;
+    contact.mInfo = collDetectInfo;
+    contact.mDirToBody0 = dirToBody0;
+    contact.mFirstPoint = mPoints.size();
+    contact.mNumPoints = numPointInfos;
+    mContacts.push_back(contact);
+    mPoints.insert(mPoints.end(), pointInfos, pointInfos + numPointInfos);
+  }
+
+  void Clear() {mContacts.resize(0); mPoints.resize(0);}
+
+  vector<tContact> mContacts;
+  vector<tCollPointInfo> mPoints;
+};
+
+//==============================================================
+// tNarrowPhaseJob
+//==============================================================
+class tCollisionSystem::tNarrowPhaseJob : public tThreadJob
+{
+public:
+  tNarrowPhaseJob(vector<tPrimitivePair> & pairs,
+                  vector<tContactBuffer *> & buffers,
+                  tScalar collTolerance)
+    : mPairs(pairs), mBuffers(buffers), mCollTolerance(collTolerance) {}
+
+  void Run(unsigned iTask, unsigned iThread)
+  {
+    tPrimitivePair & pair = mPairs[iTask];
+    tContactBuffer & buffer = *mBuffers[iThread];
+    pair.mThread = iThread;
+    pair.mFirstContact = buffer.mContacts.size();
+    pair.mFunctor->CollDetect(pair.mInfo, mCollTolerance, buffer);
+    pair.mNumContacts = buffer.mContacts.size() - pair.mFirstContact;
+  }
+
+private:
+  vector<tPrimitivePair> & mPairs;
+  vector<tContactBuffer *> & mBuffers;
+  tScalar mCollTolerance;
+};
+
 //==============================================================
 // tCollisionSystem
 //==============================================================
 tCollisionSystem::tCollisionSystem()
-  : mUseSweepTests(false)
+  : mUseSweepTests(false), mThreadPool(0), mGatheringPairs(false)
 {
   TRACE_METHOD_ONLY(ONCE_1);
   
@@ -35,6 +99,13 @@ tCollisionSystem::tCollisionSystem()
   static tCollDetectSphereStaticMesh sphereStaticMeshCollDetector;
   static tCollDetectCapsuleStaticMesh capsuleStaticMeshCollDetector;
   static tCollDetectBoxStaticMesh boxStaticMeshCollDetector;
+  static tCollDetectConvex convexHullBoxCollDetector("ConvexHullBox", tPrimitive::CONVEXHULL, tPrimitive::BOX);
+  static tCollDetectConvex convexHullCapsuleCollDetector("ConvexHullCapsule", tPrimitive::CONVEXHULL, tPrimitive::CAPSULE);
+  static tCollDetectConvex convexHullConvexHullCollDetector("ConvexHullConvexHull", tPrimitive::CONVEXHULL, tPrimitive::CONVEXHULL);
+  static tCollDetectConvex convexHullSphereCollDetector("ConvexHullSphere", tPrimitive::CONVEXHULL, tPrimitive::SPHERE);
+  static tCollDetectConvexHullHeightmap convexHullHeightmapCollDetector;
+  static tCollDetectConvexHullPlane convexHullPlaneCollDetector;
+  static tCollDetectConvexHullStaticMesh convexHullStaticMeshCollDetector;
   
   RegisterCollDetectFunctor(boxBoxCollDetector);
   RegisterCollDetectFunctor(boxHeightmapCollDetector);
@@ -51,6 +122,13 @@ tCollisionSystem::tCollisionSystem()
   RegisterCollDetectFunctor(sphereStaticMeshCollDetector);
   RegisterCollDetectFunctor(capsuleStaticMeshCollDetector);
   RegisterCollDetectFunctor(boxStaticMeshCollDetector);
+  RegisterCollDetectFunctor(convexHullBoxCollDetector);
+  RegisterCollDetectFunctor(convexHullCapsuleCollDetector);
+  RegisterCollDetectFunctor(convexHullConvexHullCollDetector);
+  RegisterCollDetectFunctor(convexHullSphereCollDetector);
+  RegisterCollDetectFunctor(convexHullHeightmapCollDetector);
+  RegisterCollDetectFunctor(convexHullPlaneCollDetector);
+  RegisterCollDetectFunctor(convexHullStaticMeshCollDetector);
 }
 
 //==============================================================
@@ -59,6 +137,8 @@ tCollisionSystem::tCollisionSystem()
 tCollisionSystem::~tCollisionSystem()
 {
   TRACE_METHOD_ONLY(ONCE_1);
+  for (unsigned i = 0 ; i < mContactBuffers.size() ; ++i)
+    delete mContactBuffers[i];
 }
 
 //==============================================================
@@ -90,3 +170,262 @@ void tCollisionSystem::RegisterCollDetectFunctor(tCollDetectFunctor & f)
 }
 
 
+
+//==============================================================
+// SegmentIntersectBatch
+//==============================================================
+unsigned tCollisionSystem::SegmentIntersectBatch(
+  tScalar * fracs,
+  tCollisionSkin ** skins,
+  tVector3 * positions,
+  tVector3 * normals,
+  const tSegment * segs,
+  unsigned numSegs,
+  const tCollisionSkinPredicate1 * const * collisionPredicates)
+{
+  unsigned numHits = 0;
+  for (unsigned iSeg = 0 ; iSeg < numSegs ; ++iSeg)
+  {
+    if (SegmentIntersect(fracs[iSeg], skins[iSeg], positions[iSeg], normals[iSeg], segs[iSeg],
+                         collisionPredicates ? collisionPredicates[iSeg] : 0))
+    {
+      ++numHits;
+    }
+    else
+    {
+      fracs[iSeg] = SCALAR_HUGE;
+      skins[iSeg] = 0;
+    }
+  }
+  return numHits;
+}
+
+//==============================================================
+// GetSweptBoxEntryFrac
+// Returns the fraction of delta when a box (centre and half size)
+// first reaches another box - 0 if it starts overlapping, and
+// SCALAR_HUGE if it misses.
+//==============================================================
+static tScalar GetSweptBoxEntryFrac(const tVector3 & centre,
+                                    const tVector3 & halfSize,
+                                    const tVector3 & delta,
+                                    const tAABox & box)
+{
+  tScalar tEnter = SCALAR(0.0f);
+  tScalar tExit = SCALAR(1.0f);
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    const tScalar minPos = box.GetMinPos()[i] - halfSize[i];
+    const tScalar maxPos = box.GetMaxPos()[i] + halfSize[i];
+    if (Abs(delta[i]) < SCALAR_TINY)
+    {
+      if (centre[i] < minPos || centre[i] > maxPos)
+        return SCALAR_HUGE;
+      continue;
+    }
+    const tScalar invDelta = SCALAR(1.0f) / delta[i];
+    tScalar t0 = (minPos - centre[i]) * invDelta;
+    tScalar t1 = (maxPos - centre[i]) * invDelta;
+    if (t0 > t1)
+      Swap(t0, t1);
+    tEnter = Max(tEnter, t0);
+    tExit = Min(tExit, t1);
+    if (tEnter > tExit)
+      return SCALAR_HUGE;
+  }
+  return tEnter;
+}
+
+//==============================================================
+// ShapeCast
+//==============================================================
+bool tCollisionSystem::ShapeCast(
+  tScalar & fracOut,
+  tCollisionSkin *& skinOut,
+  tVector3 & posOut,
+  tVector3 & normalOut,
+  const tPrimitive & shape,
+  const tVector3 & delta,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  tAABox shapeBox;
+  shapeBox.AddPrimitive(shape);
+  tAABox sweptBox(shapeBox);
+  sweptBox.Move(delta);
+  sweptBox.AddAABox(shapeBox);
+
+  tScratchVector<tCollisionSkin *> skins(tCollisionScratch::GetThreadScratch().mSkins);
+  GetSkinsOverlappingAABox(skins, sweptBox);
+
+  const tVector3 centre = shapeBox.GetCentre();
+  const tVector3 halfSize = 0.5f * shapeBox.GetSideLengths();
+
+  fracOut = SCALAR_HUGE;
+  skinOut = 0;
+
+  tScalar frac;
+  tVector3 pos;
+  tVector3 normal;
+
+  const unsigned numSkins = skins.Size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    tCollisionSkin * skin = skins[iSkin];
+    if (collisionPredicate && !collisionPredicate->ConsiderSkin(skin))
+      continue;
+    // don't bother if the skin can't be reached before the best hit so far
+    if (GetSweptBoxEntryFrac(centre, halfSize, delta, skin->GetWorldBoundingBox()) >= fracOut)
+      continue;
+    if (skin->ShapeCast(frac, pos, normal, shape, delta) && frac < fracOut)
+    {
+      fracOut = frac;
+      skinOut = skin;
+      posOut = pos;
+      normalOut = normal;
+    }
+  }
+  return skinOut != 0;
+}
+
+//==============================================================
+// QueryShapeOverlap
+//==============================================================
+unsigned tCollisionSystem::QueryShapeOverlap(
+  std::vector<tOverlapResult> & results,
+  const tPrimitive & shape,
+  const tAABox & shapeBox,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  results.resize(0);
+  tScratchVector<tCollisionSkin *> skins(tCollisionScratch::GetThreadScratch().mSkins);
+  GetSkinsOverlappingAABox(skins, shapeBox);
+
+  const unsigned numSkins = skins.Size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    tCollisionSkin * skin = skins[iSkin];
+    if (collisionPredicate && !collisionPredicate->ConsiderSkin(skin))
+      continue;
+    if (!OverlapTest(shapeBox, skin->GetWorldBoundingBox()))
+      continue;
+    const unsigned numPrims = skin->GetNumPrimitives();
+    for (unsigned iPrim = 0 ; iPrim < numPrims ; ++iPrim)
+    {
+      if (PrimitiveOverlap(shape, *skin->GetPrimitiveNewWorld(iPrim)))
+        results.push_back(tOverlapResult(skin, iPrim));
+    }
+  }
+  return results.size();
+}
+
+//==============================================================
+// QueryOverlap
+//==============================================================
+unsigned tCollisionSystem::QueryOverlap(
+  std::vector<tOverlapResult> & results,
+  const tAABox & box,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  return QueryShapeOverlap(results, 
+                      tBox(box.GetMinPos(), tMatrix33::Identity(), box.GetSideLengths()), 
+                      box, collisionPredicate);
+}
+
+//==============================================================
+// QueryOverlap
+//==============================================================
+unsigned tCollisionSystem::QueryOverlap(
+  std::vector<tOverlapResult> & results,
+  const tSphere & sphere,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  tAABox sphereBox;
+  sphereBox.AddSphere(sphere);
+  return QueryShapeOverlap(results, sphere, sphereBox, collisionPredicate);
+}
+
+//==============================================================
+// BeginNarrowPhase
+//==============================================================
+void tCollisionSystem::BeginNarrowPhase()
+{
+  Assert(!mGatheringPairs);
+  mPrimitivePairs.resize(0);
+  mGatheringPairs = mThreadPool && mThreadPool->GetNumThreads() > 1;
+}
+
+//==============================================================
+// DetectSkinPair
+//==============================================================
+void tCollisionSystem::DetectSkinPair(tCollDetectInfo & info,
+                                      tCollisionFunctor & collisionFunctor,
+                                      tScalar collTolerance)
+{
+  unsigned nPrimitives0 = info.skin0->GetNumPrimitives();
+  unsigned nPrimitives1 = info.skin1->GetNumPrimitives();
+
+  for (info.iPrim0 = 0 ; info.iPrim0 < nPrimitives0 ; ++info.iPrim0)
+  {
+    for (info.iPrim1 = 0 ; info.iPrim1 < nPrimitives1 ; ++info.iPrim1)
+    {
+      const tCollDetectFunctor * f =
+        GetCollDetectFunctor(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetType(),
+        info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetType());
+      if (!f)
+        continue;
+      if (mGatheringPairs)
+      {
+        tPrimitivePair pair;
+        pair.mInfo = info;
+        pair.mFunctor = f;
+        mPrimitivePairs.push_back(pair);
+      }
+      else
+      {
+        f->CollDetect(info, collTolerance, collisionFunctor);
+      }
+    }
+  }
+}
+
+//==============================================================
+// EndNarrowPhase
+//==============================================================
+void tCollisionSystem::EndNarrowPhase(tCollisionFunctor & collisionFunctor,
+                                      tScalar collTolerance)
+{
+  if (!mGatheringPairs)
+    return;
+  mGatheringPairs = false;
+
+  const unsigned numPairs = mPrimitivePairs.size();
+  if (numPairs == 0)
+    return;
+
+  const unsigned numThreads = mThreadPool->GetNumThreads();
+  while (mContactBuffers.size() < numThreads)
+    mContactBuffers.push_back(new tContactBuffer);
+  for (unsigned iThread = 0 ; iThread < numThreads ; ++iThread)
+    mContactBuffers[iThread]->Clear();
+
+  tNarrowPhaseJob job(mPrimitivePairs, mContactBuffers, collTolerance);
+  mThreadPool->RunJob(job, numPairs);
+
+  // pass the results on in the order the pairs were gathered, so it
+  // doesn't depend on which thread did what
+  for (unsigned iPair = 0 ; iPair < numPairs ; ++iPair)
+  {
+    const tPrimitivePair & pair = mPrimitivePairs[iPair];
+    const tContactBuffer & buffer = *mContactBuffers[pair.mThread];
+    for (unsigned i = 0 ; i < pair.mNumContacts ; ++i)
+    {
+      const tContactBuffer::tContact & contact = buffer.mContacts[pair.mFirstContact + i];
+      collisionFunctor.CollisionNotify(contact.mInfo,
+                                       contact.mDirToBody0,
+                                       buffer.mPoints.data() + contact.mFirstPoint,
+                                       contact.mNumPoints);
+    }
+  }
+}
@@ -20,7 +20,7 @@ using namespace std;
 tCollisionSystemBrute::tCollisionSystemBrute()
 {
   TRACE_METHOD_ONLY(ONCE_1);
-  mDetecting = false;
+  mDetecting = 0;
   
 }
 
@@ -42,7 +42,7 @@ void tCollisionSystemBrute::AddCollisionSkin(tCollisionSkin * skin)
 {
   TRACE_METHOD_ONLY(FRAME_1);
   Assert(skin);
-  Assert(false == mDetecting);
+  Assert(0 == mDetecting);
   if (mSkins.end() == find(mSkins.begin(), mSkins.end(), skin))
     mSkins.push_back(skin);
   else
@@ -57,7 +57,7 @@ void tCollisionSystemBrute::AddCollisionSkin(tCollisionSkin * skin)
 bool tCollisionSystemBrute::RemoveCollisionSkin(tCollisionSkin * skin)
 {
   TRACE_METHOD_ONLY(FRAME_1);
-  Assert(false == mDetecting);
+  Assert(0 == mDetecting);
   skin->SetCollisionSystem(0);
   tSkins::iterator it = find(mSkins.begin(), mSkins.end(), skin);
   if (mSkins.end() == it)
@@ -112,7 +112,7 @@ void tCollisionSystemBrute::DetectCollisions(
   if (!info.skin0)
     return;
   
-  mDetecting = true;
+  ++mDetecting;
   
   unsigned nBodyPrimitives = info.skin0->GetNumPrimitives();
 
@@ -140,7 +140,7 @@ void tCollisionSystemBrute::DetectCollisions(
   }
     
 
-  mDetecting = false;
+  --mDetecting;
 }
 
 
@@ -153,7 +153,8 @@ void tCollisionSystemBrute::DetectAllCollisions(
   const tCollisionSkinPredicate2 * collisionPredicate,
   tScalar collTolerance)
 {
-  mDetecting = true;
+  ++mDetecting;
+  BeginNarrowPhase();
   unsigned numSkins = mSkins.size();
   unsigned numBodies = bodies.size();
 
@@ -196,26 +197,14 @@ void tCollisionSystemBrute::DetectAllCollisions(
       {
         if (CheckCollidables(info.skin0, info.skin1))
         {
-          unsigned nBodyPrimitives = info.skin0->GetNumPrimitives();
-          unsigned nPrimitives = info.skin1->GetNumPrimitives();
-
-          for (info.iPrim0 = 0 ; info.iPrim0 < nBodyPrimitives ; ++info.iPrim0)
-          {
-            for (info.iPrim1 = 0 ; info.iPrim1 < nPrimitives ; ++info.iPrim1)
-            {
-              const tCollDetectFunctor * f = 
-                GetCollDetectFunctor(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetType(), 
-                info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetType());
-              if (f)
-                f->CollDetect(info, collTolerance, collisionFunctor);
-            }
-          }
+          DetectSkinPair(info, collisionFunctor, collTolerance);
         }
       } // overlap test
     } // loop over mSkins
   } // loop over bodies
   
-  mDetecting = false;
+  EndNarrowPhase(collisionFunctor, collTolerance);
+  --mDetecting;
 }
 
 //==============================================================
@@ -229,7 +218,7 @@ bool tCollisionSystemBrute::SegmentIntersect(
   const class tSegment & seg, 
   const tCollisionSkinPredicate1 * collisionPredicate)
 {
-  mDetecting = true;
+  ++mDetecting;
   unsigned numSkins = mSkins.size();
   
   tAABox segAABox;
@@ -269,7 +258,7 @@ bool tCollisionSystemBrute::SegmentIntersect(
       }
     }
   }
-  mDetecting = false;
+  --mDetecting;
   
   if (fracOut > SCALAR(1.0f))
     return false;
@@ -277,3 +266,18 @@ bool tCollisionSystemBrute::SegmentIntersect(
   return true;
 }
 
+//==============================================================
+// GetSkinsOverlappingAABox
+//==============================================================
+void tCollisionSystemBrute::GetSkinsOverlappingAABox(
+  vector<tCollisionSkin *> & skins,
+  const tAABox & box)
+{
+  skins.resize(0);
+  const unsigned numSkins = mSkins.size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    if (OverlapTest(mSkins[iSkin]->GetWorldBoundingBox(), box))
+      skins.push_back(mSkins[iSkin]);
+  }
+}
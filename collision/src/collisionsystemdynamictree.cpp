@@ -0,0 +1,847 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionsystemdynamictree.cpp 
+//                     
+//==============================================================
+#include "collisionsystemdynamictree.hpp"
+#include "collisionskin.hpp"
+#include "body.hpp"
+#include "line.hpp"
+#include "segmentpacket.hpp"
+#include "collisionscratch.hpp"
+
+using namespace JigLib;
+using namespace std;
+
+/// Enough for any tree we're likely to see since it's kept balanced
+static const int maxStackSize = 256;
+
+//==============================================================
+// Helpers for the node boxes
+//==============================================================
+static inline tVector3 MinVector(const tVector3 & a, const tVector3 & b)
+{
+  return tVector3(Min(a.x, b.x), Min(a.y, b.y), Min(a.z, b.z));
+}
+
+static inline tVector3 MaxVector(const tVector3 & a, const tVector3 & b)
+{
+  return tVector3(Max(a.x, b.x), Max(a.y, b.y), Max(a.z, b.z));
+}
+
+static inline tScalar SurfaceArea(const tVector3 & minPos, const tVector3 & maxPos)
+{
+  tVector3 sl = maxPos - minPos;
+  return 2.0f * (sl.x * sl.y + sl.x * sl.z + sl.y * sl.z);
+}
+
+static inline bool Overlap(const tVector3 & min0, const tVector3 & max0,
+                           const tVector3 & min1, const tVector3 & max1)
+{
+  return (
+    (min0.z > max1.z) ||
+    (max0.z < min1.z) ||
+    (min0.y > max1.y) ||
+    (max0.y < min1.y) ||
+    (min0.x > max1.x) ||
+    (max0.x < min1.x) ) ? false : true;
+}
+
+static inline bool Contains(const tVector3 & outerMin, const tVector3 & outerMax,
+                            const tVector3 & innerMin, const tVector3 & innerMax)
+{
+  return
+    (outerMin.x <= innerMin.x) && (outerMin.y <= innerMin.y) && (outerMin.z <= innerMin.z) &&
+    (outerMax.x >= innerMax.x) && (outerMax.y >= innerMax.y) && (outerMax.z >= innerMax.z);
+}
+
+//==============================================================
+// SegmentOverlap
+// Returns true if the segment (with invDelta = 1/delta per
+// component) passes through the box at some fraction < maxFrac
+//==============================================================
+static inline bool SegmentOverlap(const tVector3 & minPos, const tVector3 & maxPos,
+                                  const tVector3 & origin, const tVector3 & invDelta,
+                                  tScalar maxFrac)
+{
+  tScalar tMin = 0.0f;
+  tScalar tMax = maxFrac;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    tScalar t0 = (minPos[i] - origin[i]) * invDelta[i];
+    tScalar t1 = (maxPos[i] - origin[i]) * invDelta[i];
+    if (t0 > t1)
+      Swap(t0, t1);
+    tMin = Max(tMin, t0);
+    tMax = Min(tMax, t1);
+    if (tMin > tMax)
+      return false;
+  }
+  return true;
+}
+
+//==============================================================
+// tCollisionSystemDynamicTree
+//==============================================================
+tCollisionSystemDynamicTree::tCollisionSystemDynamicTree(tScalar fatMargin)
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  mRoot = -1;
+  mFreeNode = -1;
+  mFatMargin = fatMargin;
+  mDetecting = 0;
+}
+
+//==============================================================
+// ~tCollisionSystemDynamicTree
+//==============================================================
+tCollisionSystemDynamicTree::~tCollisionSystemDynamicTree()
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  for (unsigned i = 0 ; i < mSkins.size() ; ++i)
+    mSkins[i]->SetCollisionSystem(0);
+}
+
+//==============================================================
+// AllocateNode
+//==============================================================
+int tCollisionSystemDynamicTree::AllocateNode()
+{
+  int iNode;
+  if (mFreeNode >= 0)
+  {
+    iNode = mFreeNode;
+    mFreeNode = mNodes[iNode].mParent;
+  }
+  else
+  {
+    iNode = mNodes.size();
+    mNodes.resize(iNode + 1);
+  }
+  tNode & node = mNodes[iNode];
+  node.mSkin = 0;
+  node.mParent = -1;
+  node.mChild0 = -1;
+  node.mChild1 = -1;
+  node.mHeight = 0;
+  return iNode;
+}
+
+//==============================================================
+// FreeNode
+//==============================================================
+void tCollisionSystemDynamicTree::FreeNode(int iNode)
+{
+  tNode & node = mNodes[iNode];
+  node.mSkin = 0;
+  node.mHeight = -1;
+  node.mParent = mFreeNode;
+  mFreeNode = iNode;
+}
+
+//==============================================================
+// RefitAncestors
+//==============================================================
+void tCollisionSystemDynamicTree::RefitAncestors(int iNode)
+{
+  while (iNode >= 0)
+  {
+    iNode = Balance(iNode);
+
+    tNode & node = mNodes[iNode];
+    const tNode & child0 = mNodes[node.mChild0];
+    const tNode & child1 = mNodes[node.mChild1];
+    node.mMin = MinVector(child0.mMin, child1.mMin);
+    node.mMax = MaxVector(child0.mMax, child1.mMax);
+    node.mHeight = 1 + Max(child0.mHeight, child1.mHeight);
+
+    iNode = node.mParent;
+  }
+}
+
+//==============================================================
+// InsertLeaf
+//==============================================================
+void tCollisionSystemDynamicTree::InsertLeaf(int iLeaf)
+{
+  if (mRoot < 0)
+  {
+    mRoot = iLeaf;
+    mNodes[iLeaf].mParent = -1;
+    return;
+  }
+
+  const tVector3 leafMin = mNodes[iLeaf].mMin;
+  const tVector3 leafMax = mNodes[iLeaf].mMax;
+
+  // Go down the tree looking for the best sibling. At each node the
+  // choice is to pair up with it here, or to carry on down into the
+  // cheaper child - either way every ancestor has to grow to
+  // include the leaf.
+  int iSibling = mRoot;
+  while (!mNodes[iSibling].IsLeaf())
+  {
+    const tNode & node = mNodes[iSibling];
+    tScalar area = SurfaceArea(node.mMin, node.mMax);
+    tScalar combinedArea = SurfaceArea(MinVector(node.mMin, leafMin),
+                                       MaxVector(node.mMax, leafMax));
+
+    // cost of making a new parent for this node and the leaf
+    tScalar cost = 2.0f * combinedArea;
+    // minimum cost of pushing the leaf further down
+    tScalar inheritanceCost = 2.0f * (combinedArea - area);
+
+    tScalar childCosts[2];
+    for (unsigned i = 0 ; i < 2 ; ++i)
+    {
+      const tNode & child = mNodes[i == 0 ? node.mChild0 : node.mChild1];
+      tScalar newArea = SurfaceArea(MinVector(child.mMin, leafMin),
+                                    MaxVector(child.mMax, leafMax));
+      if (child.IsLeaf())
+        childCosts[i] = newArea + inheritanceCost;
+      else
+        childCosts[i] = (newArea - SurfaceArea(child.mMin, child.mMax)) + inheritanceCost;
+    }
+
+    if (cost < childCosts[0] && cost < childCosts[1])
+      break;
+
+    iSibling = childCosts[0] < childCosts[1] ? node.mChild0 : node.mChild1;
+  }
+
+  // make a new parent for the sibling and the leaf
+  int iOldParent = mNodes[iSibling].mParent;
+  int iNewParent = AllocateNode();
+  // AllocateNode may have moved the nodes
+  tNode & newParent = mNodes[iNewParent];
+  tNode & sibling = mNodes[iSibling];
+  newParent.mParent = iOldParent;
+  newParent.mMin = MinVector(sibling.mMin, leafMin);
+  newParent.mMax = MaxVector(sibling.mMax, leafMax);
+  newParent.mHeight = sibling.mHeight + 1;
+  newParent.mChild0 = iSibling;
+  newParent.mChild1 = iLeaf;
+  sibling.mParent = iNewParent;
+  mNodes[iLeaf].mParent = iNewParent;
+
+  if (iOldParent >= 0)
+  {
+    tNode & oldParent = mNodes[iOldParent];
+    if (oldParent.mChild0 == iSibling)
+      oldParent.mChild0 = iNewParent;
+    else
+      oldParent.mChild1 = iNewParent;
+  }
+  else
+  {
+    mRoot = iNewParent;
+  }
+
+  RefitAncestors(mNodes[iLeaf].mParent);
+}
+
+//==============================================================
+// RemoveLeaf
+//==============================================================
+void tCollisionSystemDynamicTree::RemoveLeaf(int iLeaf)
+{
+  if (iLeaf == mRoot)
+  {
+    mRoot = -1;
+    return;
+  }
+
+  // the sibling takes the parent's place
+  int iParent = mNodes[iLeaf].mParent;
+  int iGrandParent = mNodes[iParent].mParent;
+  int iSibling = mNodes[iParent].mChild0 == iLeaf ?
+    mNodes[iParent].mChild1 : mNodes[iParent].mChild0;
+
+  if (iGrandParent >= 0)
+  {
+    tNode & grandParent = mNodes[iGrandParent];
+    if (grandParent.mChild0 == iParent)
+      grandParent.mChild0 = iSibling;
+    else
+      grandParent.mChild1 = iSibling;
+    mNodes[iSibling].mParent = iGrandParent;
+    FreeNode(iParent);
+    RefitAncestors(iGrandParent);
+  }
+  else
+  {
+    mRoot = iSibling;
+    mNodes[iSibling].mParent = -1;
+    FreeNode(iParent);
+  }
+  mNodes[iLeaf].mParent = -1;
+}
+
+//==============================================================
+// Balance
+// If one child of A is more than one level taller than the other
+// then rotate that child up into A's place.
+//==============================================================
+int tCollisionSystemDynamicTree::Balance(int iA)
+{
+  tNode & A = mNodes[iA];
+  if (A.IsLeaf() || A.mHeight < 2)
+    return iA;
+
+  int iB = A.mChild0;
+  int iC = A.mChild1;
+  int balance = mNodes[iC].mHeight - mNodes[iB].mHeight;
+
+  if (balance > 1)
+  {
+    // rotate C up
+    tNode & C = mNodes[iC];
+    int iF = C.mChild0;
+    int iG = C.mChild1;
+    tNode & F = mNodes[iF];
+    tNode & G = mNodes[iG];
+
+    C.mChild0 = iA;
+    C.mParent = A.mParent;
+    A.mParent = iC;
+    if (C.mParent >= 0)
+    {
+      if (mNodes[C.mParent].mChild0 == iA)
+        mNodes[C.mParent].mChild0 = iC;
+      else
+        mNodes[C.mParent].mChild1 = iC;
+    }
+    else
+    {
+      mRoot = iC;
+    }
+
+    // the taller of C's children stays with C
+    const tNode & B = mNodes[iB];
+    if (F.mHeight > G.mHeight)
+    {
+      C.mChild1 = iF;
+      A.mChild1 = iG;
+      G.mParent = iA;
+      A.mMin = MinVector(B.mMin, G.mMin);
+      A.mMax = MaxVector(B.mMax, G.mMax);
+      C.mMin = MinVector(A.mMin, F.mMin);
+      C.mMax = MaxVector(A.mMax, F.mMax);
+      A.mHeight = 1 + Max(B.mHeight, G.mHeight);
+      C.mHeight = 1 + Max(A.mHeight, F.mHeight);
+    }
+    else
+    {
+      C.mChild1 = iG;
+      A.mChild1 = iF;
+      F.mParent = iA;
+      A.mMin = MinVector(B.mMin, F.mMin);
+      A.mMax = MaxVector(B.mMax, F.mMax);
+      C.mMin = MinVector(A.mMin, G.mMin);
+      C.mMax = MaxVector(A.mMax, G.mMax);
+      A.mHeight = 1 + Max(B.mHeight, F.mHeight);
+      C.mHeight = 1 + Max(A.mHeight, G.mHeight);
+    }
+    return iC;
+  }
+
+  if (balance < -1)
+  {
+    // rotate B up
+    tNode & B = mNodes[iB];
+    int iD = B.mChild0;
+    int iE = B.mChild1;
+    tNode & D = mNodes[iD];
+    tNode & E = mNodes[iE];
+
+    B.mChild0 = iA;
+    B.mParent = A.mParent;
+    A.mParent = iB;
+    if (B.mParent >= 0)
+    {
+      if (mNodes[B.mParent].mChild0 == iA)
+        mNodes[B.mParent].mChild0 = iB;
+      else
+        mNodes[B.mParent].mChild1 = iB;
+    }
+    else
+    {
+      mRoot = iB;
+    }
+
+    // the taller of B's children stays with B
+    const tNode & C = mNodes[iC];
+    if (D.mHeight > E.mHeight)
+    {
+      B.mChild1 = iD;
+      A.mChild0 = iE;
+      E.mParent = iA;
+      A.mMin = MinVector(C.mMin, E.mMin);
+      A.mMax = MaxVector(C.mMax, E.mMax);
+      B.mMin = MinVector(A.mMin, D.mMin);
+      B.mMax = MaxVector(A.mMax, D.mMax);
+      A.mHeight = 1 + Max(C.mHeight, E.mHeight);
+      B.mHeight = 1 + Max(A.mHeight, D.mHeight);
+    }
+    else
+    {
+      B.mChild1 = iE;
+      A.mChild0 = iD;
+      D.mParent = iA;
+      A.mMin = MinVector(C.mMin, D.mMin);
+      A.mMax = MaxVector(C.mMax, D.mMax);
+      B.mMin = MinVector(A.mMin, E.mMin);
+      B.mMax = MaxVector(A.mMax, E.mMax);
+      A.mHeight = 1 + Max(C.mHeight, D.mHeight);
+      B.mHeight = 1 + Max(A.mHeight, E.mHeight);
+    }
+    return iB;
+  }
+
+  return iA;
+}
+
+//==============================================================
+// AddCollisionSkin
+//==============================================================
+void tCollisionSystemDynamicTree::AddCollisionSkin(tCollisionSkin * skin)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  Assert(skin);
+  Assert(0 == mDetecting);
+  if (mSkins.end() != find(mSkins.begin(), mSkins.end(), skin))
+  {
+    TRACE("Warning: tried to add skin %p to tCollisionSystemDynamicTree but "
+          "it's already registered\n", skin);
+    return;
+  }
+  mSkins.push_back(skin);
+  skin->SetCollisionSystem(this);
+
+  int iLeaf = AllocateNode();
+  tNode & leaf = mNodes[iLeaf];
+  const tAABox & box = skin->GetWorldBoundingBox();
+  leaf.mMin = box.GetMinPos() - tVector3(mFatMargin);
+  leaf.mMax = box.GetMaxPos() + tVector3(mFatMargin);
+  leaf.mSkin = skin;
+  skin->GetExternalData().mInt = iLeaf;
+  InsertLeaf(iLeaf);
+}
+
+//==============================================================
+// RemoveCollisionSkin
+//==============================================================
+bool tCollisionSystemDynamicTree::RemoveCollisionSkin(tCollisionSkin * skin)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  Assert(0 == mDetecting);
+  skin->SetCollisionSystem(0);
+  tSkins::iterator it = find(mSkins.begin(), mSkins.end(), skin);
+  if (mSkins.end() == it)
+    return false;
+  mSkins.erase(it);
+
+  int iLeaf = skin->GetExternalData().mInt;
+  Assert(mNodes[iLeaf].mSkin == skin);
+  RemoveLeaf(iLeaf);
+  FreeNode(iLeaf);
+  skin->GetExternalData().mInt = -1;
+  return true;
+}
+
+//========================================================
+// CollisionSkinMoved
+//========================================================
+void tCollisionSystemDynamicTree::CollisionSkinMoved(
+  const class tCollisionSkin * skin)
+{
+  int iLeaf = skin->GetExternalData().mInt;
+  if (iLeaf < 0 || iLeaf >= (int) mNodes.size() || mNodes[iLeaf].mSkin != skin)
+  {
+    TRACE("Warning = skin %p has no tree node!\n", skin);
+    return;
+  }
+
+  const tAABox & box = skin->GetWorldBoundingBox();
+  if (Contains(mNodes[iLeaf].mMin, mNodes[iLeaf].mMax, box.GetMinPos(), box.GetMaxPos()))
+    return;
+
+  RemoveLeaf(iLeaf);
+  mNodes[iLeaf].mMin = box.GetMinPos() - tVector3(mFatMargin);
+  mNodes[iLeaf].mMax = box.GetMaxPos() + tVector3(mFatMargin);
+  InsertLeaf(iLeaf);
+}
+
+//========================================================
+// QueryAABox
+//========================================================
+void tCollisionSystemDynamicTree::QueryAABox(
+  vector<tCollisionSkin *> & skins,
+  const tVector3 & minPos, const tVector3 & maxPos) const
+{
+  skins.resize(0);
+  if (mRoot < 0)
+    return;
+
+  int stack[maxStackSize];
+  int stackSize = 0;
+  stack[stackSize++] = mRoot;
+  while (stackSize > 0)
+  {
+    const tNode & node = mNodes[stack[--stackSize]];
+    if (!Overlap(node.mMin, node.mMax, minPos, maxPos))
+      continue;
+    if (node.IsLeaf())
+    {
+      skins.push_back(node.mSkin);
+    }
+    else
+    {
+      Assert(stackSize + 2 <= maxStackSize);
+      stack[stackSize++] = node.mChild0;
+      stack[stackSize++] = node.mChild1;
+    }
+  }
+}
+
+//==============================================================
+// CheckCollidables
+// returns true if these two skins could collide
+//==============================================================
+static inline bool CheckCollidables(const tCollisionSkin * skin0,
+                                    const tCollisionSkin * skin1)
+{
+  const vector<const tCollisionSkin *> & nonColl0 = skin0->GetNonCollidables();
+  const vector<const tCollisionSkin *> & nonColl1 = skin1->GetNonCollidables();
+  // most common case
+  if (nonColl0.empty() && nonColl1.empty())
+    return true;
+
+  for (unsigned i0 = nonColl0.size() ; i0-- != 0 ; )
+  {
+    if (nonColl0[i0] == skin1)
+      return false;
+  }
+
+  for (unsigned i1 = nonColl1.size() ; i1-- != 0 ; )
+  {
+    if (nonColl1[i1] == skin0)
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================
+// DetectCollisions
+//==============================================================
+void tCollisionSystemDynamicTree::DetectCollisions(
+  tBody & body,
+  tCollisionFunctor & collisionFunctor,
+  const tCollisionSkinPredicate2 * collisionPredicate,
+  tScalar collTolerance)
+{
+  if (!body.IsActive())
+    return;
+
+  tCollDetectInfo info;
+
+  info.skin0 = body.GetCollisionSkin();
+  if (!info.skin0)
+    return;
+
+  ++mDetecting;
+
+  const tAABox & box = info.skin0->GetWorldBoundingBox();
+  tScratchVector<tCollisionSkin *> skinsToCheck(tCollisionScratch::GetThreadScratch().mSkins);
+  QueryAABox(skinsToCheck,
+             box.GetMinPos() - tVector3(collTolerance),
+             box.GetMaxPos() + tVector3(collTolerance));
+
+  unsigned nBodyPrimitives = info.skin0->GetNumPrimitives();
+
+  unsigned numSkins = skinsToCheck.Size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    info.skin1 = skinsToCheck[iSkin];
+    Assert(info.skin1);
+    if ((info.skin0 != info.skin1) && CheckCollidables(info.skin0, info.skin1))
+    {
+      unsigned nPrimitives = info.skin1->GetNumPrimitives();
+
+      for (info.iPrim0 = 0 ; info.iPrim0 < nBodyPrimitives ; ++info.iPrim0)
+      {
+        for (info.iPrim1 = 0 ; info.iPrim1 < nPrimitives ; ++info.iPrim1)
+        {
+          const tCollDetectFunctor * f =
+            GetCollDetectFunctor(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetType(),
+            info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetType());
+          if (f)
+            f->CollDetect(info, collTolerance, collisionFunctor);
+        }
+      }
+    }
+  }
+  --mDetecting;
+}
+
+//==============================================================
+// DetectAllCollisions
+//==============================================================
+void tCollisionSystemDynamicTree::DetectAllCollisions(
+  const vector<tBody *> & bodies,
+  tCollisionFunctor & collisionFunctor,
+  const tCollisionSkinPredicate2 * collisionPredicate,
+  tScalar collTolerance)
+{
+  ++mDetecting;
+  BeginNarrowPhase();
+  unsigned numBodies = bodies.size();
+  tScratchVector<tCollisionSkin *> skinsToCheck(tCollisionScratch::GetThreadScratch().mSkins);
+
+  tCollDetectInfo info;
+
+  for (unsigned iBody = 0 ; iBody < numBodies ; ++iBody)
+  {
+    tBody * body = bodies[iBody];
+    Assert(body);
+    if (!body->IsActive())
+      continue;
+
+    info.skin0 = body->GetCollisionSkin();
+    if (!info.skin0)
+      continue;
+
+    const tAABox & box0 = info.skin0->GetWorldBoundingBox();
+    QueryAABox(skinsToCheck,
+               box0.GetMinPos() - tVector3(collTolerance),
+               box0.GetMaxPos() + tVector3(collTolerance));
+
+    unsigned numSkins = skinsToCheck.Size();
+    for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+    {
+      info.skin1 = skinsToCheck[iSkin];
+      if (info.skin1 == info.skin0)
+        continue;
+
+      Assert(info.skin1);
+      bool skinSleeping = true;
+      if (info.skin1->GetOwner() && (info.skin1->GetOwner()->IsActive()))
+        skinSleeping = false;
+
+      // only do one per pair
+      if ( (skinSleeping == false) && (info.skin1 < info.skin0) )
+        continue;
+
+      if ( (collisionPredicate != 0) &&
+           (!collisionPredicate->ConsiderSkinPair(info.skin0, info.skin1)))
+        continue;
+
+      // the tree only checked the fat boxes
+      if (OverlapTest(info.skin1->GetWorldBoundingBox(), box0, collTolerance))
+      {
+        if (CheckCollidables(info.skin1, info.skin0))
+        {
+          DetectSkinPair(info, collisionFunctor, collTolerance);
+        } // check collidables
+      } // overlap test
+    } // loop over skins
+  } // loop over bodies
+
+  EndNarrowPhase(collisionFunctor, collTolerance);
+  --mDetecting;
+}
+
+//==============================================================
+// SegmentIntersect
+//==============================================================
+bool tCollisionSystemDynamicTree::SegmentIntersect(
+  tScalar & fracOut,
+  tCollisionSkin *& skinOut,
+  tVector3 & posOut,
+  tVector3 & normalOut,
+  const class tSegment & seg,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  // initialise the outputs
+  fracOut = SCALAR_HUGE;
+  skinOut = 0;
+
+  if (mRoot < 0)
+    return false;
+
+  ++mDetecting;
+
+  const tVector3 & origin = seg.GetOrigin();
+  const tVector3 & delta = seg.GetDelta();
+  tVector3 invDelta(SafeInvScalar(delta.x), SafeInvScalar(delta.y), SafeInvScalar(delta.z));
+
+  // working vars
+  tScalar frac;
+  tVector3 pos;
+  tVector3 normal;
+
+  // nodes that start beyond the best hit so far get skipped
+  int stack[maxStackSize];
+  int stackSize = 0;
+  stack[stackSize++] = mRoot;
+  while (stackSize > 0)
+  {
+    const tNode & node = mNodes[stack[--stackSize]];
+    if (!SegmentOverlap(node.mMin, node.mMax, origin, invDelta, Min(fracOut, SCALAR(1.0f))))
+      continue;
+    if (!node.IsLeaf())
+    {
+      Assert(stackSize + 2 <= maxStackSize);
+      stack[stackSize++] = node.mChild0;
+      stack[stackSize++] = node.mChild1;
+      continue;
+    }
+
+    tCollisionSkin * skin = node.mSkin;
+    if ( (collisionPredicate == 0) ||
+         (collisionPredicate->ConsiderSkin(skin) == true) )
+    {
+      if (skin->SegmentIntersect(frac, pos, normal, seg))
+      {
+        if (frac < fracOut)
+        {
+          posOut = pos;
+          normalOut = normal;
+          skinOut = skin;
+          fracOut = frac;
+        }
+      }
+    }
+  }
+  --mDetecting;
+
+  if (fracOut > SCALAR(1.0f))
+    return false;
+  Limit(fracOut, SCALAR(0.0f), SCALAR(1.0f));
+  return true;
+}
+
+//==============================================================
+// SegmentIntersectBatch
+// Traces the segments through the tree in packets, so each node gets
+// visited once for all the segments in the packet that reach it.
+// Each segment ends up seeing the same skins in the same order as
+// it would in SegmentIntersect.
+//==============================================================
+unsigned tCollisionSystemDynamicTree::SegmentIntersectBatch(
+  tScalar * fracs,
+  tCollisionSkin ** skins,
+  tVector3 * positions,
+  tVector3 * normals,
+  const class tSegment * segs,
+  unsigned numSegs,
+  const tCollisionSkinPredicate1 * const * collisionPredicates)
+{
+  unsigned iSeg;
+  for (iSeg = 0 ; iSeg < numSegs ; ++iSeg)
+  {
+    fracs[iSeg] = SCALAR_HUGE;
+    skins[iSeg] = 0;
+  }
+
+  if (mRoot < 0)
+    return 0;
+
+  ++mDetecting;
+
+  const unsigned packetSize = tSegmentPacket::SIZE;
+  tSegmentPacket packet;
+  // the segments from the packet that are tested against a skin
+  unsigned lanes[packetSize];
+  tSegment laneSegs[packetSize];
+  tScalar laneFracs[packetSize];
+  tVector3 lanePositions[packetSize];
+  tVector3 laneNormals[packetSize];
+
+  int stack[maxStackSize];
+  for (unsigned iFirst = 0 ; iFirst < numSegs ; iFirst += packetSize)
+  {
+    const unsigned num = Min(numSegs - iFirst, packetSize);
+    packet.Set(segs + iFirst, num);
+
+    int stackSize = 0;
+    stack[stackSize++] = mRoot;
+    while (stackSize > 0)
+    {
+      const tNode & node = mNodes[stack[--stackSize]];
+      const unsigned mask = packet.OverlapMask(node.mMin.GetData(), node.mMax.GetData());
+      if (!mask)
+        continue;
+      if (!node.IsLeaf())
+      {
+        Assert(stackSize + 2 <= maxStackSize);
+        stack[stackSize++] = node.mChild0;
+        stack[stackSize++] = node.mChild1;
+        continue;
+      }
+
+      tCollisionSkin * skin = node.mSkin;
+      unsigned numLanes = 0;
+      unsigned iLane;
+      for (iLane = 0 ; iLane < num ; ++iLane)
+      {
+        if (!(mask & (1 << iLane)))
+          continue;
+        const tCollisionSkinPredicate1 * collisionPredicate = 
+          collisionPredicates ? collisionPredicates[iFirst + iLane] : 0;
+        if ( (collisionPredicate == 0) ||
+             (collisionPredicate->ConsiderSkin(skin) == true) )
+        {
+          lanes[numLanes] = iLane;
+          laneSegs[numLanes++] = segs[iFirst + iLane];
+        }
+      }
+      if (numLanes == 0)
+        continue;
+      if (0 == skin->SegmentIntersectBatch(laneFracs, lanePositions, laneNormals, laneSegs, numLanes))
+        continue;
+
+      for (unsigned i = 0 ; i < numLanes ; ++i)
+      {
+        iSeg = iFirst + lanes[i];
+        if (laneFracs[i] < fracs[iSeg])
+        {
+          positions[iSeg] = lanePositions[i];
+          normals[iSeg] = laneNormals[i];
+          skins[iSeg] = skin;
+          fracs[iSeg] = laneFracs[i];
+          packet.mMaxFrac[lanes[i]] = Min(laneFracs[i], SCALAR(1.0f));
+        }
+      }
+    }
+  }
+  --mDetecting;
+
+  unsigned numHits = 0;
+  for (iSeg = 0 ; iSeg < numSegs ; ++iSeg)
+  {
+    if (fracs[iSeg] > SCALAR(1.0f))
+    {
+      fracs[iSeg] = SCALAR_HUGE;
+      skins[iSeg] = 0;
+      continue;
+    }
+    Limit(fracs[iSeg], SCALAR(0.0f), SCALAR(1.0f));
+    ++numHits;
+  }
+  return numHits;
+}
+
+//==============================================================
+// GetSkinsOverlappingAABox
+//==============================================================
+void tCollisionSystemDynamicTree::GetSkinsOverlappingAABox(
+  vector<tCollisionSkin *> & skins,
+  const tAABox & box)
+{
+  QueryAABox(skins, box.GetMinPos(), box.GetMaxPos());
+}
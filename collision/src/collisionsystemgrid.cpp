@@ -69,7 +69,7 @@ tCollisionSystemGrid::tCollisionSystemGrid(
   tScalar dx, tScalar dy, tScalar dz)
 {
   TRACE_METHOD_ONLY(ONCE_1);
-  mDetecting = false;
+  mDetecting = 0;
 
   mNx = nx; mNy = ny; mNz = nz;
   mDx = dx; mDy = dy; mDz = dz;
@@ -126,7 +126,7 @@ inline int tCollisionSystemGrid::CalcIndex(int i, int j, int k) const
   int I = i % mNx;
   int J = j % mNy;
   int K = k % mNz;
-  int result = I + mNx * J + (mNx + mNy) * K;
+  int result = I + mNx * J + mNx * mNy * K;
   Assert(result < (int) mGridEntries.size());
   return result;
 }
@@ -219,7 +219,7 @@ int tCollisionSystemGrid::CalcGridIndexForSkin(const tCollisionSkin * skin)
 void tCollisionSystemGrid::AddCollisionSkin(tCollisionSkin * skin)
 {
   TRACE_METHOD_ONLY(FRAME_1);
-  Assert(false == mDetecting);
+  Assert(0 == mDetecting);
   if (mSkins.end() == find(mSkins.begin(), mSkins.end(), skin))
     mSkins.push_back(skin);
   else
@@ -244,7 +244,7 @@ void tCollisionSystemGrid::AddCollisionSkin(tCollisionSkin * skin)
 bool tCollisionSystemGrid::RemoveCollisionSkin(tCollisionSkin * skin)
 {
   TRACE_METHOD_ONLY(FRAME_1);
-  Assert(false == mDetecting);
+  Assert(0 == mDetecting);
   tGridEntry * entry = (tGridEntry *) skin->GetExternalData().mPointer;
   if (entry)
   {
@@ -406,7 +406,7 @@ void tCollisionSystemGrid::DetectCollisions(
   if (!info.skin0)
     return;
 
-  mDetecting = true;
+  ++mDetecting;
 
   unsigned nBodyPrimitives = info.skin0->GetNumPrimitives();
 
@@ -432,7 +432,7 @@ void tCollisionSystemGrid::DetectCollisions(
       }
     }
   }
-  mDetecting = false;
+  --mDetecting;
 }
 
 //==============================================================
@@ -444,7 +444,8 @@ void tCollisionSystemGrid::DetectAllCollisions(
   const tCollisionSkinPredicate2 * collisionPredicate,
   tScalar collTolerance)
 {
-  mDetecting = true;
+  ++mDetecting;
+  BeginNarrowPhase();
   unsigned numBodies = bodies.size();
 
   tCollDetectInfo info;
@@ -460,12 +461,11 @@ void tCollisionSystemGrid::DetectAllCollisions(
     if (!info.skin0)
       continue;
 
-    static vector<tGridEntry *> lists;
-    GetListsToCheck(lists, info.skin0);
-    for (unsigned iList = lists.size() ; iList-- != 0 ; )
+    GetListsToCheck(mListsToCheck, info.skin0);
+    for (unsigned iList = mListsToCheck.size() ; iList-- != 0 ; )
     {
       // first one is a placeholder.
-      tGridEntry * entry = lists[iList];
+      tGridEntry * entry = mListsToCheck[iList];
       Assert(entry);
       for (entry = entry->mNext ; entry != 0 ; entry = entry->mNext)
       {
@@ -493,58 +493,41 @@ void tCollisionSystemGrid::DetectAllCollisions(
         {
           if (CheckCollidables(info.skin1, info.skin0))
           {
-            unsigned nBodyPrimitives = info.skin0->GetNumPrimitives();
-            unsigned nPrimitives = info.skin1->GetNumPrimitives();
-
-            for (info.iPrim0 = 0 ; info.iPrim0 < nBodyPrimitives ; ++info.iPrim0)
-            {
-              for (info.iPrim1 = 0 ; info.iPrim1 < nPrimitives ; ++info.iPrim1)
-              {
-                const tCollDetectFunctor * f = 
-                  GetCollDetectFunctor(info.skin0->GetPrimitiveNewWorld(info.iPrim0)->GetType(), 
-                  info.skin1->GetPrimitiveNewWorld(info.iPrim1)->GetType());
-                if (f)
-                  f->CollDetect(info, collTolerance, collisionFunctor);
-              }
-            }
+            DetectSkinPair(info, collisionFunctor, collTolerance);
           } // check collidables
         } // overlap test
       } // loop over entries
     } // loop over lists
   } // loop over bodies
 
-  mDetecting = false;
+  EndNarrowPhase(collisionFunctor, collTolerance);
+  --mDetecting;
 }
 
 //==============================================================
-// SegmentIntersect
+// SegmentIntersectList
+// Checks the skins in one grid list against the segment, updating
+// the outputs if there's a closer hit
 //==============================================================
-bool tCollisionSystemGrid::SegmentIntersect(
+static void SegmentIntersectList(
   tScalar & fracOut, 
   tCollisionSkin *& skinOut, 
   tVector3 & posOut, 
   tVector3 & normalOut, 
-  const class tSegment & seg, 
+  const tGridEntry * start,
+  const tSegment & seg, 
+  const tAABox & segAABox,
   const tCollisionSkinPredicate1 * collisionPredicate)
 {
-  mDetecting = true;
-  unsigned numSkins = mSkins.size();
-
-  tAABox segAABox;
-  segAABox.AddSegment(seg);
-
-  // initialise the outputs
-  fracOut = SCALAR_HUGE;
-  skinOut = 0;
-
   // working vars
   tScalar frac;
   tVector3 pos;
   tVector3 normal;
 
-  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  // first one is a placeholder
+  for (const tGridEntry * entry = start->mNext ; entry != 0 ; entry = entry->mNext)
   {
-    tCollisionSkin * skin = mSkins[iSkin];
+    tCollisionSkin * skin = entry->mSkin;
     Assert(skin);
     if ( (collisionPredicate == 0) ||
          (collisionPredicate->ConsiderSkin(skin) == true) )
@@ -563,11 +546,127 @@ bool tCollisionSystemGrid::SegmentIntersect(
             fracOut = frac;
           }
         }
+      }
+    }
+  }
+}
+
+//==============================================================
+// SegmentIntersect
+//==============================================================
+bool tCollisionSystemGrid::SegmentIntersect(
+  tScalar & fracOut, 
+  tCollisionSkin *& skinOut, 
+  tVector3 & posOut, 
+  tVector3 & normalOut, 
+  const class tSegment & seg, 
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  ++mDetecting;
+
+  tAABox segAABox;
+  segAABox.AddSegment(seg);
+
+  // initialise the outputs
+  fracOut = SCALAR_HUGE;
+  skinOut = 0;
+
+  // skins that are too big for the grid could be anywhere
+  SegmentIntersectList(fracOut, skinOut, posOut, normalOut,
+                       mOverflowEntries, seg, segAABox, collisionPredicate);
+
+  // Walk through the cells that the segment passes through, in order
+  // (3D-DDA), using unwrapped cell coordinates. Skins are listed in
+  // the cell containing the min corner of their bounding box, and are
+  // no bigger than a cell, so the skins that can be in cell c are in
+  // the lists for c - d, where each component of d is 0 or 1.
+  const tScalar deltas[3] = {mDx, mDy, mDz};
+  const int nums[3] = {(int) mNx, (int) mNy, (int) mNz};
+  int cell[3];
+  int step[3];
+  tScalar tMax[3];
+  tScalar tDelta[3];
+  // the walk visits one cell, plus one for each cell boundary crossed
+  tScalar numWalkCells = SCALAR(1.0f);
+  unsigned i;
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    tScalar origin = seg.mOrigin[i] / deltas[i];
+    tScalar dir = seg.mDelta[i] / deltas[i];
+    numWalkCells += fabs(floor(origin + dir) - floor(origin));
+    cell[i] = (int) floor(origin);
+    if (dir > SCALAR_TINY)
+    {
+      step[i] = 1;
+      tMax[i] = (cell[i] + 1 - origin) / dir;
+      tDelta[i] = SCALAR(1.0f) / dir;
+    }
+    else if (dir < -SCALAR_TINY)
+    {
+      step[i] = -1;
+      tMax[i] = (cell[i] - origin) / dir;
+      tDelta[i] = SCALAR(-1.0f) / dir;
+    }
+    else
+    {
+      step[i] = 0;
+      tMax[i] = tDelta[i] = SCALAR_HUGE;
+    }
+  }
 
+  // The cells are wrapped, so a long segment on a small grid would
+  // keep coming back to the same lists. If the walk would visit at
+  // least as many cells as there are in the grid, just check each
+  // list once.
+  if (numWalkCells >= (tScalar) mGridEntries.size())
+  {
+    for (unsigned iCell = 0 ; iCell < mGridEntries.size() ; ++iCell)
+    {
+      const tGridEntry * start = mGridEntries[iCell];
+      if (start->mNext)
+        SegmentIntersectList(fracOut, skinOut, posOut, normalOut,
+                             start, seg, segAABox, collisionPredicate);
+    }
+  }
+  else
+  {
+    // When stepping to the next cell along an axis, only the lists that
+    // weren't used for the previous cell need checking - those with d
+    // = 0 (stepping up) or d = 1 (stepping down) along that axis. 
+    int stepAxis = -1;
+    while (true)
+    {
+      for (int d = 0 ; d < 8 ; ++d)
+      {
+        const int dd[3] = {d & 1, (d >> 1) & 1, (d >> 2) & 1};
+        if (stepAxis >= 0 && dd[stepAxis] != (step[stepAxis] > 0 ? 0 : 1))
+          continue;
+        int ijk[3];
+        for (i = 0 ; i < 3 ; ++i)
+        {
+          ijk[i] = (cell[i] - dd[i]) % nums[i];
+          if (ijk[i] < 0)
+            ijk[i] += nums[i];
+        }
+        const tGridEntry * start = mGridEntries[CalcIndex(ijk[0], ijk[1], ijk[2])];
+        if (start->mNext)
+          SegmentIntersectList(fracOut, skinOut, posOut, normalOut,
+                               start, seg, segAABox, collisionPredicate);
       }
+
+      stepAxis = 0;
+      if (tMax[1] < tMax[stepAxis]) stepAxis = 1;
+      if (tMax[2] < tMax[stepAxis]) stepAxis = 2;
+      // stop at the end of the segment, or if there's a hit before the
+      // next cell (nothing there can be closer)
+      if (tMax[stepAxis] > SCALAR(1.0f) || fracOut <= tMax[stepAxis])
+        break;
+      cell[stepAxis] += step[stepAxis];
+      tMax[stepAxis] += tDelta[stepAxis];
     }
   }
-  mDetecting = false;
+
+  --mDetecting;
 
   if (fracOut > 1.0f)
     return false;
@@ -575,3 +674,61 @@ bool tCollisionSystemGrid::SegmentIntersect(
   return true;
 }
 
+//==============================================================
+// GetSkinsOverlappingAABox
+// Skins are in the cell that contains the minimum of their box, and
+// are no bigger than a cell, so the cells to look in start one
+// before the one containing box's minimum.
+//==============================================================
+void tCollisionSystemGrid::GetSkinsOverlappingAABox(
+  vector<tCollisionSkin *> & skins,
+  const tAABox & box)
+{
+  skins.resize(0);
+
+  tGridEntry * entry;
+  for (entry = mOverflowEntries->mNext ; entry ; entry = entry->mNext)
+  {
+    if (OverlapTest(entry->mSkin->GetWorldBoundingBox(), box))
+      skins.push_back(entry->mSkin);
+  }
+
+  const int n[3] = {(int) mNx, (int) mNy, (int) mNz};
+  const tScalar d[3] = {mDx, mDy, mDz};
+  int start[3], num[3];
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    const tScalar first = floor(box.GetMinPos()[i] / d[i]) - SCALAR(1.0f);
+    const tScalar last = floor(box.GetMaxPos()[i] / d[i]);
+    if (last - first + SCALAR(1.0f) >= n[i])
+    {
+      start[i] = 0;
+      num[i] = n[i];
+    }
+    else
+    {
+      // CalcIndex wants positive indices
+      tScalar wrapped = fmod(first, (tScalar) n[i]);
+      if (wrapped < SCALAR(0.0f))
+        wrapped += n[i];
+      start[i] = ((int) wrapped) % n[i];
+      num[i] = (int) (last - first) + 1;
+    }
+  }
+
+  for (int di = 0 ; di < num[0] ; ++di)
+  {
+    for (int dj = 0 ; dj < num[1] ; ++dj)
+    {
+      for (int dk = 0 ; dk < num[2] ; ++dk)
+      {
+        const int index = CalcIndex(start[0] + di, start[1] + dj, start[2] + dk);
+        for (entry = mGridEntries[index]->mNext ; entry ; entry = entry->mNext)
+        {
+          if (OverlapTest(entry->mSkin->GetWorldBoundingBox(), box))
+            skins.push_back(entry->mSkin);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,789 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionsystemsap.cpp 
+//                     
+//==============================================================
+#include "collisionsystemsap.hpp"
+#include "collisionskin.hpp"
+#include "body.hpp"
+#include "line.hpp"
+#include "collisionscratch.hpp"
+
+#include <algorithm>
+
+using namespace JigLib;
+using namespace std;
+
+//==============================================================
+// tCollisionSystemSAP
+//==============================================================
+tCollisionSystemSAP::tCollisionSystemSAP(tScalar margin)
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  mMargin = margin;
+  mPairTolerance = SCALAR(0.0f);
+  mDetecting = 0;
+}
+
+//==============================================================
+// ~tCollisionSystemSAP
+//==============================================================
+tCollisionSystemSAP::~tCollisionSystemSAP()
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  for (unsigned i = 0 ; i < mSkins.size() ; ++i)
+    mSkins[i]->SetCollisionSystem(0);
+}
+
+//==============================================================
+// ProxiesOverlap
+//==============================================================
+inline bool tCollisionSystemSAP::ProxiesOverlap(unsigned iProxy0, unsigned iProxy1) const
+{
+  const tProxy & p0 = mProxies[iProxy0];
+  const tProxy & p1 = mProxies[iProxy1];
+  return (
+    (p0.mMin.x > p1.mMax.x) ||
+    (p0.mMax.x < p1.mMin.x) ||
+    (p0.mMin.y > p1.mMax.y) ||
+    (p0.mMax.y < p1.mMin.y) ||
+    (p0.mMin.z > p1.mMax.z) ||
+    (p0.mMax.z < p1.mMin.z) ) ? false : true;
+}
+
+//==============================================================
+// AddPair
+//==============================================================
+void tCollisionSystemSAP::AddPair(unsigned iProxy0, unsigned iProxy1)
+{
+  if (iProxy0 > iProxy1)
+    Swap(iProxy0, iProxy1);
+  bool isNew;
+  unsigned & index = mPairIndices.Insert(iProxy0, iProxy1, isNew);
+  if (!isNew)
+    return;
+  index = mPairs.size();
+  tPair pair = {iProxy0, iProxy1};
+  mPairs.push_back(pair);
+}
+
+//==============================================================
+// RemovePair
+//==============================================================
+void tCollisionSystemSAP::RemovePair(unsigned iProxy0, unsigned iProxy1)
+{
+  if (iProxy0 > iProxy1)
+    Swap(iProxy0, iProxy1);
+  unsigned * index = mPairIndices.Find(iProxy0, iProxy1);
+  if (!index)
+    return;
+  unsigned iPair = *index;
+  mPairIndices.Remove(iProxy0, iProxy1);
+
+  // move the last pair into the gap
+  unsigned iLast = mPairs.size() - 1;
+  if (iPair != iLast)
+  {
+    mPairs[iPair] = mPairs[iLast];
+    *mPairIndices.Find(mPairs[iPair].mProxy0, mPairs[iPair].mProxy1) = iPair;
+  }
+  mPairs.pop_back();
+}
+
+//==============================================================
+// GetStabbingCount
+//==============================================================
+inline unsigned tCollisionSystemSAP::GetStabbingCount(unsigned axis, unsigned i) const
+{
+  const vector<tEndPoint> & endPoints = mEndPoints[axis];
+  const unsigned count = i > 0 ? endPoints[i - 1].mStabbingCount : 0;
+  if (mProxies[endPoints[i].GetProxy()].mUnbounded)
+    return count;
+  return endPoints[i].IsMax() ? count - 1 : count + 1;
+}
+
+//==============================================================
+// SwapEndPoints
+//==============================================================
+inline void tCollisionSystemSAP::SwapEndPoints(unsigned axis, unsigned i)
+{
+  vector<tEndPoint> & endPoints = mEndPoints[axis];
+  // the count after both ends doesn't change
+  const unsigned stabbingCount = endPoints[i + 1].mStabbingCount;
+  Swap(endPoints[i], endPoints[i + 1]);
+  endPoints[i + 1].mStabbingCount = stabbingCount;
+  endPoints[i].mStabbingCount = GetStabbingCount(axis, i);
+  for (unsigned j = i ; j <= i + 1 ; ++j)
+  {
+    tProxy & proxy = mProxies[endPoints[j].GetProxy()];
+    if (endPoints[j].IsMax())
+      proxy.mMaxIndex[axis] = j;
+    else
+      proxy.mMinIndex[axis] = j;
+  }
+}
+
+//==============================================================
+// UpdateUnbounded
+//==============================================================
+bool tCollisionSystemSAP::UpdateUnbounded(unsigned iProxy)
+{
+  tProxy & proxy = mProxies[iProxy];
+  const bool unbounded = 
+    proxy.mMin.x <= -SCALAR_HUGE || proxy.mMin.y <= -SCALAR_HUGE || proxy.mMin.z <= -SCALAR_HUGE ||
+    proxy.mMax.x >= SCALAR_HUGE || proxy.mMax.y >= SCALAR_HUGE || proxy.mMax.z >= SCALAR_HUGE;
+  if (unbounded == proxy.mUnbounded)
+    return false;
+  proxy.mUnbounded = unbounded;
+  if (unbounded)
+    mUnboundedProxies.push_back(iProxy);
+  else
+    mUnboundedProxies.erase(find(mUnboundedProxies.begin(), mUnboundedProxies.end(), iProxy));
+  return true;
+}
+
+//==============================================================
+// SortMinDown
+// Passing the max of another box means we might start overlapping
+//==============================================================
+void tCollisionSystemSAP::SortMinDown(unsigned axis, unsigned iProxy)
+{
+  vector<tEndPoint> & endPoints = mEndPoints[axis];
+  unsigned i = mProxies[iProxy].mMinIndex[axis];
+  while (i > 0 && endPoints[i] < endPoints[i - 1])
+  {
+    const tEndPoint & other = endPoints[i - 1];
+    if (other.IsMax() && ProxiesOverlap(iProxy, other.GetProxy()))
+      AddPair(iProxy, other.GetProxy());
+    SwapEndPoints(axis, i - 1);
+    --i;
+  }
+}
+
+//==============================================================
+// SortMinUp
+// Passing the max of another box means we've stopped overlapping
+//==============================================================
+void tCollisionSystemSAP::SortMinUp(unsigned axis, unsigned iProxy)
+{
+  vector<tEndPoint> & endPoints = mEndPoints[axis];
+  unsigned i = mProxies[iProxy].mMinIndex[axis];
+  const unsigned last = endPoints.size() - 1;
+  while (i < last && endPoints[i + 1] < endPoints[i])
+  {
+    const tEndPoint & other = endPoints[i + 1];
+    if (other.IsMax())
+      RemovePair(iProxy, other.GetProxy());
+    SwapEndPoints(axis, i);
+    ++i;
+  }
+}
+
+//==============================================================
+// SortMaxDown
+// Passing the min of another box means we've stopped overlapping
+//==============================================================
+void tCollisionSystemSAP::SortMaxDown(unsigned axis, unsigned iProxy)
+{
+  vector<tEndPoint> & endPoints = mEndPoints[axis];
+  unsigned i = mProxies[iProxy].mMaxIndex[axis];
+  while (i > 0 && endPoints[i] < endPoints[i - 1])
+  {
+    const tEndPoint & other = endPoints[i - 1];
+    if (!other.IsMax())
+      RemovePair(iProxy, other.GetProxy());
+    SwapEndPoints(axis, i - 1);
+    --i;
+  }
+}
+
+//==============================================================
+// SortMaxUp
+// Passing the min of another box means we might start overlapping
+//==============================================================
+void tCollisionSystemSAP::SortMaxUp(unsigned axis, unsigned iProxy)
+{
+  vector<tEndPoint> & endPoints = mEndPoints[axis];
+  unsigned i = mProxies[iProxy].mMaxIndex[axis];
+  const unsigned last = endPoints.size() - 1;
+  while (i < last && endPoints[i + 1] < endPoints[i])
+  {
+    const tEndPoint & other = endPoints[i + 1];
+    if (!other.IsMax() && ProxiesOverlap(iProxy, other.GetProxy()))
+      AddPair(iProxy, other.GetProxy());
+    SwapEndPoints(axis, i);
+    ++i;
+  }
+}
+
+//==============================================================
+// MoreProxyIndex
+//==============================================================
+static bool MoreProxyIndex(const tCollisionSkin * skin0, const tCollisionSkin * skin1)
+{
+  return skin0->GetExternalData().mInt > skin1->GetExternalData().mInt;
+}
+
+//==============================================================
+// AddCollisionSkin
+//==============================================================
+void tCollisionSystemSAP::AddCollisionSkin(tCollisionSkin * skin)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  Assert(skin);
+  Assert(0 == mDetecting);
+  int iExisting = skin->GetExternalData().mInt;
+  if (skin->GetCollisionSystem() == this && iExisting >= 0 &&
+      iExisting < (int) mProxies.size() && mProxies[iExisting].mSkin == skin)
+  {
+    TRACE("Warning: tried to add skin %p to tCollisionSystemSAP but "
+          "it's already registered\n", skin);
+    return;
+  }
+  mSkins.push_back(skin);
+  skin->SetCollisionSystem(this);
+
+  unsigned iProxy;
+  if (mFreeProxies.empty())
+  {
+    iProxy = mProxies.size();
+    mProxies.resize(iProxy + 1);
+  }
+  else
+  {
+    iProxy = mFreeProxies.back();
+    mFreeProxies.pop_back();
+  }
+  skin->GetExternalData().mInt = iProxy;
+
+  tProxy & proxy = mProxies[iProxy];
+  const tAABox & box = skin->GetWorldBoundingBox();
+  proxy.mSkin = skin;
+  const tScalar expand = mMargin + SCALAR(0.5f) * mPairTolerance;
+  proxy.mMin = box.GetMinPos() - tVector3(expand);
+  proxy.mMax = box.GetMaxPos() + tVector3(expand);
+  proxy.mDirty = false;
+  proxy.mInBodies = false;
+  proxy.mUnbounded = false;
+  UpdateUnbounded(iProxy);
+
+  // Put the ends straight into place. Everything above the min moves
+  // along one, so needs its index updating, but only the counts up to
+  // the max change.
+  for (unsigned axis = 0 ; axis < 3 ; ++axis)
+  {
+    vector<tEndPoint> & endPoints = mEndPoints[axis];
+    tEndPoint minEnd = {proxy.mMin[axis], iProxy << 1, 0};
+    tEndPoint maxEnd = {proxy.mMax[axis], (iProxy << 1) | 1, 0};
+    const unsigned minIndex = 
+      upper_bound(endPoints.begin(), endPoints.end(), minEnd) - endPoints.begin();
+    endPoints.insert(endPoints.begin() + minIndex, minEnd);
+    const unsigned maxIndex = 
+      upper_bound(endPoints.begin() + minIndex + 1, endPoints.end(), maxEnd) - endPoints.begin();
+    endPoints.insert(endPoints.begin() + maxIndex, maxEnd);
+
+    const unsigned numEndPoints = endPoints.size();
+    for (unsigned i = minIndex ; i < numEndPoints ; ++i)
+    {
+      tProxy & other = mProxies[endPoints[i].GetProxy()];
+      if (endPoints[i].IsMax())
+        other.mMaxIndex[axis] = i;
+      else
+        other.mMinIndex[axis] = i;
+      if (i <= maxIndex)
+        endPoints[i].mStabbingCount = GetStabbingCount(axis, i);
+    }
+  }
+
+  // the pairs go in from the highest proxy down, as they always have,
+  // so that the order things get detected in doesn't change
+  tScratchVector<tCollisionSkin *> othersScratch(tCollisionScratch::GetThreadScratch().mSkins);
+  vector<tCollisionSkin *> & others = othersScratch;
+  GetProxySkins(others, proxy.mMin, proxy.mMax, false);
+  sort(others.begin(), others.end(), MoreProxyIndex);
+  const unsigned numOthers = others.size();
+  for (unsigned i = 0 ; i < numOthers ; ++i)
+  {
+    const unsigned iOther = others[i]->GetExternalData().mInt;
+    if (iOther != iProxy)
+      AddPair(iProxy, iOther);
+  }
+}
+
+//==============================================================
+// RemoveCollisionSkin
+//==============================================================
+bool tCollisionSystemSAP::RemoveCollisionSkin(tCollisionSkin * skin)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  Assert(0 == mDetecting);
+  skin->SetCollisionSystem(0);
+  tSkins::iterator it = find(mSkins.begin(), mSkins.end(), skin);
+  if (mSkins.end() == it)
+    return false;
+  mSkins.erase(it);
+
+  unsigned iProxy = skin->GetExternalData().mInt;
+  Assert(mProxies[iProxy].mSkin == skin);
+  skin->GetExternalData().mInt = -1;
+
+  unsigned i;
+  for (i = mPairs.size() ; i-- != 0 ; )
+  {
+    // the pair that gets moved into i has already been checked
+    if (mPairs[i].mProxy0 == iProxy || mPairs[i].mProxy1 == iProxy)
+      RemovePair(mPairs[i].mProxy0, mPairs[i].mProxy1);
+  }
+
+  // Everything above the min moves down one, but only the counts of
+  // the ends that were inside the box change
+  for (unsigned axis = 0 ; axis < 3 ; ++axis)
+  {
+    vector<tEndPoint> & endPoints = mEndPoints[axis];
+    const unsigned minIndex = mProxies[iProxy].mMinIndex[axis];
+    const unsigned maxIndex = mProxies[iProxy].mMaxIndex[axis];
+    endPoints.erase(endPoints.begin() + maxIndex);
+    endPoints.erase(endPoints.begin() + minIndex);
+    const unsigned numEndPoints = endPoints.size();
+    for (i = minIndex ; i < numEndPoints ; ++i)
+    {
+      tProxy & proxy = mProxies[endPoints[i].GetProxy()];
+      if (endPoints[i].IsMax())
+        proxy.mMaxIndex[axis] = i;
+      else
+        proxy.mMinIndex[axis] = i;
+      if (i + 1 < maxIndex)
+        endPoints[i].mStabbingCount = GetStabbingCount(axis, i);
+    }
+  }
+
+  vector<unsigned>::iterator dirtyIt = find(mDirtyProxies.begin(), mDirtyProxies.end(), iProxy);
+  if (dirtyIt != mDirtyProxies.end())
+    mDirtyProxies.erase(dirtyIt);
+
+  if (mProxies[iProxy].mUnbounded)
+    mUnboundedProxies.erase(find(mUnboundedProxies.begin(), mUnboundedProxies.end(), iProxy));
+
+  mProxies[iProxy].mSkin = 0;
+  mProxies[iProxy].mDirty = false;
+  mProxies[iProxy].mUnbounded = false;
+  mFreeProxies.push_back(iProxy);
+  return true;
+}
+
+//========================================================
+// CollisionSkinMoved
+//========================================================
+void tCollisionSystemSAP::CollisionSkinMoved(
+  const class tCollisionSkin * skin)
+{
+  int iProxy = skin->GetExternalData().mInt;
+  if (iProxy < 0 || iProxy >= (int) mProxies.size() || mProxies[iProxy].mSkin != skin)
+  {
+    TRACE("Warning = skin %p has no proxy!\n", skin);
+    return;
+  }
+  tProxy & proxy = mProxies[iProxy];
+  if (!proxy.mDirty)
+  {
+    proxy.mDirty = true;
+    mDirtyProxies.push_back(iProxy);
+  }
+}
+
+//========================================================
+// UpdateDirtyProxies
+//========================================================
+void tCollisionSystemSAP::UpdateDirtyProxies(tScalar collTolerance)
+{
+  // A skin can sit anywhere inside its expanded box without being
+  // updated, so the boxes have to allow for the tolerance as well as
+  // the margin. Otherwise two skins at the edges of their boxes could
+  // be within collTolerance without having a pair.
+  if (collTolerance > mPairTolerance)
+  {
+    mPairTolerance = collTolerance;
+    for (unsigned iProxy = 0 ; iProxy < mProxies.size() ; ++iProxy)
+    {
+      tProxy & proxy = mProxies[iProxy];
+      if (proxy.mSkin && !proxy.mDirty)
+      {
+        proxy.mDirty = true;
+        mDirtyProxies.push_back(iProxy);
+      }
+    }
+  }
+
+  for (unsigned i = 0 ; i < mDirtyProxies.size() ; ++i)
+    UpdateProxy(mDirtyProxies[i]);
+  mDirtyProxies.resize(0);
+}
+
+//========================================================
+// UpdateProxy
+//========================================================
+void tCollisionSystemSAP::UpdateProxy(unsigned iProxy)
+{
+  tProxy & proxy = mProxies[iProxy];
+  proxy.mDirty = false;
+
+  const tAABox & box = proxy.mSkin->GetWorldBoundingBox();
+  const tVector3 halfTol(SCALAR(0.5f) * mPairTolerance);
+  const tVector3 boxMin = box.GetMinPos() - halfTol;
+  const tVector3 boxMax = box.GetMaxPos() + halfTol;
+
+  // nothing to do if it's (plus the tolerance) still inside the
+  // expanded box
+  if (boxMin.x >= proxy.mMin.x && boxMin.y >= proxy.mMin.y && boxMin.z >= proxy.mMin.z &&
+      boxMax.x <= proxy.mMax.x && boxMax.y <= proxy.mMax.y && boxMax.z <= proxy.mMax.z)
+    return;
+
+  const tVector3 oldMin = proxy.mMin;
+  const tVector3 oldMax = proxy.mMax;
+  proxy.mMin = boxMin - tVector3(mMargin);
+  proxy.mMax = boxMax + tVector3(mMargin);
+  const bool unboundedChanged = UpdateUnbounded(iProxy);
+
+  for (unsigned axis = 0 ; axis < 3 ; ++axis)
+  {
+    vector<tEndPoint> & endPoints = mEndPoints[axis];
+    endPoints[proxy.mMinIndex[axis]].mValue = proxy.mMin[axis];
+    endPoints[proxy.mMaxIndex[axis]].mValue = proxy.mMax[axis];
+
+    // grow first, then shrink, so the min never passes our own max
+    if (proxy.mMin[axis] < oldMin[axis])
+      SortMinDown(axis, iProxy);
+    if (proxy.mMax[axis] > oldMax[axis])
+      SortMaxUp(axis, iProxy);
+    if (proxy.mMin[axis] > oldMin[axis])
+      SortMinUp(axis, iProxy);
+    if (proxy.mMax[axis] < oldMax[axis])
+      SortMaxDown(axis, iProxy);
+
+    // rare (e.g. a plane being swapped for a box), so just redo them
+    // all
+    if (unboundedChanged)
+    {
+      for (unsigned i = 0 ; i < endPoints.size() ; ++i)
+        endPoints[i].mStabbingCount = GetStabbingCount(axis, i);
+    }
+  }
+}
+
+//==============================================================
+// CheckCollidables
+// returns true if these two skins could collide
+//==============================================================
+static inline bool CheckCollidables(const tCollisionSkin * skin0,
+                                    const tCollisionSkin * skin1)
+{
+  const vector<const tCollisionSkin *> & nonColl0 = skin0->GetNonCollidables();
+  const vector<const tCollisionSkin *> & nonColl1 = skin1->GetNonCollidables();
+  // most common case
+  if (nonColl0.empty() && nonColl1.empty())
+    return true;
+
+  for (unsigned i0 = nonColl0.size() ; i0-- != 0 ; )
+  {
+    if (nonColl0[i0] == skin1)
+      return false;
+  }
+
+  for (unsigned i1 = nonColl1.size() ; i1-- != 0 ; )
+  {
+    if (nonColl1[i1] == skin0)
+      return false;
+  }
+
+  return true;
+}
+
+//==============================================================
+// DetectCollisions
+//==============================================================
+void tCollisionSystemSAP::DetectCollisions(
+  tBody & body,
+  tCollisionFunctor & collisionFunctor,
+  const tCollisionSkinPredicate2 * collisionPredicate,
+  tScalar collTolerance)
+{
+  if (!body.IsActive())
+    return;
+
+  tCollDetectInfo info;
+
+  info.skin0 = body.GetCollisionSkin();
+  if (!info.skin0 || info.skin0->GetCollisionSystem() != this)
+    return;
+
+  ++mDetecting;
+  UpdateDirtyProxies(collTolerance);
+
+  const unsigned iProxy = info.skin0->GetExternalData().mInt;
+  const unsigned numPairs = mPairs.size();
+  for (unsigned iPair = 0 ; iPair < numPairs ; ++iPair)
+  {
+    const tPair & pair = mPairs[iPair];
+    if (pair.mProxy0 == iProxy)
+      info.skin1 = mProxies[pair.mProxy1].mSkin;
+    else if (pair.mProxy1 == iProxy)
+      info.skin1 = mProxies[pair.mProxy0].mSkin;
+    else
+      continue;
+
+    if (CheckCollidables(info.skin0, info.skin1))
+      DetectSkinPair(info, collisionFunctor, collTolerance);
+  }
+  --mDetecting;
+}
+
+//==============================================================
+// DetectAllCollisions
+// Rather than looking for things near each body, go through the
+// overlapping pairs and see if either of them is one of the bodies.
+//==============================================================
+void tCollisionSystemSAP::DetectAllCollisions(
+  const vector<tBody *> & bodies,
+  tCollisionFunctor & collisionFunctor,
+  const tCollisionSkinPredicate2 * collisionPredicate,
+  tScalar collTolerance)
+{
+  ++mDetecting;
+  UpdateDirtyProxies(collTolerance);
+  BeginNarrowPhase();
+
+  unsigned numBodies = bodies.size();
+  unsigned iBody;
+  for (iBody = 0 ; iBody < numBodies ; ++iBody)
+  {
+    tBody * body = bodies[iBody];
+    Assert(body);
+    tCollisionSkin * skin = body->GetCollisionSkin();
+    if (body->IsActive() && skin && skin->GetCollisionSystem() == this)
+      mProxies[skin->GetExternalData().mInt].mInBodies = true;
+  }
+
+  tCollDetectInfo info;
+
+  const unsigned numPairs = mPairs.size();
+  for (unsigned iPair = 0 ; iPair < numPairs ; ++iPair)
+  {
+    const tPair & pair = mPairs[iPair];
+    const tProxy & proxy0 = mProxies[pair.mProxy0];
+    const tProxy & proxy1 = mProxies[pair.mProxy1];
+    if (!proxy0.mInBodies && !proxy1.mInBodies)
+      continue;
+
+    // Treat it the same way as looping over the bodies - each body
+    // skin gets to be skin0, and if the other skin is active too
+    // only the lower one does.
+    for (unsigned iOrder = 0 ; iOrder < 2 ; ++iOrder)
+    {
+      const tProxy & p0 = iOrder == 0 ? proxy0 : proxy1;
+      const tProxy & p1 = iOrder == 0 ? proxy1 : proxy0;
+      if (!p0.mInBodies)
+        continue;
+
+      info.skin0 = p0.mSkin;
+      info.skin1 = p1.mSkin;
+
+      bool skinSleeping = true;
+      if (info.skin1->GetOwner() && (info.skin1->GetOwner()->IsActive()))
+        skinSleeping = false;
+
+      // only do one per pair
+      if ( (skinSleeping == false) && (info.skin1 < info.skin0) )
+        continue;
+
+      if ( (collisionPredicate != 0) &&
+           (!collisionPredicate->ConsiderSkinPair(info.skin0, info.skin1)))
+        continue;
+
+      // the pairs are only from the expanded boxes
+      if (OverlapTest(info.skin1->GetWorldBoundingBox(),
+                      info.skin0->GetWorldBoundingBox(),
+                      collTolerance))
+      {
+        if (CheckCollidables(info.skin1, info.skin0))
+          DetectSkinPair(info, collisionFunctor, collTolerance);
+      }
+    }
+  }
+
+  for (iBody = 0 ; iBody < numBodies ; ++iBody)
+  {
+    tCollisionSkin * skin = bodies[iBody]->GetCollisionSkin();
+    if (skin && skin->GetCollisionSystem() == this)
+      mProxies[skin->GetExternalData().mInt].mInBodies = false;
+  }
+
+  EndNarrowPhase(collisionFunctor, collTolerance);
+  --mDetecting;
+}
+
+//==============================================================
+// BoxesTouch
+// Like ProxiesOverlap, boxes that just touch count
+//==============================================================
+static inline bool BoxesTouch(const tVector3 & min0, const tVector3 & max0,
+                              const tVector3 & min1, const tVector3 & max1)
+{
+  return !(min0.x > max1.x || max0.x < min1.x ||
+           min0.y > max1.y || max0.y < min1.y ||
+           min0.z > max1.z || max0.z < min1.z);
+}
+
+//==============================================================
+// GetProxySkins
+//==============================================================
+void tCollisionSystemSAP::GetProxySkins(vector<tCollisionSkin *> & skins,
+                                        const tVector3 & min, const tVector3 & max,
+                                        bool skipDirty) const
+{
+  // Along each axis the boxes that start in [min, max] are the mins
+  // from lo up to hi, and the ones that started before are the
+  // stabbing count just below lo. Use the axis with the fewest.
+  const tEndPoint loEnd = {0.0f, 0, 0};
+  const tEndPoint hiEnd = {0.0f, 1, 0};
+  unsigned axis = 0, lo = 0, hi = 0, numOpen = 0, bestCost = ~0u;
+  for (unsigned iAxis = 0 ; iAxis < 3 ; ++iAxis)
+  {
+    const vector<tEndPoint> & endPoints = mEndPoints[iAxis];
+    tEndPoint probe = loEnd;
+    probe.mValue = min[iAxis];
+    const unsigned iLo = lower_bound(endPoints.begin(), endPoints.end(), probe) - endPoints.begin();
+    probe = hiEnd;
+    probe.mValue = max[iAxis];
+    const unsigned iHi = upper_bound(endPoints.begin() + iLo, endPoints.end(), probe) - endPoints.begin();
+    const unsigned iOpen = iLo > 0 ? endPoints[iLo - 1].mStabbingCount : 0;
+    if (iHi - iLo + iOpen < bestCost)
+    {
+      bestCost = iHi - iLo + iOpen;
+      axis = iAxis;
+      lo = iLo;
+      hi = iHi;
+      numOpen = iOpen;
+    }
+  }
+
+  const vector<tEndPoint> & endPoints = mEndPoints[axis];
+  unsigned i;
+  for (i = lo ; i < hi ; ++i)
+  {
+    const tProxy & proxy = mProxies[endPoints[i].GetProxy()];
+    if (!endPoints[i].IsMax() && !proxy.mUnbounded && !(skipDirty && proxy.mDirty) &&
+        BoxesTouch(proxy.mMin, proxy.mMax, min, max))
+      skins.push_back(proxy.mSkin);
+  }
+
+  for (i = lo ; numOpen > 0 && i-- != 0 ; )
+  {
+    const tProxy & proxy = mProxies[endPoints[i].GetProxy()];
+    if (endPoints[i].IsMax() || proxy.mUnbounded || proxy.mMaxIndex[axis] < lo)
+      continue;
+    --numOpen;
+    if (!(skipDirty && proxy.mDirty) && BoxesTouch(proxy.mMin, proxy.mMax, min, max))
+      skins.push_back(proxy.mSkin);
+  }
+
+  for (i = 0 ; i < mUnboundedProxies.size() ; ++i)
+  {
+    const tProxy & proxy = mProxies[mUnboundedProxies[i]];
+    if (!(skipDirty && proxy.mDirty) && BoxesTouch(proxy.mMin, proxy.mMax, min, max))
+      skins.push_back(proxy.mSkin);
+  }
+
+  if (skipDirty)
+  {
+    for (i = 0 ; i < mDirtyProxies.size() ; ++i)
+      skins.push_back(mProxies[mDirtyProxies[i]].mSkin);
+  }
+}
+
+//==============================================================
+// SegmentIntersect
+// The skins near the segment come from its bounding box. Skins that
+// have moved since the last detection are always checked, since their
+// proxies aren't up to date.
+//==============================================================
+bool tCollisionSystemSAP::SegmentIntersect(
+  tScalar & fracOut,
+  tCollisionSkin *& skinOut,
+  tVector3 & posOut,
+  tVector3 & normalOut,
+  const class tSegment & seg,
+  const tCollisionSkinPredicate1 * collisionPredicate)
+{
+  ++mDetecting;
+
+  tAABox segAABox;
+  segAABox.AddSegment(seg);
+
+  tScratchVector<tCollisionSkin *> skins(tCollisionScratch::GetThreadScratch().mSkins);
+  GetProxySkins(skins, segAABox.GetMinPos(), segAABox.GetMaxPos(), true);
+
+  // initialise the outputs
+  fracOut = SCALAR_HUGE;
+  skinOut = 0;
+
+  // working vars
+  tScalar frac;
+  tVector3 pos;
+  tVector3 normal;
+
+  const unsigned numSkins = skins.Size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    tCollisionSkin * skin = skins[iSkin];
+    Assert(skin);
+    if ( (collisionPredicate == 0) ||
+         (collisionPredicate->ConsiderSkin(skin) == true) )
+    {
+      // basic bbox test
+      if (OverlapTest(skin->GetWorldBoundingBox(),
+                      segAABox))
+      {
+        if (skin->SegmentIntersect(frac, pos, normal, seg))
+        {
+          if (frac < fracOut)
+          {
+            posOut = pos;
+            normalOut = normal;
+            skinOut = skin;
+            fracOut = frac;
+          }
+        }
+      }
+    }
+  }
+  --mDetecting;
+
+  if (fracOut > SCALAR(1.0f))
+    return false;
+  Limit(fracOut, SCALAR(0.0f), SCALAR(1.0f));
+  return true;
+}
+
+//==============================================================
+// GetSkinsOverlappingAABox
+// The candidates come from the ends in the same way as
+// SegmentIntersect.
+//==============================================================
+void tCollisionSystemSAP::GetSkinsOverlappingAABox(
+  vector<tCollisionSkin *> & skins,
+  const tAABox & box)
+{
+  skins.resize(0);
+  GetProxySkins(skins, box.GetMinPos(), box.GetMaxPos(), true);
+  unsigned numKept = 0;
+  const unsigned numSkins = skins.size();
+  for (unsigned iSkin = 0 ; iSkin < numSkins ; ++iSkin)
+  {
+    if (OverlapTest(skins[iSkin]->GetWorldBoundingBox(), box))
+      skins[numKept++] = skins[iSkin];
+  }
+  skins.resize(numKept);
+}
@@ -15,6 +15,8 @@ using namespace std;
 // tMaterialTable
 //==============================================================
 tMaterialTable::tMaterialTable()
+  :
+  mNumDenseMaterials(0)
 {
   Reset();
 }
@@ -48,7 +50,54 @@ void tMaterialTable::Reset()
 void tMaterialTable::Clear()
 {
   mMaterials.clear();
-  mMaterialPairs.clear();
+  mDensePairs.clear();
+  mNumDenseMaterials = 0;
+  mSparsePairs.Clear();
+}
+
+//==============================================================
+// GetMaterialProperties
+//==============================================================
+const tMaterialProperties &tMaterialTable::GetMaterialProperties(tMaterialID id) const
+{
+  tMaterials::const_iterator it = mMaterials.find(id);
+  return it == mMaterials.end() ? mDefaultProperties : it->second;
+}
+
+//==============================================================
+// GrowDensePairs
+//==============================================================
+void tMaterialTable::GrowDensePairs(tMaterialID id)
+{
+  if (id < mNumDenseMaterials || id >= MAX_DENSE_MATERIAL_ID)
+    return;
+  const tMaterialID num = id + 1;
+  std::vector<tMaterialPairProperties> pairs(num * num);
+  for (tMaterialID id1 = 0 ; id1 < mNumDenseMaterials ; ++id1)
+  {
+    for (tMaterialID id2 = 0 ; id2 < mNumDenseMaterials ; ++id2)
+      pairs[id1 * num + id2] = mDensePairs[id1 * mNumDenseMaterials + id2];
+  }
+  mDensePairs.swap(pairs);
+  mNumDenseMaterials = num;
+}
+
+//==============================================================
+// SetPair
+//==============================================================
+void tMaterialTable::SetPair(tMaterialID id1, tMaterialID id2, const tMaterialPairProperties &pairProperties)
+{
+  GrowDensePairs(id1);
+  GrowDensePairs(id2);
+  if (id1 < mNumDenseMaterials && id2 < mNumDenseMaterials)
+  {
+    mDensePairs[id1 * mNumDenseMaterials + id2] = pairProperties;
+  }
+  else
+  {
+    bool isNew;
+    mSparsePairs.Insert(id1, id2, isNew) = pairProperties;
+  }
 }
 
 //==============================================================
@@ -61,10 +110,12 @@ void tMaterialTable::SetMaterialProperties(tMaterialID id, const tMaterialProper
   {
     tMaterialID otherId = it->first;
     const tMaterialProperties &mat = it->second;
-    mMaterialPairs[std::pair<tMaterialID, tMaterialID>(otherId, id)] = mMaterialPairs[std::pair<tMaterialID, tMaterialID>(id, otherId)] = tMaterialPairProperties(
+    const tMaterialPairProperties pair(
       properties.mElasticity * mat.mElasticity,
       properties.mStaticRoughness * mat.mStaticRoughness,
       properties.mDynamicRoughness * mat.mDynamicRoughness);
+    SetPair(otherId, id, pair);
+    SetPair(id, otherId, pair);
   }
 }
 
@@ -73,6 +124,7 @@ void tMaterialTable::SetMaterialProperties(tMaterialID id, const tMaterialProper
 //==============================================================
 void tMaterialTable::SetMaterialPairProperties(tMaterialID id1, tMaterialID id2, const tMaterialPairProperties &pairProperties)
 {
-  mMaterialPairs[std::pair<tMaterialID, tMaterialID>(id1, id2)] = mMaterialPairs[std::pair<tMaterialID, tMaterialID>(id2, id1)] = pairProperties;
+  SetPair(id1, id2, pairProperties);
+  SetPair(id2, id1, pairProperties);
 }
 
@@ -52,23 +52,6 @@ inline void tAABox::AddSphere(const tSphere & sphere)
   }
 }
 
-//==============================================================
-// AddBox
-//==============================================================
-inline void tAABox::AddBox(const tBox & box)
-{
-  tVector3 pts[8];
-  box.GetCornerPoints(pts);
-  AddPoint(pts[0]);
-  AddPoint(pts[1]);
-  AddPoint(pts[2]);
-  AddPoint(pts[3]);
-  AddPoint(pts[4]);
-  AddPoint(pts[5]);
-  AddPoint(pts[6]);
-  AddPoint(pts[7]);
-}
-
 //==============================================================
 // AddSegment
 //==============================================================
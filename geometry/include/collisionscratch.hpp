@@ -0,0 +1,95 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionscratch.hpp 
+//                     
+//==============================================================
+#ifndef JIGCOLLISIONSCRATCH_HPP
+#define JIGCOLLISIONSCRATCH_HPP
+
+#include "../utils/include/assert.hpp"
+
+#include <vector>
+
+namespace JigLib
+{
+  /// A stack of vectors that get reused, so that working lists don't
+  /// need allocating each time. Each one that's handed out stays in
+  /// use until it's released (in the reverse order), so a function
+  /// can borrow one whilst something that it calls borrows another.
+  template<typename T>
+  class tScratchPool
+  {
+  public:
+    tScratchPool() : mNumInUse(0) {}
+    ~tScratchPool()
+    {
+      for (unsigned i = 0 ; i < mVectors.size() ; ++i)
+        delete mVectors[i];
+    }
+
+    /// Returns an empty vector
+    std::vector<T> & Acquire()
+    {
+      if (mNumInUse == mVectors.size())
+        mVectors.push_back(new std::vector<T>);
+      std::vector<T> & vec = *mVectors[mNumInUse++];
+      vec.resize(0);
+      return vec;
+    }
+
+    void Release() {Assert(mNumInUse > 0); --mNumInUse;}
+
+  private:
+    tScratchPool(const tScratchPool &);
+    tScratchPool & operator=(const tScratchPool &);
+
+    /// pointers so that handing out more doesn't move the ones in use
+    std::vector<std::vector<T> *> mVectors;
+    unsigned mNumInUse;
+  };
+
+  /// Working space for collision detection and queries. Nothing in
+  /// the narrowphase or the query functions keeps state between calls
+  /// except in one of these, and each thread has its own, so any
+  /// number of threads can do detection/queries at once (as long as
+  /// nothing is moving or changing the skins at the same time).
+  class tCollisionScratch
+  {
+  public:
+    /// The scratch belonging to the calling thread
+    static tCollisionScratch & GetThreadScratch();
+
+    /// Triangle indices - e.g. the candidates from a mesh
+    tScratchPool<unsigned> mTriangles;
+    /// Skins - e.g. the candidates from the broadphase
+    tScratchPool<class tCollisionSkin *> mSkins;
+  };
+
+  /// Borrows a vector from a tScratchPool for as long as it's in
+  /// scope.
+  template<typename T>
+  class tScratchVector
+  {
+  public:
+    explicit tScratchVector(tScratchPool<T> & pool) : mPool(pool), mVector(pool.Acquire()) {}
+    ~tScratchVector() {mPool.Release();}
+
+    operator std::vector<T> & () {return mVector;}
+    operator const std::vector<T> & () const {return mVector;}
+    T & operator[](unsigned i) {return mVector[i];}
+    const T & operator[](unsigned i) const {return mVector[i];}
+    unsigned Size() const {return mVector.size();}
+
+  private:
+    tScratchVector(const tScratchVector &);
+    tScratchVector & operator=(const tScratchVector &);
+
+    tScratchPool<T> & mPool;
+    std::vector<T> & mVector;
+  };
+}
+
+#endif
@@ -0,0 +1,114 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file convexhull.hpp 
+//                     
+//==============================================================
+#ifndef JIGCONVEXHULL_HPP
+#define JIGCONVEXHULL_HPP
+
+#include "../geometry/include/primitive.hpp"
+#include "../geometry/include/aabox.hpp"
+#include "../maths/include/transform3.hpp"
+
+#include <vector>
+
+namespace JigLib
+{
+  /// The convex hull of a set of points. The points are given
+  /// relative to the hull's transform, and the hull is built from
+  /// them when they're set - points that are inside (or nearly on) the
+  /// hull are dropped, and coplanar triangles get merged into polygon
+  /// faces. The vertices and faces are kept in world space as well so
+  /// that collision detection doesn't need to transform them.
+  class tConvexHull : public tPrimitive
+  {
+  public:
+    tConvexHull() : tPrimitive(tPrimitive::CONVEXHULL) {}
+    tConvexHull(const tVector3 * points, unsigned numPoints,
+                const tTransform3 & transform = tTransform3(tTransform3::IDENTITY));
+
+    virtual tPrimitive* Clone() const;
+
+    // inherited
+    virtual void GetTransform(class tTransform3 &t) const {t = mTransform;}
+    virtual void SetTransform(const class tTransform3 &t);
+    virtual bool SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const;
+    virtual void GetMassProperties(const tPrimitiveProperties &primitiveProperties,
+      tScalar &mass, tVector3 &centerOfMass, tMatrix33 &inertiaTensor) const;
+    virtual tScalar GetVolume() const {return mVolume;}
+    virtual tScalar GetSurfaceArea() const {return mSurfaceArea;}
+    virtual const tAABox &GetBoundingBox() const {return mBoundingBox;}
+
+    /// Builds the hull of the points (in the hull frame). If there
+    /// are fewer than 4 distinct points, or they are all (nearly) in
+    /// a plane, the hull is just those points with no faces and no
+    /// volume, and it won't collide properly. With no points it is
+    /// empty.
+    void SetPoints(const tVector3 * points, unsigned numPoints);
+
+    /// A face is a convex polygon - its vertices are
+    /// GetFaceVertexIndex(mFirstIndex, ... mFirstIndex + mNumIndices - 1),
+    /// anticlockwise when looking at the front.
+    struct tFace
+    {
+      unsigned mFirstIndex;
+      unsigned mNumIndices;
+    };
+
+    unsigned GetNumVertices() const {return mVertices.size();}
+    /// Gets a vertex in world space
+    const tVector3 & GetVertex(unsigned iVertex) const {return mVertices[iVertex];}
+
+    unsigned GetNumFaces() const {return mFaces.size();}
+    const tFace & GetFace(unsigned iFace) const {return mFaces[iFace];}
+    unsigned GetFaceVertexIndex(unsigned i) const {return mFaceVertexIndices[i];}
+    /// Gets the outward face normal in world space
+    const tVector3 & GetFaceNormal(unsigned iFace) const {return mFaceNormals[iFace];}
+    /// Gets the distance of the face plane from the origin along the
+    /// normal, in world space
+    tScalar GetFaceDistance(unsigned iFace) const {return mFaceDistances[iFace];}
+
+    /// Returns the index of the vertex that's furthest along dir
+    unsigned GetSupportVertex(const tVector3 & dir) const;
+
+    /// Returns the index of the face whose normal is closest to dir
+    unsigned GetSupportFace(const tVector3 & dir) const;
+
+    /// The centre of the vertices in world space - inside the hull
+    /// (unless it's empty)
+    tVector3 GetCentre() const {return mTransform.position + mTransform.orientation * mLocalCentre;}
+
+  private:
+    /// Sets up the world values from the local ones
+    void UpdateWorld();
+
+    /// Makes the hull just the (non-empty) points - for when they
+    /// don't enclose any volume
+    void SetFlatPoints(const std::vector<tVector3> & pts);
+
+    tTransform3 mTransform;
+
+    // in the hull frame
+    std::vector<tVector3> mLocalVertices;
+    std::vector<tVector3> mLocalFaceNormals;
+    std::vector<tScalar> mLocalFaceDistances;
+    tVector3 mLocalCentre;
+
+    std::vector<tFace> mFaces;
+    std::vector<unsigned> mFaceVertexIndices;
+
+    // in world space
+    std::vector<tVector3> mVertices;
+    std::vector<tVector3> mFaceNormals;
+    std::vector<tScalar> mFaceDistances;
+    tAABox mBoundingBox;
+
+    tScalar mVolume;
+    tScalar mSurfaceArea;
+  };
+}
+
+#endif
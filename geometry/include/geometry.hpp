@@ -18,13 +18,16 @@
 #include "../geometry/include/plane.hpp"
 #include "../geometry/include/heightmap.hpp"
 #include "../geometry/include/box.hpp"
+#include "../geometry/include/convexhull.hpp"
 #include "../geometry/include/aabox.hpp"
 #include "../geometry/include/trianglemesh.hpp"
 
-#include "../geometry/include/octree.hpp"
+#include "../geometry/include/trianglebvh.hpp"
+#include "../geometry/include/collisionscratch.hpp"
 
 #include "../geometry/include/distance.hpp"
 #include "../geometry/include/overlap.hpp"
 #include "../geometry/include/intersection.hpp"
+#include "../geometry/include/gjk.hpp"
 
 #endif
@@ -0,0 +1,90 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file gjk.hpp 
+///                     
+/// Distance and penetration between any two convex shapes, using
+/// GJK (for the distance when they're apart) and EPA (for the depth
+/// when they overlap). Shapes are described by their support
+/// function, so anything convex can be tested against anything else
+/// without needing a special function for each pair.
+//
+//==============================================================
+#ifndef JIGGJK_HPP
+#define JIGGJK_HPP
+
+#include "../geometry/include/primitive.hpp"
+#include "../geometry/include/triangle.hpp"
+
+namespace JigLib
+{
+  /// A convex shape as a core (a point, segment, box, convex hull or
+  /// triangle) inflated by a radius - so spheres and capsules are
+  /// exact. GJK/EPA only work on the core, and the radius gets added
+  /// on afterwards, which is more robust than putting round shapes
+  /// into the support function.
+  class tSupportShape
+  {
+  public:
+    enum tCoreType {POINT, SEGMENT, BOX, CONVEXHULL, TRIANGLE};
+
+    tSupportShape() : mCoreType(POINT), mPrimitive(0), mRadius(SCALAR(0.0f)), mOffset(SCALAR(0.0f)) {mPoints[0].SetToZero();}
+
+    /// Sets up from a sphere, capsule, box or convex hull - returns
+    /// false (and doesn't change anything) for other primitives. The
+    /// primitive is referenced, not copied.
+    bool SetPrimitive(const tPrimitive & prim);
+
+    /// Sets up as a triangle (copied)
+    void SetTriangle(const tTriangle & triangle);
+
+    /// Moves the shape without changing the primitive - e.g. for
+    /// testing it at different points along a sweep
+    void SetOffset(const tVector3 & offset) {mOffset = offset;}
+
+    /// The point of the core that's furthest along dir
+    tVector3 GetSupportPoint(const tVector3 & dir) const {return GetCoreSupportPoint(dir) + mOffset;}
+
+    tScalar GetRadius() const {return mRadius;}
+
+    /// A point inside the core
+    tVector3 GetCentre() const {return GetCoreCentre() + mOffset;}
+
+    /// Gets the part of the core that faces dir the most - a face (if
+    /// its normal is within a few degrees of dir), otherwise an edge
+    /// or a single point. Face points are in order around the
+    /// face. Returns the number of points (at most maxPts).
+    unsigned GetSupportFeature(tVector3 * pts, unsigned maxPts, const tVector3 & dir) const;
+
+  private:
+    /// As above, but ignoring mOffset
+    tVector3 GetCoreSupportPoint(const tVector3 & dir) const;
+    tVector3 GetCoreCentre() const;
+    unsigned GetCoreSupportFeature(tVector3 * pts, unsigned maxPts, const tVector3 & dir) const;
+
+    tCoreType mCoreType;
+    const tPrimitive * mPrimitive;
+    /// the segment ends, or triangle corners
+    tVector3 mPoints[3];
+    tScalar mRadius;
+    tVector3 mOffset;
+  };
+
+  /// Finds the closest points of the shapes (including their radii)
+  /// and returns the separation between them - negative if they
+  /// overlap, in which case the points are the deepest ones. N is
+  /// the direction to move shape0 to separate it from shape1 (so it
+  /// points from shape1 towards shape0). Returns false if the shapes
+  /// are degenerate (e.g. both flat) so that no direction can be
+  /// found.
+  bool ConvexConvexSeparation(tScalar & separation,
+                              tVector3 & N,
+                              tVector3 & pt0,
+                              tVector3 & pt1,
+                              const tSupportShape & shape0,
+                              const tSupportShape & shape1);
+}
+
+#endif
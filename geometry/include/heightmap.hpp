@@ -12,9 +12,13 @@
 #include "../geometry/include/primitive.hpp"
 #include "../geometry/include/line.hpp"
 #include "../geometry/include/plane.hpp"
+#include "../geometry/include/aabox.hpp"
 #include "../maths/include/transform3.hpp"
 #include "../utils/include/array2d.hpp"
 
+#include <memory>
+#include <vector>
+
 namespace JigLib
 {
   /// Defines a heightmap that has up in the "z" direction indexs go
@@ -22,6 +26,10 @@ namespace JigLib
   /// heights/normals are obtained by interpolation over triangles,
   /// with each quad being divided up in the same way - the diagonal
   /// going from (i, j) to (i+1, j+1)
+  ///
+  /// The heights are never changed after construction, so they (and
+  /// the min/max pyramid built from them) are shared between copies -
+  /// e.g. the local/old/new primitives in a collision skin.
   class tHeightmap : public tPrimitive
   {    
   public:
@@ -41,9 +49,10 @@ namespace JigLib
       tScalar &mass, tVector3 &centerOfMass, tMatrix33 &inertiaTensor) const;
     virtual tScalar GetVolume() const {return 0.0f;}
     virtual tScalar GetSurfaceArea() const {return 0.0f;}
+    virtual const tAABox &GetBoundingBox() const {return mBoundingBox;}
 
-    unsigned GetNx() const {return mHeights.GetNx();}
-    unsigned GetNy() const {return mHeights.GetNy();}
+    unsigned GetNx() const {return mData->mHeights.GetNx();}
+    unsigned GetNy() const {return mData->mHeights.GetNy();}
     
     /// Get the height at a particular index
     /// indices are clamped
@@ -73,9 +82,68 @@ namespace JigLib
     void GetSurfacePosAndNormal(tVector3 & pos, 
                                 tVector3 & normal, 
                                 const tVector3 & point) const;
+
+    /// Gets the range of cells that the box covers in x and y. Cell
+    /// (i, j) goes from grid point (i, j) to (i+1, j+1). Returns false
+    /// if the box is off the heightmap.
+    bool GetCellRange(int & iMin, int & jMin, int & iMax, int & jMax,
+                      const class tAABox & box) const;
+
+    /// Gets the two triangles (facing up) that make up a cell
+    void GetCellTriangles(class tTriangle & tri0, class tTriangle & tri1,
+                          int i, int j) const;
+
+    /// Gets the lowest and highest heights over the cells iMin to iMax
+    /// and jMin to jMax (inclusive) from the min/max pyramid. The
+    /// range may be a bit bigger than the exact one, as it comes from
+    /// blocks that cover the cells.
+    void GetHeightRange(tScalar & hMin, tScalar & hMax,
+                        int iMin, int jMin, int iMax, int jMax) const;
+
+    /// As above, for the cells under the box. A box that's off the
+    /// heightmap gets the range of the nearest edge, to match the
+    /// height queries.
+    void GetHeightRange(tScalar & hMin, tScalar & hMax, const class tAABox & box) const;
+
   private:
-    tArray2D<tScalar> mHeights;
-    
+    struct tHeightRange
+    {
+      tScalar mMin, mMax;
+    };
+
+    /// Level 0 of the pyramid has the range of each block of 2x2
+    /// cells, and each level above covers 2x2 blocks of the one below,
+    /// up to a single block.
+    struct tData
+    {
+      tArray2D<tScalar> mHeights;
+      std::vector<tArray2D<tHeightRange> > mLevels;
+    };
+
+    /// Builds the pyramid levels from the heights
+    static void BuildLevels(tData & data);
+
+    /// The range of block (i, j) of level, clamped into the level
+    const tHeightRange & GetBlockRange(unsigned level, int i, int j) const;
+
+    /// Intersects the segment with the triangles in block (i, j) of
+    /// level, where the segment is over the block between t0 and t1
+    /// (fractions along it). frac is the closest hit so far - returns
+    /// true if there's a closer one.
+    bool SegmentIntersectBlock(tScalar & frac, tVector3 & normal, const class tSegment & seg,
+                               unsigned level, int i, int j, tScalar t0, tScalar t1) const;
+
+    /// Intersects the part of the segment between t0 and t1, which
+    /// isn't over the heightmap, with the surface that
+    /// GetHeightAndNormal extends out from the edges. Returns true
+    /// (and sets frac/normal) for the first place it goes from above
+    /// to below.
+    bool SegmentIntersectOutside(tScalar & frac, tVector3 & normal, const class tSegment & seg,
+                                 tScalar t0, tScalar t1) const;
+
+    std::shared_ptr<const tData> mData;
+    tAABox mBoundingBox;
+
     tScalar mX0, mY0;
     tScalar mDx, mDy;
     tScalar mXMin, mYMin;
@@ -38,8 +38,11 @@ namespace JigLib
     /// Get the triangle plane
     const tPlane& GetPlane() const {return mPlane;}
 
-    /// Has the edge been marked as convex. Same convention for edge
-    /// numbering as in tTriangle.
+    /// Has the edge been marked as convex. Edge i goes from corner i
+    /// to corner (i + 1) % 3, as in tEdgesToTest. Edges that are flat
+    /// or concave (or shared by more than two triangles) aren't
+    /// convex, and contacts on them should come from the neighbouring
+    /// triangle's face instead.
     bool IsEdgeConvex(unsigned iEdge) const {return 0 != (mConvexFlags & (1 << iEdge));}
     void SetEdgeConvex(unsigned iEdge, bool convex) {
       if (convex) mConvexFlags |= (1 << iEdge); else mConvexFlags &= ~(1 << iEdge);}
@@ -50,10 +53,12 @@ namespace JigLib
     void SetPointConvex(unsigned iPoint, bool convex) {
       if (convex) mConvexFlags |= (1 << (iPoint+3)); else mConvexFlags &= ~(1 << (iPoint+3));}
 
-    const tAABox & GetBoundingBox() const {return mBoundingBox;}
+    /// The convex edges/points as bit masks - bit i for edge/point i -
+    /// which can be passed on as tEdgesToTest/tCornersToTest
+    unsigned GetConvexEdges() const {return mConvexFlags & 7;}
+    unsigned GetConvexPoints() const {return (mConvexFlags >> 3) & 7;}
 
-    // used when traversing to stop us visiting the same triangle twice
-    mutable unsigned m_counter;
+    const tAABox & GetBoundingBox() const {return mBoundingBox;}
   private:
     /// indices into our owner's array of vertices 
     int mVertexIndices[3];
@@ -94,6 +94,25 @@ namespace JigLib
                                        tEdgesToTest edgesToTest = EDGE_ALL,
                                        tCornersToTest cornersToTest = CORNER_ALL);
 
+  /// Indicates if shape, moved by delta, would hit prim, and if so
+  /// returns the fraction of delta when they first touch, the contact
+  /// point and the normal (pointing from prim towards shape). shape
+  /// must be a sphere, capsule or box. prim can be any of the built-in
+  /// primitives apart from tAABox. Like the other tests this is
+  /// "sided" - there's no hit if shape is already moving away from
+  /// prim, and planes, heightmaps and mesh triangles can only be hit
+  /// from the front. If they start off overlapping the fraction is 0
+  /// and the normal is only approximate.
+  bool SweptPrimitiveIntersection(tScalar& frac, tVector3& pt, tVector3& N,
+                                  const tPrimitive& shape, const tVector3& delta,
+                                  const tPrimitive& prim);
+
+  /// Indicates if shape (a sphere, capsule or box) overlaps prim
+  /// (any of the built-in primitives apart from tAABox). Touching
+  /// counts as overlapping. Heightmaps are solid underneath, but
+  /// meshes are just surfaces.
+  bool PrimitiveOverlap(const tPrimitive& shape, const tPrimitive& prim);
+
 #include "../geometry/include/intersection.inl"
 }
 
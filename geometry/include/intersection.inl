@@ -198,8 +198,8 @@ inline bool SweptSpherePlaneIntersection(tVector3& pt, tScalar& finalPenetration
   if (newDistToPlane > radius)
     return false;
 
-  // intersect with plane
-  tScalar t = (newDistToPlane - radius) / (newDistToPlane - oldDistToPlane);
+  // intersect with plane - t is measured from the old position
+  tScalar t = (oldDistToPlane - radius) / (oldDistToPlane - newDistToPlane);
   if (t < 0.0f || t > 1.0f)
     return false;
 
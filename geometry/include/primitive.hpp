@@ -30,6 +30,7 @@ namespace JigLib
       AABOX,
       BOX,
       CAPSULE,
+      CONVEXHULL,
       HEIGHTMAP,
       PLANE,
       SPHERE,
@@ -49,6 +50,12 @@ namespace JigLib
     /// must support intersection with a segment (ray cast)
     virtual bool SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const = 0;
 
+    /// Intersects each of the segments with the primitive. fracs gets
+    /// SCALAR_HUGE where there's no hit. The default just calls
+    /// SegmentIntersect for each one. Returns the number of hits.
+    virtual unsigned SegmentIntersectBatch(tScalar * fracs, tVector3 * positions, tVector3 * normals,
+                                           const class tSegment * segs, unsigned numSegs) const;
+
     struct tPrimitiveProperties
     {
       enum tMassDistribution {SOLID, SHELL};
@@ -86,6 +93,9 @@ namespace JigLib
     class tCapsule &GetCapsule() {Assert(mType == CAPSULE); return *((tCapsule*) this);}
     const class tCapsule &GetCapsule() const {Assert(mType == CAPSULE); return *((const tCapsule*) this);}
 
+    class tConvexHull &GetConvexHull() {Assert(mType == CONVEXHULL); return *((tConvexHull*) this);}
+    const class tConvexHull &GetConvexHull() const {Assert(mType == CONVEXHULL); return *((const tConvexHull*) this);}
+
     class tHeightmap &GetHeightmap() {Assert(mType == HEIGHTMAP); return *((tHeightmap*) this);}
     const class tHeightmap &GetHeightmap() const {Assert(mType == HEIGHTMAP); return *((const tHeightmap*) this);}
 
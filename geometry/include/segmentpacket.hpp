@@ -0,0 +1,81 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file segmentpacket.hpp 
+//                     
+//==============================================================
+#ifndef JIGSEGMENTPACKET_HPP
+#define JIGSEGMENTPACKET_HPP
+
+#include "../geometry/include/line.hpp"
+#include "../maths/include/mathsmisc.hpp"
+#include "../utils/include/assert.hpp"
+
+namespace JigLib
+{
+  /// Up to SIZE segments stored component by component, so that they
+  /// can all be tested against a bounding box at once when walking a
+  /// tree - the loops over the lanes are simple enough for the
+  /// compiler to vectorise. Each lane has a maximum fraction (normally
+  /// the closest hit so far) beyond which boxes are ignored.
+  struct tSegmentPacket
+  {
+    enum {SIZE = 4};
+
+    /// Sets up the first num lanes from segs. Unused lanes never
+    /// overlap anything.
+    void Set(const tSegment * segs, unsigned num)
+    {
+      Assert(num <= SIZE);
+      for (unsigned iLane = 0 ; iLane < SIZE ; ++iLane)
+      {
+        const tSegment & seg = segs[iLane < num ? iLane : 0];
+        for (unsigned i = 0 ; i < 3 ; ++i)
+        {
+          mOrigin[i][iLane] = seg.mOrigin[i];
+          mInvDelta[i][iLane] = SafeInvScalar(seg.mDelta[i]);
+        }
+        mMaxFrac[iLane] = iLane < num ? SCALAR(1.0f) : SCALAR(-1.0f);
+      }
+    }
+
+    /// Returns a mask with bit i set if segment i passes through the
+    /// box at some fraction up to its mMaxFrac
+    unsigned OverlapMask(const tScalar * minPos, const tScalar * maxPos) const
+    {
+      tScalar tMin[SIZE];
+      tScalar tMax[SIZE];
+      unsigned iLane;
+      for (iLane = 0 ; iLane < SIZE ; ++iLane)
+      {
+        tMin[iLane] = SCALAR(0.0f);
+        tMax[iLane] = mMaxFrac[iLane];
+      }
+      for (unsigned i = 0 ; i < 3 ; ++i)
+      {
+        for (iLane = 0 ; iLane < SIZE ; ++iLane)
+        {
+          tScalar t0 = (minPos[i] - mOrigin[i][iLane]) * mInvDelta[i][iLane];
+          tScalar t1 = (maxPos[i] - mOrigin[i][iLane]) * mInvDelta[i][iLane];
+          tMin[iLane] = Max(tMin[iLane], Min(t0, t1));
+          tMax[iLane] = Min(tMax[iLane], Max(t0, t1));
+        }
+      }
+      unsigned mask = 0;
+      for (iLane = 0 ; iLane < SIZE ; ++iLane)
+      {
+        if (tMin[iLane] <= tMax[iLane])
+          mask |= 1 << iLane;
+      }
+      return mask;
+    }
+
+    tScalar mOrigin[3][SIZE];
+    tScalar mInvDelta[3][SIZE];
+    tScalar mMaxFrac[SIZE];
+  };
+}
+
+#endif
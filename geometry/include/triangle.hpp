@@ -70,6 +70,9 @@ namespace JigLib
     }
   }
 
+  inline tTriangle::tTriangle()
+  {}
+
   inline tTriangle::tTriangle(const tVector3& pt0, const tVector3& pt1, const tVector3& pt2)
     : mOrigin(pt0), mEdge0(pt1 - pt0), mEdge1(pt2 - pt0) 
   {}
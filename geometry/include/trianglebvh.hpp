@@ -0,0 +1,132 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file trianglebvh.hpp 
+//                     
+//==============================================================
+#ifndef JIGTRIANGLEBVH_HPP
+#define JIGTRIANGLEBVH_HPP
+
+#include "../geometry/include/indexedtriangle.hpp"
+
+#include <vector>
+
+namespace JigLib
+{
+  /// Stores a set of triangles in a bounding volume hierarchy for
+  /// quick box queries. The tree is built once using the surface area
+  /// heuristic, and is stored as a flat array of nodes in depth-first
+  /// order, so queries just walk forwards through the array (skipping
+  /// subtrees that don't overlap) without needing a stack. Each
+  /// triangle is in exactly one leaf, and the triangles are reordered
+  /// so that each leaf refers to a contiguous range of them - so
+  /// triangle indices are not the same as the order they were added
+  /// in.
+  class tTriangleBVH
+  {
+  public:
+    tTriangleBVH();
+    ~tTriangleBVH();
+
+    /// Gets the number of triangles
+    unsigned GetNumTriangles() const {return mTriangles.size();}
+
+    /// Get a triangle
+    const tIndexedTriangle & GetTriangle(unsigned iTriangle) const {
+      return mTriangles[iTriangle];}
+
+    /// Get a vertex
+    const tVector3 & GetVertex(unsigned iVertex) const {return mVertices[iVertex];}
+
+    /// The box around all the triangles (cleared if there aren't any)
+    tAABox GetBoundingBox() const;
+
+    enum {NO_NEIGHBOUR = 0xffffffff};
+
+    /// Gets the triangle on the other side of iEdge (numbered as in
+    /// tIndexedTriangle), or NO_NEIGHBOUR if it's an open edge
+    unsigned GetEdgeNeighbour(unsigned iTriangle, unsigned iEdge) const {
+      return mEdgeNeighbours[3 * iTriangle + iEdge];}
+
+    /// Add the triangles (degenerate ones are dropped) - doesn't
+    /// actually build the tree
+    void AddTriangles(const tVector3 * vertices, unsigned numVertices,
+                      const tTriangleVertexIndices * triangleVertexIndices,
+                      unsigned numTriangles);
+
+    /// Clears triangles and nodes. If freeMemory is false the memory
+    /// is kept for reuse.
+    void Clear(bool freeMemory = true);
+
+    /// Builds the tree from scratch. Nodes get split until they have
+    /// no more than maxTrianglesPerLeaf triangles (unless the
+    /// triangles can't be separated).
+    void BuildBVH(unsigned maxTrianglesPerLeaf);
+
+    /// Finds the neighbours of each triangle, and marks each edge and
+    /// point as convex or not. Triangles are only neighbours if they
+    /// use the same vertex indices (wound in opposite directions), and
+    /// edges shared by more than two triangles are left open. Call
+    /// after BuildBVH, since that reorders the triangles.
+    void BuildConnectivity();
+
+    /// Gets a list of all triangle indices that intersect an tAABox. The vector passed in resized,
+    /// so if you keep it between calls after a while it won't grow any more, and this
+    /// won't allocate more memory. The indices are in increasing order.
+    /// Doesn't modify the tree, so can be called from more than one thread at once.
+    /// Returns the number of triangles (same as triangles.size())
+    unsigned GetTrianglesIntersectingtAABox(std::vector<unsigned>& triangles, const tAABox& aabb) const;
+
+    /// Finds the closest triangle hit by each of the segments, tracing
+    /// them through the tree in packets. fracs gets SCALAR_HUGE for
+    /// segments that don't hit anything, and triangles gets the
+    /// triangle index for those that do. Returns the number of
+    /// segments that hit something.
+    unsigned SegmentIntersectBatch(tScalar * fracs, unsigned * triangles,
+                                   const class tSegment * segs, unsigned numSegs) const;
+
+    /// Write out some info
+    void DumpStats() const;
+
+  private:
+    /// A node is 32 bytes (with single precision). The first child of
+    /// an internal node is always the next node.
+    struct tNode
+    {
+      bool IsLeaf() const {return mNumTriangles != 0;}
+      tScalar mMin[3];
+      /// first triangle for leaves. For internal nodes it's the node
+      /// after the subtree - i.e. where to go if the node is missed.
+      unsigned mIndex;
+      tScalar mMax[3];
+      /// 0 for internal nodes
+      unsigned mNumTriangles;
+    };
+
+    /// Builds the node for the triangles mTriangleOrder[begin, end),
+    /// and everything below it
+    void BuildNode(unsigned begin, unsigned end, unsigned maxTrianglesPerLeaf);
+
+    /// Chooses where to split the triangles mTriangleOrder[begin, end)
+    /// and partitions them. Returns the index of the first triangle in
+    /// the second half, or begin if it's better not to split. area is
+    /// the surface area of the node.
+    unsigned SplitTriangles(unsigned begin, unsigned end, tScalar area, bool mustSplit);
+
+    std::vector<tNode> mNodes;
+    /// the vertices
+    std::vector<tVector3> mVertices;
+    /// All our triangles, in leaf order once the tree is built
+    std::vector<tIndexedTriangle> mTriangles;
+    /// Three per triangle - see GetEdgeNeighbour
+    std::vector<unsigned> mEdgeNeighbours;
+
+    /// Only used during the build
+    std::vector<unsigned> mTriangleOrder;
+    std::vector<tVector3> mCentres;
+  };
+
+} // namespace
+#endif
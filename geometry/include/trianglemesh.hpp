@@ -9,14 +9,25 @@
 #ifndef JIGTRIANGLEMESH_HPP
 #define JIGTRIANGLEMESH_HPP
 
-#include "../geometry/include/octree.hpp"
+#include "../geometry/include/trianglebvh.hpp"
 #include "../geometry/include/primitive.hpp"
+#include "../geometry/include/aabox.hpp"
+#include "../maths/include/transform3.hpp"
+#include <memory>
 #include <vector>
 
 namespace JigLib
 {
   // contains a bunch of triangles and their related information
   // (vertices, edges etc) that can be used for higher level queries.
+  // The triangles and their tree don't change once the mesh is
+  // created, so copies (e.g. in collision skins) share them.
+  //
+  // The triangles are in mesh space, and the transform takes them
+  // into the world. So a mesh can be copied and each copy given its
+  // own transform to place lots of instances of it, or it can be put
+  // in the collision skin of a (kinematic) body. Everything that gets
+  // triangles, vertices or normals from the mesh works in mesh space.
   class tTriangleMesh : public tPrimitive
   {
   public:
@@ -24,9 +35,12 @@ namespace JigLib
 
     virtual tPrimitive* Clone() const;
 
-    virtual void GetTransform(class tTransform3 &t) const {t.position.SetTo(0.0f); t.orientation.SetToIdentity();}
-    virtual void SetTransform(const class tTransform3 &t) {}
+    virtual void GetTransform(class tTransform3 &t) const {t = mTransform;}
+    virtual void SetTransform(const class tTransform3 &t);
+    virtual const tAABox &GetBoundingBox() const {return mBoundingBox;}
     virtual bool SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const;
+    virtual unsigned SegmentIntersectBatch(tScalar * fracs, tVector3 * positions, tVector3 * normals,
+                                           const class tSegment * segs, unsigned numSegs) const;
     virtual void GetMassProperties(const tPrimitiveProperties &primitiveProperties, 
       tScalar &mass, tVector3 &centerOfMass, tMatrix33 &inertiaTensor) const;
     virtual tScalar GetVolume() const {return 0.0f;}
@@ -34,30 +48,78 @@ namespace JigLib
 
     /// Internally set up and preprocess all numTriangles. Each index
     /// should, of course, be from 0 to numVertices-1. Vertices and
-    /// triangles are copied and stored internally.
+    /// triangles are copied and stored internally. The triangles are
+    /// stored in a tree with up to maxTrianglesPerCell in each
+    /// leaf. minCellSize isn't used any more. Triangles that share
+    /// vertex indices are joined up, and their edges get marked as
+    /// convex or not (see tIndexedTriangle) - so vertices that are
+    /// meant to be shared should be shared.
     void CreateMesh(const tVector3 * vertices, unsigned numVertices,
                     const tTriangleVertexIndices * triangleVertexIndices,
                     unsigned numTriangles,
                     int maxTrianglesPerCell, tScalar minCellSize);
 
-    unsigned GetNumTriangles() const {return mOctree.GetNumTriangles();}
+    /// False if the transform is the identity - i.e. mesh space is
+    /// world space
+    bool HasTransform() const {return mHasTransform;}
+
+    /// Converts from world space into mesh space
+    tVector3 PointToMesh(const tVector3 & pt) const {
+      return mHasTransform ? DirToMesh(pt - mTransform.position) : pt;}
+    tVector3 DirToMesh(const tVector3 & dir) const {
+      const tMatrix33 & orient = mTransform.orientation;
+      return mHasTransform ? tVector3(Dot(dir, orient[0]), Dot(dir, orient[1]), Dot(dir, orient[2])) : dir;}
+    /// Gets the mesh-space box around a world-space box
+    tAABox AABoxToMesh(const tAABox & box) const;
+    /// Gets a primitive's transform relative to the mesh
+    tTransform3 TransformToMesh(const tTransform3 & t) const;
+
+    /// Converts from mesh space into world space
+    tVector3 PointToWorld(const tVector3 & pt) const {
+      return mHasTransform ? mTransform.position + mTransform.orientation * pt : pt;}
+    tVector3 DirToWorld(const tVector3 & dir) const {
+      return mHasTransform ? mTransform.orientation * dir : dir;}
+
+    unsigned GetNumTriangles() const {return mBVH->GetNumTriangles();}
 
     /// Get a triangle
     const tIndexedTriangle & GetTriangle(unsigned iTriangle) const {
-      return mOctree.GetTriangle(iTriangle);}
+      return mBVH->GetTriangle(iTriangle);}
 
     /// Get a vertex
-    const tVector3 & GetVertex(unsigned iVertex) const {return mOctree.GetVertex(iVertex);}
+    const tVector3 & GetVertex(unsigned iVertex) const {return mBVH->GetVertex(iVertex);}
 
-    /// Gets a list of all triangle indices that intersect an tAABox. The vector passed in resized,
+    /// Gets the triangle on the other side of iEdge, or
+    /// tTriangleBVH::NO_NEIGHBOUR
+    unsigned GetEdgeNeighbour(unsigned iTriangle, unsigned iEdge) const {
+      return mBVH->GetEdgeNeighbour(iTriangle, iEdge);}
+
+    /// Checks if a contact with the triangle can have the normal N
+    /// (normalised, pointing away from the triangle, in mesh space). If the part of
+    /// the triangle furthest along N is an edge or a point it has to
+    /// be convex, and for an edge N has to be between the normals of
+    /// the triangles either side of it. Otherwise the contact is on an
+    /// internal/concave edge, and should come from the neighbouring
+    /// triangle's face instead.
+    bool IsContactNormalValid(unsigned iTriangle, const tVector3 & N) const;
+
+    /// Gets a list of all triangle indices that intersect an tAABox
+    /// (in mesh space - see AABoxToMesh). The vector passed in resized,
     /// so if you keep it between calls after a while it won't grow any more, and this
-    /// won't allocate more memory.
+    /// won't allocate more memory. The indices are in increasing order.
     /// Returns the number of triangles (same as triangles.size())
     unsigned GetTrianglesIntersectingtAABox(std::vector<unsigned>& triangles, const tAABox& aabb) const {
-      return mOctree.GetTrianglesIntersectingtAABox(triangles, aabb);}
+      return mBVH->GetTrianglesIntersectingtAABox(triangles, aabb);}
 
   private:
-    tOctree mOctree;
+    /// Sets mBoundingBox from the tree and the transform
+    void UpdateBoundingBox();
+
+    std::shared_ptr<const tTriangleBVH> mBVH;
+    tTransform3 mTransform;
+    bool mHasTransform;
+    /// in world space
+    tAABox mBoundingBox;
   };
 }
 
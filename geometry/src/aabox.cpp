@@ -43,6 +43,22 @@ void tAABox::GetMassProperties(const tPrimitiveProperties &primitiveProperties,
   inertiaTensor.SetTo(0.0f);
 }
 
+//==============================================================
+// AddBox
+//==============================================================
+void tAABox::AddBox(const tBox & box)
+{
+  tVector3 pts[8];
+  box.GetCornerPoints(pts);
+  AddPoint(pts[0]);
+  AddPoint(pts[1]);
+  AddPoint(pts[2]);
+  AddPoint(pts[3]);
+  AddPoint(pts[4]);
+  AddPoint(pts[5]);
+  AddPoint(pts[6]);
+  AddPoint(pts[7]);
+}
 
 //==============================================================
 // AddPrimitive
@@ -0,0 +1,20 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file collisionscratch.cpp 
+//                     
+//==============================================================
+#include "collisionscratch.hpp"
+
+using namespace JigLib;
+
+//==============================================================
+// GetThreadScratch
+//==============================================================
+tCollisionScratch & tCollisionScratch::GetThreadScratch()
+{
+  thread_local tCollisionScratch scratch;
+  return scratch;
+}
@@ -0,0 +1,533 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file convexhull.cpp 
+//                     
+//==============================================================
+#include "convexhull.hpp"
+#include "line.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+using namespace JigLib;
+using namespace std;
+
+/// Triangles whose normals are closer than this get merged into the
+/// same face (if they're in the same plane)
+static const tScalar faceMergeCosAngle = SCALAR(0.99999f);
+
+//==============================================================
+// tHullTriangle
+// Used while building the hull - the vertices are anticlockwise
+// when looking from outside
+//==============================================================
+struct tHullTriangle
+{
+  unsigned mV[3];
+  tVector3 mN;
+  tScalar mD;
+};
+
+//==============================================================
+// MakeHullTriangle
+// Faces the triangle away from inside
+//==============================================================
+static tHullTriangle MakeHullTriangle(const vector<tVector3> & pts,
+                                      unsigned i0, unsigned i1, unsigned i2,
+                                      const tVector3 & inside)
+{
+  tHullTriangle tri;
+  tri.mV[0] = i0;
+  tri.mV[1] = i1;
+  tri.mV[2] = i2;
+  tri.mN = Cross(pts[i1] - pts[i0], pts[i2] - pts[i0]).NormaliseSafe();
+  tri.mD = Dot(tri.mN, pts[i0]);
+  if (Dot(tri.mN, inside) > tri.mD)
+  {
+    Swap(tri.mV[1], tri.mV[2]);
+    tri.mN.Negate();
+    tri.mD = -tri.mD;
+  }
+  return tri;
+}
+
+//==============================================================
+// AddOuterProduct
+// m += scale * a * b^T
+//==============================================================
+static inline void AddOuterProduct(tMatrix33 & m, const tVector3 & a, const tVector3 & b, tScalar scale)
+{
+  for (unsigned i = 0 ; i < 3 ; ++i)
+    for (unsigned j = 0 ; j < 3 ; ++j)
+      m(i, j) += scale * a[i] * b[j];
+}
+
+//==============================================================
+// tConvexHull
+//==============================================================
+tConvexHull::tConvexHull(const tVector3 * points, unsigned numPoints,
+                         const tTransform3 & transform)
+  :
+  tPrimitive(tPrimitive::CONVEXHULL),
+  mTransform(transform)
+{
+  SetPoints(points, numPoints);
+}
+
+//==============================================================
+// Clone
+//==============================================================
+tPrimitive* tConvexHull::Clone() const
+{
+  return new tConvexHull(*this);
+}
+
+//==============================================================
+// SetTransform
+//==============================================================
+void tConvexHull::SetTransform(const tTransform3 &t)
+{
+  mTransform = t;
+  UpdateWorld();
+}
+
+//==============================================================
+// UpdateWorld
+//==============================================================
+void tConvexHull::UpdateWorld()
+{
+  const tVector3 & pos = mTransform.position;
+  const tMatrix33 & orient = mTransform.orientation;
+  const unsigned numVertices = mLocalVertices.size();
+  mVertices.resize(numVertices);
+  mBoundingBox.Clear();
+  unsigned i;
+  for (i = 0 ; i < numVertices ; ++i)
+  {
+    mVertices[i] = pos + orient * mLocalVertices[i];
+    mBoundingBox.AddPoint(mVertices[i]);
+  }
+  const unsigned numFaces = mFaces.size();
+  mFaceNormals.resize(numFaces);
+  mFaceDistances.resize(numFaces);
+  for (i = 0 ; i < numFaces ; ++i)
+  {
+    mFaceNormals[i] = orient * mLocalFaceNormals[i];
+    mFaceDistances[i] = mLocalFaceDistances[i] + Dot(mFaceNormals[i], pos);
+  }
+}
+
+//==============================================================
+// SetPoints
+// Incremental construction - start with a tetrahedron and then add
+// each point that's outside, replacing the triangles it can see.
+//==============================================================
+void tConvexHull::SetPoints(const tVector3 * points, unsigned numPoints)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+  mLocalVertices.resize(0);
+  mLocalFaceNormals.resize(0);
+  mLocalFaceDistances.resize(0);
+  mFaces.resize(0);
+  mFaceVertexIndices.resize(0);
+  mLocalCentre.SetToZero();
+  mVolume = SCALAR(0.0f);
+  mSurfaceArea = SCALAR(0.0f);
+  if (numPoints == 0)
+  {
+    UpdateWorld();
+    return;
+  }
+
+  tAABox box;
+  unsigned i, j;
+  for (i = 0 ; i < numPoints ; ++i)
+    box.AddPoint(points[i]);
+  const tScalar tol = Max(SCALAR(0.00001f) * box.GetSideLengths().GetLength(), SCALAR_TINY);
+
+  // drop duplicates
+  vector<tVector3> pts;
+  pts.reserve(numPoints);
+  for (i = 0 ; i < numPoints ; ++i)
+  {
+    for (j = 0 ; j < pts.size() ; ++j)
+    {
+      if ((points[i] - pts[j]).GetLengthSq() < Sq(tol))
+        break;
+    }
+    if (j == pts.size())
+      pts.push_back(points[i]);
+  }
+  const unsigned numPts = pts.size();
+  if (numPts < 4)
+  {
+    // a point, segment or triangle
+    SetFlatPoints(pts);
+    return;
+  }
+
+  // the initial tetrahedron - the two points furthest apart out of
+  // the extreme ones along the axes, then the furthest from the line
+  // through them, and the furthest from that plane.
+  unsigned extremes[6] = {0, 0, 0, 0, 0, 0};
+  for (i = 0 ; i < numPts ; ++i)
+  {
+    for (j = 0 ; j < 3 ; ++j)
+    {
+      if (pts[i][j] < pts[extremes[2 * j]][j])
+        extremes[2 * j] = i;
+      if (pts[i][j] > pts[extremes[2 * j + 1]][j])
+        extremes[2 * j + 1] = i;
+    }
+  }
+  unsigned iTet[4] = {0, 0, 0, 0};
+  tScalar best = -SCALAR(1.0f);
+  for (i = 0 ; i < 6 ; ++i)
+  {
+    for (j = i + 1 ; j < 6 ; ++j)
+    {
+      tScalar distSq = (pts[extremes[i]] - pts[extremes[j]]).GetLengthSq();
+      if (distSq > best)
+      {
+        best = distSq;
+        iTet[0] = extremes[i];
+        iTet[1] = extremes[j];
+      }
+    }
+  }
+  best = SCALAR(0.0f);
+  const tVector3 lineDir = (pts[iTet[1]] - pts[iTet[0]]).NormaliseSafe();
+  for (i = 0 ; i < numPts ; ++i)
+  {
+    tScalar distSq = Cross(pts[i] - pts[iTet[0]], lineDir).GetLengthSq();
+    if (distSq > best)
+    {
+      best = distSq;
+      iTet[2] = i;
+    }
+  }
+  tVector3 baseNormal(SCALAR(0.0f));
+  if (best > Sq(tol))
+  {
+    baseNormal = Cross(pts[iTet[1]] - pts[iTet[0]], pts[iTet[2]] - pts[iTet[0]]).NormaliseSafe();
+    best = SCALAR(0.0f);
+    for (i = 0 ; i < numPts ; ++i)
+    {
+      tScalar dist = Abs(Dot(pts[i] - pts[iTet[0]], baseNormal));
+      if (dist > best)
+      {
+        best = dist;
+        iTet[3] = i;
+      }
+    }
+  }
+  if (best <= tol)
+  {
+    TRACE("Warning: convex hull of %d points is flat\n", numPoints);
+    SetFlatPoints(pts);
+    return;
+  }
+
+  const tVector3 inside = 0.25f * (pts[iTet[0]] + pts[iTet[1]] + pts[iTet[2]] + pts[iTet[3]]);
+  vector<tHullTriangle> tris;
+  tris.push_back(MakeHullTriangle(pts, iTet[0], iTet[1], iTet[2], inside));
+  tris.push_back(MakeHullTriangle(pts, iTet[0], iTet[1], iTet[3], inside));
+  tris.push_back(MakeHullTriangle(pts, iTet[0], iTet[2], iTet[3], inside));
+  tris.push_back(MakeHullTriangle(pts, iTet[1], iTet[2], iTet[3], inside));
+
+  vector<tHullTriangle> keptTris;
+  vector<pair<unsigned, unsigned> > edges;
+  for (i = 0 ; i < numPts ; ++i)
+  {
+    if (i == iTet[0] || i == iTet[1] || i == iTet[2] || i == iTet[3])
+      continue;
+    keptTris.resize(0);
+    edges.resize(0);
+    for (j = 0 ; j < tris.size() ; ++j)
+    {
+      const tHullTriangle & tri = tris[j];
+      if (Dot(tri.mN, pts[i]) - tri.mD > tol)
+      {
+        for (unsigned k = 0 ; k < 3 ; ++k)
+          edges.push_back(pair<unsigned, unsigned>(tri.mV[k], tri.mV[(k + 1) % 3]));
+      }
+      else
+      {
+        keptTris.push_back(tri);
+      }
+    }
+    if (edges.empty())
+      continue;
+    // The horizon is the edges that only one of the visible triangles has
+    for (j = 0 ; j < edges.size() ; ++j)
+    {
+      pair<unsigned, unsigned> reversed(edges[j].second, edges[j].first);
+      if (find(edges.begin(), edges.end(), reversed) == edges.end())
+        keptTris.push_back(MakeHullTriangle(pts, edges[j].first, edges[j].second, i, inside));
+    }
+    tris.swap(keptTris);
+  }
+
+  // Only keep the points that are used
+  vector<int> vertexMap(numPts, -1);
+  for (i = 0 ; i < tris.size() ; ++i)
+  {
+    for (j = 0 ; j < 3 ; ++j)
+    {
+      unsigned & v = tris[i].mV[j];
+      if (vertexMap[v] < 0)
+      {
+        vertexMap[v] = mLocalVertices.size();
+        mLocalVertices.push_back(pts[v]);
+        mLocalCentre += pts[v];
+      }
+      v = vertexMap[v];
+    }
+  }
+  mLocalCentre /= (tScalar) mLocalVertices.size();
+
+  // Merge triangles in the same plane into faces. The face vertices
+  // are sorted by angle around the middle of the face.
+  vector<bool> done(tris.size(), false);
+  vector<unsigned> faceVertices;
+  vector<pair<tScalar, unsigned> > angles;
+  for (i = 0 ; i < tris.size() ; ++i)
+  {
+    if (done[i])
+      continue;
+    const tVector3 N = tris[i].mN;
+    faceVertices.resize(0);
+    for (j = i ; j < tris.size() ; ++j)
+    {
+      if (done[j] || Dot(tris[j].mN, N) < faceMergeCosAngle)
+        continue;
+      unsigned k;
+      for (k = 0 ; k < 3 ; ++k)
+      {
+        if (Abs(Dot(N, mLocalVertices[tris[j].mV[k]]) - tris[i].mD) > tol)
+          break;
+      }
+      if (k < 3)
+        continue;
+      done[j] = true;
+      for (k = 0 ; k < 3 ; ++k)
+      {
+        if (find(faceVertices.begin(), faceVertices.end(), tris[j].mV[k]) == faceVertices.end())
+          faceVertices.push_back(tris[j].mV[k]);
+      }
+    }
+
+    tVector3 middle(SCALAR(0.0f));
+    for (j = 0 ; j < faceVertices.size() ; ++j)
+      middle += mLocalVertices[faceVertices[j]];
+    middle /= (tScalar) faceVertices.size();
+    const tVector3 u = (mLocalVertices[faceVertices[0]] - middle).NormaliseSafe();
+    const tVector3 v = Cross(N, u);
+    angles.resize(0);
+    tScalar d = -SCALAR_HUGE;
+    for (j = 0 ; j < faceVertices.size() ; ++j)
+    {
+      const tVector3 & pt = mLocalVertices[faceVertices[j]];
+      angles.push_back(pair<tScalar, unsigned>(ATan2(Dot(pt - middle, v), Dot(pt - middle, u)),
+                                               faceVertices[j]));
+      d = Max(d, Dot(N, pt));
+    }
+    sort(angles.begin(), angles.end());
+
+    tFace face;
+    face.mFirstIndex = mFaceVertexIndices.size();
+    face.mNumIndices = angles.size();
+    mFaces.push_back(face);
+    for (j = 0 ; j < angles.size() ; ++j)
+      mFaceVertexIndices.push_back(angles[j].second);
+    mLocalFaceNormals.push_back(N);
+    mLocalFaceDistances.push_back(d);
+
+    // area, and volume from the tetrahedra to the origin
+    const tVector3 & p0 = mLocalVertices[angles[0].second];
+    for (j = 2 ; j < angles.size() ; ++j)
+    {
+      const tVector3 & p1 = mLocalVertices[angles[j - 1].second];
+      const tVector3 & p2 = mLocalVertices[angles[j].second];
+      mSurfaceArea += SCALAR(0.5f) * Cross(p1 - p0, p2 - p0).GetLength();
+      mVolume += Dot(p0, Cross(p1, p2)) / SCALAR(6.0f);
+    }
+  }
+
+  UpdateWorld();
+}
+
+//==============================================================
+// SetFlatPoints
+//==============================================================
+void tConvexHull::SetFlatPoints(const vector<tVector3> & pts)
+{
+  mLocalVertices = pts;
+  mLocalCentre.SetToZero();
+  for (unsigned i = 0 ; i < pts.size() ; ++i)
+    mLocalCentre += pts[i];
+  mLocalCentre /= (tScalar) pts.size();
+  UpdateWorld();
+}
+
+//==============================================================
+// GetSupportVertex
+//==============================================================
+unsigned tConvexHull::GetSupportVertex(const tVector3 & dir) const
+{
+  unsigned best = 0;
+  tScalar bestDist = -SCALAR_HUGE;
+  const unsigned numVertices = mVertices.size();
+  for (unsigned i = 0 ; i < numVertices ; ++i)
+  {
+    tScalar dist = Dot(mVertices[i], dir);
+    if (dist > bestDist)
+    {
+      bestDist = dist;
+      best = i;
+    }
+  }
+  return best;
+}
+
+//==============================================================
+// GetSupportFace
+//==============================================================
+unsigned tConvexHull::GetSupportFace(const tVector3 & dir) const
+{
+  unsigned best = 0;
+  tScalar bestDot = -SCALAR_HUGE;
+  const unsigned numFaces = mFaces.size();
+  for (unsigned i = 0 ; i < numFaces ; ++i)
+  {
+    tScalar d = Dot(mFaceNormals[i], dir);
+    if (d > bestDot)
+    {
+      bestDot = d;
+      best = i;
+    }
+  }
+  return best;
+}
+
+//==============================================================
+// SegmentIntersect
+// Clips the segment against each face plane in turn
+//==============================================================
+bool tConvexHull::SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const tSegment &seg) const
+{
+  const unsigned numFaces = mFaces.size();
+  if (numFaces == 0)
+    return false;
+  tScalar tEnter = SCALAR(0.0f);
+  tScalar tExit = SCALAR(1.0f);
+  int enterFace = -1;
+  for (unsigned i = 0 ; i < numFaces ; ++i)
+  {
+    const tScalar denom = Dot(mFaceNormals[i], seg.mDelta);
+    // +ve when the origin is inside this face
+    const tScalar dist = mFaceDistances[i] - Dot(mFaceNormals[i], seg.mOrigin);
+    if (Abs(denom) < SCALAR_TINY)
+    {
+      if (dist < SCALAR(0.0f))
+        return false;
+      continue;
+    }
+    const tScalar t = dist / denom;
+    if (denom < SCALAR(0.0f))
+    {
+      if (t > tEnter)
+      {
+        tEnter = t;
+        enterFace = i;
+      }
+    }
+    else
+    {
+      tExit = Min(tExit, t);
+    }
+    if (tEnter > tExit)
+      return false;
+  }
+  frac = tEnter;
+  pos = seg.GetPoint(frac);
+  if (enterFace >= 0)
+    normal = mFaceNormals[enterFace];
+  else
+    normal = -seg.mDelta.GetNormalisedSafe();
+  return true;
+}
+
+//==============================================================
+// GetMassProperties
+// Integrates over tetrahedra from the centre to each face triangle
+// (or over the face triangles for a shell)
+//==============================================================
+void tConvexHull::GetMassProperties(const tPrimitiveProperties &primitiveProperties,
+                                    tScalar &mass,
+                                    tVector3 &centerOfMass,
+                                    tMatrix33 &inertiaTensor) const
+{
+  const bool solid = primitiveProperties.mMassDistribution == tPrimitiveProperties::SOLID;
+  if (primitiveProperties.mMassType == tPrimitiveProperties::MASS)
+    mass = primitiveProperties.mMassOrDensity;
+  else
+    mass = (solid ? GetVolume() : GetSurfaceArea()) * primitiveProperties.mMassOrDensity;
+
+  const tVector3 centre = GetCentre();
+  // integrals (with unit density) of 1, r and r r^T, relative to the centre
+  tScalar total = SCALAR(0.0f);
+  tVector3 first(SCALAR(0.0f));
+  tMatrix33 second(SCALAR(0.0f));
+  const unsigned numFaces = mFaces.size();
+  for (unsigned iFace = 0 ; iFace < numFaces ; ++iFace)
+  {
+    const tFace & face = mFaces[iFace];
+    const tVector3 r0 = mVertices[mFaceVertexIndices[face.mFirstIndex]] - centre;
+    for (unsigned i = 2 ; i < face.mNumIndices ; ++i)
+    {
+      const tVector3 r1 = mVertices[mFaceVertexIndices[face.mFirstIndex + i - 1]] - centre;
+      const tVector3 r2 = mVertices[mFaceVertexIndices[face.mFirstIndex + i]] - centre;
+      const tVector3 sum = r0 + r1 + r2;
+      tScalar scale;
+      if (solid)
+      {
+        const tScalar det = Dot(r0, Cross(r1, r2));
+        total += det / SCALAR(6.0f);
+        first += (det / SCALAR(24.0f)) * sum;
+        scale = det / SCALAR(120.0f);
+      }
+      else
+      {
+        const tScalar area = SCALAR(0.5f) * Cross(r1 - r0, r2 - r0).GetLength();
+        total += area;
+        first += (area / SCALAR(3.0f)) * sum;
+        scale = area / SCALAR(12.0f);
+      }
+      AddOuterProduct(second, r0, r0, scale);
+      AddOuterProduct(second, r1, r1, scale);
+      AddOuterProduct(second, r2, r2, scale);
+      AddOuterProduct(second, sum, sum, scale);
+    }
+  }
+
+  if (total < SCALAR_TINY)
+  {
+    centerOfMass = centre;
+    inertiaTensor.SetTo(SCALAR(0.0f));
+    return;
+  }
+  const tScalar density = mass / total;
+  centerOfMass = centre + first / total;
+
+  // second moment about the origin, then the inertia from that
+  AddOuterProduct(second, centre, centre, total);
+  AddOuterProduct(second, centre, first, SCALAR(1.0f));
+  AddOuterProduct(second, first, centre, SCALAR(1.0f));
+  second *= density;
+  const tScalar trace = second(0, 0) + second(1, 1) + second(2, 2);
+  inertiaTensor = trace * tMatrix33::Identity() - second;
+}
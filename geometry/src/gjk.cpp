@@ -0,0 +1,864 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file gjk.cpp 
+//                     
+//==============================================================
+#include "gjk.hpp"
+#include "sphere.hpp"
+#include "capsule.hpp"
+#include "box.hpp"
+#include "convexhull.hpp"
+#include "trace.hpp"
+
+using namespace JigLib;
+using namespace std;
+
+/// Features with a normal at least this close to the direction are
+/// treated as faces
+static const tScalar featureFaceCosAngle = SCALAR(0.98f);
+/// Edges with a direction at most this close to perpendicular to the
+/// direction are treated as edges (rather than just their end)
+static const tScalar featureEdgeSinAngle = SCALAR(0.1f);
+
+/// Below this the cores are treated as touching, and EPA is used
+static const tScalar gjkTouchDistance = SCALAR(1.0e-5f);
+/// GJK stops when it can't get closer than this fraction of the distance
+static const tScalar gjkRelativeTolerance = SCALAR(0.0001f);
+/// EPA stops when it can't get deeper than this
+static const tScalar epaTolerance = SCALAR(0.0001f);
+static const unsigned maxIterations = 64;
+
+enum {MAX_EPA_VERTICES = 128, MAX_EPA_FACES = 256, MAX_EPA_EDGES = 128};
+
+//==============================================================
+// SetPrimitive
+//==============================================================
+bool tSupportShape::SetPrimitive(const tPrimitive & prim)
+{
+  switch (prim.GetType())
+  {
+  case tPrimitive::SPHERE:
+    mCoreType = POINT;
+    mPoints[0] = prim.GetSphere().GetPos();
+    mRadius = prim.GetSphere().GetRadius();
+    break;
+  case tPrimitive::CAPSULE:
+    mCoreType = SEGMENT;
+    mPoints[0] = prim.GetCapsule().GetPos();
+    mPoints[1] = prim.GetCapsule().GetEnd();
+    mRadius = prim.GetCapsule().GetRadius();
+    break;
+  case tPrimitive::BOX:
+    mCoreType = BOX;
+    mRadius = SCALAR(0.0f);
+    break;
+  case tPrimitive::CONVEXHULL:
+    mCoreType = CONVEXHULL;
+    mRadius = SCALAR(0.0f);
+    break;
+  default:
+    return false;
+  }
+  mPrimitive = &prim;
+  mOffset.SetToZero();
+  return true;
+}
+
+//==============================================================
+// SetTriangle
+//==============================================================
+void tSupportShape::SetTriangle(const tTriangle & triangle)
+{
+  mCoreType = TRIANGLE;
+  mPrimitive = 0;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+    mPoints[i] = triangle.GetPoint(i);
+  mRadius = SCALAR(0.0f);
+  mOffset.SetToZero();
+}
+
+//==============================================================
+// GetCoreSupportPoint
+//==============================================================
+tVector3 tSupportShape::GetCoreSupportPoint(const tVector3 & dir) const
+{
+  switch (mCoreType)
+  {
+  case POINT:
+    return mPoints[0];
+  case SEGMENT:
+    return Dot(mPoints[1] - mPoints[0], dir) > SCALAR(0.0f) ? mPoints[1] : mPoints[0];
+  case BOX:
+  {
+    const tBox & box = mPrimitive->GetBox();
+    const tMatrix33 & orient = box.GetOrient();
+    const tVector3 halfSides = box.GetHalfSideLengths();
+    tVector3 pt = box.GetCentre();
+    for (unsigned i = 0 ; i < 3 ; ++i)
+      pt += (Dot(orient[i], dir) > SCALAR(0.0f) ? halfSides[i] : -halfSides[i]) * orient[i];
+    return pt;
+  }
+  case CONVEXHULL:
+  {
+    const tConvexHull & hull = mPrimitive->GetConvexHull();
+    return hull.GetVertex(hull.GetSupportVertex(dir));
+  }
+  case TRIANGLE:
+  {
+    unsigned best = 0;
+    tScalar bestDist = Dot(mPoints[0], dir);
+    for (unsigned i = 1 ; i < 3 ; ++i)
+    {
+      tScalar dist = Dot(mPoints[i], dir);
+      if (dist > bestDist)
+      {
+        bestDist = dist;
+        best = i;
+      }
+    }
+    return mPoints[best];
+  }
+  }
+  return mPoints[0];
+}
+
+//==============================================================
+// GetCoreCentre
+//==============================================================
+tVector3 tSupportShape::GetCoreCentre() const
+{
+  switch (mCoreType)
+  {
+  case POINT:
+    return mPoints[0];
+  case SEGMENT:
+    return SCALAR(0.5f) * (mPoints[0] + mPoints[1]);
+  case BOX:
+    return mPrimitive->GetBox().GetCentre();
+  case CONVEXHULL:
+    return mPrimitive->GetConvexHull().GetCentre();
+  case TRIANGLE:
+    return (mPoints[0] + mPoints[1] + mPoints[2]) / SCALAR(3.0f);
+  }
+  return mPoints[0];
+}
+
+//==============================================================
+// GetSupportEdge
+// Returns the edge (i.e. 2 pts) if the edge from pt to other is
+// perpendicular to dir, otherwise just pt
+//==============================================================
+static unsigned GetSupportEdge(tVector3 * pts, const tVector3 & pt, const tVector3 & other,
+                               const tVector3 & dir)
+{
+  pts[0] = pt;
+  const tVector3 edge = other - pt;
+  const tScalar edgeLen = edge.GetLength();
+  if (edgeLen > SCALAR_TINY && Abs(Dot(edge, dir)) < featureEdgeSinAngle * edgeLen)
+  {
+    pts[1] = other;
+    return 2;
+  }
+  return 1;
+}
+
+//==============================================================
+// GetCoreSupportFeature
+//==============================================================
+unsigned tSupportShape::GetCoreSupportFeature(tVector3 * pts, unsigned maxPts, const tVector3 & dirIn) const
+{
+  Assert(maxPts >= 4);
+  const tVector3 dir = dirIn.GetNormalisedSafe();
+  switch (mCoreType)
+  {
+  case POINT:
+    pts[0] = mPoints[0];
+    return 1;
+  case SEGMENT:
+  {
+    const bool end = Dot(mPoints[1] - mPoints[0], dir) > SCALAR(0.0f);
+    return GetSupportEdge(pts, mPoints[end ? 1 : 0], mPoints[end ? 0 : 1], dir);
+  }
+  case BOX:
+  {
+    const tBox & box = mPrimitive->GetBox();
+    const tMatrix33 & orient = box.GetOrient();
+    const tVector3 halfSides = box.GetHalfSideLengths();
+    const tVector3 centre = box.GetCentre();
+    tScalar dots[3];
+    unsigned iFace = 0;
+    unsigned i;
+    for (i = 0 ; i < 3 ; ++i)
+    {
+      dots[i] = Dot(orient[i], dir);
+      if (Abs(dots[i]) > Abs(dots[iFace]))
+        iFace = i;
+    }
+    if (Abs(dots[iFace]) > featureFaceCosAngle)
+    {
+      const tScalar sign = dots[iFace] > SCALAR(0.0f) ? SCALAR(1.0f) : SCALAR(-1.0f);
+      const tVector3 faceCentre = centre + (sign * halfSides[iFace]) * orient[iFace];
+      const unsigned iU = (iFace + 1) % 3;
+      const unsigned iV = (iFace + 2) % 3;
+      const tVector3 u = halfSides[iU] * orient[iU];
+      const tVector3 v = (sign * halfSides[iV]) * orient[iV];
+      pts[0] = faceCentre + u + v;
+      pts[1] = faceCentre - u + v;
+      pts[2] = faceCentre - u - v;
+      pts[3] = faceCentre + u - v;
+      return 4;
+    }
+    tVector3 corner = centre;
+    for (i = 0 ; i < 3 ; ++i)
+      corner += (dots[i] > SCALAR(0.0f) ? halfSides[i] : -halfSides[i]) * orient[i];
+    for (i = 0 ; i < 3 ; ++i)
+    {
+      if (Abs(dots[i]) < featureEdgeSinAngle)
+      {
+        pts[0] = corner;
+        pts[1] = corner - ((dots[i] > SCALAR(0.0f) ? SCALAR(2.0f) : SCALAR(-2.0f)) * halfSides[i]) * orient[i];
+        return 2;
+      }
+    }
+    pts[0] = corner;
+    return 1;
+  }
+  case CONVEXHULL:
+  {
+    const tConvexHull & hull = mPrimitive->GetConvexHull();
+    if (hull.GetNumFaces() == 0)
+    {
+      pts[0] = hull.GetVertex(hull.GetSupportVertex(dir));
+      return 1;
+    }
+    const unsigned iFace = hull.GetSupportFace(dir);
+    const tConvexHull::tFace & face = hull.GetFace(iFace);
+    if (Dot(hull.GetFaceNormal(iFace), dir) > featureFaceCosAngle && face.mNumIndices <= maxPts)
+    {
+      for (unsigned i = 0 ; i < face.mNumIndices ; ++i)
+        pts[i] = hull.GetVertex(hull.GetFaceVertexIndex(face.mFirstIndex + i));
+      return face.mNumIndices;
+    }
+    // Look at the edges going out of the support vertex, and use
+    // the one that's most perpendicular to dir
+    const unsigned iVertex = hull.GetSupportVertex(dir);
+    const tVector3 & pt = hull.GetVertex(iVertex);
+    tVector3 bestOther = pt;
+    tScalar bestDot = SCALAR_HUGE;
+    const unsigned numFaces = hull.GetNumFaces();
+    for (unsigned f = 0 ; f < numFaces ; ++f)
+    {
+      const tConvexHull::tFace & hullFace = hull.GetFace(f);
+      for (unsigned i = 0 ; i < hullFace.mNumIndices ; ++i)
+      {
+        if (hull.GetFaceVertexIndex(hullFace.mFirstIndex + i) != iVertex)
+          continue;
+        const unsigned iNext = (i + 1) % hullFace.mNumIndices;
+        const tVector3 & other = hull.GetVertex(hull.GetFaceVertexIndex(hullFace.mFirstIndex + iNext));
+        const tScalar dot = Abs(Dot((other - pt).GetNormalisedSafe(), dir));
+        if (dot < bestDot)
+        {
+          bestDot = dot;
+          bestOther = other;
+        }
+      }
+    }
+    return GetSupportEdge(pts, pt, bestOther, dir);
+  }
+  case TRIANGLE:
+  {
+    const tVector3 normal = Cross(mPoints[1] - mPoints[0], mPoints[2] - mPoints[0]).NormaliseSafe();
+    const tScalar dot = Dot(normal, dir);
+    if (Abs(dot) > featureFaceCosAngle)
+    {
+      pts[0] = mPoints[0];
+      pts[1] = mPoints[dot > SCALAR(0.0f) ? 1 : 2];
+      pts[2] = mPoints[dot > SCALAR(0.0f) ? 2 : 1];
+      return 3;
+    }
+    unsigned best = 0;
+    for (unsigned i = 1 ; i < 3 ; ++i)
+    {
+      if (Dot(mPoints[i], dir) > Dot(mPoints[best], dir))
+        best = i;
+    }
+    const tVector3 & next = mPoints[(best + 1) % 3];
+    const tVector3 & prev = mPoints[(best + 2) % 3];
+    if (Dot(next, dir) > Dot(prev, dir))
+      return GetSupportEdge(pts, mPoints[best], next, dir);
+    else
+      return GetSupportEdge(pts, mPoints[best], prev, dir);
+  }
+  }
+  pts[0] = GetCoreSupportPoint(dir);
+  return 1;
+}
+
+//==============================================================
+// GetSupportFeature
+//==============================================================
+unsigned tSupportShape::GetSupportFeature(tVector3 * pts, unsigned maxPts, const tVector3 & dir) const
+{
+  const unsigned numPts = GetCoreSupportFeature(pts, maxPts, dir);
+  for (unsigned i = 0 ; i < numPts ; ++i)
+    pts[i] += mOffset;
+  return numPts;
+}
+
+//==============================================================
+// tSimplexVertex
+// A point on the Minkowski difference of the cores, with the
+// points on each core that it came from
+//==============================================================
+struct tSimplexVertex
+{
+  tVector3 mW;
+  tVector3 mA;
+  tVector3 mB;
+};
+
+//==============================================================
+// GetSupportVertex
+//==============================================================
+static inline void GetSupportVertex(tSimplexVertex & vertex,
+                                    const tSupportShape & shape0,
+                                    const tSupportShape & shape1,
+                                    const tVector3 & dir)
+{
+  vertex.mA = shape0.GetSupportPoint(dir);
+  vertex.mB = shape1.GetSupportPoint(-dir);
+  vertex.mW = vertex.mA - vertex.mB;
+}
+
+//==============================================================
+// tSimplex
+//==============================================================
+struct tSimplex
+{
+  tSimplexVertex mVertices[4];
+  tScalar mLambdas[4];
+  unsigned mNum;
+
+  /// Keeps just the vertices in indices (in that order) with their
+  /// barycentric coords
+  void Reduce(unsigned num, const unsigned * indices, const tScalar * lambdas)
+  {
+    tSimplexVertex vertices[4];
+    unsigned i;
+    for (i = 0 ; i < num ; ++i)
+      vertices[i] = mVertices[indices[i]];
+    for (i = 0 ; i < num ; ++i)
+    {
+      mVertices[i] = vertices[i];
+      mLambdas[i] = lambdas[i];
+    }
+    mNum = num;
+  }
+
+  tVector3 GetClosestPoint() const
+  {
+    tVector3 v(SCALAR(0.0f));
+    for (unsigned i = 0 ; i < mNum ; ++i)
+      v += mLambdas[i] * mVertices[i].mW;
+    return v;
+  }
+
+  void GetWitnessPoints(tVector3 & pt0, tVector3 & pt1) const
+  {
+    pt0.SetToZero();
+    pt1.SetToZero();
+    for (unsigned i = 0 ; i < mNum ; ++i)
+    {
+      pt0 += mLambdas[i] * mVertices[i].mA;
+      pt1 += mLambdas[i] * mVertices[i].mB;
+    }
+  }
+};
+
+//==============================================================
+// ClosestOnSegment
+// Finds the closest point to the origin on the segment between
+// vertices i0 and i1, and the vertices/coords that give it
+//==============================================================
+static void ClosestOnSegment(unsigned & num, unsigned * indices, tScalar * lambdas,
+                             const tSimplexVertex * vertices, unsigned i0, unsigned i1)
+{
+  const tVector3 & a = vertices[i0].mW;
+  const tVector3 ab = vertices[i1].mW - a;
+  const tScalar lenSq = ab.GetLengthSq();
+  const tScalar t = lenSq > SCALAR(0.0f) ? -Dot(a, ab) / lenSq : SCALAR(0.0f);
+  if (t <= SCALAR(0.0f))
+  {
+    num = 1;
+    indices[0] = i0;
+    lambdas[0] = SCALAR(1.0f);
+  }
+  else if (t >= SCALAR(1.0f))
+  {
+    num = 1;
+    indices[0] = i1;
+    lambdas[0] = SCALAR(1.0f);
+  }
+  else
+  {
+    num = 2;
+    indices[0] = i0;
+    indices[1] = i1;
+    lambdas[0] = SCALAR(1.0f) - t;
+    lambdas[1] = t;
+  }
+}
+
+//==============================================================
+// ClosestOnTriangle
+// As ClosestOnSegment, using the Voronoi regions of the triangle
+//==============================================================
+static void ClosestOnTriangle(unsigned & num, unsigned * indices, tScalar * lambdas,
+                              const tSimplexVertex * vertices,
+                              unsigned i0, unsigned i1, unsigned i2)
+{
+  const tVector3 & a = vertices[i0].mW;
+  const tVector3 & b = vertices[i1].mW;
+  const tVector3 & c = vertices[i2].mW;
+  const tVector3 ab = b - a;
+  const tVector3 ac = c - a;
+
+  const tScalar d1 = -Dot(ab, a);
+  const tScalar d2 = -Dot(ac, a);
+  if (d1 <= SCALAR(0.0f) && d2 <= SCALAR(0.0f))
+  {
+    num = 1; indices[0] = i0; lambdas[0] = SCALAR(1.0f);
+    return;
+  }
+  const tScalar d3 = -Dot(ab, b);
+  const tScalar d4 = -Dot(ac, b);
+  if (d3 >= SCALAR(0.0f) && d4 <= d3)
+  {
+    num = 1; indices[0] = i1; lambdas[0] = SCALAR(1.0f);
+    return;
+  }
+  const tScalar vc = d1 * d4 - d3 * d2;
+  if (vc <= SCALAR(0.0f) && d1 >= SCALAR(0.0f) && d3 <= SCALAR(0.0f))
+  {
+    ClosestOnSegment(num, indices, lambdas, vertices, i0, i1);
+    return;
+  }
+  const tScalar d5 = -Dot(ab, c);
+  const tScalar d6 = -Dot(ac, c);
+  if (d6 >= SCALAR(0.0f) && d5 <= d6)
+  {
+    num = 1; indices[0] = i2; lambdas[0] = SCALAR(1.0f);
+    return;
+  }
+  const tScalar vb = d5 * d2 - d1 * d6;
+  if (vb <= SCALAR(0.0f) && d2 >= SCALAR(0.0f) && d6 <= SCALAR(0.0f))
+  {
+    ClosestOnSegment(num, indices, lambdas, vertices, i0, i2);
+    return;
+  }
+  const tScalar va = d3 * d6 - d5 * d4;
+  if (va <= SCALAR(0.0f) && (d4 - d3) >= SCALAR(0.0f) && (d5 - d6) >= SCALAR(0.0f))
+  {
+    ClosestOnSegment(num, indices, lambdas, vertices, i1, i2);
+    return;
+  }
+  const tScalar sum = va + vb + vc;
+  if (sum <= SCALAR(0.0f))
+  {
+    // degenerate - just use the longest edge
+    ClosestOnSegment(num, indices, lambdas, vertices, i0, ab.GetLengthSq() > ac.GetLengthSq() ? i1 : i2);
+    return;
+  }
+  num = 3;
+  indices[0] = i0;
+  indices[1] = i1;
+  indices[2] = i2;
+  lambdas[1] = vb / sum;
+  lambdas[2] = vc / sum;
+  lambdas[0] = SCALAR(1.0f) - lambdas[1] - lambdas[2];
+}
+
+//==============================================================
+// UpdateSimplex
+// Reduces the simplex to the smallest part that contains the
+// closest point to the origin. Returns false if the origin is
+// inside the tetrahedron.
+//==============================================================
+static bool UpdateSimplex(tSimplex & simplex)
+{
+  unsigned num = 0;
+  unsigned indices[4];
+  tScalar lambdas[4];
+  const tSimplexVertex * vertices = simplex.mVertices;
+  switch (simplex.mNum)
+  {
+  case 1:
+    simplex.mLambdas[0] = SCALAR(1.0f);
+    return true;
+  case 2:
+    ClosestOnSegment(num, indices, lambdas, vertices, 0, 1);
+    break;
+  case 3:
+    ClosestOnTriangle(num, indices, lambdas, vertices, 0, 1, 2);
+    break;
+  case 4:
+  {
+    // Check each face that has the origin on the other side to the
+    // remaining vertex
+    static const unsigned faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+    tScalar bestDistSq = SCALAR_HUGE;
+    bool inside = true;
+    for (unsigned iFace = 0 ; iFace < 4 ; ++iFace)
+    {
+      const tVector3 & a = vertices[faces[iFace][0]].mW;
+      const tVector3 n = Cross(vertices[faces[iFace][1]].mW - a, vertices[faces[iFace][2]].mW - a);
+      const tScalar signOrigin = -Dot(a, n);
+      const tScalar signOther = Dot(vertices[faces[iFace][3]].mW - a, n);
+      if (signOrigin * signOther > SCALAR(0.0f) && Abs(signOther) > SCALAR_TINY * SCALAR_TINY)
+        continue;
+      inside = false;
+      unsigned faceNum;
+      unsigned faceIndices[3];
+      tScalar faceLambdas[3];
+      ClosestOnTriangle(faceNum, faceIndices, faceLambdas, vertices,
+                        faces[iFace][0], faces[iFace][1], faces[iFace][2]);
+      tVector3 v(SCALAR(0.0f));
+      for (unsigned i = 0 ; i < faceNum ; ++i)
+        v += faceLambdas[i] * vertices[faceIndices[i]].mW;
+      const tScalar distSq = v.GetLengthSq();
+      if (distSq < bestDistSq)
+      {
+        bestDistSq = distSq;
+        num = faceNum;
+        for (unsigned i = 0 ; i < faceNum ; ++i)
+        {
+          indices[i] = faceIndices[i];
+          lambdas[i] = faceLambdas[i];
+        }
+      }
+    }
+    if (inside)
+      return false;
+    break;
+  }
+  }
+  simplex.Reduce(num, indices, lambdas);
+  return true;
+}
+
+//==============================================================
+// GJK
+// Returns true if the cores are separated, in which case pt0 and
+// pt1 are the closest points. Otherwise simplex contains the origin
+// (or is close to it).
+//==============================================================
+static bool GJK(tSimplex & simplex, tVector3 & pt0, tVector3 & pt1,
+                const tSupportShape & shape0, const tSupportShape & shape1)
+{
+  tVector3 v = shape0.GetCentre() - shape1.GetCentre();
+  if (v.GetLengthSq() < SCALAR_TINY * SCALAR_TINY)
+    v = tVector3::Up();
+  GetSupportVertex(simplex.mVertices[0], shape0, shape1, -v);
+  simplex.mLambdas[0] = SCALAR(1.0f);
+  simplex.mNum = 1;
+  v = simplex.mVertices[0].mW;
+
+  for (unsigned iter = 0 ; iter < maxIterations ; ++iter)
+  {
+    const tScalar vLenSq = v.GetLengthSq();
+    if (vLenSq < Sq(gjkTouchDistance))
+      return false;
+
+    tSimplexVertex & vertex = simplex.mVertices[simplex.mNum];
+    GetSupportVertex(vertex, shape0, shape1, -v);
+    if (vLenSq - Dot(v, vertex.mW) <= gjkRelativeTolerance * vLenSq)
+      break;
+    unsigned i;
+    for (i = 0 ; i < simplex.mNum ; ++i)
+    {
+      if ((simplex.mVertices[i].mW - vertex.mW).GetLengthSq() < Sq(gjkTouchDistance))
+        break;
+    }
+    if (i < simplex.mNum)
+      break;
+
+    tSimplex oldSimplex = simplex;
+    ++simplex.mNum;
+    if (!UpdateSimplex(simplex))
+      return false;
+    const tVector3 newV = simplex.GetClosestPoint();
+    if (newV.GetLengthSq() >= vLenSq)
+    {
+      // not getting any closer - numerical trouble
+      simplex = oldSimplex;
+      break;
+    }
+    v = newV;
+  }
+  simplex.GetWitnessPoints(pt0, pt1);
+  return true;
+}
+
+//==============================================================
+// tEPAFace
+//==============================================================
+struct tEPAFace
+{
+  unsigned mV[3];
+  tVector3 mN;
+  tScalar mD;
+  bool mValid;
+};
+
+//==============================================================
+// MakeEPAFace
+//==============================================================
+static tEPAFace MakeEPAFace(const tSimplexVertex * vertices, unsigned i0, unsigned i1, unsigned i2)
+{
+  tEPAFace face;
+  face.mV[0] = i0;
+  face.mV[1] = i1;
+  face.mV[2] = i2;
+  const tVector3 & a = vertices[i0].mW;
+  face.mN = Cross(vertices[i1].mW - a, vertices[i2].mW - a);
+  const tScalar len = face.mN.GetLength();
+  face.mValid = len > SCALAR_TINY * SCALAR_TINY;
+  if (face.mValid)
+    face.mN /= len;
+  face.mD = Dot(face.mN, a);
+  return face;
+}
+
+//==============================================================
+// BlowUpSimplex
+// Adds vertices to the simplex until it's a tetrahedron. Returns
+// false if the Minkowski difference is flat.
+//==============================================================
+static bool BlowUpSimplex(tSimplex & simplex, const tSupportShape & shape0, const tSupportShape & shape1)
+{
+  static const tVector3 axes[3] = {tVector3(1, 0, 0), tVector3(0, 1, 0), tVector3(0, 0, 1)};
+  tSimplexVertex * vertices = simplex.mVertices;
+  if (simplex.mNum == 1)
+  {
+    for (unsigned i = 0 ; i < 6 && simplex.mNum == 1 ; ++i)
+    {
+      GetSupportVertex(vertices[1], shape0, shape1, (i & 1) ? -axes[i / 2] : axes[i / 2]);
+      if ((vertices[1].mW - vertices[0].mW).GetLengthSq() > Sq(gjkTouchDistance))
+        simplex.mNum = 2;
+    }
+    if (simplex.mNum == 1)
+      return false;
+  }
+  if (simplex.mNum == 2)
+  {
+    const tVector3 d = (vertices[1].mW - vertices[0].mW).NormaliseSafe();
+    unsigned iAxis = 0;
+    for (unsigned i = 1 ; i < 3 ; ++i)
+    {
+      if (Abs(d[i]) < Abs(d[iAxis]))
+        iAxis = i;
+    }
+    const tVector3 e1 = Cross(d, axes[iAxis]).NormaliseSafe();
+    const tVector3 e2 = Cross(d, e1);
+    const tVector3 dirs[4] = {e1, -e1, e2, -e2};
+    for (unsigned i = 0 ; i < 4 && simplex.mNum == 2 ; ++i)
+    {
+      GetSupportVertex(vertices[2], shape0, shape1, dirs[i]);
+      if (Cross(vertices[2].mW - vertices[0].mW, d).GetLengthSq() > Sq(gjkTouchDistance))
+        simplex.mNum = 3;
+    }
+    if (simplex.mNum == 2)
+      return false;
+  }
+  if (simplex.mNum == 3)
+  {
+    const tVector3 n = Cross(vertices[1].mW - vertices[0].mW,
+                             vertices[2].mW - vertices[0].mW).NormaliseSafe();
+    for (unsigned i = 0 ; i < 2 && simplex.mNum == 3 ; ++i)
+    {
+      GetSupportVertex(vertices[3], shape0, shape1, i == 0 ? n : -n);
+      if (Abs(Dot(vertices[3].mW - vertices[0].mW, n)) > gjkTouchDistance)
+        simplex.mNum = 4;
+    }
+    if (simplex.mNum == 3)
+      return false;
+  }
+  return true;
+}
+
+//==============================================================
+// EPA
+// Expands the polytope in simplex (which contains the origin)
+// until it finds the face of the Minkowski difference that's
+// closest to the origin. Returns false if it can't.
+//==============================================================
+static bool EPA(tScalar & depth, tVector3 & n, tVector3 & pt0, tVector3 & pt1,
+                tSimplex & simplex, const tSupportShape & shape0, const tSupportShape & shape1)
+{
+  if (!BlowUpSimplex(simplex, shape0, shape1))
+    return false;
+
+  tSimplexVertex vertices[MAX_EPA_VERTICES];
+  tEPAFace faces[MAX_EPA_FACES];
+  unsigned edges[MAX_EPA_EDGES][2];
+  unsigned numVertices = 4;
+  unsigned numFaces = 0;
+  unsigned i;
+  for (i = 0 ; i < 4 ; ++i)
+    vertices[i] = simplex.mVertices[i];
+
+  // orient the tetrahedron so the faces point out
+  if (Dot(Cross(vertices[1].mW - vertices[0].mW, vertices[2].mW - vertices[0].mW),
+          vertices[3].mW - vertices[0].mW) > SCALAR(0.0f))
+    Swap(vertices[1], vertices[2]);
+  faces[numFaces++] = MakeEPAFace(vertices, 0, 1, 2);
+  faces[numFaces++] = MakeEPAFace(vertices, 0, 3, 1);
+  faces[numFaces++] = MakeEPAFace(vertices, 0, 2, 3);
+  faces[numFaces++] = MakeEPAFace(vertices, 1, 3, 2);
+
+  tEPAFace bestFace = faces[0];
+  for (unsigned iter = 0 ; iter < maxIterations ; ++iter)
+  {
+    unsigned iBest = MAX_EPA_FACES;
+    for (i = 0 ; i < numFaces ; ++i)
+    {
+      if (faces[i].mValid && (iBest == MAX_EPA_FACES || faces[i].mD < faces[iBest].mD))
+        iBest = i;
+    }
+    if (iBest == MAX_EPA_FACES)
+      return false;
+
+    bestFace = faces[iBest];
+    if (numVertices == MAX_EPA_VERTICES)
+      break;
+    tSimplexVertex & vertex = vertices[numVertices];
+    GetSupportVertex(vertex, shape0, shape1, bestFace.mN);
+    if (Dot(vertex.mW, bestFace.mN) - bestFace.mD < epaTolerance)
+      break;
+
+    // remove the faces that can see the new vertex, keeping the
+    // edges around the hole
+    unsigned numEdges = 0;
+    bool overflow = false;
+    for (i = 0 ; i < numFaces && !overflow ; ++i)
+    {
+      tEPAFace & face = faces[i];
+      if (!face.mValid && i != iBest)
+        continue;
+      if (i != iBest && Dot(face.mN, vertex.mW - vertices[face.mV[0]].mW) <= SCALAR(0.0f))
+        continue;
+      face.mValid = false;
+      face.mD = SCALAR_HUGE;
+      for (unsigned e = 0 ; e < 3 ; ++e)
+      {
+        const unsigned e0 = face.mV[e];
+        const unsigned e1 = face.mV[(e + 1) % 3];
+        unsigned iEdge;
+        for (iEdge = 0 ; iEdge < numEdges ; ++iEdge)
+        {
+          if (edges[iEdge][0] == e1 && edges[iEdge][1] == e0)
+            break;
+        }
+        if (iEdge < numEdges)
+        {
+          edges[iEdge][0] = edges[numEdges - 1][0];
+          edges[iEdge][1] = edges[numEdges - 1][1];
+          --numEdges;
+        }
+        else if (numEdges < MAX_EPA_EDGES)
+        {
+          edges[numEdges][0] = e0;
+          edges[numEdges][1] = e1;
+          ++numEdges;
+        }
+        else
+        {
+          overflow = true;
+        }
+      }
+    }
+    if (overflow)
+      return false;
+
+    // reuse the dead face slots
+    unsigned iFace = 0;
+    for (unsigned iEdge = 0 ; iEdge < numEdges ; ++iEdge)
+    {
+      while (iFace < numFaces && faces[iFace].mD < SCALAR_HUGE)
+        ++iFace;
+      if (iFace == MAX_EPA_FACES)
+        return false;
+      faces[iFace] = MakeEPAFace(vertices, edges[iEdge][0], edges[iEdge][1], numVertices);
+      if (iFace == numFaces)
+        ++numFaces;
+    }
+    ++numVertices;
+  }
+
+  const tEPAFace & face = bestFace;
+  depth = face.mD;
+  n = face.mN;
+
+  // barycentric coords of the closest point on the face
+  const tVector3 & a = vertices[face.mV[0]].mW;
+  const tVector3 v0 = vertices[face.mV[1]].mW - a;
+  const tVector3 v1 = vertices[face.mV[2]].mW - a;
+  const tVector3 v2 = depth * n - a;
+  const tScalar d00 = Dot(v0, v0);
+  const tScalar d01 = Dot(v0, v1);
+  const tScalar d11 = Dot(v1, v1);
+  const tScalar d20 = Dot(v2, v0);
+  const tScalar d21 = Dot(v2, v1);
+  const tScalar denom = d00 * d11 - d01 * d01;
+  tScalar lambdas[3] = {SCALAR(1.0f), SCALAR(0.0f), SCALAR(0.0f)};
+  if (denom > SCALAR_TINY * SCALAR_TINY)
+  {
+    lambdas[1] = (d11 * d20 - d01 * d21) / denom;
+    lambdas[2] = (d00 * d21 - d01 * d20) / denom;
+    lambdas[0] = SCALAR(1.0f) - lambdas[1] - lambdas[2];
+  }
+  pt0.SetToZero();
+  pt1.SetToZero();
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    pt0 += lambdas[i] * vertices[face.mV[i]].mA;
+    pt1 += lambdas[i] * vertices[face.mV[i]].mB;
+  }
+  return true;
+}
+
+//==============================================================
+// ConvexConvexSeparation
+//==============================================================
+bool JigLib::ConvexConvexSeparation(tScalar & separation,
+                                    tVector3 & N,
+                                    tVector3 & pt0,
+                                    tVector3 & pt1,
+                                    const tSupportShape & shape0,
+                                    const tSupportShape & shape1)
+{
+  tSimplex simplex;
+  tVector3 core0, core1;
+  if (GJK(simplex, core0, core1, shape0, shape1))
+  {
+    const tVector3 delta = core0 - core1;
+    const tScalar dist = delta.GetLength();
+    N = delta / dist;
+    separation = dist - shape0.GetRadius() - shape1.GetRadius();
+  }
+  else
+  {
+    tScalar depth;
+    tVector3 n;
+    if (!EPA(depth, n, core0, core1, simplex, shape0, shape1))
+      return false;
+    N = -n;
+    separation = -depth - shape0.GetRadius() - shape1.GetRadius();
+  }
+  pt0 = core0 - shape0.GetRadius() * N;
+  pt1 = core1 + shape1.GetRadius() * N;
+  return true;
+}
@@ -8,6 +8,9 @@
 //==============================================================
 #include "heightmap.hpp"
 #include "distance.hpp"
+#include "triangle.hpp"
+#include "aabox.hpp"
+#include "intersection.hpp"
 
 using namespace JigLib;
 
@@ -28,17 +31,95 @@ tHeightmap::tHeightmap(const tArray2D<tScalar> & heights,
                        tScalar dx, tScalar dy)
   :
   tPrimitive(tPrimitive::HEIGHTMAP),
-  mHeights(heights),
   mX0(x0), mY0(y0),
   mDx(dx), mDy(dy)
 {
-  Assert(mHeights.GetNx() >= 2);
-  Assert(mHeights.GetNy() >= 2);
+  Assert(heights.GetNx() >= 2);
+  Assert(heights.GetNy() >= 2);
+
+  std::shared_ptr<tData> data(new tData);
+  data->mHeights = heights;
+  BuildLevels(*data);
+  mData = data;
   
-  mXMin = mX0 - (mHeights.GetNx() - 1) * 0.5f * mDx;
-  mYMin = mY0 - (mHeights.GetNy() - 1) * 0.5f * mDy;
-  mXMax = mX0 + (mHeights.GetNx() - 1) * 0.5f * mDx;
-  mYMax = mY0 + (mHeights.GetNy() - 1) * 0.5f * mDy;
+  mXMin = mX0 - (GetNx() - 1) * 0.5f * mDx;
+  mYMin = mY0 - (GetNy() - 1) * 0.5f * mDy;
+  mXMax = mX0 + (GetNx() - 1) * 0.5f * mDx;
+  mYMax = mY0 + (GetNy() - 1) * 0.5f * mDy;
+
+  // Heights off the edges are clamped, and it's solid underneath,
+  // so only the top is bounded
+  const tHeightRange & top = mData->mLevels.back()(0, 0);
+  mBoundingBox = tAABox(tAABox::HugeBox().GetMinPos(),
+                        tVector3(SCALAR_HUGE, SCALAR_HUGE, top.mMax));
+}
+
+//==============================================================
+// BuildLevels
+//==============================================================
+void tHeightmap::BuildLevels(tData & data)
+{
+  TRACE_FUNCTION_ONLY(ONCE_2);
+  const tArray2D<tScalar> & heights = data.mHeights;
+  const unsigned nxHeights = heights.GetNx();
+  const unsigned nyHeights = heights.GetNy();
+
+  // Each block at level 0 is 2x2 cells, so 3x3 heights
+  unsigned nx = nxHeights / 2;
+  unsigned ny = nyHeights / 2;
+  data.mLevels.clear();
+  data.mLevels.reserve(32);
+  data.mLevels.push_back(tArray2D<tHeightRange>(nx, ny));
+  tArray2D<tHeightRange> & level0 = data.mLevels.back();
+  unsigned i, j;
+  for (j = 0 ; j < ny ; ++j)
+  {
+    for (i = 0 ; i < nx ; ++i)
+    {
+      tHeightRange & range = level0(i, j);
+      range.mMin = SCALAR_HUGE;
+      range.mMax = -SCALAR_HUGE;
+      const unsigned iEnd = Min(2 * i + 2, nxHeights - 1);
+      const unsigned jEnd = Min(2 * j + 2, nyHeights - 1);
+      for (unsigned jj = 2 * j ; jj <= jEnd ; ++jj)
+      {
+        for (unsigned ii = 2 * i ; ii <= iEnd ; ++ii)
+        {
+          const tScalar h = heights(ii, jj);
+          if (h < range.mMin) range.mMin = h;
+          if (h > range.mMax) range.mMax = h;
+        }
+      }
+    }
+  }
+
+  while (nx > 1 || ny > 1)
+  {
+    const unsigned nxBelow = nx;
+    const unsigned nyBelow = ny;
+    nx = (nx + 1) / 2;
+    ny = (ny + 1) / 2;
+    data.mLevels.push_back(tArray2D<tHeightRange>(nx, ny));
+    const tArray2D<tHeightRange> & below = data.mLevels[data.mLevels.size() - 2];
+    tArray2D<tHeightRange> & level = data.mLevels.back();
+    for (j = 0 ; j < ny ; ++j)
+    {
+      for (i = 0 ; i < nx ; ++i)
+      {
+        tHeightRange & range = level(i, j);
+        range = below(2 * i, 2 * j);
+        for (unsigned jj = 2 * j ; jj < Min(2 * j + 2, nyBelow) ; ++jj)
+        {
+          for (unsigned ii = 2 * i ; ii < Min(2 * i + 2, nxBelow) ; ++ii)
+          {
+            const tHeightRange & rangeBelow = below(ii, jj);
+            if (rangeBelow.mMin < range.mMin) range.mMin = rangeBelow.mMin;
+            if (rangeBelow.mMax > range.mMax) range.mMax = rangeBelow.mMax;
+          }
+        }
+      }
+    }
+  }
 }
 
 //==============================================================
@@ -46,23 +127,24 @@ tHeightmap::tHeightmap(const tArray2D<tScalar> & heights,
 //==============================================================
 tScalar tHeightmap::GetHeight(int i, int j) const
 {
-  Limit(i, 0, (int) mHeights.GetNx() - 1);
-  Limit(j, 0, (int) mHeights.GetNy() - 1);
-  return mHeights(i, j);
+  Limit(i, 0, (int) GetNx() - 1);
+  Limit(j, 0, (int) GetNy() - 1);
+  return mData->mHeights(i, j);
 }
 //==============================================================
 // GetNormal
 //==============================================================
 tVector3 tHeightmap::GetNormal(int i, int j) const
 {
+  const tArray2D<tScalar> & heights = mData->mHeights;
   int i0 = i-1;
   int i1 = i+1;
   int j0 = j-1;
   int j1 = j+1;
-  Limit(i0, 0, (int) mHeights.GetNx() - 1);
-  Limit(j0, 0, (int) mHeights.GetNy() - 1);
-  Limit(i1, 0, (int) mHeights.GetNx() - 1);
-  Limit(j1, 0, (int) mHeights.GetNy() - 1);
+  Limit(i0, 0, (int) heights.GetNx() - 1);
+  Limit(j0, 0, (int) heights.GetNy() - 1);
+  Limit(i1, 0, (int) heights.GetNx() - 1);
+  Limit(j1, 0, (int) heights.GetNy() - 1);
   
   tScalar dx = (i1 - i0) * mDx;
   tScalar dy = (j1 - j0) * mDy;
@@ -70,10 +152,10 @@ tVector3 tHeightmap::GetNormal(int i, int j) const
   if (j0 == j1) dy = 1.0f;
   if (i0 == i1 && j0 == j1) return tVector3::Up();
   
-  tScalar hFwd = mHeights(i1, j);
-  tScalar hBack = mHeights(i0, j);
-  tScalar hLeft = mHeights(i, j1);
-  tScalar hRight = mHeights(i, j0);
+  tScalar hFwd = heights(i1, j);
+  tScalar hBack = heights(i0, j);
+  tScalar hLeft = heights(i, j1);
+  tScalar hRight = heights(i, j0);
   
   tVector3 normal = Cross(tVector3(dx, 0.0f, hFwd - hBack),
                           tVector3(0.0f, dy, hLeft - hRight)).Normalise();
@@ -142,6 +224,7 @@ void tHeightmap::GetHeightAndNormal(tScalar & h,
                                     tVector3 & normal, 
                                     const tVector3 & point) const
 {
+  const tArray2D<tScalar> & heights = mData->mHeights;
   tScalar x = point.x;
   tScalar y = point.y;
   Limit(x, mXMin, mXMax);
@@ -149,23 +232,23 @@ void tHeightmap::GetHeightAndNormal(tScalar & h,
   
   int i0 = (int) ((x - mXMin)/mDx);
   int j0 = (int) ((point.y - mYMin)/mDy);
-  Limit(i0, 0, (int) mHeights.GetNx() - 1);
-  Limit(j0, 0, (int) mHeights.GetNy() - 1);
+  Limit(i0, 0, (int) heights.GetNx() - 1);
+  Limit(j0, 0, (int) heights.GetNy() - 1);
   
   int i1 = i0 + 1;
   int j1 = j0 + 1;
-  if (i1 >= (int) mHeights.GetNx()) i1 = mHeights.GetNx() - 1;
-  if (j1 >= (int) mHeights.GetNy()) j1 = mHeights.GetNy() - 1;
+  if (i1 >= (int) heights.GetNx()) i1 = heights.GetNx() - 1;
+  if (j1 >= (int) heights.GetNy()) j1 = heights.GetNy() - 1;
   
   tScalar iFrac = (x - (i0 * mDx + mXMin))/mDx;
   tScalar jFrac = (y - (j0 * mDy + mYMin))/mDy;
   Limit(iFrac, SCALAR(0.0f), SCALAR(1.0f));
   Limit(jFrac, SCALAR(0.0f), SCALAR(1.0f));
   
-  tScalar h00 = mHeights(i0, j0);
-  tScalar h01 = mHeights(i0, j1);
-  tScalar h10 = mHeights(i1, j0);
-  tScalar h11 = mHeights(i1, j1);
+  tScalar h00 = heights(i0, j0);
+  tScalar h01 = heights(i0, j1);
+  tScalar h10 = heights(i1, j0);
+  tScalar h11 = heights(i1, j1);
   
   // All the triangles are orientated the same way.
   // work out the normal, then z is in the plane of this normal
@@ -222,44 +305,345 @@ void tHeightmap::GetSurfacePosAndNormal(tVector3 & pos,
   pos = tVector3(point.x, point.y, h);
 }
 //==============================================================
-// SegmentIntersect
-// assume that the segment doesn't pass through the terrain and out.
+// GetCellRange
 //==============================================================
-bool tHeightmap::SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const
+bool tHeightmap::GetCellRange(int & iMin, int & jMin, int & iMax, int & jMax,
+                              const tAABox & box) const
 {
-  if (seg.mDelta.z > -SCALAR_TINY)
+  if (box.GetMaxPos().x < mXMin || box.GetMinPos().x > mXMax ||
+      box.GetMaxPos().y < mYMin || box.GetMinPos().y > mYMax)
     return false;
-  
-  tVector3 normalStart;
-  tScalar heightStart;
-  GetHeightAndNormal(heightStart, normalStart, seg.mOrigin);
-  
-  if (heightStart < 0.0f)
+
+  iMin = (int) ((box.GetMinPos().x - mXMin) / mDx);
+  jMin = (int) ((box.GetMinPos().y - mYMin) / mDy);
+  iMax = (int) ((box.GetMaxPos().x - mXMin) / mDx);
+  jMax = (int) ((box.GetMaxPos().y - mYMin) / mDy);
+  Limit(iMin, 0, (int) GetNx() - 2);
+  Limit(jMin, 0, (int) GetNy() - 2);
+  Limit(iMax, 0, (int) GetNx() - 2);
+  Limit(jMax, 0, (int) GetNy() - 2);
+  return true;
+}
+
+//==============================================================
+// GetCellTriangles
+// Split the same way as in GetHeightAndNormal
+//==============================================================
+void tHeightmap::GetCellTriangles(tTriangle & tri0, tTriangle & tri1,
+                                  int i, int j) const
+{
+  tVector3 p00, p10, p01, p11;
+  GetSurfacePos(p00, i, j);
+  GetSurfacePos(p10, i + 1, j);
+  GetSurfacePos(p01, i, j + 1);
+  GetSurfacePos(p11, i + 1, j + 1);
+  tri0 = tTriangle(p00, p10, p11);
+  tri1 = tTriangle(p00, p11, p01);
+}
+
+//==============================================================
+// GetBlockRange
+//==============================================================
+inline const tHeightmap::tHeightRange & tHeightmap::GetBlockRange(unsigned level, int i, int j) const
+{
+  const tArray2D<tHeightRange> & blocks = mData->mLevels[level];
+  Limit(i, 0, (int) blocks.GetNx() - 1);
+  Limit(j, 0, (int) blocks.GetNy() - 1);
+  return blocks(i, j);
+}
+
+//==============================================================
+// GetHeightRange
+//==============================================================
+void tHeightmap::GetHeightRange(tScalar & hMin, tScalar & hMax,
+                                int iMin, int jMin, int iMax, int jMax) const
+{
+  // Go up the pyramid until the cells are covered by 2x2 blocks at
+  // most - cell i is in block i >> (level + 1)
+  const unsigned numLevels = mData->mLevels.size();
+  unsigned level = 0;
+  iMin >>= 1; jMin >>= 1;
+  iMax >>= 1; jMax >>= 1;
+  while (level + 1 < numLevels && (iMax - iMin > 1 || jMax - jMin > 1))
+  {
+    ++level;
+    iMin >>= 1; jMin >>= 1;
+    iMax >>= 1; jMax >>= 1;
+  }
+
+  hMin = SCALAR_HUGE;
+  hMax = -SCALAR_HUGE;
+  for (int j = jMin ; j <= jMax ; ++j)
+  {
+    for (int i = iMin ; i <= iMax ; ++i)
+    {
+      const tHeightRange & range = GetBlockRange(level, i, j);
+      if (range.mMin < hMin) hMin = range.mMin;
+      if (range.mMax > hMax) hMax = range.mMax;
+    }
+  }
+}
+
+//==============================================================
+// GetHeightRange
+//==============================================================
+void tHeightmap::GetHeightRange(tScalar & hMin, tScalar & hMax, const tAABox & box) const
+{
+  // clamp before converting, since the box might be huge
+  tVector3 minPos = box.GetMinPos();
+  tVector3 maxPos = box.GetMaxPos();
+  Limit(minPos.x, mXMin, mXMax);
+  Limit(minPos.y, mYMin, mYMax);
+  Limit(maxPos.x, mXMin, mXMax);
+  Limit(maxPos.y, mYMin, mYMax);
+
+  int iMin = (int) ((minPos.x - mXMin) / mDx);
+  int jMin = (int) ((minPos.y - mYMin) / mDy);
+  int iMax = (int) ((maxPos.x - mXMin) / mDx);
+  int jMax = (int) ((maxPos.y - mYMin) / mDy);
+  Limit(iMin, 0, (int) GetNx() - 2);
+  Limit(jMin, 0, (int) GetNy() - 2);
+  Limit(iMax, 0, (int) GetNx() - 2);
+  Limit(jMax, 0, (int) GetNy() - 2);
+  GetHeightRange(hMin, hMax, iMin, jMin, iMax, jMax);
+}
+
+//==============================================================
+// ClipSegmentToRect
+// Narrows t0 to t1 (fractions along the segment) to the part that's
+// over the rectangle in x/y. Returns false if none of it is.
+//==============================================================
+static bool ClipSegmentToRect(tScalar & t0, tScalar & t1, const tSegment & seg,
+                              tScalar xMin, tScalar yMin, tScalar xMax, tScalar yMax)
+{
+  const tScalar origins[2] = {seg.mOrigin.x, seg.mOrigin.y};
+  const tScalar deltas[2] = {seg.mDelta.x, seg.mDelta.y};
+  const tScalar mins[2] = {xMin, yMin};
+  const tScalar maxs[2] = {xMax, yMax};
+  for (unsigned i = 0 ; i < 2 ; ++i)
+  {
+    if (Abs(deltas[i]) < SCALAR_TINY)
+    {
+      if (origins[i] < mins[i] || origins[i] > maxs[i])
+        return false;
+      continue;
+    }
+    tScalar tMin = (mins[i] - origins[i]) / deltas[i];
+    tScalar tMax = (maxs[i] - origins[i]) / deltas[i];
+    if (tMin > tMax)
+      Swap(tMin, tMax);
+    if (tMin > t0) t0 = tMin;
+    if (tMax < t1) t1 = tMax;
+    if (t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+//==============================================================
+// SegmentIntersectBlock
+//==============================================================
+bool tHeightmap::SegmentIntersectBlock(tScalar & frac, tVector3 & normal, const tSegment & seg,
+                                       unsigned level, int i, int j, tScalar t0, tScalar t1) const
+{
+  if (t0 > frac)
     return false;
-  
-  tVector3 normalEnd;
-  tScalar heightEnd;
-  tVector3 end = seg.GetEnd();
-  GetHeightAndNormal(heightEnd, normalEnd, end);
-  
-  if (heightEnd > 0.0f)
+
+  // the part of the segment over the block is all above or below it
+  const tHeightRange & range = mData->mLevels[level](i, j);
+  const tScalar z0 = seg.mOrigin.z + t0 * seg.mDelta.z;
+  const tScalar z1 = seg.mOrigin.z + t1 * seg.mDelta.z;
+  if (Min(z0, z1) > range.mMax || Max(z0, z1) < range.mMin)
     return false;
-  
-  // start is above, end is below...
-  tScalar depthEnd = -heightEnd;
-  
-  // normal is the weighted mean of these...
-  tScalar weightStart = 1.0f / (SCALAR_TINY + heightStart);
-  tScalar weightEnd = 1.0f / (SCALAR_TINY + depthEnd);
-  
-  normal = (normalStart * weightStart + normalEnd * weightEnd) /
-    (weightStart + weightEnd);
-  
-  frac = heightStart / (heightStart + depthEnd + SCALAR_TINY);
-  
-  pos = seg.GetPoint(frac);
-  
-  return true;
+
+  bool hit = false;
+  if (level == 0)
+  {
+    const int iEnd = Min(2 * i + 2, (int) GetNx() - 1);
+    const int jEnd = Min(2 * j + 2, (int) GetNy() - 1);
+    tTriangle triangles[2];
+    tScalar t;
+    for (int jCell = 2 * j ; jCell < jEnd ; ++jCell)
+    {
+      for (int iCell = 2 * i ; iCell < iEnd ; ++iCell)
+      {
+        GetCellTriangles(triangles[0], triangles[1], iCell, jCell);
+        for (unsigned iTri = 0 ; iTri < 2 ; ++iTri)
+        {
+          // only hit from above
+          const tVector3 triNormal = Cross(triangles[iTri].GetEdge0(), triangles[iTri].GetEdge1());
+          if (Dot(triNormal, seg.mDelta) < SCALAR(0.0f) &&
+              SegmentTriangleIntersection(&t, 0, 0, seg, triangles[iTri]) &&
+              t < frac)
+          {
+            frac = t;
+            normal = triNormal.GetNormalisedSafe();
+            hit = true;
+          }
+        }
+      }
+    }
+    return hit;
+  }
+
+  // Visit the blocks below in the order that the segment passes over
+  // them, stopping once they start after the closest hit. They get
+  // expanded a little so hits on their edges don't get missed.
+  struct tChild
+  {
+    int i, j;
+    tScalar t0, t1;
+  };
+  tChild children[4];
+  unsigned numChildren = 0;
+  const tArray2D<tHeightRange> & below = mData->mLevels[level - 1];
+  const int cellsPerChild = 1 << level;
+  const tScalar dx = cellsPerChild * mDx;
+  const tScalar dy = cellsPerChild * mDy;
+  const tScalar epsX = SCALAR(0.001f) * mDx;
+  const tScalar epsY = SCALAR(0.001f) * mDy;
+  for (int jChild = 2 * j ; jChild < Min(2 * j + 2, (int) below.GetNy()) ; ++jChild)
+  {
+    for (int iChild = 2 * i ; iChild < Min(2 * i + 2, (int) below.GetNx()) ; ++iChild)
+    {
+      const tScalar xMin = mXMin + iChild * dx;
+      const tScalar yMin = mYMin + jChild * dy;
+      tChild child = {iChild, jChild, t0, t1};
+      if (!ClipSegmentToRect(child.t0, child.t1, seg,
+                             xMin - epsX, yMin - epsY, xMin + dx + epsX, yMin + dy + epsY))
+        continue;
+      unsigned iInsert = numChildren++;
+      for ( ; iInsert > 0 && children[iInsert - 1].t0 > child.t0 ; --iInsert)
+        children[iInsert] = children[iInsert - 1];
+      children[iInsert] = child;
+    }
+  }
+
+  for (unsigned iChild = 0 ; iChild < numChildren ; ++iChild)
+  {
+    const tChild & child = children[iChild];
+    if (SegmentIntersectBlock(frac, normal, seg, level - 1, child.i, child.j, child.t0, child.t1))
+      hit = true;
+  }
+  return hit;
+}
+
+//==============================================================
+// SegmentIntersectOutside
+// Outside the heightmap GetHeightAndNormal uses the plane of the
+// nearest edge triangle, which changes where the segment crosses grid
+// lines. So step between those crossings, using the plane from the
+// middle of each piece. The surface can step down (or up) where the
+// plane changes, and stepping from above to below counts as a hit
+// too.
+//==============================================================
+bool tHeightmap::SegmentIntersectOutside(tScalar & frac, tVector3 & normal, const tSegment & seg,
+                                         tScalar t0, tScalar t1) const
+{
+  if (t1 <= t0)
+    return false;
+
+  const tScalar origins[2] = {seg.mOrigin.x, seg.mOrigin.y};
+  const tScalar deltas[2] = {seg.mDelta.x, seg.mDelta.y};
+  const tScalar mins[2] = {mXMin, mYMin};
+  const tScalar d[2] = {mDx, mDy};
+  const int nums[2] = {(int) GetNx(), (int) GetNy()};
+
+  // the next grid line to cross along each axis
+  int line[2];
+  int step[2];
+  for (unsigned i = 0 ; i < 2 ; ++i)
+  {
+    step[i] = deltas[i] > SCALAR_TINY ? 1 : (deltas[i] < -SCALAR_TINY ? -1 : 0);
+    const tScalar pos = (origins[i] + t0 * deltas[i] - mins[i]) / d[i];
+    line[i] = step[i] > 0 ? (int) floor(pos) + 1 : (int) ceil(pos) - 1;
+    if (step[i] > 0 && line[i] < 0)
+      line[i] = 0;
+    else if (step[i] < 0 && line[i] > nums[i] - 1)
+      line[i] = nums[i] - 1;
+  }
+
+  tScalar tA = t0;
+  bool above = false;
+  bool first = true;
+  while (true)
+  {
+    unsigned iNext = 2;
+    tScalar tB = t1;
+    for (unsigned i = 0 ; i < 2 ; ++i)
+    {
+      if (step[i] == 0 || line[i] < 0 || line[i] > nums[i] - 1)
+        continue;
+      const tScalar t = (mins[i] + line[i] * d[i] - origins[i]) / deltas[i];
+      if (t < tB)
+      {
+        tB = t;
+        iNext = i;
+      }
+    }
+    if (tB < tA)
+      tB = tA;
+
+    // the height above this piece's plane at either end
+    const tVector3 mid = seg.GetPoint(SCALAR(0.5f) * (tA + tB));
+    tScalar hMid;
+    tVector3 N;
+    GetHeightAndNormal(hMid, N, mid);
+    const tScalar hA = hMid + (tA - SCALAR(0.5f) * (tA + tB)) * Dot(seg.mDelta, N);
+    const tScalar hB = hMid + (tB - SCALAR(0.5f) * (tA + tB)) * Dot(seg.mDelta, N);
+
+    if (!first && above && hA < SCALAR(0.0f))
+    {
+      frac = tA;
+      normal = N;
+      return true;
+    }
+    if (hA >= SCALAR(0.0f) && hB < SCALAR(0.0f))
+    {
+      frac = tA + (tB - tA) * hA / (hA - hB);
+      normal = N;
+      return true;
+    }
+    if (iNext == 2)
+      return false;
+    line[iNext] += step[iNext];
+    tA = tB;
+    above = hB >= SCALAR(0.0f);
+    first = false;
+  }
+}
+
+//==============================================================
+// SegmentIntersect
+// Walks down the min/max pyramid, so only the blocks that the
+// segment passes through (at the right height) get their triangles
+// tested. Only hits on the top of the surface count. The parts of
+// the segment that aren't over the heightmap are tested against the
+// edges carried on outwards, as the collision detection sees them.
+//==============================================================
+bool tHeightmap::SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const
+{
+  tScalar t0 = SCALAR(0.0f);
+  tScalar t1 = SCALAR(1.0f);
+  if (!ClipSegmentToRect(t0, t1, seg, mXMin, mYMin, mXMax, mYMax))
+  {
+    if (!SegmentIntersectOutside(frac, normal, seg, SCALAR(0.0f), SCALAR(1.0f)))
+      return false;
+    pos = seg.GetPoint(frac);
+    return true;
+  }
+
+  // before, over, then after the heightmap
+  tScalar closestFrac = SCALAR_HUGE;
+  if (SegmentIntersectOutside(closestFrac, normal, seg, SCALAR(0.0f), t0) ||
+      SegmentIntersectBlock(closestFrac, normal, seg, mData->mLevels.size() - 1, 0, 0, t0, t1) ||
+      SegmentIntersectOutside(closestFrac, normal, seg, t1, SCALAR(1.0f)))
+  {
+    frac = closestFrac;
+    pos = seg.GetPoint(frac);
+    return true;
+  }
+  return false;
 }
 
 //==============================================================
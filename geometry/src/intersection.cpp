@@ -8,9 +8,22 @@
 //==============================================================
 #include "intersection.hpp"
 #include "distance.hpp"
+#include "trianglemesh.hpp"
+#include "convexhull.hpp"
+#include "gjk.hpp"
+#include "collisionscratch.hpp"
 #include <limits>
+#include <vector>
 using namespace JigLib;
 
+/// Sweeps stop when the shapes get this close (or for polytopes,
+/// this far before they touch), so that whatever got swept can be
+/// moved there and swept again without starting off touching.
+static const tScalar sweepTolerance = SCALAR(0.001f);
+
+/// Limit on the steps when homing in on the time of impact
+static const unsigned maxSweepIterations = 32;
+
 //====================================================================
 // SweptSphereTriangleIntersection
 // See Real Time Rendering p624
@@ -113,11 +126,8 @@ bool JigLib::SweptSphereTriangleIntersection(tVector3& pt, tVector3& N, tScalar&
     N = (Ct - pt).GetNormalisedSafe();
     // depth is already calculated
   }
-  if (bestT <= 1.0f)
-    return true;
 
-  // check the corners
-  bestT = SCALAR_HUGE;
+  // check the corners - a corner can be hit before an edge
   for (i = 0 ; i < 3 ; ++i)
   {
     unsigned mask = 1 << i;
@@ -157,3 +167,761 @@ bool JigLib::SweptSphereTriangleIntersection(tVector3& pt, tVector3& N, tScalar&
   return false;
 }
 
+
+//====================================================================
+// GetCoreRadius
+// Spheres and capsules are treated as a point/segment (the "core")
+// plus a radius
+//====================================================================
+static tScalar GetCoreRadius(const tPrimitive * prim)
+{
+  if (prim == 0)
+    return SCALAR(0.0f);
+  switch (prim->GetType())
+  {
+  case tPrimitive::SPHERE: return prim->GetSphere().GetRadius();
+  case tPrimitive::CAPSULE: return prim->GetCapsule().GetRadius();
+  default: return SCALAR(0.0f);
+  }
+}
+
+//====================================================================
+// GetCapsuleSegment
+//====================================================================
+static inline tSegment GetCapsuleSegment(const tCapsule & capsule, const tVector3 & offset)
+{
+  return tSegment(capsule.GetPos() + offset, capsule.GetEnd() - capsule.GetPos());
+}
+
+//====================================================================
+// GetCoreClosestPoints
+// Returns the distance between the cores of shape (moved by offset)
+// and prim - or triangle if prim is 0. Box-box and box-triangle
+// aren't handled here.
+//====================================================================
+static tScalar GetCoreClosestPoints(tVector3 & ptShape, tVector3 & ptPrim,
+                                    const tPrimitive & shape, const tVector3 & offset,
+                                    const tPrimitive * prim, const tTriangle * triangle)
+{
+  tScalar t0, t1, t2, t3;
+  switch (shape.GetType())
+  {
+  case tPrimitive::SPHERE:
+    ptShape = shape.GetSphere().GetPos() + offset;
+    if (triangle)
+    {
+      PointTriangleDistanceSq(&t0, &t1, ptShape, *triangle);
+      ptPrim = triangle->GetPoint(t0, t1);
+    }
+    else if (prim->GetType() == tPrimitive::SPHERE)
+    {
+      ptPrim = prim->GetSphere().GetPos();
+    }
+    else if (prim->GetType() == tPrimitive::CAPSULE)
+    {
+      const tSegment seg = GetCapsuleSegment(prim->GetCapsule(), tVector3::Zero());
+      PointSegmentDistanceSq(&t0, ptShape, seg);
+      ptPrim = seg.GetPoint(t0);
+    }
+    else
+    {
+      prim->GetBox().GetSqDistanceToPoint(ptPrim, ptShape);
+    }
+    break;
+  case tPrimitive::CAPSULE:
+  {
+    const tSegment seg = GetCapsuleSegment(shape.GetCapsule(), offset);
+    if (triangle)
+    {
+      SegmentTriangleDistanceSq(&t0, &t1, &t2, seg, *triangle);
+      ptShape = seg.GetPoint(t0);
+      ptPrim = triangle->GetPoint(t1, t2);
+    }
+    else if (prim->GetType() == tPrimitive::SPHERE)
+    {
+      ptPrim = prim->GetSphere().GetPos();
+      PointSegmentDistanceSq(&t0, ptPrim, seg);
+      ptShape = seg.GetPoint(t0);
+    }
+    else if (prim->GetType() == tPrimitive::CAPSULE)
+    {
+      const tSegment primSeg = GetCapsuleSegment(prim->GetCapsule(), tVector3::Zero());
+      SegmentSegmentDistanceSq(&t0, &t1, seg, primSeg);
+      ptShape = seg.GetPoint(t0);
+      ptPrim = primSeg.GetPoint(t1);
+    }
+    else
+    {
+      const tBox & box = prim->GetBox();
+      SegmentBoxDistanceSq(&t0, &t1, &t2, &t3, seg, box);
+      ptShape = seg.GetPoint(t0);
+      ptPrim = box.GetCentre() + t1 * box.GetOrient()[0] + 
+        t2 * box.GetOrient()[1] + t3 * box.GetOrient()[2];
+    }
+    break;
+  }
+  case tPrimitive::BOX:
+  {
+    tBox box(shape.GetBox());
+    box.SetPos(box.GetPos() + offset);
+    Assert(prim);
+    if (prim->GetType() == tPrimitive::SPHERE)
+    {
+      ptPrim = prim->GetSphere().GetPos();
+      box.GetSqDistanceToPoint(ptShape, ptPrim);
+    }
+    else
+    {
+      const tSegment seg = GetCapsuleSegment(prim->GetCapsule(), tVector3::Zero());
+      SegmentBoxDistanceSq(&t0, &t1, &t2, &t3, seg, box);
+      ptPrim = seg.GetPoint(t0);
+      ptShape = box.GetCentre() + t1 * box.GetOrient()[0] + 
+        t2 * box.GetOrient()[1] + t3 * box.GetOrient()[2];
+    }
+    break;
+  }
+  default:
+    Assert(!"Unhandled shape type");
+    return SCALAR_HUGE;
+  }
+  return PointPointDistance(ptShape, ptPrim);
+}
+
+//====================================================================
+// SweptConvexIntersection
+// Conservative advancement. The distance between two convex things
+// is a convex function of how far one of them has moved, so stepping
+// to where its tangent reaches zero never goes past the first
+// contact (and converges quickly). Once the distance stops
+// decreasing it never will.
+//====================================================================
+static bool SweptConvexIntersection(tScalar & frac, tVector3 & pt, tVector3 & N,
+                                    const tPrimitive & shape, const tVector3 & delta,
+                                    const tPrimitive * prim, const tTriangle * triangle)
+{
+  const tScalar primRadius = GetCoreRadius(prim);
+  const tScalar radius = GetCoreRadius(&shape) + primRadius;
+  tVector3 ptShape, ptPrim;
+  tScalar t = SCALAR(0.0f);
+  for (unsigned iIter = 0 ; iIter < maxSweepIterations ; ++iIter)
+  {
+    const tScalar dist = GetCoreClosestPoints(ptShape, ptPrim, shape, t * delta, prim, triangle);
+    if (dist < SCALAR_TINY)
+    {
+      // the cores overlap, so there's no way of telling which way is out
+      frac = t;
+      pt = ptPrim;
+      N = -delta.GetNormalisedSafe();
+      return true;
+    }
+    N = (ptShape - ptPrim) / dist;
+    const tScalar closingSpeed = -Dot(delta, N);
+    if (closingSpeed <= SCALAR(0.0f))
+      return false;
+    const tScalar gap = dist - radius;
+    if (gap < sweepTolerance)
+    {
+      frac = t;
+      pt = ptPrim + primRadius * N;
+      return true;
+    }
+    t += gap / closingSpeed;
+    if (t > SCALAR(1.0f))
+      return false;
+  }
+  return false;
+}
+
+//====================================================================
+// SweptConvexHullIntersection
+// Like SweptConvexIntersection, but using GJK to get the distance
+//====================================================================
+static bool SweptConvexHullIntersection(tScalar & frac, tVector3 & pt, tVector3 & N,
+                                        const tPrimitive & shape, const tVector3 & delta,
+                                        const tConvexHull & hull)
+{
+  tSupportShape shape0, shape1;
+  shape0.SetPrimitive(shape);
+  shape1.SetPrimitive(hull);
+  tVector3 ptShape, ptPrim;
+  tScalar t = SCALAR(0.0f);
+  for (unsigned iIter = 0 ; iIter < maxSweepIterations ; ++iIter)
+  {
+    shape0.SetOffset(t * delta);
+    tScalar gap;
+    if (!ConvexConvexSeparation(gap, N, ptShape, ptPrim, shape0, shape1))
+      return false;
+    if (gap < SCALAR(0.0f) && iIter == 0)
+    {
+      // started off overlapping
+      frac = t;
+      pt = ptPrim;
+      return Dot(delta, N) < SCALAR(0.0f);
+    }
+    const tScalar closingSpeed = -Dot(delta, N);
+    if (closingSpeed <= SCALAR(0.0f))
+      return false;
+    if (gap < sweepTolerance)
+    {
+      frac = t;
+      pt = ptPrim;
+      return true;
+    }
+    t += gap / closingSpeed;
+    if (t > SCALAR(1.0f))
+      return false;
+  }
+  return false;
+}
+
+//====================================================================
+// GetSupportPoints
+// Copies the points that are furthest along dir (to within tol) into
+// supportPts, and returns how many there are.
+//====================================================================
+static unsigned GetSupportPoints(tVector3 * supportPts, const tVector3 * pts, unsigned numPts,
+                                 const tVector3 & dir, tScalar tol)
+{
+  tScalar maxDist = -SCALAR_HUGE;
+  unsigned i;
+  for (i = 0 ; i < numPts ; ++i)
+    maxDist = Max(maxDist, Dot(pts[i], dir));
+  unsigned numSupportPts = 0;
+  for (i = 0 ; i < numPts ; ++i)
+  {
+    if (Dot(pts[i], dir) > maxDist - tol)
+      supportPts[numSupportPts++] = pts[i];
+  }
+  return numSupportPts;
+}
+
+//====================================================================
+// GetPolytopeAxes
+// The possible separating axes of a box and a box/triangle - the box
+// faces, the prim faces, and edge-edge. axes needs room for 15.
+//====================================================================
+static unsigned GetPolytopeAxes(tVector3 * axes, const tBox & box,
+                                const tVector3 * primFaceNormals, unsigned numPrimFaceNormals,
+                                const tVector3 * primEdges, unsigned numPrimEdges)
+{
+  unsigned numAxes = 0;
+  unsigned i, j;
+  for (i = 0 ; i < 3 ; ++i)
+    axes[numAxes++] = box.GetOrient()[i];
+  for (i = 0 ; i < numPrimFaceNormals ; ++i)
+    axes[numAxes++] = primFaceNormals[i];
+  for (i = 0 ; i < 3 ; ++i)
+  {
+    for (j = 0 ; j < numPrimEdges ; ++j)
+    {
+      tVector3 axis = Cross(box.GetOrient()[i], primEdges[j]);
+      tScalar lenSq = axis.GetLengthSq();
+      // parallel edges are covered by the face axes
+      if (lenSq > SCALAR_TINY)
+        axes[numAxes++] = axis / Sqrt(lenSq);
+    }
+  }
+  return numAxes;
+}
+
+//====================================================================
+// PolytopeOverlap
+// The static version of SweptPolytopeIntersection
+//====================================================================
+static bool PolytopeOverlap(const tBox & box, 
+                            const tVector3 * primPts, unsigned numPrimPts,
+                            const tVector3 * primFaceNormals, unsigned numPrimFaceNormals,
+                            const tVector3 * primEdges, unsigned numPrimEdges)
+{
+  tVector3 axes[3 + 3 + 9];
+  const unsigned numAxes = GetPolytopeAxes(axes, box, primFaceNormals, numPrimFaceNormals,
+                                           primEdges, numPrimEdges);
+  for (unsigned i = 0 ; i < numAxes ; ++i)
+  {
+    tScalar boxMin, boxMax;
+    box.GetSpan(boxMin, boxMax, axes[i]);
+    tScalar primMin = SCALAR_HUGE;
+    tScalar primMax = -SCALAR_HUGE;
+    for (unsigned j = 0 ; j < numPrimPts ; ++j)
+    {
+      tScalar d = Dot(primPts[j], axes[i]);
+      primMin = Min(primMin, d);
+      primMax = Max(primMax, d);
+    }
+    if (boxMax < primMin || boxMin > primMax)
+      return false;
+  }
+  return true;
+}
+
+//====================================================================
+// SweptPolytopeIntersection
+// A box against a box or triangle. The time of impact is when the
+// projections onto all the separating axes first overlap. The contact
+// point is picked from the features that end up touching.
+//====================================================================
+static bool SweptPolytopeIntersection(tScalar & frac, tVector3 & pt, tVector3 & N,
+                                      const tBox & box, const tVector3 & delta,
+                                      const tVector3 * primPts, unsigned numPrimPts,
+                                      const tVector3 * primFaceNormals, unsigned numPrimFaceNormals,
+                                      const tVector3 * primEdges, unsigned numPrimEdges)
+{
+  tVector3 axes[3 + 3 + 9];
+  const unsigned numAxes = GetPolytopeAxes(axes, box, primFaceNormals, numPrimFaceNormals,
+                                           primEdges, numPrimEdges);
+  unsigned i, j;
+
+  tScalar tFirst = -SCALAR_HUGE;
+  tScalar tLast = SCALAR_HUGE;
+  tScalar closingSpeed = SCALAR(0.0f);
+  N = -delta.GetNormalisedSafe();
+  for (i = 0 ; i < numAxes ; ++i)
+  {
+    const tVector3 & axis = axes[i];
+    tScalar boxMin, boxMax;
+    box.GetSpan(boxMin, boxMax, axis);
+    tScalar primMin = SCALAR_HUGE;
+    tScalar primMax = -SCALAR_HUGE;
+    for (j = 0 ; j < numPrimPts ; ++j)
+    {
+      tScalar d = Dot(primPts[j], axis);
+      primMin = Min(primMin, d);
+      primMax = Max(primMax, d);
+    }
+
+    const tScalar v = Dot(delta, axis);
+    if (Abs(v) < SCALAR_TINY)
+    {
+      if (boxMax < primMin || boxMin > primMax)
+        return false;
+      continue;
+    }
+    tScalar tEnter, tExit;
+    if (v > SCALAR(0.0f))
+    {
+      tEnter = (primMin - boxMax) / v;
+      tExit = (primMax - boxMin) / v;
+    }
+    else
+    {
+      tEnter = (primMax - boxMin) / v;
+      tExit = (primMin - boxMax) / v;
+    }
+    if (tEnter > tFirst)
+    {
+      tFirst = tEnter;
+      N = v > SCALAR(0.0f) ? -axis : axis;
+      closingSpeed = Abs(v);
+    }
+    tLast = Min(tLast, tExit);
+    if (tFirst > tLast || tFirst > SCALAR(1.0f) || tLast < SCALAR(0.0f))
+      return false;
+  }
+
+  tScalar tContact = Max(tFirst, SCALAR(0.0f));
+  frac = closingSpeed > SCALAR(0.0f) ? 
+    Max(tFirst - sweepTolerance / closingSpeed, SCALAR(0.0f)) : SCALAR(0.0f);
+
+  // the features that touch at tContact
+  tVector3 boxPts[8];
+  box.GetCornerPoints(boxPts);
+  for (i = 0 ; i < 8 ; ++i)
+    boxPts[i] += tContact * delta;
+  const tScalar tol = SCALAR(0.001f) * box.GetBoundingRadiusAboutCentre();
+  tVector3 boxSupport[8];
+  tVector3 primSupport[8];
+  const unsigned numBoxSupport = GetSupportPoints(boxSupport, boxPts, 8, -N, tol);
+  const unsigned numPrimSupport = GetSupportPoints(primSupport, primPts, numPrimPts, N, tol);
+  if (numBoxSupport == 1)
+  {
+    pt = boxSupport[0];
+  }
+  else if (numPrimSupport == 1)
+  {
+    pt = primSupport[0];
+  }
+  else if (numBoxSupport == 2 && numPrimSupport == 2)
+  {
+    tSegment seg0(boxSupport[0], boxSupport[1] - boxSupport[0]);
+    tSegment seg1(primSupport[0], primSupport[1] - primSupport[0]);
+    tScalar t0, t1;
+    SegmentSegmentDistanceSq(&t0, &t1, seg0, seg1);
+    pt = 0.5f * (seg0.GetPoint(t0) + seg1.GetPoint(t1));
+  }
+  else
+  {
+    // face against edge or face - use the middle of the smaller one
+    const tVector3 * supportPts = numBoxSupport <= numPrimSupport ? boxSupport : primSupport;
+    const unsigned numSupportPts = Min(numBoxSupport, numPrimSupport);
+    pt.SetToZero();
+    for (i = 0 ; i < numSupportPts ; ++i)
+      pt += supportPts[i];
+    pt /= (tScalar) numSupportPts;
+  }
+  return true;
+}
+
+//====================================================================
+// GetPlaneSupportPoint
+// Gets the point of shape's core that's closest to the plane, and
+// the radius around it.
+//====================================================================
+static void GetPlaneSupportPoint(tVector3 & supportPos, tScalar & radius,
+                                 const tPrimitive & shape, const tPlane & plane)
+{
+  radius = GetCoreRadius(&shape);
+  switch (shape.GetType())
+  {
+  case tPrimitive::SPHERE:
+    supportPos = shape.GetSphere().GetPos();
+    break;
+  case tPrimitive::CAPSULE:
+  {
+    const tCapsule & capsule = shape.GetCapsule();
+    const tVector3 end = capsule.GetEnd();
+    supportPos = PointPlaneDistance(capsule.GetPos(), plane) < PointPlaneDistance(end, plane) ?
+      capsule.GetPos() : end;
+    break;
+  }
+  case tPrimitive::BOX:
+  {
+    tVector3 pts[8];
+    shape.GetBox().GetCornerPoints(pts);
+    supportPos = pts[0];
+    for (unsigned i = 1 ; i < 8 ; ++i)
+    {
+      if (Dot(pts[i], plane.GetN()) < Dot(supportPos, plane.GetN()))
+        supportPos = pts[i];
+    }
+    break;
+  }
+  default:
+    Assert(!"Unhandled shape type");
+    supportPos.SetToZero();
+  }
+}
+
+//====================================================================
+// SweptShapePlaneIntersection
+// Only the point of shape that's closest to the plane matters, so
+// sweep a sphere (maybe of zero radius) around it.
+//====================================================================
+static bool SweptShapePlaneIntersection(tScalar & frac, tVector3 & pt, tVector3 & N,
+                                        const tPrimitive & shape, const tVector3 & delta,
+                                        const tPlane & plane)
+{
+  if (Dot(delta, plane.GetN()) >= SCALAR(0.0f))
+    return false;
+
+  tVector3 supportPos;
+  tScalar radius;
+  GetPlaneSupportPoint(supportPos, radius, shape, plane);
+
+  N = plane.GetN();
+  tScalar oldDist = PointPlaneDistance(supportPos, plane);
+  if (oldDist < radius + sweepTolerance)
+  {
+    frac = SCALAR(0.0f);
+    pt = supportPos - oldDist * N;
+    return true;
+  }
+  tScalar newDist = PointPlaneDistance(supportPos + delta, plane);
+  tScalar depth;
+  if (!SweptSpherePlaneIntersection(pt, depth, 
+                                    tSphere(supportPos, radius), 
+                                    tSphere(supportPos + delta, radius),
+                                    plane, &oldDist, &newDist))
+    return false;
+  frac = Max((oldDist - radius - sweepTolerance) / (oldDist - newDist), SCALAR(0.0f));
+  return true;
+}
+
+//====================================================================
+// SweptShapeTriangleIntersection
+//====================================================================
+static bool SweptShapeTriangleIntersection(tScalar & frac, tVector3 & pt, tVector3 & N,
+                                           const tPrimitive & shape, const tVector3 & delta,
+                                           const tTriangle & triangle)
+{
+  const tVector3 triNormal = triangle.GetNormal();
+  if (Dot(delta, triNormal) >= SCALAR(0.0f))
+    return false;
+
+  switch (shape.GetType())
+  {
+  case tPrimitive::SPHERE:
+  {
+    const tSphere & sphere = shape.GetSphere();
+    const tScalar radius = sphere.GetRadius();
+    // SweptSphereTriangleIntersection only finds hits if the sphere
+    // starts off clear of the triangle plane
+    if (PointPlaneDistance(sphere.GetPos(), triangle.GetPlane()) < radius + sweepTolerance)
+      return SweptConvexIntersection(frac, pt, N, shape, delta, 0, &triangle);
+
+    tScalar depth;
+    if (!SweptSphereTriangleIntersection(pt, N, depth, sphere, 
+                                         tSphere(sphere.GetPos() + delta, radius),
+                                         triangle))
+      return false;
+    // it doesn't return the time, but the sphere centre is radius
+    // along the normal from the contact
+    const tScalar deltaSq = delta.GetLengthSq();
+    if (deltaSq < SCALAR_TINY)
+      return false;
+    const tScalar closingSpeed = -Dot(delta, N);
+    frac = Dot(pt + radius * N - sphere.GetPos(), delta) / deltaSq;
+    if (closingSpeed > SCALAR_TINY)
+      frac -= sweepTolerance / closingSpeed;
+    Limit(frac, SCALAR(0.0f), SCALAR(1.0f));
+    return true;
+  }
+  case tPrimitive::CAPSULE:
+    return SweptConvexIntersection(frac, pt, N, shape, delta, 0, &triangle);
+  case tPrimitive::BOX:
+  {
+    const tVector3 pts[3] = {triangle.GetPoint(0), triangle.GetPoint(1), triangle.GetPoint(2)};
+    const tVector3 edges[3] = {triangle.GetEdge0(), triangle.GetEdge1(), triangle.GetEdge2()};
+    return SweptPolytopeIntersection(frac, pt, N, shape.GetBox(), delta,
+                                     pts, 3, &triNormal, 1, edges, 3);
+  }
+  default:
+    Assert(!"Unhandled shape type");
+    return false;
+  }
+}
+
+//====================================================================
+// SweptPrimitiveIntersection
+//====================================================================
+bool JigLib::SweptPrimitiveIntersection(tScalar& fracOut, tVector3& ptOut, tVector3& NOut,
+                                        const tPrimitive& shape, const tVector3& delta,
+                                        const tPrimitive& prim)
+{
+  Assert(shape.GetType() == tPrimitive::SPHERE || 
+         shape.GetType() == tPrimitive::CAPSULE || 
+         shape.GetType() == tPrimitive::BOX);
+  switch (prim.GetType())
+  {
+  case tPrimitive::SPHERE:
+  case tPrimitive::CAPSULE:
+    return SweptConvexIntersection(fracOut, ptOut, NOut, shape, delta, &prim, 0);
+  case tPrimitive::BOX:
+  {
+    if (shape.GetType() != tPrimitive::BOX)
+      return SweptConvexIntersection(fracOut, ptOut, NOut, shape, delta, &prim, 0);
+    const tBox & box = prim.GetBox();
+    tVector3 pts[8];
+    box.GetCornerPoints(pts);
+    const tVector3 axes[3] = {box.GetOrient()[0], box.GetOrient()[1], box.GetOrient()[2]};
+    return SweptPolytopeIntersection(fracOut, ptOut, NOut, shape.GetBox(), delta,
+                                     pts, 8, axes, 3, axes, 3);
+  }
+  case tPrimitive::CONVEXHULL:
+    return SweptConvexHullIntersection(fracOut, ptOut, NOut, shape, delta, prim.GetConvexHull());
+  case tPrimitive::PLANE:
+    return SweptShapePlaneIntersection(fracOut, ptOut, NOut, shape, delta, prim.GetPlane());
+  case tPrimitive::HEIGHTMAP:
+  case tPrimitive::TRIANGLEMESH:
+    break;
+  default:
+    return false;
+  }
+
+  // Everything else is made of triangles - test the ones that are
+  // near the sweep and keep the earliest hit
+  tAABox sweptBox;
+  sweptBox.AddPrimitive(shape);
+  tAABox endBox(sweptBox);
+  endBox.Move(delta);
+  sweptBox.AddAABox(endBox);
+
+  fracOut = SCALAR_HUGE;
+  tScalar frac;
+  tVector3 pt, N;
+  tTriangle triangles[2];
+  if (prim.GetType() == tPrimitive::HEIGHTMAP)
+  {
+    const tHeightmap & heightmap = prim.GetHeightmap();
+    tScalar hMin, hMax;
+    heightmap.GetHeightRange(hMin, hMax, sweptBox);
+    if (sweptBox.GetMinPos().z > hMax)
+      return false;
+    int iMin, jMin, iMax, jMax;
+    if (!heightmap.GetCellRange(iMin, jMin, iMax, jMax, sweptBox))
+      return false;
+    for (int i = iMin ; i <= iMax ; ++i)
+    {
+      for (int j = jMin ; j <= jMax ; ++j)
+      {
+        heightmap.GetCellTriangles(triangles[0], triangles[1], i, j);
+        for (unsigned iTri = 0 ; iTri < 2 ; ++iTri)
+        {
+          if (SweptShapeTriangleIntersection(frac, pt, N, shape, delta, triangles[iTri]) &&
+              frac < fracOut)
+          {
+            fracOut = frac;
+            ptOut = pt;
+            NOut = N;
+          }
+        }
+      }
+    }
+  }
+  else
+  {
+    const tTriangleMesh & mesh = prim.GetTriangleMesh();
+    tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
+    const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, mesh.AABoxToMesh(sweptBox));
+    for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+    {
+      const tIndexedTriangle & meshTriangle = mesh.GetTriangle(potentialTriangles[iTriangle]);
+      triangles[0] = tTriangle(mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(0))),
+                               mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(1))),
+                               mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(2))));
+      if (SweptShapeTriangleIntersection(frac, pt, N, shape, delta, triangles[0]) &&
+          frac < fracOut)
+      {
+        fracOut = frac;
+        ptOut = pt;
+        NOut = N;
+      }
+    }
+  }
+  return fracOut <= SCALAR(1.0f);
+}
+
+//====================================================================
+// ShapeTriangleOverlap
+//====================================================================
+static bool ShapeTriangleOverlap(const tPrimitive & shape, const tTriangle & triangle)
+{
+  if (shape.GetType() == tPrimitive::BOX)
+  {
+    const tVector3 triNormal = triangle.GetNormal();
+    const tVector3 pts[3] = {triangle.GetPoint(0), triangle.GetPoint(1), triangle.GetPoint(2)};
+    const tVector3 edges[3] = {triangle.GetEdge0(), triangle.GetEdge1(), triangle.GetEdge2()};
+    return PolytopeOverlap(shape.GetBox(), pts, 3, &triNormal, 1, edges, 3);
+  }
+  tVector3 ptShape, ptPrim;
+  return GetCoreClosestPoints(ptShape, ptPrim, shape, tVector3::Zero(), 0, &triangle) <= 
+    GetCoreRadius(&shape);
+}
+
+//====================================================================
+// PrimitiveOverlap
+//====================================================================
+bool JigLib::PrimitiveOverlap(const tPrimitive& shape, const tPrimitive& prim)
+{
+  Assert(shape.GetType() == tPrimitive::SPHERE || 
+         shape.GetType() == tPrimitive::CAPSULE || 
+         shape.GetType() == tPrimitive::BOX);
+  tVector3 ptShape, ptPrim;
+  switch (prim.GetType())
+  {
+  case tPrimitive::SPHERE:
+  case tPrimitive::CAPSULE:
+    return GetCoreClosestPoints(ptShape, ptPrim, shape, tVector3::Zero(), &prim, 0) <=
+      GetCoreRadius(&shape) + GetCoreRadius(&prim);
+  case tPrimitive::BOX:
+  {
+    if (shape.GetType() != tPrimitive::BOX)
+      return GetCoreClosestPoints(ptShape, ptPrim, shape, tVector3::Zero(), &prim, 0) <=
+        GetCoreRadius(&shape);
+    const tBox & box = prim.GetBox();
+    tVector3 pts[8];
+    box.GetCornerPoints(pts);
+    const tVector3 axes[3] = {box.GetOrient()[0], box.GetOrient()[1], box.GetOrient()[2]};
+    return PolytopeOverlap(shape.GetBox(), pts, 8, axes, 3, axes, 3);
+  }
+  case tPrimitive::CONVEXHULL:
+  {
+    tSupportShape shape0, shape1;
+    shape0.SetPrimitive(shape);
+    shape1.SetPrimitive(prim);
+    tScalar separation;
+    tVector3 N;
+    return ConvexConvexSeparation(separation, N, ptShape, ptPrim, shape0, shape1) &&
+      separation <= SCALAR(0.0f);
+  }
+  case tPrimitive::PLANE:
+  {
+    tScalar radius;
+    GetPlaneSupportPoint(ptShape, radius, shape, prim.GetPlane());
+    return PointPlaneDistance(ptShape, prim.GetPlane()) <= radius;
+  }
+  case tPrimitive::HEIGHTMAP:
+  case tPrimitive::TRIANGLEMESH:
+    break;
+  default:
+    return false;
+  }
+
+  tAABox shapeBox;
+  shapeBox.AddPrimitive(shape);
+  tTriangle triangles[2];
+  if (prim.GetType() == tPrimitive::HEIGHTMAP)
+  {
+    const tHeightmap & heightmap = prim.GetHeightmap();
+    tScalar hMin, hMax;
+    heightmap.GetHeightRange(hMin, hMax, shapeBox);
+    if (shapeBox.GetMinPos().z > hMax)
+      return false;
+    // The heightmap is solid underneath, so anything that's
+    // completely below the surface overlaps without touching any
+    // triangles
+    tVector3 pts[8];
+    unsigned numPts;
+    switch (shape.GetType())
+    {
+    case tPrimitive::SPHERE:
+      pts[0] = shape.GetSphere().GetPos();
+      numPts = 1;
+      break;
+    case tPrimitive::CAPSULE:
+      pts[0] = shape.GetCapsule().GetPos();
+      pts[1] = shape.GetCapsule().GetEnd();
+      numPts = 2;
+      break;
+    default:
+      shape.GetBox().GetCornerPoints(pts);
+      numPts = 8;
+      break;
+    }
+    const tScalar radius = GetCoreRadius(&shape);
+    for (unsigned iPt = 0 ; iPt < numPts ; ++iPt)
+    {
+      if (heightmap.GetHeight(pts[iPt]) <= radius)
+        return true;
+    }
+
+    int iMin, jMin, iMax, jMax;
+    if (!heightmap.GetCellRange(iMin, jMin, iMax, jMax, shapeBox))
+      return false;
+    for (int i = iMin ; i <= iMax ; ++i)
+    {
+      for (int j = jMin ; j <= jMax ; ++j)
+      {
+        heightmap.GetCellTriangles(triangles[0], triangles[1], i, j);
+        if (ShapeTriangleOverlap(shape, triangles[0]) || 
+            ShapeTriangleOverlap(shape, triangles[1]))
+          return true;
+      }
+    }
+  }
+  else
+  {
+    const tTriangleMesh & mesh = prim.GetTriangleMesh();
+    tScratchVector<unsigned> potentialTriangles(tCollisionScratch::GetThreadScratch().mTriangles);
+    const unsigned numTriangles = mesh.GetTrianglesIntersectingtAABox(potentialTriangles, mesh.AABoxToMesh(shapeBox));
+    for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+    {
+      const tIndexedTriangle & meshTriangle = mesh.GetTriangle(potentialTriangles[iTriangle]);
+      triangles[0] = tTriangle(mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(0))),
+                               mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(1))),
+                               mesh.PointToWorld(mesh.GetVertex(meshTriangle.GetVertexIndex(2))));
+      if (ShapeTriangleOverlap(shape, triangles[0]))
+        return true;
+    }
+  }
+  return false;
+}
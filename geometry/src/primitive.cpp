@@ -14,6 +14,7 @@
 #include "plane.hpp"
 #include "sphere.hpp"
 #include "trianglemesh.hpp"
+#include "line.hpp"
 
 using namespace JigLib;
 
@@ -22,3 +23,20 @@ const class tAABox &tPrimitive::GetBoundingBox() const
 {
   return tAABox::HugeBox();
 }
+
+//==============================================================
+// SegmentIntersectBatch
+//==============================================================
+unsigned tPrimitive::SegmentIntersectBatch(tScalar * fracs, tVector3 * positions, tVector3 * normals,
+                                           const tSegment * segs, unsigned numSegs) const
+{
+  unsigned numHits = 0;
+  for (unsigned iSeg = 0 ; iSeg < numSegs ; ++iSeg)
+  {
+    if (SegmentIntersect(fracs[iSeg], positions[iSeg], normals[iSeg], segs[iSeg]))
+      ++numHits;
+    else
+      fracs[iSeg] = SCALAR_HUGE;
+  }
+  return numHits;
+}
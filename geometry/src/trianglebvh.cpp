@@ -0,0 +1,520 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file trianglebvh.cpp 
+//                     
+//==============================================================
+#include "trianglebvh.hpp"
+#include "segmentpacket.hpp"
+#include "triangle.hpp"
+#include "intersection.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+
+using namespace std;
+using namespace JigLib;
+
+// number of bins the centres get sorted into when looking for the
+// best split
+static const unsigned numSplitBins = 16;
+
+//====================================================================
+// tTriangleBVH
+//====================================================================
+tTriangleBVH::tTriangleBVH()
+{
+}
+
+//====================================================================
+// ~tTriangleBVH
+//====================================================================
+tTriangleBVH::~tTriangleBVH()
+{
+}
+
+//====================================================================
+// Clear
+//====================================================================
+void tTriangleBVH::Clear(bool freeMemory)
+{
+  if (freeMemory)
+  {
+    mNodes.clear();
+    mVertices.clear();
+    mTriangles.clear();
+    mEdgeNeighbours.clear();
+  }
+  else
+  {
+    mNodes.resize(0);
+    mVertices.resize(0);
+    mTriangles.resize(0);
+    mEdgeNeighbours.resize(0);
+  }
+}
+
+//====================================================================
+// AddTriangles
+//====================================================================
+void tTriangleBVH::AddTriangles(const tVector3 * vertices, unsigned numVertices,
+                                const tTriangleVertexIndices * triangleVertexIndices,
+                                unsigned numTriangles)
+{
+  mVertices.resize(0);
+  mTriangles.resize(0);
+  mEdgeNeighbours.resize(0);
+  mNodes.resize(0);
+
+  Assert(vertices);
+  Assert(triangleVertexIndices);
+
+  mVertices.assign(vertices, vertices + numVertices);
+
+  mTriangles.reserve(numTriangles);
+  for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+  {
+    unsigned i0 = triangleVertexIndices[iTriangle].i0;
+    unsigned i1 = triangleVertexIndices[iTriangle].i1;
+    unsigned i2 = triangleVertexIndices[iTriangle].i2;
+    Assert(i0 < numVertices);
+    Assert(i1 < numVertices);
+    Assert(i2 < numVertices);
+
+    tVector3 dr1 = vertices[i1] - vertices[i0];
+    tVector3 dr2 = vertices[i2] - vertices[i0];
+    tVector3 N = Cross(dr1, dr2);
+    tScalar NLen = N.GetLength();
+    // only add if it's not degenerate. This makes a hole in the mesh,
+    // so the neighbours will see those edges as open (and so convex)
+    if (NLen > SCALAR_TINY)
+    {
+      mTriangles.push_back(tIndexedTriangle());
+      mTriangles.back().SetVertexIndices(i0, i1, i2, vertices);
+    }
+  }
+}
+
+//====================================================================
+// BuildBVH
+//====================================================================
+void tTriangleBVH::BuildBVH(unsigned maxTrianglesPerLeaf)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+  if (maxTrianglesPerLeaf < 1)
+    maxTrianglesPerLeaf = 1;
+
+  mNodes.clear();
+  const unsigned numTriangles = mTriangles.size();
+  if (numTriangles == 0)
+    return;
+
+  mTriangleOrder.resize(numTriangles);
+  mCentres.resize(numTriangles);
+  unsigned i;
+  for (i = 0 ; i < numTriangles ; ++i)
+  {
+    mTriangleOrder[i] = i;
+    mCentres[i] = mTriangles[i].GetBoundingBox().GetCentre();
+  }
+
+  // there are at most 2n-1 nodes
+  mNodes.reserve(2 * numTriangles - 1);
+  BuildNode(0, numTriangles, maxTrianglesPerLeaf);
+
+  // put the triangles into leaf order
+  std::vector<tIndexedTriangle> triangles(numTriangles);
+  for (i = 0 ; i < numTriangles ; ++i)
+    triangles[i] = mTriangles[mTriangleOrder[i]];
+  mTriangles.swap(triangles);
+
+  std::vector<unsigned>().swap(mTriangleOrder);
+  std::vector<tVector3>().swap(mCentres);
+}
+
+//====================================================================
+// tEdgeRef
+// Used to sort the edges so that shared ones end up next to each
+// other
+//====================================================================
+struct tEdgeRef
+{
+  bool operator<(const tEdgeRef & other) const {
+    return iVertex0 != other.iVertex0 ? iVertex0 < other.iVertex0 : 
+      iVertex1 != other.iVertex1 ? iVertex1 < other.iVertex1 : iEdge < other.iEdge;}
+  /// iVertex0 < iVertex1
+  unsigned iVertex0, iVertex1;
+  /// 3 * triangle + edge
+  unsigned iEdge;
+};
+
+// Edges where the neighbour bends down by less than this (as the sin
+// of the angle) count as flat
+static const tScalar convexEdgeSin = SCALAR(0.01f);
+
+//====================================================================
+// BuildConnectivity
+//====================================================================
+void tTriangleBVH::BuildConnectivity()
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+  const unsigned numTriangles = mTriangles.size();
+  mEdgeNeighbours.assign(3 * numTriangles, (unsigned) NO_NEIGHBOUR);
+
+  std::vector<tEdgeRef> edges(3 * numTriangles);
+  unsigned iTriangle, iEdge;
+  for (iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+  {
+    for (iEdge = 0 ; iEdge < 3 ; ++iEdge)
+    {
+      const unsigned i0 = mTriangles[iTriangle].GetVertexIndex(iEdge);
+      const unsigned i1 = mTriangles[iTriangle].GetVertexIndex((iEdge + 1) % 3);
+      tEdgeRef & edge = edges[3 * iTriangle + iEdge];
+      edge.iVertex0 = Min(i0, i1);
+      edge.iVertex1 = Max(i0, i1);
+      edge.iEdge = 3 * iTriangle + iEdge;
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  unsigned i, j;
+  for (i = 0 ; i < edges.size() ; i = j)
+  {
+    for (j = i + 1 ; 
+         j < edges.size() && 
+           edges[j].iVertex0 == edges[i].iVertex0 && 
+           edges[j].iVertex1 == edges[i].iVertex1 ; 
+         ++j)
+    {}
+    if (j - i != 2)
+      continue;
+    const unsigned iEdge0 = edges[i].iEdge;
+    const unsigned iEdge1 = edges[i + 1].iEdge;
+    const tIndexedTriangle & triangle0 = mTriangles[iEdge0 / 3];
+    const tIndexedTriangle & triangle1 = mTriangles[iEdge1 / 3];
+    // if they go the same way along the edge, the triangles face
+    // opposite ways
+    if (triangle0.GetVertexIndex(iEdge0 % 3) == triangle1.GetVertexIndex(iEdge1 % 3))
+      continue;
+    mEdgeNeighbours[iEdge0] = iEdge1 / 3;
+    mEdgeNeighbours[iEdge1] = iEdge0 / 3;
+  }
+
+  // An edge is convex if the neighbour bends away below the
+  // triangle's plane, and a point is convex if any edge using it is
+  std::vector<bool> convexVertices(mVertices.size(), false);
+  for (iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+  {
+    tIndexedTriangle & triangle = mTriangles[iTriangle];
+    for (iEdge = 0 ; iEdge < 3 ; ++iEdge)
+    {
+      const unsigned i0 = triangle.GetVertexIndex(iEdge);
+      const unsigned i1 = triangle.GetVertexIndex((iEdge + 1) % 3);
+      const unsigned iNeighbour = mEdgeNeighbours[3 * iTriangle + iEdge];
+      bool convex = true;
+      if (iNeighbour != NO_NEIGHBOUR)
+      {
+        const tIndexedTriangle & neighbour = mTriangles[iNeighbour];
+        unsigned iOpposite = neighbour.GetVertexIndex(0);
+        for (i = 1 ; i < 3 && (iOpposite == i0 || iOpposite == i1) ; ++i)
+          iOpposite = neighbour.GetVertexIndex(i);
+        const tVector3 delta = mVertices[iOpposite] - mVertices[i0];
+        convex = Dot(triangle.GetPlane().GetN(), delta) < -convexEdgeSin * delta.GetLength();
+      }
+      triangle.SetEdgeConvex(iEdge, convex);
+      if (convex)
+        convexVertices[i0] = convexVertices[i1] = true;
+    }
+  }
+  for (iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+  {
+    tIndexedTriangle & triangle = mTriangles[iTriangle];
+    for (unsigned iPoint = 0 ; iPoint < 3 ; ++iPoint)
+      triangle.SetPointConvex(iPoint, convexVertices[triangle.GetVertexIndex(iPoint)]);
+  }
+}
+
+//====================================================================
+// BuildNode
+//====================================================================
+void tTriangleBVH::BuildNode(unsigned begin, unsigned end, unsigned maxTrianglesPerLeaf)
+{
+  const unsigned iNode = mNodes.size();
+  mNodes.push_back(tNode());
+
+  tAABox box(true);
+  for (unsigned i = begin ; i < end ; ++i)
+    box.AddAABox(mTriangles[mTriangleOrder[i]].GetBoundingBox());
+  for (unsigned iDir = 0 ; iDir < 3 ; ++iDir)
+  {
+    mNodes[iNode].mMin[iDir] = box.GetMinPos()[iDir];
+    mNodes[iNode].mMax[iDir] = box.GetMaxPos()[iDir];
+  }
+
+  const unsigned num = end - begin;
+  unsigned mid = begin;
+  if (num > 1)
+    mid = SplitTriangles(begin, end, box.GetSurfaceArea(), num > maxTrianglesPerLeaf);
+
+  if (mid == begin)
+  {
+    mNodes[iNode].mIndex = begin;
+    mNodes[iNode].mNumTriangles = num;
+    return;
+  }
+
+  // careful - building the children can move the nodes
+  BuildNode(begin, mid, maxTrianglesPerLeaf);
+  BuildNode(mid, end, maxTrianglesPerLeaf);
+  mNodes[iNode].mIndex = mNodes.size();
+  mNodes[iNode].mNumTriangles = 0;
+}
+
+//====================================================================
+// SplitTriangles
+// Sorts the triangle centres into bins along the longest axis, and
+// picks the boundary between bins that gives the lowest surface area
+// cost.
+//====================================================================
+unsigned tTriangleBVH::SplitTriangles(unsigned begin, unsigned end,
+                                      tScalar area, bool mustSplit)
+{
+  const unsigned num = end - begin;
+  unsigned i;
+
+  tAABox centreBox(true);
+  for (i = begin ; i < end ; ++i)
+    centreBox.AddPoint(mCentres[mTriangleOrder[i]]);
+  const tVector3 extents = centreBox.GetSideLengths();
+  unsigned axis = 0;
+  if (extents[1] > extents[axis]) axis = 1;
+  if (extents[2] > extents[axis]) axis = 2;
+
+  // all the centres are in the same place so there's no sensible
+  // split - just halve them if we have to
+  if (extents[axis] < SCALAR_TINY)
+    return mustSplit ? begin + num / 2 : begin;
+
+  const tScalar minPos = centreBox.GetMinPos()[axis];
+  const tScalar binScale = numSplitBins / extents[axis];
+
+  tAABox binBoxes[numSplitBins];
+  unsigned binCounts[numSplitBins] = {0};
+  for (i = 0 ; i < numSplitBins ; ++i)
+    binBoxes[i].Clear();
+  for (i = begin ; i < end ; ++i)
+  {
+    unsigned iTri = mTriangleOrder[i];
+    unsigned bin = Min((unsigned) ((mCentres[iTri][axis] - minPos) * binScale), numSplitBins - 1);
+    binBoxes[bin].AddAABox(mTriangles[iTri].GetBoundingBox());
+    ++binCounts[bin];
+  }
+
+  // cost of splitting after bin i is the area times the number of
+  // triangles for each side
+  tScalar rightCosts[numSplitBins];
+  tAABox rightBox(true);
+  unsigned rightCount = 0;
+  for (i = numSplitBins - 1 ; i > 0 ; --i)
+  {
+    rightCount += binCounts[i];
+    if (binCounts[i] > 0)
+      rightBox.AddAABox(binBoxes[i]);
+    rightCosts[i - 1] = rightCount ? rightCount * rightBox.GetSurfaceArea() : SCALAR(0.0f);
+  }
+
+  tScalar bestCost = SCALAR_HUGE;
+  unsigned bestBin = 0;
+  tAABox leftBox(true);
+  unsigned leftCount = 0;
+  for (i = 0 ; i < numSplitBins - 1 ; ++i)
+  {
+    leftCount += binCounts[i];
+    if (binCounts[i] > 0)
+      leftBox.AddAABox(binBoxes[i]);
+    if (leftCount == 0 || leftCount == num)
+      continue;
+    tScalar cost = leftCount * leftBox.GetSurfaceArea() + rightCosts[i];
+    if (cost < bestCost)
+    {
+      bestCost = cost;
+      bestBin = i;
+    }
+  }
+
+  // Not splitting costs a test for each triangle. Splitting costs
+  // (roughly) one node test plus the triangles in the children that
+  // get hit.
+  if (!mustSplit && area + bestCost >= num * area)
+    return begin;
+
+  // partition
+  unsigned mid = begin;
+  for (i = begin ; i < end ; ++i)
+  {
+    unsigned iTri = mTriangleOrder[i];
+    unsigned bin = Min((unsigned) ((mCentres[iTri][axis] - minPos) * binScale), numSplitBins - 1);
+    if (bin <= bestBin)
+      std::swap(mTriangleOrder[i], mTriangleOrder[mid++]);
+  }
+  Assert(mid > begin && mid < end);
+  return mid;
+}
+
+//====================================================================
+// GetTrianglesIntersectingtAABox
+//====================================================================
+unsigned tTriangleBVH::GetTrianglesIntersectingtAABox(
+  std::vector<unsigned>& triangles, const tAABox& aabb) const
+{
+  triangles.resize(0);
+
+  const tVector3 & minPos = aabb.GetMinPos();
+  const tVector3 & maxPos = aabb.GetMaxPos();
+
+  // Walk forwards through the nodes. If a node is missed then skip
+  // over its subtree. Since the leaves (and their triangles) are in
+  // order, the result is already sorted.
+  const unsigned numNodes = mNodes.size();
+  unsigned iNode = 0;
+  while (iNode < numNodes)
+  {
+    const tNode & node = mNodes[iNode];
+    if (minPos.x > node.mMax[0] || maxPos.x < node.mMin[0] ||
+        minPos.y > node.mMax[1] || maxPos.y < node.mMin[1] ||
+        minPos.z > node.mMax[2] || maxPos.z < node.mMin[2])
+    {
+      iNode = node.IsLeaf() ? iNode + 1 : node.mIndex;
+      continue;
+    }
+
+    if (node.IsLeaf())
+    {
+      const unsigned end = node.mIndex + node.mNumTriangles;
+      for (unsigned iTri = node.mIndex ; iTri < end ; ++iTri)
+      {
+        if (OverlapTest(aabb, mTriangles[iTri].GetBoundingBox()))
+          triangles.push_back(iTri);
+      }
+    }
+    ++iNode;
+  }
+  return triangles.size();
+}
+
+//====================================================================
+// SegmentIntersectBatch
+//====================================================================
+unsigned tTriangleBVH::SegmentIntersectBatch(tScalar * fracs, unsigned * triangles,
+                                             const tSegment * segs, unsigned numSegs) const
+{
+  const unsigned numNodes = mNodes.size();
+  unsigned numHits = 0;
+  tSegmentPacket packet;
+  for (unsigned iFirst = 0 ; iFirst < numSegs ; iFirst += tSegmentPacket::SIZE)
+  {
+    const unsigned num = Min(numSegs - iFirst, (unsigned) tSegmentPacket::SIZE);
+    const tSegment * packetSegs = segs + iFirst;
+    tScalar * packetFracs = fracs + iFirst;
+    unsigned * packetTriangles = triangles + iFirst;
+    packet.Set(packetSegs, num);
+    unsigned iLane;
+    for (iLane = 0 ; iLane < num ; ++iLane)
+      packetFracs[iLane] = SCALAR_HUGE;
+
+    // Walk forwards as in GetTrianglesIntersectingtAABox, skipping
+    // subtrees that none of the segments reach (the max fractions get
+    // reduced as hits are found).
+    unsigned iNode = 0;
+    while (iNode < numNodes)
+    {
+      const tNode & node = mNodes[iNode];
+      const unsigned mask = packet.OverlapMask(node.mMin, node.mMax);
+      if (!mask)
+      {
+        iNode = node.IsLeaf() ? iNode + 1 : node.mIndex;
+        continue;
+      }
+
+      if (node.IsLeaf())
+      {
+        const unsigned end = node.mIndex + node.mNumTriangles;
+        for (unsigned iTri = node.mIndex ; iTri < end ; ++iTri)
+        {
+          const tIndexedTriangle & meshTriangle = mTriangles[iTri];
+          tTriangle tri(
+            GetVertex(meshTriangle.GetVertexIndex(0)),
+            GetVertex(meshTriangle.GetVertexIndex(1)),
+            GetVertex(meshTriangle.GetVertexIndex(2)));
+          for (iLane = 0 ; iLane < num ; ++iLane)
+          {
+            tScalar frac;
+            if ( (mask & (1 << iLane)) &&
+                 SegmentTriangleIntersection(&frac, 0, 0, packetSegs[iLane], tri) &&
+                 frac < packetFracs[iLane] )
+            {
+              packetFracs[iLane] = frac;
+              packetTriangles[iLane] = iTri;
+              packet.mMaxFrac[iLane] = Min(frac, SCALAR(1.0f));
+            }
+          }
+        }
+      }
+      ++iNode;
+    }
+
+    for (iLane = 0 ; iLane < num ; ++iLane)
+    {
+      if (packetFracs[iLane] < SCALAR_HUGE)
+        ++numHits;
+    }
+  }
+  return numHits;
+}
+
+//====================================================================
+// GetBoundingBox
+//====================================================================
+tAABox tTriangleBVH::GetBoundingBox() const
+{
+  if (mNodes.empty())
+    return tAABox(true);
+  const tNode & root = mNodes[0];
+  return tAABox(tVector3(root.mMin[0], root.mMin[1], root.mMin[2]),
+                tVector3(root.mMax[0], root.mMax[1], root.mMax[2]));
+}
+
+//====================================================================
+// DumpStats
+//====================================================================
+void tTriangleBVH::DumpStats() const
+{
+  TRACE("tTriangleBVH::DumpStats:");
+  TRACE("Num tris = %d, num nodes = %d", mTriangles.size(), mNodes.size());
+
+  unsigned numLeaves = 0;
+  unsigned maxTris = 0;
+  unsigned numTris = 0;
+  for (unsigned iNode = 0 ; iNode < mNodes.size() ; ++iNode)
+  {
+    const tNode & node = mNodes[iNode];
+    if (node.IsLeaf())
+    {
+      ++numLeaves;
+      numTris += node.mNumTriangles;
+      if (node.mNumTriangles > maxTris)
+        maxTris = node.mNumTriangles;
+      if (node.mIndex + node.mNumTriangles > mTriangles.size())
+        TRACE("Found invalid triangle range in leaf %d", iNode);
+    }
+    else if (node.mIndex <= iNode + 1 || node.mIndex > mNodes.size())
+    {
+      TRACE("Found invalid skip index %d in node %d", node.mIndex, iNode);
+    }
+  }
+  if (numTris != mTriangles.size())
+    TRACE("Leaves have %d triangles - expected %d", numTris, mTriangles.size());
+  TRACE("Num leaves = %d, max triangles in a leaf = %d", numLeaves, maxTris);
+}
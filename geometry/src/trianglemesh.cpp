@@ -8,7 +8,7 @@
 //==============================================================
 #include "trianglemesh.hpp"
 #include "triangle.hpp"
-#include "intersection.hpp"
+#include "segmentpacket.hpp"
 #include "trace.hpp"
 
 using namespace JigLib;
@@ -25,10 +25,90 @@ tPrimitive* tTriangleMesh::Clone() const
 //====================================================================
 // tTriangleMesh
 //====================================================================
-tTriangleMesh::tTriangleMesh() : tPrimitive(tPrimitive::TRIANGLEMESH)
+tTriangleMesh::tTriangleMesh() 
+  : 
+  tPrimitive(tPrimitive::TRIANGLEMESH), 
+  mBVH(new tTriangleBVH),
+  mTransform(tTransform3::IDENTITY),
+  mHasTransform(false)
 {
 }
 
+//==============================================================
+// SetTransform
+//==============================================================
+void tTriangleMesh::SetTransform(const tTransform3 &t)
+{
+  mTransform = t;
+  // most meshes are just static world geometry, so don't make them
+  // pay for transforming everything
+  const tMatrix33 & orient = t.orientation;
+  mHasTransform = false;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    for (unsigned j = 0 ; j < 3 ; ++j)
+    {
+      if (orient(i, j) != (i == j ? SCALAR(1.0f) : SCALAR(0.0f)))
+        mHasTransform = true;
+    }
+    if (t.position[i] != SCALAR(0.0f))
+      mHasTransform = true;
+  }
+  UpdateBoundingBox();
+}
+
+//==============================================================
+// TransformAABox
+// Gets the box around box after it's been rotated by orient and
+// then moved by pos
+//==============================================================
+static tAABox TransformAABox(const tAABox & box, const tVector3 & pos, const tMatrix33 & orient)
+{
+  const tVector3 centre = pos + orient * box.GetCentre();
+  const tVector3 halfSides = SCALAR(0.5f) * box.GetSideLengths();
+  tVector3 extents;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    extents[i] = 
+      Abs(orient(i, 0)) * halfSides[0] + 
+      Abs(orient(i, 1)) * halfSides[1] + 
+      Abs(orient(i, 2)) * halfSides[2];
+  }
+  return tAABox(centre - extents, centre + extents);
+}
+
+//==============================================================
+// AABoxToMesh
+//==============================================================
+tAABox tTriangleMesh::AABoxToMesh(const tAABox & box) const
+{
+  if (!mHasTransform)
+    return box;
+  const tMatrix33 invOrient = mTransform.orientation.GetTranspose();
+  return TransformAABox(box, -(invOrient * mTransform.position), invOrient);
+}
+
+//==============================================================
+// TransformToMesh
+//==============================================================
+tTransform3 tTriangleMesh::TransformToMesh(const tTransform3 & t) const
+{
+  if (!mHasTransform)
+    return t;
+  const tMatrix33 invOrient = mTransform.orientation.GetTranspose();
+  return tTransform3(invOrient * (t.position - mTransform.position), invOrient * t.orientation);
+}
+
+//==============================================================
+// UpdateBoundingBox
+//==============================================================
+void tTriangleMesh::UpdateBoundingBox()
+{
+  mBoundingBox = mBVH->GetBoundingBox();
+  if (mHasTransform && mBVH->GetNumTriangles() > 0)
+    mBoundingBox = TransformAABox(mBoundingBox, mTransform.position, mTransform.orientation);
+}
+
 //==============================================================
 // CreateMesh
 //==============================================================
@@ -37,9 +117,70 @@ void tTriangleMesh::CreateMesh(const tVector3 * vertices, unsigned numVertices,
                                int maxTrianglesPerCell, tScalar minCellSize)
 {
   TRACE_METHOD_ONLY(ONCE_2);
-  mOctree.Clear(true);
-  mOctree.AddTriangles(vertices, numVertices, triangleVertexIndices, numTriangles);
-  mOctree.BuildOctree(maxTrianglesPerCell, minCellSize);
+  // Make a new tree rather than changing the old one, since that may
+  // be shared with other copies
+  std::shared_ptr<tTriangleBVH> bvh(new tTriangleBVH);
+  bvh->AddTriangles(vertices, numVertices, triangleVertexIndices, numTriangles);
+  bvh->BuildBVH(maxTrianglesPerCell > 0 ? maxTrianglesPerCell : 1);
+  bvh->BuildConnectivity();
+  mBVH = bvh;
+  UpdateBoundingBox();
+}
+
+// Corners that are below the furthest one (along the normal) by less
+// than this fraction of their distance from it count as level with
+// it. Also the slack when checking if a normal is between two faces.
+static const tScalar featureSin = SCALAR(0.02f);
+
+//==============================================================
+// IsContactNormalValid
+//==============================================================
+bool tTriangleMesh::IsContactNormalValid(unsigned iTriangle, const tVector3 & N) const
+{
+  const tIndexedTriangle & triangle = GetTriangle(iTriangle);
+  const tVector3 pts[3] = {
+    GetVertex(triangle.GetVertexIndex(0)),
+    GetVertex(triangle.GetVertexIndex(1)),
+    GetVertex(triangle.GetVertexIndex(2))};
+  const tScalar dists[3] = {Dot(pts[0], N), Dot(pts[1], N), Dot(pts[2], N)};
+  unsigned iMax = 0;
+  if (dists[1] > dists[iMax]) iMax = 1;
+  if (dists[2] > dists[iMax]) iMax = 2;
+
+  unsigned corners = 1 << iMax;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+  {
+    if (i != iMax && dists[iMax] - dists[i] <= featureSin * (pts[iMax] - pts[i]).GetLength())
+      corners |= 1 << i;
+  }
+
+  // corners just need to be convex, and N in front of the triangle
+  const tVector3 & N0 = triangle.GetPlane().GetN();
+  unsigned iEdge;
+  switch (corners)
+  {
+  case 1: 
+  case 2: 
+  case 4: return triangle.IsPointConvex(iMax) && Dot(N, N0) >= -featureSin;
+  case 3: iEdge = 0; break;
+  case 6: iEdge = 1; break;
+  case 5: iEdge = 2; break;
+  default: return true; // the face
+  }
+
+  if (!triangle.IsEdgeConvex(iEdge))
+    return false;
+  const unsigned iNeighbour = GetEdgeNeighbour(iTriangle, iEdge);
+  if (iNeighbour == tTriangleBVH::NO_NEIGHBOUR)
+    return true;
+
+  // Looking along the edge, N has to be between the two face normals
+  const tVector3 edge = pts[(iEdge + 1) % 3] - pts[iEdge];
+  const tVector3 & N1 = GetTriangle(iNeighbour).GetPlane().GetN();
+  const tScalar sign = Dot(Cross(N0, N1), edge) > SCALAR(0.0f) ? SCALAR(1.0f) : -SCALAR(1.0f);
+  const tScalar tolerance = featureSin * edge.GetLength();
+  return sign * Dot(Cross(N0, N), edge) >= -tolerance && 
+    sign * Dot(Cross(N, N1), edge) >= -tolerance;
 }
 
 //==============================================================
@@ -48,38 +189,42 @@ void tTriangleMesh::CreateMesh(const tVector3 * vertices, unsigned numVertices,
 bool tTriangleMesh::SegmentIntersect(tScalar &frac, tVector3 &pos, tVector3 &normal, const class tSegment &seg) const
 {
   TRACE_METHOD_ONLY(MULTI_FRAME_2);
+  return SegmentIntersectBatch(&frac, &pos, &normal, &seg, 1) != 0;
+}
 
-  tAABox segBox(true);
-  segBox.AddSegment(seg);
-
-  static std::vector<unsigned> potentialTriangles;
-  const unsigned numTriangles = GetTrianglesIntersectingtAABox(potentialTriangles, segBox);
-
-  tScalar bestFrac = SCALAR_HUGE;
-  for (unsigned iTriangle = 0 ; iTriangle < numTriangles ; ++iTriangle)
+//==============================================================
+// SegmentIntersectBatch
+//==============================================================
+unsigned tTriangleMesh::SegmentIntersectBatch(tScalar * fracs, tVector3 * positions, tVector3 * normals,
+                                              const class tSegment * segs, unsigned numSegs) const
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_2);
+  unsigned triangles[tSegmentPacket::SIZE];
+  unsigned numHits = 0;
+  for (unsigned iFirst = 0 ; iFirst < numSegs ; iFirst += tSegmentPacket::SIZE)
   {
-    const tIndexedTriangle& meshTriangle = GetTriangle(potentialTriangles[iTriangle]);
-    tScalar thisFrac;
-    tTriangle tri(
-      GetVertex(meshTriangle.GetVertexIndex(0)),
-      GetVertex(meshTriangle.GetVertexIndex(1)),
-      GetVertex(meshTriangle.GetVertexIndex(2)));
-      
-    if (SegmentTriangleIntersection(&thisFrac, 0, 0, seg, tri))
+    const unsigned num = Min(numSegs - iFirst, (unsigned) tSegmentPacket::SIZE);
+    const tSegment * packetSegs = segs + iFirst;
+    tSegment meshSegs[tSegmentPacket::SIZE];
+    if (mHasTransform)
     {
-      if (thisFrac < bestFrac)
-      {
-        bestFrac = thisFrac;
-        pos = seg.GetPoint(thisFrac);
-        normal = meshTriangle.GetPlane().GetN();
-      }
+      for (unsigned iSeg = 0 ; iSeg < num ; ++iSeg)
+        meshSegs[iSeg] = tSegment(PointToMesh(packetSegs[iSeg].mOrigin), DirToMesh(packetSegs[iSeg].mDelta));
+      packetSegs = meshSegs;
+    }
+    if (0 == mBVH->SegmentIntersectBatch(fracs + iFirst, triangles, packetSegs, num))
+      continue;
+    for (unsigned iSeg = 0 ; iSeg < num ; ++iSeg)
+    {
+      const tScalar frac = fracs[iFirst + iSeg];
+      if (frac == SCALAR_HUGE)
+        continue;
+      ++numHits;
+      positions[iFirst + iSeg] = segs[iFirst + iSeg].GetPoint(frac);
+      normals[iFirst + iSeg] = DirToWorld(GetTriangle(triangles[iSeg]).GetPlane().GetN());
     }
   }
-  frac = bestFrac;
-  if (bestFrac < SCALAR_HUGE)
-    return true;
-  else
-    return false;
+  return numHits;
 }
 
 //==============================================================
@@ -11,6 +11,11 @@
 
 //#define USING_DOUBLE
 
+/// Use SSE for the tVector3/tMatrix33 maths. Vectors get padded to 16
+/// bytes (and aligned) so they can be loaded straight into a
+/// register. Only for single precision.
+//#define USING_SSE
+
 // disable MSVC specific warnings
 #ifdef _MSC_VER
 // long names in debug info
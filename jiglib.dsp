@@ -123,6 +123,22 @@ SOURCE=.\collision\include\colldetectcapsulestaticmesh.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\include\colldetectconvex.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\include\colldetectconvexhullheightmap.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\include\colldetectconvexhullplane.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\include\colldetectconvexhullstaticmesh.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\include\colldetectspherebox.hpp
 # End Source File
 # Begin Source File
@@ -167,10 +183,18 @@ SOURCE=.\collision\include\collisionsystembrute.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\include\collisionsystemdynamictree.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\include\collisionsystemgrid.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\include\collisionsystemsap.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\include\materials.hpp
 # End Source File
 # End Group
@@ -215,6 +239,22 @@ SOURCE=.\collision\src\colldetectcapsulestaticmesh.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\src\colldetectconvex.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\src\colldetectconvexhullheightmap.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\src\colldetectconvexhullplane.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\collision\src\colldetectconvexhullstaticmesh.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\src\colldetectspherebox.cpp
 # End Source File
 # Begin Source File
@@ -255,10 +295,18 @@ SOURCE=.\collision\src\collisionsystembrute.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\src\collisionsystemdynamictree.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\src\collisionsystemgrid.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\collision\src\collisionsystemsap.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\collision\src\materials.cpp
 # End Source File
 # End Group
@@ -286,6 +334,18 @@ SOURCE=.\geometry\include\capsule.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\geometry\include\collisionscratch.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\geometry\include\convexhull.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\geometry\include\gjk.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\geometry\include\heightmap.hpp
 # End Source File
 # Begin Source File
@@ -298,10 +358,18 @@ SOURCE=.\geometry\include\primitive.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\geometry\include\segmentpacket.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\geometry\include\sphere.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\geometry\include\trianglebvh.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\geometry\include\trianglemesh.hpp
 # End Source File
 # End Group
@@ -335,10 +403,6 @@ SOURCE=.\geometry\include\line.hpp
 # End Source File
 # Begin Source File
 
-SOURCE=.\geometry\include\octree.hpp
-# End Source File
-# Begin Source File
-
 SOURCE=.\geometry\include\overlap.hpp
 # End Source File
 # Begin Source File
@@ -378,6 +442,18 @@ SOURCE=.\geometry\src\capsule.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\geometry\src\collisionscratch.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\geometry\src\convexhull.cpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\geometry\src\gjk.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\geometry\src\heightmap.cpp
 # End Source File
 # Begin Source File
@@ -394,6 +470,10 @@ SOURCE=.\geometry\src\sphere.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\geometry\src\trianglebvh.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\geometry\src\trianglemesh.cpp
 # End Source File
 # End Group
@@ -415,10 +495,6 @@ SOURCE=.\geometry\src\line.cpp
 # End Source File
 # Begin Source File
 
-SOURCE=.\geometry\src\octree.cpp
-# End Source File
-# Begin Source File
-
 SOURCE=.\geometry\src\overlap.cpp
 # End Source File
 # Begin Source File
@@ -495,6 +571,10 @@ SOURCE=.\physics\include\body.inl
 # End Source File
 # Begin Source File
 
+SOURCE=.\physics\include\bodystatestore.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\physics\include\constraint.hpp
 # End Source File
 # Begin Source File
@@ -543,6 +623,10 @@ SOURCE=.\physics\src\body.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\physics\src\bodystatestore.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\physics\src\constraint.cpp
 # End Source File
 # Begin Source File
@@ -608,6 +692,18 @@ SOURCE=.\utils\include\fixedvector.hpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\utils\include\framearena.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\utils\include\pairhashmap.hpp
+# End Source File
+# Begin Source File
+
+SOURCE=.\utils\include\threadpool.hpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\utils\include\time.hpp
 # End Source File
 # Begin Source File
@@ -640,6 +736,10 @@ SOURCE=.\utils\src\configfile.cpp
 # End Source File
 # Begin Source File
 
+SOURCE=.\utils\src\threadpool.cpp
+# End Source File
+# Begin Source File
+
 SOURCE=.\utils\src\timer.cpp
 # End Source File
 # Begin Source File
@@ -93,7 +93,7 @@ void RenderAllContacts(int type)
   {
     tCollisionInfo * coll = colls[i];
     Assert(coll);
-    for (unsigned iPt = 0 ; iPt < coll->mPointInfo.Size() ; ++iPt)
+    for (unsigned iPt = 0 ; iPt < coll->mNumPointInfos ; ++iPt)
     {
       RenderContact(coll->mPointInfo[iPt].mPosition,
                     coll->mDirToBody0,
@@ -986,6 +986,16 @@ void tJigTestApp::SetupExperiment()
       TRACE("Creating tCollisionSystemGrid\n");
     mCollisionSystem = new tCollisionSystemGrid(32, 32, 4, tAppConfig::mCollisionGridSize, tAppConfig::mCollisionGridSize, tAppConfig::mCollisionGridSize);
     break;
+  case 2:
+    TRACE_FILE_IF(ONCE_1)
+      TRACE("Creating tCollisionSystemDynamicTree\n");
+    mCollisionSystem = new tCollisionSystemDynamicTree();
+    break;
+  case 3:
+    TRACE_FILE_IF(ONCE_1)
+      TRACE("Creating tCollisionSystemSAP\n");
+    mCollisionSystem = new tCollisionSystemSAP();
+    break;
   default:
     TRACE("Collision system type %d not handled\n", tAppConfig::mCollisionSystemType);
     mCollisionSystem = new tCollisionSystemBrute();
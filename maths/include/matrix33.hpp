@@ -61,7 +61,8 @@ namespace JigLib
     const tScalar & operator()(const unsigned i, const unsigned j) const {
       return mCols[j][i];}
     
-    /// returns pointer to the first element - the first of 9
+    /// returns pointer to the first element - the first of 9 (but
+    /// note that with USING_SSE each column is padded to 4)
     const tScalar * GetData() {return mCols[0].GetData();} 
     const tScalar * GetData() const {return mCols[0].GetData();} 
     /// pointer to value returned from get_data
@@ -132,6 +133,20 @@ namespace JigLib
                                     const tVector3 & vec,
                                     const tMatrix33 & mat,
                                     const tVector3 & pos);
+
+    /// out[i] = mat * points[i] + pos for num points. out can be
+    /// points.
+    friend void TransformPoints(tVector3 * out,
+                                const tVector3 * points,
+                                unsigned num,
+                                const tMatrix33 & mat,
+                                const tVector3 & pos);
+
+    /// out[i] = mat * points[i] for num points. out can be points.
+    friend void RotatePoints(tVector3 * out,
+                             const tVector3 * points,
+                             unsigned num,
+                             const tMatrix33 & mat);
     
     
 
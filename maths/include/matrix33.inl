@@ -131,7 +131,16 @@ inline tMatrix33 & tMatrix33::Transpose()
 //==============================================================
 inline tMatrix33 tMatrix33::GetTranspose() const
 {
+#ifdef USING_SSE
+  __m128 c0 = mCols[0].GetM128();
+  __m128 c1 = mCols[1].GetM128();
+  __m128 c2 = mCols[2].GetM128();
+  __m128 c3 = _mm_setzero_ps();
+  _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+  return tMatrix33(tVector3(c0), tVector3(c1), tVector3(c2));
+#else
   return tMatrix33(*this).Transpose();
+#endif
 }
 
 //==============================================================
@@ -244,6 +253,12 @@ inline tMatrix33 & tMatrix33::operator-=(const tMatrix33 & rhs)
 //==============================================================
 inline tMatrix33 & tMatrix33::operator*=(const tScalar rhs)
 {
+#ifdef USING_SSE
+  mCols[0] *= rhs;
+  mCols[1] *= rhs;
+  mCols[2] *= rhs;
+  return *this;
+#else
   mCols[0].x *= rhs;
   mCols[0].y *= rhs;
   mCols[0].z *= rhs;
@@ -254,6 +269,7 @@ inline tMatrix33 & tMatrix33::operator*=(const tScalar rhs)
   mCols[2].y *= rhs;
   mCols[2].z *= rhs;
   return *this;
+#endif
 }
 
 //==============================================================
@@ -262,6 +278,12 @@ inline tMatrix33 & tMatrix33::operator*=(const tScalar rhs)
 inline tMatrix33 & tMatrix33::operator/=(const tScalar rhs)
 {
   const tScalar invRhs = 1.0f / rhs;
+#ifdef USING_SSE
+  mCols[0] *= invRhs;
+  mCols[1] *= invRhs;
+  mCols[2] *= invRhs;
+  return *this;
+#else
   mCols[0].x *= invRhs;
   mCols[0].y *= invRhs;
   mCols[0].z *= invRhs;
@@ -272,6 +294,7 @@ inline tMatrix33 & tMatrix33::operator/=(const tScalar rhs)
   mCols[2].y *= invRhs;
   mCols[2].z *= invRhs;
   return *this;
+#endif
 }
 
 //==============================================================
@@ -314,6 +337,10 @@ inline tMatrix33 operator*(const tScalar lhs, const tMatrix33 & rhs)
 inline tMatrix33 operator*(const tMatrix33 & lhs, const tMatrix33 & rhs)
 {
   tMatrix33 out; 
+#ifdef USING_SSE
+  MultMatrix33(out, lhs, rhs);
+  return out;
+#else
 
   out.mCols[0].x = lhs.mCols[0].x * rhs.mCols[0].x + lhs.mCols[1].x * rhs.mCols[0].y + lhs.mCols[2].x * rhs.mCols[0].z;
   out.mCols[0].y = lhs.mCols[0].y * rhs.mCols[0].x + lhs.mCols[1].y * rhs.mCols[0].y + lhs.mCols[2].y * rhs.mCols[0].z;
@@ -326,6 +353,7 @@ inline tMatrix33 operator*(const tMatrix33 & lhs, const tMatrix33 & rhs)
   out.mCols[2].z = lhs.mCols[0].z * rhs.mCols[2].x + lhs.mCols[1].z * rhs.mCols[2].y + lhs.mCols[2].z * rhs.mCols[2].z;
 
   return out;
+#endif
 }
 
 //==============================================================
@@ -376,6 +404,11 @@ inline void tMatrix33::Orthonormalise()
 //==============================================================
 inline tVector3 operator*(const tMatrix33 & lhs, const tVector3 & rhs)
 {
+#ifdef USING_SSE
+  tVector3 out;
+  MultMatrix33(out, lhs, rhs);
+  return out;
+#else
   return tVector3(
     lhs(0,0) * rhs.x +
     lhs(0,1) * rhs.y +
@@ -386,6 +419,7 @@ inline tVector3 operator*(const tMatrix33 & lhs, const tVector3 & rhs)
     lhs(2,0) * rhs.x +
     lhs(2,1) * rhs.y +
     lhs(2,2) * rhs.z);
+#endif
 }
 
 //==============================================================
@@ -476,11 +510,8 @@ inline bool ApproxEqual(const tMatrix33 & a,
                         const tMatrix33 & b, 
                         tScalar tol)
 {
-  const tScalar * da = a.GetData();
-  const tScalar * db = b.GetData();
-  int i;
-  for (i = 0 ; i < 9 ; ++i)
-    if (!ApproxEqual(da[i], db[i], tol)) return false;
+  for (unsigned i = 0 ; i < 3 ; ++i)
+    if (!ApproxEqual(a[i], b[i], tol)) return false;
   return true;
 }
 
@@ -491,9 +522,18 @@ inline void MultMatrix33(tVector3 & out,
                          const tMatrix33 & mat,
                          const tVector3 & vec)
 {
+#ifdef USING_SSE
+  // sum of the columns scaled by the elements of vec
+  __m128 v = vec.GetM128();
+  __m128 r = _mm_mul_ps(mat.mCols[0].GetM128(), _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+  r = _mm_add_ps(r, _mm_mul_ps(mat.mCols[1].GetM128(), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+  r = _mm_add_ps(r, _mm_mul_ps(mat.mCols[2].GetM128(), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+  out.SetM128(r);
+#else
   out.x = mat(0,0) * vec[0] + mat(0,1) * vec[1] + mat(0,2) * vec[2];
   out.y = mat(1,0) * vec[0] + mat(1,1) * vec[1] + mat(1,2) * vec[2];
   out.z = mat(2,0) * vec[0] + mat(2,1) * vec[1] + mat(2,2) * vec[2];
+#endif
 }
 
 
@@ -504,6 +544,12 @@ inline void MultMatrix33(tMatrix33 & out,
                          const tMatrix33 & lhs,
                          const tMatrix33 & rhs)
 {
+#ifdef USING_SSE
+  Assert(&out != &lhs);
+  // each column of out is lhs * that column of rhs
+  for (unsigned oj = 3 ; oj-- != 0 ;)
+    MultMatrix33(out.mCols[oj], lhs, rhs.mCols[oj]);
+#else
   for (unsigned oj = 3 ; oj-- != 0 ;)
   {
     for (unsigned oi = 3 ; oi-- != 0 ;)
@@ -514,6 +560,7 @@ inline void MultMatrix33(tMatrix33 & out,
         lhs(oi, 2)*rhs(2, oj);
     }
   }
+#endif
 }
 
 //==============================================================
@@ -526,12 +573,81 @@ inline void ApplyTransformation(tVector3 & out,
 {
   Assert(&out != &vec && &out != &pos);
   
+#ifdef USING_SSE
+  __m128 p = pos.GetM128();
+  __m128 r = _mm_add_ps(vec.GetM128(), _mm_mul_ps(mat.mCols[0].GetM128(), _mm_shuffle_ps(p, p, _MM_SHUFFLE(0, 0, 0, 0))));
+  r = _mm_add_ps(r, _mm_mul_ps(mat.mCols[1].GetM128(), _mm_shuffle_ps(p, p, _MM_SHUFFLE(1, 1, 1, 1))));
+  r = _mm_add_ps(r, _mm_mul_ps(mat.mCols[2].GetM128(), _mm_shuffle_ps(p, p, _MM_SHUFFLE(2, 2, 2, 2))));
+  out.SetM128(r);
+#else
   out.x = vec.x + 
     mat(0,0) * pos[0] + mat(0,1) * pos[1] + mat(0,2) * pos[2];
   out.y = vec.y + 
     mat(1,0) * pos[0] + mat(1,1) * pos[1] + mat(1,2) * pos[2];
   out.z = vec.z + 
     mat(2,0) * pos[0] + mat(2,1) * pos[1] + mat(2,2) * pos[2];
+#endif
+}
+
+//==============================================================
+// TransformPoints
+//==============================================================
+inline void TransformPoints(tVector3 * out,
+                            const tVector3 * points,
+                            unsigned num,
+                            const tMatrix33 & mat,
+                            const tVector3 & pos)
+{
+#ifdef USING_SSE
+  // keep the matrix and position in registers over the loop
+  const __m128 c0 = mat.mCols[0].GetM128();
+  const __m128 c1 = mat.mCols[1].GetM128();
+  const __m128 c2 = mat.mCols[2].GetM128();
+  const __m128 p = pos.GetM128();
+  for (unsigned i = 0 ; i < num ; ++i)
+  {
+    __m128 v = points[i].GetM128();
+    __m128 r = _mm_add_ps(p, _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0))));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    out[i].SetM128(r);
+  }
+#else
+  for (unsigned i = 0 ; i < num ; ++i)
+  {
+    const tVector3 pt = points[i];
+    ApplyTransformation(out[i], pos, mat, pt);
+  }
+#endif
+}
+
+//==============================================================
+// RotatePoints
+//==============================================================
+inline void RotatePoints(tVector3 * out,
+                         const tVector3 * points,
+                         unsigned num,
+                         const tMatrix33 & mat)
+{
+#ifdef USING_SSE
+  const __m128 c0 = mat.mCols[0].GetM128();
+  const __m128 c1 = mat.mCols[1].GetM128();
+  const __m128 c2 = mat.mCols[2].GetM128();
+  for (unsigned i = 0 ; i < num ; ++i)
+  {
+    __m128 v = points[i].GetM128();
+    __m128 r = _mm_mul_ps(c0, _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1))));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2))));
+    out[i].SetM128(r);
+  }
+#else
+  for (unsigned i = 0 ; i < num ; ++i)
+  {
+    const tVector3 pt = points[i];
+    MultMatrix33(out[i], mat, pt);
+  }
+#endif
 }
 
     
@@ -22,6 +22,25 @@ namespace JigLib
 #endif
 }
 
+#ifdef USING_SSE
+
+#ifdef USING_DOUBLE
+#error USING_SSE only works with single precision
+#endif
+
+#include <xmmintrin.h>
+#ifdef _MSC_VER
+#define JIGALIGN16 __declspec(align(16))
+#else
+#define JIGALIGN16 __attribute__((aligned(16)))
+#endif
+
+#else
+
+#define JIGALIGN16
+
+#endif
+
 #ifdef OPT
 
 #include <xmmintrin.h>
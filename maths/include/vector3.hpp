@@ -11,15 +11,27 @@ namespace JigLib
 {
   class tMatrix33;
   
-  /// A 3x1 matrix
-  class tVector3
+  /// A 3x1 matrix. With USING_SSE there's a (hidden) 4th element, so
+  /// arrays of these aren't arrays of 3 scalars.
+  class JIGALIGN16 tVector3
   {
   public:
     // public access
     tScalar x, y, z;
-
+#ifdef USING_SSE
+  private:
+    /// padding - kept at 0 so it doesn't generate denormals etc
+    tScalar mW;
+  public:
+    /// default constructor does not initialise (apart from the padding)
+    tVector3() : mW(0.0f) {}
+    explicit tVector3(__m128 v) {_mm_store_ps(&x, v);}
+    __m128 GetM128() const {return _mm_load_ps(&x);}
+    void SetM128(__m128 v) {_mm_store_ps(&x, v);}
+#else
     /// default constructor does not initialise
     tVector3() {}
+#endif
     explicit tVector3(tScalar val);
     tVector3(tScalar x, tScalar y, tScalar z);
     // sets *this = scale * vec, avoiding temporary
@@ -27,7 +39,7 @@ namespace JigLib
     ~tVector3() {}
 
     enum tZero {ZERO};
-    tVector3(tZero) : x(0.0f), y(0.0f), z(0.0f) {}
+    tVector3(tZero);
     
     // Some static "helpers"
     enum {LOOK_INDEX = 0, LEFT_INDEX = 1, UP_INDEX = 2};
@@ -38,7 +50,7 @@ namespace JigLib
     static const tVector3 & Zero() {return mZero;}
     
     /// Set all to zero
-    void SetToZero() {x = y = z = 0.0f;}
+    void SetToZero() {SetTo(0.0f);}
     /// set all values to val
     void SetTo(tScalar val);
     /// set the individual values
@@ -67,8 +79,7 @@ namespace JigLib
     tVector3 & operator*=(const tScalar rhs);
     tVector3 & operator/=(const tScalar rhs);
     
-    tVector3 operator-() const {
-      return tVector3(-x, -y, -z);}
+    tVector3 operator-() const;
     
     tVector3 operator+(const tVector3 & rhs) const;
     tVector3 operator-(const tVector3 & rhs) const;
@@ -110,11 +121,8 @@ namespace JigLib
   };
   
   // global operators
-  inline tVector3 operator*(const tVector3 & lhs, const tScalar rhs) {
-    return tVector3(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs); }
-  inline tVector3 operator/(const tVector3 & lhs, const tScalar rhs) {
-    const tScalar inv_rhs = 1.0f/rhs; 
-    return tVector3(lhs.x * inv_rhs, lhs.y * inv_rhs, lhs.z * inv_rhs);}
+  tVector3 operator*(const tVector3 & lhs, const tScalar rhs);
+  tVector3 operator/(const tVector3 & lhs, const tScalar rhs);
   tScalar Dot(const tVector3 & lhs, const tVector3 & rhs);
   tVector3 Cross(const tVector3 & lhs, const tVector3 & rhs);
   tVector3 ElementMult(const tVector3 & lhs, const tVector3 & rhs);
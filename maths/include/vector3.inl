@@ -32,6 +32,44 @@ inline const tScalar & tVector3::operator()(unsigned i) const
   return (&x)[i];
 }
 
+#ifdef USING_SSE
+
+// The SSE versions do exactly the same operations in the same order
+// as the scalar ones, so the results shouldn't depend on which is
+// used. The padding element ends up as 0 (or 0 * something).
+
+inline void tVector3::SetTo(tScalar val)
+{
+  SetM128(_mm_set_ps(0.0f, val, val, val));
+}
+
+inline void tVector3::Set(tScalar _x, tScalar _y, tScalar _z)
+{
+  SetM128(_mm_set_ps(0.0f, _z, _y, _x));
+}
+
+inline tVector3::tVector3(tZero)
+{
+  SetM128(_mm_setzero_ps());
+}
+
+inline tVector3::tVector3(tScalar val)
+{
+  SetM128(_mm_set_ps(0.0f, val, val, val));
+}
+
+inline tVector3::tVector3(tScalar _x, tScalar _y, tScalar _z)
+{
+  SetM128(_mm_set_ps(0.0f, _z, _y, _x));
+}
+
+inline tVector3::tVector3(tScalar scale, const tVector3& vec)
+{
+  SetM128(_mm_mul_ps(_mm_set1_ps(scale), vec.GetM128()));
+}
+
+#else
+
 inline void tVector3::SetTo(tScalar val)
 {
   x = y = z = val;
@@ -42,6 +80,10 @@ inline void tVector3::Set(tScalar _x, tScalar _y, tScalar _z)
   x = _x; y = _y; z = _z;
 }
 
+inline tVector3::tVector3(tZero) : x(0.0f), y(0.0f), z(0.0f)
+{
+}
+
 inline tVector3::tVector3(tScalar val) : x(val), y(val), z(val) 
 {
 }
@@ -54,6 +96,8 @@ inline tVector3::tVector3(tScalar scale, const tVector3& vec) : x(scale * vec.x)
 {
 }
 
+#endif
+
 inline void tVector3::SetData(const tScalar * d)
 {
   x = d[0];
@@ -61,6 +105,56 @@ inline void tVector3::SetData(const tScalar * d)
   z = d[2];
 }
 
+#ifdef USING_SSE
+
+inline tVector3 & tVector3::operator+=(const tVector3 & rhs)
+{
+  SetM128(_mm_add_ps(GetM128(), rhs.GetM128()));
+  return *this;
+}
+
+inline tVector3 & tVector3::operator-=(const tVector3 & rhs)
+{
+  SetM128(_mm_sub_ps(GetM128(), rhs.GetM128()));
+  return *this;
+}
+
+inline tVector3 & tVector3::operator*=(const tScalar rhs)
+{
+  SetM128(_mm_mul_ps(GetM128(), _mm_set1_ps(rhs)));
+  return *this;
+}
+
+inline tVector3 & tVector3::operator/=(const tScalar rhs)
+{
+  SetM128(_mm_mul_ps(GetM128(), _mm_set1_ps(1.0f / rhs)));
+  return *this;
+}
+
+inline tVector3 tVector3::operator+(const tVector3 & rhs) const
+{
+  return tVector3(_mm_add_ps(GetM128(), rhs.GetM128()));
+}
+
+inline tVector3 tVector3::operator-(const tVector3 & rhs) const
+{
+  return tVector3(_mm_sub_ps(GetM128(), rhs.GetM128()));
+}
+
+inline tVector3 tVector3::operator-() const
+{
+  // flip the sign bits (0 - v would lose the sign of zeros)
+  return tVector3(_mm_xor_ps(GetM128(), _mm_set1_ps(-0.0f)));
+}
+
+inline tVector3 & tVector3::Negate()
+{
+  SetM128(_mm_xor_ps(GetM128(), _mm_set1_ps(-0.0f)));
+  return *this;
+}
+
+#else
+
 inline tVector3 & tVector3::operator+=(const tVector3 & rhs)
 {
   x += rhs.x;
@@ -104,12 +198,19 @@ inline tVector3 tVector3::operator-(const tVector3 & rhs) const
   return tVector3(x - rhs.x, y - rhs.y, z - rhs.z);
 }
 
+inline tVector3 tVector3::operator-() const
+{
+  return tVector3(-x, -y, -z);
+}
+
 inline tVector3 & tVector3::Negate()
 {
   x = -x; y = -y; z = -z;
   return *this;
 }
 
+#endif
+
 inline tVector3 & tVector3::Normalise() 
 {
   (*this) *= (1.0f / GetLength()); return *this;
@@ -159,6 +260,51 @@ inline void tVector3::Show(const char * str) const
 }
 
 // global operators
+#ifdef USING_SSE
+
+inline tVector3 operator*(const tVector3 & lhs, const tScalar rhs)
+{
+  return tVector3(_mm_mul_ps(lhs.GetM128(), _mm_set1_ps(rhs)));
+}
+
+inline tVector3 operator/(const tVector3 & lhs, const tScalar rhs)
+{
+  return tVector3(_mm_mul_ps(lhs.GetM128(), _mm_set1_ps(1.0f / rhs)));
+}
+
+inline tScalar Dot(const tVector3 & lhs, const tVector3 & rhs)
+{
+  // (x + y) + z, like the scalar version
+  __m128 m = _mm_mul_ps(lhs.GetM128(), rhs.GetM128());
+  __m128 y = _mm_shuffle_ps(m, m, _MM_SHUFFLE(1, 1, 1, 1));
+  __m128 z = _mm_shuffle_ps(m, m, _MM_SHUFFLE(2, 2, 2, 2));
+  return _mm_cvtss_f32(_mm_add_ss(_mm_add_ss(m, y), z));
+}
+
+inline tVector3 Cross(const tVector3 & lhs, const tVector3 & rhs)
+{
+  __m128 a = lhs.GetM128();
+  __m128 b = rhs.GetM128();
+  __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+  __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+  // this gives (z, x, y)
+  __m128 c = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b));
+  return tVector3(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+}
+
+#else
+
+inline tVector3 operator*(const tVector3 & lhs, const tScalar rhs)
+{
+  return tVector3(lhs.x * rhs, lhs.y * rhs, lhs.z * rhs);
+}
+
+inline tVector3 operator/(const tVector3 & lhs, const tScalar rhs)
+{
+  const tScalar inv_rhs = 1.0f/rhs; 
+  return tVector3(lhs.x * inv_rhs, lhs.y * inv_rhs, lhs.z * inv_rhs);
+}
+
 inline tScalar Dot(const tVector3 & lhs, const tVector3 & rhs)
 {
   return (lhs.x * rhs.x +
@@ -173,6 +319,8 @@ inline tVector3 Cross(const tVector3 & lhs, const tVector3 & rhs)
                   lhs.x*rhs.y - lhs.y*rhs.x);
 }
 
+#endif
+
 inline bool ApproxEqual(const tVector3 & a, 
                         const tVector3 & b, 
                         tScalar tol)
@@ -183,6 +331,47 @@ inline bool ApproxEqual(const tVector3 & a,
   return true;
 }
 
+#ifdef USING_SSE
+
+inline tVector3 ElementMult(const tVector3 & lhs, const tVector3 & rhs)
+{
+  return tVector3(_mm_mul_ps(lhs.GetM128(), rhs.GetM128()));
+}
+
+inline void AddVector3(tVector3 & out, 
+                       const tVector3 & vec1, 
+                       const tVector3 & vec2)
+{
+  out.SetM128(_mm_add_ps(vec1.GetM128(), vec2.GetM128()));
+}
+
+inline void AddVector3(tVector3 & out, 
+                       const tVector3 & vec1, 
+                       const tVector3 & vec2, 
+                       const tVector3 & vec3)
+{
+  out.SetM128(_mm_add_ps(_mm_add_ps(vec1.GetM128(), vec2.GetM128()), vec3.GetM128()));
+}
+
+inline void SubVector3(tVector3 & out, 
+                       const tVector3 & vec1, 
+                       const tVector3 & vec2)
+{
+  out.SetM128(_mm_sub_ps(vec1.GetM128(), vec2.GetM128()));
+}
+
+inline void ScaleVector3(tVector3 & out, const tVector3 & vec1, tScalar scale)
+{
+  out.SetM128(_mm_mul_ps(vec1.GetM128(), _mm_set1_ps(scale)));
+}
+
+inline void AddScaleVector3(tVector3 & out, const tVector3 & vec1, tScalar scale, const tVector3 & vec2)
+{
+  out.SetM128(_mm_add_ps(vec1.GetM128(), _mm_mul_ps(_mm_set1_ps(scale), vec2.GetM128())));
+}
+
+#else
+
 inline tVector3 ElementMult(const tVector3 & lhs, const tVector3 & rhs)
 {
   return tVector3(lhs.x * rhs.x,
@@ -231,3 +420,5 @@ inline void AddScaleVector3(tVector3 & out, const tVector3 & vec1, tScalar scale
   out.y = vec1.y + scale * vec2.y;
   out.z = vec1.z + scale * vec2.z;
 }
+
+#endif
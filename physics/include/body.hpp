@@ -12,6 +12,7 @@
 #include "../maths/include/transform3.hpp"
 #include "../physics/include/physicssystem.hpp"
 #include "../physics/include/constraint.hpp"
+#include "../physics/include/bodystatestore.hpp"
 
 namespace JigLib
 {
@@ -35,12 +36,20 @@ namespace JigLib
     /// Called right at the end of the timestep to notify the derived class
     virtual void PostPhysics(tScalar dt) {}
 
-    /// register with the physics system
+    /// register with the current physics system (see
+    /// tPhysicsSystem::GetCurrentPhysicsSystem)
     void EnableBody();
 
+    /// register with physics. This moves our state into physics, so
+    /// only touches that system (and us).
+    void EnableBody(class tPhysicsSystem & physics);
+
     /// deregister from the physics system
     void DisableBody();
 
+    /// The physics system we're registered with, or 0
+    class tPhysicsSystem * GetPhysicsSystem() const {return mPhysicsSystem;}
+
     /// are we registered with the physics system?
     bool GetBodyEnabled() const {return mBodyEnabled;}
 
@@ -58,38 +67,38 @@ namespace JigLib
     /// active.
     void MoveTo(const tVector3 & pos, const tMatrix33 & orientation);
     
-    void SetTransform(const tTransform3 &t) {mTransform = t;}
-    void SetTransformRate(const tTransform3Rate &rate) {mTransformRate = rate;}
-    const tTransform3 &GetTransform() const {return mTransform;}
-    const tTransform3 &GetOldTransform() const {return mOldTransform;}
-    const tTransform3Rate &GetTransformRate() const {return mTransformRate;}
-    const tTransform3Rate &GetOldTransformRate() const {return mOldTransformRate;}
+    void SetTransform(const tTransform3 &t) {Transform() = t;}
+    void SetTransformRate(const tTransform3Rate &rate) {TransformRate() = rate;}
+    const tTransform3 &GetTransform() const {return Transform();}
+    const tTransform3 &GetOldTransform() const {return OldTransform();}
+    const tTransform3Rate &GetTransformRate() const {return TransformRate();}
+    const tTransform3Rate &GetOldTransformRate() const {return OldTransformRate();}
 
-    void SetPosition(const tVector3 & pos) {mTransform.position = pos; }
-    const tVector3 & GetPosition() const { return mTransform.position; }
-    const tVector3 & GetOldPosition() const { return mOldTransform.position; }
+    void SetPosition(const tVector3 & pos) {Transform().position = pos; }
+    const tVector3 & GetPosition() const { return Transform().position; }
+    const tVector3 & GetOldPosition() const { return OldTransform().position; }
     
     void SetOrientation(const tMatrix33 & orient);
-    const tMatrix33 & GetOrientation() const { return mTransform.orientation; }
-    const tMatrix33 & GetOldOrientation() const { return mOldTransform.orientation; }
+    const tMatrix33 & GetOrientation() const { return Transform().orientation; }
+    const tMatrix33 & GetOldOrientation() const { return OldTransform().orientation; }
     
-    void SetVelocity(const tVector3 & vel) { mTransformRate.velocity = vel; }
-    void SetVelocityAux(const tVector3 & vel) { mTransformRateAux.velocity = vel; }
-    const tVector3 & GetVelocity() const { return mTransformRate.velocity; }
-    const tVector3 & GetOldVelocity() const { return mOldTransformRate.velocity; }
-    const tVector3 & GetVelocityAux() const { return mTransformRateAux.velocity; }
+    void SetVelocity(const tVector3 & vel) { TransformRate().velocity = vel; }
+    void SetVelocityAux(const tVector3 & vel) { TransformRateAux().velocity = vel; }
+    const tVector3 & GetVelocity() const { return TransformRate().velocity; }
+    const tVector3 & GetOldVelocity() const { return OldTransformRate().velocity; }
+    const tVector3 & GetVelocityAux() const { return TransformRateAux().velocity; }
 
-    void SetAngVel(const tVector3 & angVel) { mTransformRate.angVelocity = angVel; }
-    void SetAngVelAux(const tVector3 & angVel) { mTransformRateAux.angVelocity = angVel; }
-    const tVector3 & GetAngVel() const { return mTransformRate.angVelocity; }
-    const tVector3 & GetOldAngVel() const { return mOldTransformRate.angVelocity; }
-    const tVector3 & GetAngVelAux() const { return mTransformRateAux.angVelocity; }
+    void SetAngVel(const tVector3 & angVel) { TransformRate().angVelocity = angVel; }
+    void SetAngVelAux(const tVector3 & angVel) { TransformRateAux().angVelocity = angVel; }
+    const tVector3 & GetAngVel() const { return TransformRate().angVelocity; }
+    const tVector3 & GetOldAngVel() const { return OldTransformRate().angVelocity; }
+    const tVector3 & GetAngVelAux() const { return TransformRateAux().angVelocity; }
     
-    void SetForce(const tVector3 & f) { mForce = f; }
-    const tVector3 & GetForce() const { return mForce; }
+    void SetForce(const tVector3 & f) { Force() = f; }
+    const tVector3 & GetForce() const { return Force(); }
     
-    void SetTorque(const tVector3 & t) { mTorque = t; }
-    const tVector3 & GetTorque() const { return mTorque; }
+    void SetTorque(const tVector3 & t) { Torque() = t; }
+    const tVector3 & GetTorque() const { return Torque(); }
 
     /// Returns the velocity of a point at body-relative position
     /// (in world frame) relPos
@@ -106,15 +115,15 @@ namespace JigLib
     void SetMass(tScalar mass);
     void SetInvMass(tScalar invMass);
     tScalar GetMass() const {return mMass;}
-    tScalar GetInvMass() const {return mInvMass;}
+    tScalar GetInvMass() const {return InvMass();}
     
     void SetBodyInertia(tScalar Ixx, tScalar Iyy, tScalar Izz);
     void SetBodyInertia(const tMatrix33 &bodyInertia);
     void SetBodyInvInertia(tScalar invIxx, tScalar invIyy, tScalar invIzz);
-    const tMatrix33 & GetBodyInertia() const {return mBodyInertia;}
-    const tMatrix33 & GetBodyInvInertia() const {return mBodyInvInertia;}
-    const tMatrix33 & GetWorldInvInertia() const { return mWorldInvInertia; }
-    const tMatrix33 & GetWorldInertia() const { return mWorldInertia; }
+    const tMatrix33 & GetBodyInertia() const {return BodyInertia();}
+    const tMatrix33 & GetBodyInvInertia() const {return BodyInvInertia();}
+    const tMatrix33 & GetWorldInvInertia() const { return WorldInvInertia(); }
+    const tMatrix33 & GetWorldInertia() const { return WorldInertia(); }
     
     // functions to add forces in the world coordinate frame
     void AddWorldForce(const tVector3 & force);
@@ -169,10 +178,10 @@ namespace JigLib
 
     /// indicates if we ever move (change our position - may still
     /// have a non-zero velocity for conveyor-belts!)
-    bool GetImmovable() const {return mImmovable;}
+    bool GetImmovable() const {return Immovable();}
     
     enum tActivity {ACTIVE, INACTIVE};
-    bool IsActive() const {return mActivity == ACTIVE;}
+    bool IsActive() const {return Active();}
     
     /// Allow the activity to be explicitly set - be careful about
     /// explicitly freezing an object (may become unfrozen anyway).
@@ -185,14 +194,14 @@ namespace JigLib
     
     /// indicates if the velocity is above the threshold for freezing
     bool GetShouldBeActive() {
-      return ( (mTransformRate.velocity.GetLengthSq() > 
+      return ( (TransformRate().velocity.GetLengthSq() > 
                 mSqVelocityActivityThreshold) ||
-               (mTransformRate.angVelocity.GetLengthSq() > 
+               (TransformRate().angVelocity.GetLengthSq() > 
                 mSqAngVelActivityThreshold) );}
     bool GetShouldBeActiveAux() {
-      return ( (mTransformRateAux.velocity.GetLengthSq() > 
+      return ( (TransformRateAux().velocity.GetLengthSq() > 
                 mSqVelocityActivityThreshold) ||
-               (mTransformRateAux.angVelocity.GetLengthSq() > 
+               (TransformRateAux().angVelocity.GetLengthSq() > 
                 mSqAngVelActivityThreshold) );}
     
     //==============================================================
@@ -238,18 +247,14 @@ namespace JigLib
     /// restore from the stored state into our current state.
     void RestoreState();
 
-    /// implementation updates the velocity/angular rotation with the
-    /// force/torque.
-    void UpdateVelocity(tScalar dt);
-    
-    /// implementation updates the position/orientation with the
-    /// current velocties. 
-    void UpdatePosition(tScalar dt);
-    /// Updates the position with the auxilary velocities, and zeros them
-    void UpdatePositionWithAux(tScalar dt);
+    /// function provided for the use of Physics system. Updates the
+    /// deactivation timer and returns true if we'd be happy to go to
+    /// sleep - physics only actually freezes us (using Freeze) if the
+    /// rest of our island is happy too.
+    inline bool TryToFreeze(tScalar dt);
 
-    /// function provided for the use of Physics system
-    inline void TryToFreeze(tScalar dt);
+    /// puts the body to sleep (if allowed)
+    void Freeze();
     
     /// damp movement as the body approaches deactivation
     void DampForDeactivation();
@@ -268,73 +273,76 @@ namespace JigLib
     /// Used by physics to temporarily make an object immovable -
     /// needs to restore afterwars!
     void InternalSetImmovable() {
-      mOrigImmovable = mImmovable; mImmovable = true;}
+      mOrigImmovable = Immovable(); Immovable() = true;}
     void InternalRestoreImmovable() {
-      mImmovable = mOrigImmovable;}
+      Immovable() = mOrigImmovable;}
+
+    bool GetVelChanged() const {return VelChanged();}
+    void ClearVelChanged() {VelChanged() = false;}
+
+    // Our state in the store - the references are only valid until
+    // a body gets added to or removed from the store.
+    tTransform3 & Transform() {return mStateStore->mTransforms[mStateIndex];}
+    const tTransform3 & Transform() const {return mStateStore->mTransforms[mStateIndex];}
+    tTransform3Rate & TransformRate() {return mStateStore->mTransformRates[mStateIndex];}
+    const tTransform3Rate & TransformRate() const {return mStateStore->mTransformRates[mStateIndex];}
+    tTransform3Rate & TransformRateAux() {return mStateStore->mTransformRatesAux[mStateIndex];}
+    const tTransform3Rate & TransformRateAux() const {return mStateStore->mTransformRatesAux[mStateIndex];}
+    tTransform3 & OldTransform() {return mStateStore->mOldTransforms[mStateIndex];}
+    const tTransform3 & OldTransform() const {return mStateStore->mOldTransforms[mStateIndex];}
+    tTransform3Rate & OldTransformRate() {return mStateStore->mOldTransformRates[mStateIndex];}
+    const tTransform3Rate & OldTransformRate() const {return mStateStore->mOldTransformRates[mStateIndex];}
+    tTransform3 & StoredTransform() {return mStateStore->mStoredTransforms[mStateIndex];}
+    tTransform3Rate & StoredTransformRate() {return mStateStore->mStoredTransformRates[mStateIndex];}
+    tVector3 & Force() {return mStateStore->mForces[mStateIndex];}
+    const tVector3 & Force() const {return mStateStore->mForces[mStateIndex];}
+    tVector3 & Torque() {return mStateStore->mTorques[mStateIndex];}
+    const tVector3 & Torque() const {return mStateStore->mTorques[mStateIndex];}
+    tScalar & InvMass() {return mStateStore->mInvMasses[mStateIndex];}
+    tScalar InvMass() const {return mStateStore->mInvMasses[mStateIndex];}
+    tMatrix33 & BodyInertia() {return mStateStore->mBodyInertias[mStateIndex];}
+    const tMatrix33 & BodyInertia() const {return mStateStore->mBodyInertias[mStateIndex];}
+    tMatrix33 & BodyInvInertia() {return mStateStore->mBodyInvInertias[mStateIndex];}
+    const tMatrix33 & BodyInvInertia() const {return mStateStore->mBodyInvInertias[mStateIndex];}
+    tMatrix33 & WorldInertia() {return mStateStore->mWorldInertias[mStateIndex];}
+    const tMatrix33 & WorldInertia() const {return mStateStore->mWorldInertias[mStateIndex];}
+    tMatrix33 & WorldInvInertia() {return mStateStore->mWorldInvInertias[mStateIndex];}
+    const tMatrix33 & WorldInvInertia() const {return mStateStore->mWorldInvInertias[mStateIndex];}
+    unsigned char & Active() {return mStateStore->mActive[mStateIndex];}
+    bool Active() const {return mStateStore->mActive[mStateIndex] != 0;}
+    unsigned char & Immovable() {return mStateStore->mImmovable[mStateIndex];}
+    bool Immovable() const {return mStateStore->mImmovable[mStateIndex] != 0;}
+    unsigned char & VelChanged() {return mStateStore->mVelChanged[mStateIndex];}
+    bool VelChanged() const {return mStateStore->mVelChanged[mStateIndex] != 0;}
+
+    // not implemented - a body owns its slot in the store
+    tBody(const tBody &);
+    tBody & operator=(const tBody &);
 
-    bool GetVelChanged() const {return mVelChanged;}
-    void ClearVelChanged() {mVelChanged = false;}
-
-    void LimitVel();
-    void LimitAngVel();
-    
   private:
-    /// Helper to stop the velocities getting silly
-    static tScalar mVelMax;
-    static tScalar mAngVelMax;
+    friend class tBodyStateStore;
+
+    /// Where our transforms, velocities, forces, mass etc live
+    tBodyStateStore * mStateStore;
+    unsigned mStateIndex;
+
+    /// Holds our state whilst we're not in a physics system (and is
+    /// empty when we are), so a body that isn't enabled doesn't share
+    /// anything with other bodies
+    tBodyStateStore mOwnStateStore;
+
     bool mBodyEnabled;
+    class tPhysicsSystem * mPhysicsSystem;
     
     /// don't actually own the skin...
     tCollisionSkin * mCollSkin;
     
-    /// the "working" state
-    tTransform3 mTransform;
-    tTransform3Rate mTransformRate;
-    tTransform3Rate mTransformRateAux;
-
-    /// Prevent velocity updates etc 
-    bool mImmovable;
-    /// Flag that gets set whenever our velocity/angular velocity might have been changed.
-    /// Used by physics to speed up checking for activation
-    bool mVelChanged;
-    tScalar mInvMass;
-
-    /// inverse inertia in world frame
-    tMatrix33 mWorldInvInertia;
-    
-    /// the previous state - copied explicitly using
-    /// CopyCurrentStateToOld.
-    tTransform3 mOldTransform;
-    tTransform3Rate mOldTransformRate;
-    
-    /// stored state - used internally by physics during the updates
-    tTransform3 mStoredTransform;
-    tTransform3Rate mStoredTransformRate;
-
-    tMatrix33 mInvOrientation;
-    
     tScalar mMass;
     
     bool mOrigImmovable;
     
     bool mDoShockProcessing;
 
-    /// inertia in body space (not necessarily diagonal)
-    tMatrix33 mBodyInertia;
-    
-    /// inertia tensor in world space
-    tMatrix33 mWorldInertia;
-    
-    /// inverse inertia in body frame
-    tMatrix33 mBodyInvInertia;
-    
-    /// force etc in world frame.
-    tVector3 mForce;
-    /// torque in world frame
-    tVector3 mTorque;
-    
-    /// for deactivation
-    tActivity mActivity;
     /// How long we've been still
     tScalar mInactiveTime;
     
@@ -370,6 +378,15 @@ namespace JigLib
 
     /// list of constraints that act on this body
     std::vector<class tConstraint *> mConstraints;
+
+    /// Our index in the physics body list whilst the islands are being
+    /// built (-1 if we don't take part)
+    int mIslandNode;
+
+    /// Bodies that went to sleep together are linked in a ring, so
+    /// that if one gets woken the physics can wake the rest. Points to
+    /// ourself if we're not part of a sleeping island.
+    tBody * mNextSleepingBody;
   };
   
 //==============================================================
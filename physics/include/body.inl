@@ -8,38 +8,15 @@
 //==============================================================
 // only to be included by body.hpp
 
-//==============================================================
-// LimitVel
-//==============================================================
-inline void tBody::LimitVel()
-{
-  Limit(mTransformRate.velocity.x, -mVelMax, mVelMax);
-  Limit(mTransformRate.velocity.y, -mVelMax, mVelMax);
-  Limit(mTransformRate.velocity.z, -mVelMax, mVelMax);
-}
-
-//==============================================================
-// LimitAngVel
-//==============================================================
-inline void tBody::LimitAngVel()
-{
-  tScalar fX = Abs(mTransformRate.angVelocity.x) / mAngVelMax;
-  tScalar fY = Abs(mTransformRate.angVelocity.y) / mAngVelMax;
-  tScalar fZ = Abs(mTransformRate.angVelocity.z) / mAngVelMax;
-  tScalar f = Max(fX, fY, fZ);
-  if (f > 1.0f)
-    mTransformRate.angVelocity /= f;
-}
-
 //==============================================================
 // GetVelocity
 //==============================================================
 inline tVector3 tBody::GetVelocity(const tVector3& relPos) const
 {
   return tVector3(
-    mTransformRate.velocity[0] + mTransformRate.angVelocity[1]*relPos[2] - mTransformRate.angVelocity[2]*relPos[1],
-    mTransformRate.velocity[1] + mTransformRate.angVelocity[2]*relPos[0] - mTransformRate.angVelocity[0]*relPos[2],
-    mTransformRate.velocity[2] + mTransformRate.angVelocity[0]*relPos[1] - mTransformRate.angVelocity[1]*relPos[0]);
+    TransformRate().velocity[0] + TransformRate().angVelocity[1]*relPos[2] - TransformRate().angVelocity[2]*relPos[1],
+    TransformRate().velocity[1] + TransformRate().angVelocity[2]*relPos[0] - TransformRate().angVelocity[0]*relPos[2],
+    TransformRate().velocity[2] + TransformRate().angVelocity[0]*relPos[1] - TransformRate().angVelocity[1]*relPos[0]);
 }
 
 //==============================================================
@@ -48,9 +25,9 @@ inline tVector3 tBody::GetVelocity(const tVector3& relPos) const
 inline tVector3 tBody::GetVelocityAux(const tVector3& relPos) const
 {
   return tVector3(
-    mTransformRateAux.velocity[0] + mTransformRateAux.angVelocity[1]*relPos[2] - mTransformRateAux.angVelocity[2]*relPos[1],
-    mTransformRateAux.velocity[1] + mTransformRateAux.angVelocity[2]*relPos[0] - mTransformRateAux.angVelocity[0]*relPos[2],
-    mTransformRateAux.velocity[2] + mTransformRateAux.angVelocity[0]*relPos[1] - mTransformRateAux.angVelocity[1]*relPos[0]);
+    TransformRateAux().velocity[0] + TransformRateAux().angVelocity[1]*relPos[2] - TransformRateAux().angVelocity[2]*relPos[1],
+    TransformRateAux().velocity[1] + TransformRateAux().angVelocity[2]*relPos[0] - TransformRateAux().angVelocity[0]*relPos[2],
+    TransformRateAux().velocity[2] + TransformRateAux().angVelocity[0]*relPos[1] - TransformRateAux().angVelocity[1]*relPos[0]);
 }
 
 
@@ -63,7 +40,7 @@ inline void tBody::DoMovementActivations()
   Assert(tPhysicsSystem::GetCurrentPhysicsSystem());
   if (mBodiesToBeActivatedOnMovement.empty())
     return;
-  if ( (mTransform.position - mStoredPositionForActivation).GetLengthSq() < mSqDeltaPosThreshold)
+  if ( (Transform().position - mStoredPositionForActivation).GetLengthSq() < mSqDeltaPosThreshold)
     return;
   
   const size_t numBodies = mBodiesToBeActivatedOnMovement.size();
@@ -93,45 +70,42 @@ inline void tBody::AddMovementActivation(const tVector3 & pos,
 //==============================================================
 // TryToFreeze
 //==============================================================
-inline void tBody::TryToFreeze(tScalar dt)
+inline bool tBody::TryToFreeze(tScalar dt)
 {
-  if (!mAllowFreezing || mImmovable || !IsActive())
-    return;
+  if (!mAllowFreezing || Immovable())
+    return false;
+
+  if (!IsActive())
+    return true;
   
-  if ((mTransform.position - mLastPositionForDeactivation).GetLengthSq() > 
+  if ((Transform().position - mLastPositionForDeactivation).GetLengthSq() > 
       mSqDeltaPosThreshold)
   {
-    mLastPositionForDeactivation = mTransform.position;
+    mLastPositionForDeactivation = Transform().position;
     mInactiveTime = 0.0f;
-    return;
+    return false;
   }
 // ugly - use quaternions
-  tMatrix33 deltaMat = mTransform.orientation - mLastOrientationForDeactivation;
+  tMatrix33 deltaMat = Transform().orientation - mLastOrientationForDeactivation;
   if ( (deltaMat.GetLook().GetLengthSq() > mSqDeltaOrientThreshold ) ||
        (deltaMat.GetLeft().GetLengthSq() > mSqDeltaOrientThreshold ) ||
        (deltaMat.GetUp().GetLengthSq()   > mSqDeltaOrientThreshold ) )
   {
-    mLastOrientationForDeactivation = mTransform.orientation;
+    mLastOrientationForDeactivation = Transform().orientation;
     mInactiveTime = 0.0f;
-    return;
+    return false;
   }
 
 // check the thresholds as well
   if ( GetShouldBeActive() )
   {
     // let the inactivity timer continue
-    return;
+    return false;
   }
   
   mInactiveTime += dt;
   
-  if (mInactiveTime > mDeactivationTime)
-  {
-// sleep!
-    mLastOrientationForDeactivation = mTransform.orientation;
-    mLastPositionForDeactivation = mTransform.position;
-    SetInactive();
-  }
+  return mInactiveTime > mDeactivationTime;
 }
 
 //==============================================================
@@ -139,10 +113,8 @@ inline void tBody::TryToFreeze(tScalar dt)
 //==============================================================
 inline void tBody::SetOrientation(const tMatrix33 & orient) 
 { 
-  mTransform.orientation = orient; 
-  mInvOrientation = mTransform.orientation.GetTranspose();
-  mWorldInvInertia = mTransform.orientation * mBodyInvInertia * mInvOrientation;
-  mWorldInertia = mTransform.orientation * mBodyInertia * mInvOrientation;
+  Transform().orientation = orient; 
+  mStateStore->UpdateWorldInertia(mStateIndex);
 }
 
 #ifdef DEBUG
@@ -156,20 +128,20 @@ void DummyFnForMSVC();
 //==============================================================
 inline void tBody::ApplyWorldImpulse(const tVector3 & impulse)
 {
-  if (mImmovable)
+  if (Immovable())
     return;
 #ifdef CHECK_RIGID_BODY
-  tVector3 origVelocity = mTransformRate.velocity;
+  tVector3 origVelocity = TransformRate().velocity;
 #endif
-  AddScaleVector3(mTransformRate.velocity, mTransformRate.velocity, mInvMass, impulse);
-  mVelChanged = true;
+  AddScaleVector3(TransformRate().velocity, TransformRate().velocity, InvMass(), impulse);
+  VelChanged() = true;
 #ifdef CHECK_RIGID_BODY
-  if (!mTransformRate.velocity.IsSensible())
+  if (!TransformRate().velocity.IsSensible())
   {
     TRACE("tVector3 is not sensible after impulse: this = %p\n", this);
     origVelocity.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRate.velocity.Show("velocity");
+    TransformRate().velocity.Show("velocity");
     while (1) {DummyFnForMSVC();}
   }
 #endif
@@ -183,10 +155,10 @@ inline void tBody::ApplyNegativeWorldImpulse(const tVector3 & impulse)
 #ifdef CHECK_RIGID_BODY
   ApplyWorldImpulse(-impulse);
 #else
-  if (mImmovable)
+  if (Immovable())
     return;
-  AddScaleVector3(mTransformRate.velocity, mTransformRate.velocity, mInvMass, impulse);
-  mVelChanged = true;
+  AddScaleVector3(TransformRate().velocity, TransformRate().velocity, InvMass(), impulse);
+  VelChanged() = true;
 #endif
 }
 
@@ -195,20 +167,20 @@ inline void tBody::ApplyNegativeWorldImpulse(const tVector3 & impulse)
 //==============================================================
 inline void tBody::ApplyWorldImpulseAux(const tVector3 & impulse)
 {
-  if (mImmovable)
+  if (Immovable())
     return;
 #ifdef CHECK_RIGID_BODY
-  tVector3 origVelocity = mTransformRateAux.velocity;
+  tVector3 origVelocity = TransformRateAux().velocity;
 #endif
-  AddScaleVector3(mTransformRateAux.velocity, mTransformRateAux.velocity, mInvMass, impulse);
-  mVelChanged = true;
+  AddScaleVector3(TransformRateAux().velocity, TransformRateAux().velocity, InvMass(), impulse);
+  VelChanged() = true;
 #ifdef CHECK_RIGID_BODY
-  if (!mTransformRateAux.velocity.IsSensible())
+  if (!TransformRateAux().velocity.IsSensible())
   {
     TRACE("tVector3 is not sensible after aux impulse: this = %p\n", this);
     origVelocity.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRateAux.velocity.Show("velocity");
+    TransformRateAux().velocity.Show("velocity");
     while (1) {DummyFnForMSVC();}
   }
 #endif
@@ -222,10 +194,10 @@ inline void tBody::ApplyNegativeWorldImpulseAux(const tVector3 & impulse)
 #ifdef CHECK_RIGID_BODY
   ApplyWorldImpulseAux(-impulse);
 #else
-  if (mImmovable)
+  if (Immovable())
     return;
-  AddScaleVector3(mTransformRateAux.velocity, mTransformRateAux.velocity, mInvMass, impulse);
-  mVelChanged = true;
+  AddScaleVector3(TransformRateAux().velocity, TransformRateAux().velocity, InvMass(), impulse);
+  VelChanged() = true;
 #endif
 }
 
@@ -234,31 +206,31 @@ inline void tBody::ApplyNegativeWorldImpulseAux(const tVector3 & impulse)
 //====================================================================
 inline void tBody::ApplyBodyWorldImpulse(const tVector3 & impulse, const tVector3 & delta)
 {
-  if (mImmovable)
+  if (Immovable())
     return;
 #ifdef CHECK_RIGID_BODY
-  tVector3 origVelocity = mTransformRate.velocity;
-  tVector3 origAngVel = mTransformRate.angVelocity;
+  tVector3 origVelocity = TransformRate().velocity;
+  tVector3 origAngVel = TransformRate().angVelocity;
 #endif
-  AddScaleVector3(mTransformRate.velocity, mTransformRate.velocity, mInvMass, impulse);
-  mTransformRate.angVelocity += mWorldInvInertia * Cross(delta, impulse);
+  AddScaleVector3(TransformRate().velocity, TransformRate().velocity, InvMass(), impulse);
+  TransformRate().angVelocity += WorldInvInertia() * Cross(delta, impulse);
 
-  mVelChanged = true;
+  VelChanged() = true;
 #ifdef CHECK_RIGID_BODY
-  if (!mTransformRate.angVelocity.IsSensible())
+  if (!TransformRate().angVelocity.IsSensible())
   {
     TRACE("rotation is not sensible after impulse: this = %p\n", this);
     origAngVel.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRate.angVelocity.Show("rotation");
+    TransformRate().angVelocity.Show("rotation");
     while (1) {DummyFnForMSVC();}
   }
-  if (!mTransformRate.velocity.IsSensible())
+  if (!TransformRate().velocity.IsSensible())
   {
-    TRACE("mTransformRate.velocity is not sensible after impulse: this = %p\n", this);
+    TRACE("TransformRate().velocity is not sensible after impulse: this = %p\n", this);
     origVelocity.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRate.velocity.Show("velocity");
+    TransformRate().velocity.Show("velocity");
     while (1) {DummyFnForMSVC();}
   }
 #endif
@@ -272,11 +244,11 @@ inline void tBody::ApplyNegativeBodyWorldImpulse(const tVector3 & impulse, const
 #ifdef CHECK_RIGID_BODY
   ApplyBodyWorldImpulse(-impulse, delta);
 #else
-  if (mImmovable)
+  if (Immovable())
     return;
-  AddScaleVector3(mTransformRate.velocity, mTransformRate.velocity, -mInvMass, impulse);
-  mTransformRate.angVelocity -= mWorldInvInertia * Cross(delta, impulse);
-  mVelChanged = true;
+  AddScaleVector3(TransformRate().velocity, TransformRate().velocity, -InvMass(), impulse);
+  TransformRate().angVelocity -= WorldInvInertia() * Cross(delta, impulse);
+  VelChanged() = true;
 #endif
 }
 //====================================================================
@@ -284,31 +256,31 @@ inline void tBody::ApplyNegativeBodyWorldImpulse(const tVector3 & impulse, const
 //====================================================================
 inline void tBody::ApplyBodyWorldImpulseAux(const tVector3 & impulse, const tVector3 & delta)
 {
-  if (mImmovable)
+  if (Immovable())
     return;
 #ifdef CHECK_RIGID_BODY
-  tVector3 origVelocity = mTransformRateAux.velocity;
-  tVector3 origAngVel = mTransformRateAux.angVelocity;
+  tVector3 origVelocity = TransformRateAux().velocity;
+  tVector3 origAngVel = TransformRateAux().angVelocity;
 #endif
-  AddScaleVector3(mTransformRateAux.velocity, mTransformRateAux.velocity, mInvMass, impulse);
-  mTransformRateAux.angVelocity += mWorldInvInertia * Cross(delta, impulse);
+  AddScaleVector3(TransformRateAux().velocity, TransformRateAux().velocity, InvMass(), impulse);
+  TransformRateAux().angVelocity += WorldInvInertia() * Cross(delta, impulse);
   /// todo flag vel changed?
-  mVelChanged = true;
+  VelChanged() = true;
 #ifdef CHECK_RIGID_BODY
-  if (!mTransformRateAux.angVelocity.IsSensible())
+  if (!TransformRateAux().angVelocity.IsSensible())
   {
     TRACE("rotation is not sensible after aux impulse: this = %p\n", this);
     origAngVel.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRateAux.angVelocity.Show("rotation");
+    TransformRateAux().angVelocity.Show("rotation");
     while (1) {DummyFnForMSVC();}
   }
-  if (!mTransformRateAux.velocity.IsSensible())
+  if (!TransformRateAux().velocity.IsSensible())
   {
-    TRACE("mTransformRateAux.velocity is not sensible after impulse: this = %p\n", this);
+    TRACE("TransformRateAux().velocity is not sensible after impulse: this = %p\n", this);
     origVelocity.Show("orig vel");
     impulse.Show("impulse");
-    mTransformRateAux.velocity.Show("velocity");
+    TransformRateAux().velocity.Show("velocity");
     while (1) {DummyFnForMSVC();}
   }
 #endif
@@ -322,12 +294,12 @@ inline void tBody::ApplyNegativeBodyWorldImpulseAux(const tVector3 & impulse, co
 #ifdef CHECK_RIGID_BODY
   ApplyBodyWorldImpulseAux(-impulse, delta);
 #else
-  if (mImmovable)
+  if (Immovable())
     return;
-  AddScaleVector3(mTransformRateAux.velocity, mTransformRateAux.velocity, -mInvMass, impulse);
-  mTransformRateAux.angVelocity -= mWorldInvInertia * Cross(delta, impulse);
+  AddScaleVector3(TransformRateAux().velocity, TransformRateAux().velocity, -InvMass(), impulse);
+  TransformRateAux().angVelocity -= WorldInvInertia() * Cross(delta, impulse);
   /// todo falg vel changed when it's aux?
-  mVelChanged = true;
+  VelChanged() = true;
 #endif
 }
 
@@ -337,7 +309,7 @@ inline void tBody::ApplyNegativeBodyWorldImpulseAux(const tVector3 & impulse, co
 inline void tBody::ApplyWorldImpulse(const tVector3 & impulse, 
                                      const tVector3 & pos)
 {
-  ApplyBodyWorldImpulse(impulse, pos - mTransform.position);
+  ApplyBodyWorldImpulse(impulse, pos - Transform().position);
 }
 
 //==============================================================
@@ -346,7 +318,7 @@ inline void tBody::ApplyWorldImpulse(const tVector3 & impulse,
 inline void tBody::ApplyNegativeWorldImpulse(const tVector3 & impulse, 
                                              const tVector3 & pos)
 {
-  ApplyNegativeBodyWorldImpulse(impulse, pos - mTransform.position);
+  ApplyNegativeBodyWorldImpulse(impulse, pos - Transform().position);
 }
 
 //==============================================================
@@ -355,7 +327,7 @@ inline void tBody::ApplyNegativeWorldImpulse(const tVector3 & impulse,
 inline void tBody::ApplyWorldImpulseAux(const tVector3 & impulse, 
                                         const tVector3 & pos)
 {
-  ApplyBodyWorldImpulseAux(impulse, pos - mTransform.position);
+  ApplyBodyWorldImpulseAux(impulse, pos - Transform().position);
 }
 
 //==============================================================
@@ -364,7 +336,7 @@ inline void tBody::ApplyWorldImpulseAux(const tVector3 & impulse,
 inline void tBody::ApplyNegativeWorldImpulseAux(const tVector3 & impulse, 
                                                 const tVector3 & pos)
 {
-  ApplyNegativeBodyWorldImpulseAux(impulse, pos - mTransform.position);
+  ApplyNegativeBodyWorldImpulseAux(impulse, pos - Transform().position);
 }
 
 //==============================================================
@@ -372,20 +344,20 @@ inline void tBody::ApplyNegativeWorldImpulseAux(const tVector3 & impulse,
 //==============================================================
 inline void tBody::ApplyWorldAngImpulse(const tVector3 & angImpulse)
 {
-  if (mImmovable) return;
+  if (Immovable()) return;
 #ifdef CHECK_RIGID_BODY
-  tVector3 origAngVel = mTransformRate.angVelocity;
+  tVector3 origAngVel = TransformRate().angVelocity;
 #endif
-  mTransformRate.angVelocity += mWorldInvInertia * angImpulse;
+  TransformRate().angVelocity += WorldInvInertia() * angImpulse;
 
-  mVelChanged = true;
+  VelChanged() = true;
 #ifdef CHECK_RIGID_BODY
-  if (!mTransformRate.angVelocity.IsSensible())
+  if (!TransformRate().angVelocity.IsSensible())
   {
     TRACE("rotation is not sensible after ang impulse: this = %p\n", this);
     origAngVel.Show("orig ang vel");
     angImpulse.Show("ang impulse");
-    mTransformRate.angVelocity.Show("rotation");
+    TransformRate().angVelocity.Show("rotation");
     while (1) {DummyFnForMSVC();}
   }
 #endif
@@ -396,7 +368,7 @@ inline void tBody::ApplyWorldAngImpulse(const tVector3 & angImpulse)
 //==============================================================
 inline void tBody::ApplyBodyImpulse(const tVector3 & impulse)
 {
-  ApplyWorldImpulse(mTransform.orientation * impulse);
+  ApplyWorldImpulse(Transform().orientation * impulse);
 }
 
 //==============================================================
@@ -404,7 +376,7 @@ inline void tBody::ApplyBodyImpulse(const tVector3 & impulse)
 //==============================================================
 inline void tBody::ApplyNegativeBodyImpulse(const tVector3 & impulse)
 {
-  ApplyNegativeWorldImpulse(mTransform.orientation * impulse);
+  ApplyNegativeWorldImpulse(Transform().orientation * impulse);
 }
 
 //==============================================================
@@ -413,7 +385,7 @@ inline void tBody::ApplyNegativeBodyImpulse(const tVector3 & impulse)
 inline void tBody::ApplyBodyImpulse(const tVector3 & impulse, 
                                     const tVector3 & pos)
 {
-  ApplyWorldImpulse(mTransform.orientation * impulse, mTransform.position + mTransform.orientation * pos);
+  ApplyWorldImpulse(Transform().orientation * impulse, Transform().position + Transform().orientation * pos);
 }
 
 //==============================================================
@@ -422,14 +394,14 @@ inline void tBody::ApplyBodyImpulse(const tVector3 & impulse,
 inline void tBody::ApplyNegativeBodyImpulse(const tVector3 & impulse, 
                                             const tVector3 & pos)
 {
-  ApplyNegativeWorldImpulse(mTransform.orientation * impulse, mTransform.position + mTransform.orientation * pos);
+  ApplyNegativeWorldImpulse(Transform().orientation * impulse, Transform().position + Transform().orientation * pos);
 }
 //==============================================================
 // ApplyBodyAngImpulse
 //==============================================================
 inline void tBody::ApplyBodyAngImpulse(const tVector3 & angImpulse)
 {
-  ApplyWorldAngImpulse(mTransform.orientation * angImpulse);
+  ApplyWorldAngImpulse(Transform().orientation * angImpulse);
 }
 
 //========================================================
@@ -437,9 +409,9 @@ inline void tBody::ApplyBodyAngImpulse(const tVector3 & angImpulse)
 //========================================================
 inline void tBody::AddWorldForce(const tVector3 & force) 
 {
-  if (mImmovable) return;
-  mForce += force;
-  mVelChanged = true;
+  if (Immovable()) return;
+  Force() += force;
+  VelChanged() = true;
 }
 
 //==============================================================
@@ -448,10 +420,10 @@ inline void tBody::AddWorldForce(const tVector3 & force)
 inline void tBody::AddWorldForce(const tVector3 & force, 
                                  const tVector3 & pos)
 {
-  if (mImmovable) return;
-  mForce += force ;
-  mTorque += Cross(pos - mTransform.position, force);
-  mVelChanged = true;
+  if (Immovable()) return;
+  Force() += force ;
+  Torque() += Cross(pos - Transform().position, force);
+  VelChanged() = true;
 }
 
 //========================================================
@@ -459,9 +431,9 @@ inline void tBody::AddWorldForce(const tVector3 & force,
 //========================================================
 inline void tBody::AddWorldTorque(const tVector3 & torque) 
 {
-  if (mImmovable) return;
-  mTorque += torque;
-  mVelChanged = true;
+  if (Immovable()) return;
+  Torque() += torque;
+  VelChanged() = true;
 }
 
 //==============================================================
@@ -469,7 +441,7 @@ inline void tBody::AddWorldTorque(const tVector3 & torque)
 //==============================================================
 inline void tBody::AddBodyForce(const tVector3 & force)
 {
-  AddWorldForce(mTransform.orientation * force);
+  AddWorldForce(Transform().orientation * force);
 }
 
 //==============================================================
@@ -477,7 +449,7 @@ inline void tBody::AddBodyForce(const tVector3 & force)
 //==============================================================
 inline void tBody::AddBodyForce(const tVector3 & force, const tVector3 & pos)
 {
-  AddWorldForce(mTransform.orientation * force, mTransform.position + mTransform.orientation * pos);
+  AddWorldForce(Transform().orientation * force, Transform().position + Transform().orientation * pos);
 }
 
 //==============================================================
@@ -485,7 +457,7 @@ inline void tBody::AddBodyForce(const tVector3 & force, const tVector3 & pos)
 //==============================================================
 inline void tBody::AddBodyTorque(const tVector3 & torque)
 {
-  AddWorldTorque(mTransform.orientation * torque);
+  AddWorldTorque(Transform().orientation * torque);
 }
 
 //==============================================================
@@ -493,8 +465,8 @@ inline void tBody::AddBodyTorque(const tVector3 & torque)
 //==============================================================
 inline void tBody::ClearForces()
 {
-  mForce.SetTo(0.0f);
-  mTorque.SetTo(0.0f);
+  Force().SetTo(0.0f);
+  Torque().SetTo(0.0f);
 }
 
 //==============================================================
@@ -503,9 +475,9 @@ inline void tBody::ClearForces()
 inline void tBody::SetForceToGravity()
 {
   if (tPhysicsSystem::GetCurrentPhysicsSystem())
-    mForce = mMass * tPhysicsSystem::GetCurrentPhysicsSystem()->GetGravity();
+    Force() = mMass * tPhysicsSystem::GetCurrentPhysicsSystem()->GetGravity();
   else
-    mForce.SetTo(0.0f);
+    Force().SetTo(0.0f);
 }
 
 //========================================================
@@ -513,7 +485,7 @@ inline void tBody::SetForceToGravity()
 //========================================================
 inline void tBody::AddExternalForces(tScalar dt)
 {
-  mTorque.SetTo(0.0f);
+  Torque().SetTo(0.0f);
   SetForceToGravity();
 }
 
@@ -524,8 +496,8 @@ inline void tBody::AddExternalForces(tScalar dt)
 inline void tBody::CopyCurrentStateToOld()
 {
   TRACE_METHOD_ONLY(MULTI_FRAME_1);
-  mOldTransform = mTransform;
-  mOldTransformRate = mTransformRate;
+  OldTransform() = Transform();
+  OldTransformRate() = TransformRate();
 }
 
 //==============================================================
@@ -533,6 +505,12 @@ inline void tBody::CopyCurrentStateToOld()
 //==============================================================
 inline void tBody::SetConstraintsAndCollisionsUnsatisfied()
 {
+  // nothing can change an immovable body, so there's nothing to
+  // redo. Also, an immovable body can be shared between islands
+  // that are being solved at the same time.
+  if (Immovable())
+    return;
+
   for (size_t iConstraint = mConstraints.size() ; iConstraint-- != 0; )
     mConstraints[iConstraint]->SetUnsatisfied();
 
@@ -549,8 +527,8 @@ inline void tBody::SetConstraintsAndCollisionsUnsatisfied()
 //========================================================
 inline void tBody::StoreState()
 {
-  mStoredTransform = mTransform;
-  mStoredTransformRate = mTransformRate;
+  StoredTransform() = Transform();
+  StoredTransformRate() = TransformRate();
 }
 
 //========================================================
@@ -558,11 +536,9 @@ inline void tBody::StoreState()
 //========================================================
 inline void tBody::RestoreState()
 {
-  mTransform = mStoredTransform;
-  mTransformRate = mStoredTransformRate;
+  Transform() = StoredTransform();
+  TransformRate() = StoredTransformRate();
 
-  mInvOrientation = mTransform.orientation.GetTranspose();
   // recalculate the world inertia
-  mWorldInvInertia = mTransform.orientation * mBodyInvInertia * mInvOrientation;
-  mWorldInertia = mTransform.orientation * mBodyInertia * mInvOrientation;
+  mStateStore->UpdateWorldInertia(mStateIndex);
 }
@@ -0,0 +1,114 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file bodystatestore.hpp 
+//                     
+//==============================================================
+#ifndef JIGBODYSTATESTORE_HPP
+#define JIGBODYSTATESTORE_HPP
+
+#include "../maths/include/transform3.hpp"
+
+#include <vector>
+
+namespace JigLib
+{
+  /// Holds the state that the integrator works on (transforms,
+  /// velocities, forces, inertia) for a set of bodies, with one array
+  /// per quantity. The passes over all the bodies each step can then
+  /// be linear loops over just the data they need, rather than
+  /// chasing pointers to each body.
+  ///
+  /// Each tBody is a handle to a slot in a store. The physics system
+  /// has a store for its bodies, and a body that isn't in a physics
+  /// system uses a store of its own. Slots get moved when bodies are
+  /// added/removed, so references to body state are only valid until
+  /// then.
+  class tBodyStateStore
+  {
+  public:
+    tBodyStateStore();
+    ~tBodyStateStore();
+
+    /// Adds a slot for the body (initialised to be at rest at the
+    /// origin) and returns its index
+    unsigned AddBody(class tBody * body);
+
+    /// Removes the slot - the last slot gets moved into its place
+    void RemoveBody(unsigned index);
+
+    /// Moves the body in slot index to the other store
+    void MoveBody(unsigned index, tBodyStateStore & other);
+
+    unsigned GetNumBodies() const {return mBodies.size();}
+
+    //==============================================================
+    // Passes over all the bodies
+    //==============================================================
+
+    /// Copies the current state to the old for bodies that are active
+    /// or have had their velocity changed
+    void CopyAllCurrentStatesToOld();
+
+    /// Applies the forces and torques to the velocities of active,
+    /// movable bodies
+    void UpdateAllVelocities(tScalar dt);
+
+    /// Updates the positions of active, movable bodies using the
+    /// velocities plus the aux velocities, and zeros the aux
+    /// velocities. gravityAxis is from tPhysicsSystem.
+    void UpdateAllPositionsWithAux(tScalar dt, int gravityAxis);
+
+    /// Stops the velocities of active, movable bodies getting silly
+    void LimitAllVelocities();
+
+    /// Recalculates the world inertia from the orientation
+    void UpdateWorldInertia(unsigned index);
+
+  private:
+    friend class tBody;
+
+    void UpdateVelocity(unsigned index, tScalar dt);
+    void UpdatePositionWithAux(unsigned index, tScalar dt, int gravityAxis);
+
+    void Resize(unsigned num);
+    /// copies slot fromIndex of from into slot toIndex of this
+    void CopySlot(unsigned toIndex, const tBodyStateStore & from, unsigned fromIndex);
+
+    std::vector<class tBody *> mBodies;
+
+    /// the "working" state
+    std::vector<tTransform3> mTransforms;
+    std::vector<tTransform3Rate> mTransformRates;
+    std::vector<tTransform3Rate> mTransformRatesAux;
+
+    /// the previous state
+    std::vector<tTransform3> mOldTransforms;
+    std::vector<tTransform3Rate> mOldTransformRates;
+
+    /// stored state - used internally by physics during the updates
+    std::vector<tTransform3> mStoredTransforms;
+    std::vector<tTransform3Rate> mStoredTransformRates;
+
+    /// force and torque in world frame
+    std::vector<tVector3> mForces;
+    std::vector<tVector3> mTorques;
+
+    std::vector<tScalar> mInvMasses;
+    std::vector<tMatrix33> mBodyInertias;
+    std::vector<tMatrix33> mBodyInvInertias;
+    std::vector<tMatrix33> mWorldInertias;
+    std::vector<tMatrix33> mWorldInvInertias;
+
+    // flags - chars rather than bools so they can be written from
+    // different threads
+    std::vector<unsigned char> mActive;
+    std::vector<unsigned char> mImmovable;
+    /// set whenever the velocity might have been changed
+    std::vector<unsigned char> mVelChanged;
+  };
+}
+
+#endif
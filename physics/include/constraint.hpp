@@ -18,12 +18,19 @@ namespace JigLib
     tConstraint();
     virtual ~tConstraint();
     
-    /// register with the physics system
+    /// register with the current physics system (see
+    /// tPhysicsSystem::GetCurrentPhysicsSystem)
     void EnableConstraint();
 
+    /// register with physics - should be the one the bodies are in
+    void EnableConstraint(class tPhysicsSystem & physics);
+
     /// deregister from the physics system
     void DisableConstraint();
 
+    /// The physics system we're registered with, or 0
+    class tPhysicsSystem * GetPhysicsSystem() const {return mPhysicsSystem;}
+
     /// are we registered with the physics system?
     bool GetConstraintEnabled() const {return mConstraintEnabled;}
    
@@ -57,7 +64,12 @@ namespace JigLib
     
   private:
     bool mConstraintEnabled;
+    class tPhysicsSystem * mPhysicsSystem;
     bool mSatisfied;
+
+    /// Used by physics when it's building the islands - the first
+    /// body node that was found to use this constraint
+    int mIslandNode;
   };
 }
 
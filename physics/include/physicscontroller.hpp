@@ -20,12 +20,19 @@ namespace JigLib
     tPhysicsController();
     virtual ~tPhysicsController();
     
-    /// register with the physics system
+    /// register with the current physics system (see
+    /// tPhysicsSystem::GetCurrentPhysicsSystem)
     void EnableController();
 
+    /// register with physics
+    void EnableController(class tPhysicsSystem & physics);
+
     /// deregister from the physics system
     void DisableController();
 
+    /// The physics system we're registered with, or 0
+    class tPhysicsSystem * GetPhysicsSystem() const {return mPhysicsSystem;}
+
     /// are we registered with the physics system?
     bool GetControllerEnabled() const {return mControllerEnabled;}
 
@@ -37,6 +44,7 @@ namespace JigLib
     
   private:
     bool mControllerEnabled;
+    class tPhysicsSystem * mPhysicsSystem;
   };
 }
 
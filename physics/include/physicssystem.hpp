@@ -12,8 +12,10 @@
 #include "../maths/include/vector3.hpp"
 #include "../maths/include/matrix33.hpp"
 #include "../collision/include/collisioninfo.hpp"
+#include "../utils/include/pairhashmap.hpp"
+#include "../physics/include/bodystatestore.hpp"
 
-#include <map>
+#include <vector>
 
 namespace JigLib
 {
@@ -24,17 +26,24 @@ namespace JigLib
   /// In the vast majority of cases there will be only one physics system,
   /// and it is consequently very annoying if every object has to keep
   /// track of which physics system it's associated with. Therefore,
-  /// tPhysicsSystem supports a "singleton" style use, but it also lets
-  /// the user change the "current" physics system (bad things will
-  /// happen if you set it to zero whilst there are still physical objects!).
-  /// 
-  /// If you want more than one physics system, then in your update loop set
-  /// the physics system to the first one, run physics, then set it to
-  /// the second one etc.
+  /// tPhysicsSystem supports a "singleton" style use: bodies,
+  /// constraints and controllers that are enabled without saying which
+  /// system to use go into the "current" one. After that they remember
+  /// which system they are in, so changing the current system doesn't
+  /// affect them.
+  ///
+  /// The current system is per-thread. The constructor makes the new
+  /// system current for the thread that creates it, the destructor
+  /// clears it if it is still current, and Integrate makes the system
+  /// current whilst it runs.
   /// 
-  /// Note that the physics system constructor and destructor will set the
-  /// current physics system variable, so under normal circumstances you don't
-  /// need to worry about this.
+  /// If you want more than one physics system then either pass the
+  /// system explicitly (e.g. tBody::EnableBody(physics)), or set the
+  /// current system before creating/enabling objects for it. Separate
+  /// systems share nothing (a body that isn't enabled keeps its own
+  /// state), so they can be integrated at the same time on different
+  /// threads as long as each one's objects are only touched by the
+  /// thread running it.
   class tPhysicsSystem
   {
   public:
@@ -52,6 +61,13 @@ namespace JigLib
       mCollisionSystem = coll;}
     class tCollisionSystem * GetCollisionSystem() const {
       return mCollisionSystem;}
+
+    /// If there's a thread pool then the islands get solved in
+    /// parallel over it. The pool isn't owned by the physics
+    /// system. Zero (the default) means solve everything in this
+    /// thread.
+    void SetThreadPool(class tThreadPool * pool) {mThreadPool = pool;}
+    class tThreadPool * GetThreadPool() const {return mThreadPool;}
     
     /// Integrates the system forwards by dt - the caller is
     /// responsible for making sure that repeated calls to this use
@@ -71,8 +87,19 @@ namespace JigLib
     void SetAllowedPenetration(tScalar dist) {mAllowedPenetration = dist;}
     void SetDoShockStep(bool shock) {mDoShockStep = shock;}
     void SetCollToll(tScalar toll) {mCollToll = toll;}
-    enum tSolverType {SOLVER_FAST, SOLVER_NORMAL, SOLVER_COMBINED, SOLVER_ACCUMULATED};
+    /// SOLVER_BATCHED is SOLVER_ACCUMULATED with the contacts split
+    /// into batches that don't share bodies, so that each batch can be
+    /// solved over the thread pool. Helps with big islands like stacks.
+    enum tSolverType {SOLVER_FAST, SOLVER_NORMAL, SOLVER_COMBINED, SOLVER_ACCUMULATED, SOLVER_BATCHED};
     void SetSolverType(tSolverType type) {mSolverType = type;}
+    /// Bodies that move more than this fraction of their size (the
+    /// radius of their thinnest primitive) in a step get swept from
+    /// their old to their new position at the end of the step. If
+    /// they would have passed through something they get stopped
+    /// just after touching it, so fast things don't tunnel without
+    /// needing a small timestep. Zero (the default) disables it.
+    void SetCCDMotionThreshold(tScalar fraction) {mCCDMotionThreshold = fraction;}
+    tScalar GetCCDMotionThreshold() const {return mCCDMotionThreshold;}
 		/// if nullUpdate then all updates will use dt = 0 (for debugging/profiling)
 		void SetNullUpdate(bool nullUpdate) {mNullUpdate = nullUpdate;}
 
@@ -124,6 +151,23 @@ namespace JigLib
     bool RemoveController(class tPhysicsController * controller);
 
   private:
+    typedef std::vector<class tBody *> tBodies;
+    typedef std::vector<tCollisionInfo *> tCollisions;
+    typedef std::vector<class tConstraint *> tConstraints;
+    typedef std::vector<class tPhysicsController *> tControllers;
+    
+    /// A group of bodies connected through collisions and/or
+    /// constraints. Nothing that happens in one island during the
+    /// collision/constraint handling can affect another, so they can
+    /// be solved separately, and they go to sleep and wake up as a
+    /// unit.
+    struct tIsland
+    {
+      tBodies mBodies;
+      tCollisions mCollisions;
+      tConstraints mConstraints;
+    };
+
     // functions working on multiple bodies etc
     void FindAllActiveBodies();
     void HandleAllConstraints(tScalar dt, unsigned iter, bool forceInelastic);
@@ -136,13 +180,64 @@ namespace JigLib
     void NotifyAllPostPhysics(tScalar dt);
     void TryToFreezeAllObjects(tScalar dt);
     void DampAllActiveBodies();
-    void TryToActivateAllFrozenObjects();
+    /// Splits the bodies up into islands using the collisions and
+    /// constraints we've got this step
+    void FormAllIslands();
     /// try to activate frozen objects that are affected by a touching
     /// active object moving away from them
     void ActivateAllFrozenObjectsLeftHanging();
     void LimitAllVelocities();
+    /// Sweeps the bodies that have moved too far this step - see
+    /// SetCCDMotionThreshold
+    void HandleAllFastBodies();
+    void HandleFastBody(class tBody & body, tScalar shrink);
     
     // ======== helpers for individual cases =========
+
+    /// Activates any frozen bodies in the list that have been given
+    /// a reasonable velocity
+    void TryToActivateFrozenObjects(const tBodies & bodies);
+
+    /// Does the collision/constraint iterations for just one
+    /// island. If activateFrozen then frozen bodies in the island
+    /// that get knocked are woken up as we go (which isn't safe when
+    /// other islands are being solved at the same time).
+    void HandleIslandConstraints(tIsland & island, tScalar dt, unsigned iter, 
+                                 bool forceInelastic, bool activateFrozen);
+
+    /// Job for solving islands on the thread pool
+    class tIslandJob;
+    /// Puts the islands with the most work first
+    struct tMoreIslandWork;
+
+    /// The contact iterations for SOLVER_BATCHED
+    void HandleAllContactsBatched(tScalar dt, unsigned iter);
+    /// Sorts mContactsToBatch into mBatchedContacts
+    void ColourContacts();
+    /// Pre-processes or solves the contacts in a batch, returning true
+    /// if any impulses were applied
+    bool RunContactBatch(unsigned iBatch, tScalar dt, bool preProcess);
+    /// Pre-processes or solves contact i of mBatchedContacts, putting
+    /// the result in mBatchedContactResults
+    void ProcessBatchedContact(unsigned i, tScalar dt, bool preProcess);
+    /// Job for solving a batch on the thread pool
+    class tContactBatchJob;
+
+    /// Freezes all the bodies in the island, and links them so that
+    /// they'll all get woken together
+    void FreezeIsland(tIsland & island);
+
+    /// Wakes up anything that went to sleep in the same island as body
+    void WakeSleepingIsland(class tBody * body);
+
+    /// Removes body from any sleeping island it's in
+    void UnlinkSleepingBody(class tBody * body);
+
+    /// Helpers for building the islands
+    int GetIslandNode(const class tBody * body) const;
+    int FindIslandRoot(int node);
+    void JoinIslandNodes(int node0, int node1);
+    tIsland & GetIsland(int & islandIndex);
     
     /// Handle an individual collision by classifying it, calculating
     /// impulse, applying impulse and updating the velocities of the
@@ -157,6 +252,10 @@ namespace JigLib
                               tScalar dt,
                               bool firstContact);
 
+    /// The impulses of ProcessCollisionAccumulated - shared with the
+    /// batched solver
+    static bool ApplyAccumulatedImpulses(tCollisionInfo * collision);
+
     /// Accumulated and clamp impulses
     bool ProcessCollisionAccumulated(tCollisionInfo * collision, 
                                      tScalar dt,
@@ -187,14 +286,30 @@ namespace JigLib
 
     class tCollisionSystem * mCollisionSystem;
     
-    typedef std::vector<class tBody *> tBodies;
-    typedef std::vector<tCollisionInfo *> tCollisions;
-    typedef std::vector<class tConstraint *> tConstraints;
-    typedef std::vector<class tPhysicsController *> tControllers;
-    
     tBodies mBodies;
     tBodies mActiveBodies;
+    /// the state of all of mBodies - the integration passes go
+    /// through this
+    tBodyStateStore mBodyStates;
+
+    /// Contacts that need more colours than this go in a final batch
+    /// that gets solved serially
+    enum {MAX_CONTACT_COLOURS = 64};
+    /// The contacts (and constraints) being solved by SOLVER_BATCHED
+    tCollisions mContactsToBatch;
+    tConstraints mBatchedConstraints;
+    /// mContactsToBatch sorted by batch - batch i is from
+    /// mBatchStarts[i] up to mBatchStarts[i+1]
+    tCollisions mBatchedContacts;
+    std::vector<unsigned> mBatchStarts;
+    std::vector<unsigned char> mBatchedContactResults;
+    /// scratch for the colouring
+    std::vector<unsigned long long> mBodyColours;
+    std::vector<unsigned> mContactColours;
     tCollisions mCollisions;
+    /// mCollisions (and their points) live here until the next
+    /// DetectAllCollisions
+    tFrameArena mCollisionArena;
     tConstraints mConstraints;
     tControllers mControllers;
     
@@ -208,6 +323,26 @@ namespace JigLib
       tVector3 angVel;
     };
     std::vector<tStoredData> mStoredData;
+
+    /// we don't shrink this, to keep the memory in the lists - only
+    /// the first mNumIslands are in use.
+    std::vector<tIsland> mIslands;
+    unsigned mNumIslands;
+    /// Island holding collisions/constraints that don't involve any
+    /// movable bodies, and collisions picked up by activating bodies
+    /// that aren't in any island. -1 if there isn't one this step.
+    int mLooseIsland;
+    /// union-find parent for each body whilst building islands
+    std::vector<int> mIslandParents;
+    /// island index for each root body whilst building islands
+    std::vector<int> mIslandOfRoot;
+    /// islands to be solved in parallel, biggest first
+    std::vector<unsigned> mIslandOrder;
+    /// counts calls to HandleAllConstraints so each island can
+    /// alternate its processing direction from one to the next
+    unsigned mNumConstraintPasses;
+
+    class tThreadPool * mThreadPool;
     
     /// Our idea of time
     tScalar mTargetTime;
@@ -227,6 +362,9 @@ namespace JigLib
     /// the tolerance for collision detection - depends on the typical scales 
     /// used in the system.
     tScalar mCollToll;
+
+    /// See SetCCDMotionThreshold
+    tScalar mCCDMotionThreshold;
     
     /// Solver type (can get changed on the fly)
     tSolverType mSolverType;
@@ -247,40 +385,37 @@ namespace JigLib
     /// be added etc).
     bool mDoingIntegration;
 
-    /// The current system - sort-of singleton support.
-    static tPhysicsSystem * mCurrentPhysicsSystem;
+    /// The current system for each thread - sort-of singleton support.
+    static thread_local tPhysicsSystem * mCurrentPhysicsSystem;
 
-    struct tBodyPair
+    /// A contact point from the last step, kept so that its impulses
+    /// can warm start the accumulated solver
+    struct tCachedContact
     {
-      /// only the bodies are used for the comparison
-      /// Note that bodyB is likely to be 0
-      tBodyPair(const class tBody *bodyA, const class tBody *bodyB, const tVector3 &rA, const tVector3 &rB) 
-      {
-        if (bodyA > bodyB) {mBodyA = bodyA; mBodyB = bodyB; mRA = rA;}
-        else {mBodyA = bodyB; mBodyB = bodyA; mRA = rB;}
-      }
-      bool operator<(const tBodyPair &other) const
-      {
-        if (mBodyA < other.mBodyA) return true;
-        else if (mBodyA > other.mBodyA) return false;
-        if (mBodyB < other.mBodyB) return true;
-        else return false;
-      }
-      const class tBody * mBodyA;
-      const class tBody * mBodyB;
-      /// position relative to mBodyA in world space
-      tVector3 mRA;
-    };
-    struct tCachedImpulses
-    {
-      tCachedImpulses(tScalar normalImpulse, tScalar normalImpulseAux, const tVector3 &frictionImpulse) 
-        : mNormalImpulse(normalImpulse), mNormalImpulseAux(normalImpulseAux), mFrictionImpulse(frictionImpulse) {}
+      /// positions in the body space of each skin's owner (world space
+      /// if there isn't one)
+      tVector3 mLocalPos0;
+      tVector3 mLocalPos1;
       tScalar mNormalImpulse;
       tScalar mNormalImpulseAux;
+      /// world space, acting on the owner of the first skin
       tVector3 mFrictionImpulse;
     };
-    /// Some solver methods cache a "typical" contact inpulse between body pairs to warm start
-    std::multimap<tBodyPair, tCachedImpulses> mCachedContacts;
+    enum {MAX_CACHED_CONTACTS = 2 * tCollisionInfo::MAX_COLLISION_POINTS};
+    /// All the contacts between a pair of skins
+    struct tContactManifold
+    {
+      tContactManifold() : mFrame(0) {}
+      tFixedVector<tCachedContact, MAX_CACHED_CONTACTS> mContacts;
+      /// manifolds that didn't get updated on the last step are removed
+      unsigned mFrame;
+    };
+    /// Contact manifolds for the accumulated solver, persisting from
+    /// one step to the next. The key is the pair of skins, with the
+    /// higher address first. Skins are only used as keys, never
+    /// dereferenced.
+    tPairHashMap<tContactManifold> mContactManifolds;
+    unsigned mContactCacheFrame;
     void UpdateContactCache();
 
     typedef bool (tPhysicsSystem::*tProcessCollisionFn)(tCollisionInfo * collision, 
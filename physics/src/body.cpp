@@ -13,45 +13,48 @@
 using namespace JigLib;
 using namespace std;
 
-tScalar tBody::mVelMax = SCALAR(100.0f);
-tScalar tBody::mAngVelMax = SCALAR(50.0f);
-
-
 //==============================================================
 // tBody
 //==============================================================
 tBody::tBody()
 {
   TRACE_METHOD_ONLY(ONCE_2);
+  // our state lives in our own store until we're enabled
+  mStateStore = &mOwnStateStore;
+  mStateIndex = mOwnStateStore.AddBody(this);
+
   mBodiesToBeActivatedOnMovement.reserve(8);
   mBodyEnabled = false;
+  mPhysicsSystem = 0;
   mCollSkin = 0;
   
   SetMass(SCALAR(1.0f));
   SetBodyInertia(SCALAR(1.0f), SCALAR(1.0f), SCALAR(1.0f));
   
-  mTransform.position.SetTo(SCALAR(0.0f));
+  Transform().position.SetTo(SCALAR(0.0f));
   SetOrientation(tMatrix33::Identity());
-  mTransformRate.SetToZero();
-  mTransformRateAux.SetToZero();
+  TransformRate().SetToZero();
+  TransformRateAux().SetToZero();
   
-  mImmovable = false;
+  Immovable() = false;
   mOrigImmovable = false;
   mDoShockProcessing = true;
 
-  mForce.SetTo(SCALAR(0.0f));
-  mTorque.SetTo(SCALAR(0.0f));
+  Force().SetTo(SCALAR(0.0f));
+  Torque().SetTo(SCALAR(0.0f));
   
-  mVelChanged = true;
+  VelChanged() = true;
 
-  mActivity = ACTIVE;
+  Active() = true;
   mInactiveTime = SCALAR(0.0f);
   mDeactivationTime = SCALAR(1.0f);
   SetActivityThreshold(SCALAR(0.5f), SCALAR(30.0f));
   SetDeactivationThreshold(SCALAR(0.1f), SCALAR(0.2f));
   mAllowFreezing = true;
-  mLastPositionForDeactivation = mTransform.position;
-  mLastOrientationForDeactivation = mTransform.orientation;
+  mLastPositionForDeactivation = Transform().position;
+  mLastOrientationForDeactivation = Transform().orientation;
+  mIslandNode = -1;
+  mNextSleepingBody = this;
   
   CopyCurrentStateToOld();
 }
@@ -75,6 +78,8 @@ tBody::~tBody()
 
   // don't care if this fails
   DisableBody();
+
+  mStateStore->RemoveBody(mStateIndex);
 }
 
 
@@ -84,7 +89,7 @@ tBody::~tBody()
 void tBody::SetMass(tScalar mass)
 {
   mMass = mass;
-  mInvMass = SafeInvScalar(mMass);
+  InvMass() = SafeInvScalar(mMass);
   SetForceToGravity();
 }
 
@@ -93,8 +98,8 @@ void tBody::SetMass(tScalar mass)
 //==============================================================
 void tBody::SetInvMass(tScalar invMass)
 {
-  mInvMass = invMass;
-  mMass = SafeInvScalar(mInvMass);
+  InvMass() = invMass;
+  mMass = SafeInvScalar(InvMass());
   SetForceToGravity();
 }
 
@@ -103,8 +108,8 @@ void tBody::SetInvMass(tScalar invMass)
 //==============================================================
 void tBody::SetBodyInertia(const tMatrix33 &bodyInertia)
 {
-  mBodyInertia = bodyInertia;
-  mBodyInvInertia = bodyInertia.GetInverted();
+  BodyInertia() = bodyInertia;
+  BodyInvInertia() = bodyInertia.GetInverted();
 }
 
 
@@ -113,15 +118,15 @@ void tBody::SetBodyInertia(const tMatrix33 &bodyInertia)
 //==============================================================
 void tBody::SetBodyInertia(tScalar Ixx, tScalar Iyy, tScalar Izz)
 {
-  mBodyInertia.SetTo(SCALAR(0.0f));
-  mBodyInertia(0, 0) = Ixx;
-  mBodyInertia(1, 1) = Iyy;
-  mBodyInertia(2, 2) = Izz;
+  BodyInertia().SetTo(SCALAR(0.0f));
+  BodyInertia()(0, 0) = Ixx;
+  BodyInertia()(1, 1) = Iyy;
+  BodyInertia()(2, 2) = Izz;
   
-  mBodyInvInertia.SetTo(SCALAR(0.0f));
-  mBodyInvInertia(0, 0) = SafeInvScalar(Ixx);
-  mBodyInvInertia(1, 1) = SafeInvScalar(Iyy);
-  mBodyInvInertia(2, 2) = SafeInvScalar(Izz);
+  BodyInvInertia().SetTo(SCALAR(0.0f));
+  BodyInvInertia()(0, 0) = SafeInvScalar(Ixx);
+  BodyInvInertia()(1, 1) = SafeInvScalar(Iyy);
+  BodyInvInertia()(2, 2) = SafeInvScalar(Izz);
 }
 
 //==============================================================
@@ -131,219 +136,17 @@ void tBody::SetBodyInvInertia(tScalar invIxx,
                               tScalar invIyy, 
                               tScalar invIzz)
 {
-  mBodyInvInertia.SetTo(SCALAR(0.0f));
-  mBodyInvInertia(0, 0) = invIxx;
-  mBodyInvInertia(1, 1) = invIyy;
-  mBodyInvInertia(2, 2) = invIzz;
-  
-  mBodyInertia.SetTo(SCALAR(0.0f));
-  mBodyInertia(0, 0) = SafeInvScalar(invIxx);
-  mBodyInertia(1, 1) = SafeInvScalar(invIyy);
-  mBodyInertia(2, 2) = SafeInvScalar(invIzz);
-}
-
-//==============================================================
-// UpdateVelocity
-//==============================================================
-void tBody::UpdateVelocity(tScalar dt)
-{
-  TRACE_METHOD_ONLY(MULTI_FRAME_1);
-  if (mImmovable || !IsActive())
-    return;
-
-#ifdef CHECK_RIGID_BODY
-  tVector3 origVelocity = mTransformRate.velocity;
-  tVector3 origAngVel = mTransformRate.angVelocity;
-#endif
-  
-  mTransformRate.velocity += (dt * mInvMass) * mForce ;
-  // don't quite get this - calculating angMom from angVel, then applying torque to that, then
-  // converting back just results in the simple equation anyway. The extra term just produces
-  // weirdness...
-//#define INCLUDE_GYROSCOPIC_TERM
-#ifdef INCLUDE_GYROSCOPIC_TERM
-  tVector3 angMom = mWorldInertia * mTransformRate.angVelocity;
-  mTransformRate.angVelocity += mWorldInvInertia * dt * (mTorque - Cross(mTransformRate.angVelocity, mWorldInertia * mTransformRate.angVelocity));
-//  mTransformRate.angVelocity += mWorldInvInertia * (dt * mTorque);
-  TRACE("%5.2f %5.2f %5.2f\n", angMom.x, angMom.y, angMom.z);
-#else
-  mTransformRate.angVelocity += mWorldInvInertia * (dt * mTorque);
-#endif
-
-  /// TODO implement rotational friction properly
-//  if (mCollSkin && 
-//      (mCollSkin->GetCollisions().size() >= 1) &&
-//      (Abs(Dot(mCollSkin->GetCollisions()[0]->mDirToBody0, mTransformRate.angVelocity.GetNormalisedSafe())) > SCALAR(0.6f)) )
-//    mTransformRate.angVelocity *= SCALAR(0.99f);
-  if (mCollSkin && mCollSkin->GetCollisions().size() >= 1)
-    mTransformRate.angVelocity *= SCALAR(0.99f);
-#ifdef CHECK_RIGID_BODY
-  // check the result, and roll-back if needed
-  if (!mTransformRate.velocity.IsSensible())
-  {
-    TRACE("Velocity is not sensible: this = %p\n", this);
-    origVelocity.Show("orig vel");
-    mForce.Show("force");
-    mTransformRate.velocity.Show("velocity");
-    while (1) {DummyFnForMSVC();}
-    mTransformRate.velocity = origVelocity;
-  }
-  
-  if (!mTransformRate.angVelocity.IsSensible())
-  {
-    TRACE("rotation is not sensible: this = %p\n-", this);
-    mTransformRate.angVelocity.Show("rotation");
-    origAngVel.Show("orig");
-    mTorque.Show("torque");
-    mWorldInvInertia.Show("inv world inertia");
-    while (1) {DummyFnForMSVC();}
-    mTransformRate.angVelocity = origAngVel;
-  }
-#endif
-}
-
-//==============================================================
-// UpdatePosition
-//==============================================================
-void tBody::UpdatePosition(tScalar dt)
-{
-  TRACE_METHOD_ONLY(MULTI_FRAME_1);
-
-  if (mImmovable || !IsActive())
-    return;
-  
-#ifdef CHECK_RIGID_BODY
-  // in case something goes wrong...
-  tVector3 origPosition = mTransform.position;
-  tMatrix33 origOrientation = mTransform.orientation;
-#endif
-
-  tVector3 angMomBefore = mWorldInertia * mTransformRate.angVelocity;
-  ApplyTransformRate(mTransform, mTransformRate, dt);
-
-  mInvOrientation = mTransform.orientation.GetTranspose();
-  // recalculate the world inertia
-  mWorldInvInertia = mTransform.orientation * mBodyInvInertia * mInvOrientation;
-  mWorldInertia = mTransform.orientation * mBodyInertia * mInvOrientation;
+  BodyInvInertia().SetTo(SCALAR(0.0f));
+  BodyInvInertia()(0, 0) = invIxx;
+  BodyInvInertia()(1, 1) = invIyy;
+  BodyInvInertia()(2, 2) = invIzz;
   
-  // conservation of momentum
-  mTransformRate.angVelocity = mWorldInvInertia * angMomBefore;
-
-  TRACE_FILE_IF(MULTI_FRAME_1)
-    mTransform.position.Show("Body position");
-  
-#ifdef CHECK_RIGID_BODY
-  // check the result, and roll-back if needed
-  // hmmm probably due to velocity/ration being screwed, so reset them
-  if (!mTransform.position.IsSensible())
-  {
-    TRACE("Position is not sensible: this = %p", this);
-    mTransform.position.Show("position");
-    origPosition.Show("orig position");
-    mTransformRate.velocity.Show("velocity");
-    while (1) {DummyFnForMSVC();}
-    mTransform.position = origPosition;
-    mTransform.orientation = origOrientation;
-    mTransformRate.velocity.SetTo(SCALAR(0.0f));
-    mTransformRate.angVelocity.SetTo(SCALAR(0.0f));
-  }
-  if (!mTransform.orientation.IsSensible())
-  {
-    TRACE("Orientation is not sensible: this = %p", this);
-    mTransform.orientation.Show("orientation");
-    origOrientation.Show("orig orientation");
-    mTransformRate.angVelocity.Show("ang vel");
-    while (1) {DummyFnForMSVC();}
-    mTransform.orientation = origOrientation;
-    mTransform.position = origPosition;
-    mTransformRate.velocity.SetTo(SCALAR(0.0f));
-    mTransformRate.angVelocity.SetTo(SCALAR(0.0f));
-  }
-#endif
-  
-  
-  tCollisionSkin * collSkin = GetCollisionSkin();
-  if ( collSkin )
-    collSkin->SetTransform(mOldTransform, mTransform);
+  BodyInertia().SetTo(SCALAR(0.0f));
+  BodyInertia()(0, 0) = SafeInvScalar(invIxx);
+  BodyInertia()(1, 1) = SafeInvScalar(invIyy);
+  BodyInertia()(2, 2) = SafeInvScalar(invIzz);
 }
 
-//==============================================================
-// UpdatePositionWithAux
-//==============================================================
-void tBody::UpdatePositionWithAux(tScalar dt)
-{
-  TRACE_METHOD_ONLY(MULTI_FRAME_1);
-
-  if (mImmovable || !IsActive())
-  {
-    mTransformRateAux.SetToZero();
-    return;
-  }
-
-#ifdef CHECK_RIGID_BODY
-  // in case something goes wrong...
-  tVector3 origPosition = mTransform.position;
-  tMatrix33 origOrientation = mTransform.orientation;
-#endif
-
-  tPhysicsSystem * physics = tPhysicsSystem::GetCurrentPhysicsSystem();
-  int ga = physics->GetMainGravityAxis();
-  if (ga != -1)
-  {
-    mTransformRateAux.velocity[(ga+1)%3] *= 0.1f;
-    mTransformRateAux.velocity[(ga+2)%3] *= 0.1f;
-  }
-  tVector3 angMomBefore = mWorldInertia * mTransformRate.angVelocity;
-  ApplyTransformRate(mTransform, mTransformRate + mTransformRateAux, dt);
-  mTransformRateAux.SetToZero();
-
-  mInvOrientation = mTransform.orientation.GetTranspose();
-  // recalculate the world inertia
-  mWorldInvInertia = mTransform.orientation * mBodyInvInertia * mInvOrientation;
-  mWorldInertia = mTransform.orientation * mBodyInertia * mInvOrientation;
-  
-  // conservation of momentum
-  mTransformRate.angVelocity = mWorldInvInertia * angMomBefore;
-
-  TRACE_FILE_IF(MULTI_FRAME_1)
-    mTransform.position.Show("Body position");
-  
-#ifdef CHECK_RIGID_BODY
-  // check the result, and roll-back if needed
-  // hmmm probably due to velocity/rotation being screwed, so reset them
-  if (!mTransform.position.IsSensible())
-  {
-    TRACE("Position is not sensible: this = %p\n", this);
-    mTransform.position.Show("position");
-    origPosition.Show("orig position");
-    mTransformRate.velocity.Show("velocity");
-    while (1) {DummyFnForMSVC();}
-    mTransform.position = origPosition;
-    mTransform.orientation = origOrientation;
-    mTransformRate.velocity.SetTo(SCALAR(0.0f));
-    mTransformRate.angVelocity.SetTo(SCALAR(0.0f));
-  }
-  if (!mTransform.orientation.IsSensible())
-  {
-    TRACE("Orientation is not sensible: this = %p\n", this);
-    mTransform.orientation.Show("orientation");
-    origOrientation.Show("orig orientation");
-    mTransformRate.angVelocity.Show("ang vel");
-    while (1) {DummyFnForMSVC();}
-    mTransform.orientation = origOrientation;
-    mTransform.position = origPosition;
-    mTransformRate.velocity.SetTo(SCALAR(0.0f));
-    mTransformRate.angVelocity.SetTo(SCALAR(0.0f));
-  }
-#endif
-  
-  
-  tCollisionSkin * collSkin = GetCollisionSkin();
-  if ( collSkin )
-    collSkin->SetTransform(mOldTransform, mTransform);
-}
-
-
 //==============================================================
 // StateToStr
 //==============================================================
@@ -390,15 +193,15 @@ void tBody::SetDeactivationThreshold(tScalar posThreshold,
 void tBody::SetActive(tScalar activityFactor)
 {
   TRACE_METHOD_ONLY(FRAME_2);
-  tPhysicsSystem * physics = tPhysicsSystem::GetCurrentPhysicsSystem();
-  static bool recursing = false;
-  if (physics && !recursing)
+  // ActivateObject calls back here
+  thread_local bool recursing = false;
+  if (mPhysicsSystem && !recursing)
   {
     recursing = true;
-    physics->ActivateObject(this);
+    mPhysicsSystem->ActivateObject(this);
     recursing = false;
   }
-  mActivity = ACTIVE;
+  Active() = true;
   mInactiveTime = (SCALAR(1.0f) - activityFactor) * mDeactivationTime;
 }
 
@@ -407,8 +210,20 @@ void tBody::SetActive(tScalar activityFactor)
 //==============================================================
 void tBody::SetInactive()
 {
-  if (mAllowFreezing && tPhysicsSystem::GetCurrentPhysicsSystem()->IsFreezingEnabled())
-    mActivity = INACTIVE;
+  if (mAllowFreezing && mPhysicsSystem && mPhysicsSystem->IsFreezingEnabled())
+    Active() = false;
+}
+
+//==============================================================
+// Freeze
+//==============================================================
+void tBody::Freeze()
+{
+  if (!IsActive())
+    return;
+  mLastOrientationForDeactivation = Transform().orientation;
+  mLastPositionForDeactivation = Transform().position;
+  SetInactive();
 }
 
 //==============================================================
@@ -424,8 +239,8 @@ void tBody::DampForDeactivation()
 
   tScalar scale = SCALAR(1.0f) - ((frac - r) / (SCALAR(1.0f) - r));
   Limit(scale, SCALAR(0.0f), SCALAR(1.0f));
-  mTransformRate.velocity *= scale;
-  mTransformRate.angVelocity *= scale;
+  TransformRate().velocity *= scale;
+  TransformRate().angVelocity *= scale;
 }
 
 //==============================================================
@@ -446,8 +261,8 @@ void tBody::MoveTo(const tVector3 & pos, const tMatrix33 & orientation)
   TRACE_METHOD_ONLY(FRAME_2);
   if (mBodyEnabled && !IsActive())
   {
-    Assert(tPhysicsSystem::GetCurrentPhysicsSystem());
-    tPhysicsSystem::GetCurrentPhysicsSystem()->ActivateObject(this);
+    Assert(mPhysicsSystem);
+    mPhysicsSystem->ActivateObject(this);
   }
   SetPosition(pos);
   SetOrientation(orientation);
@@ -456,7 +271,7 @@ void tBody::MoveTo(const tVector3 & pos, const tMatrix33 & orientation)
   CopyCurrentStateToOld();
   tCollisionSkin * collSkin = GetCollisionSkin();
   if ( collSkin )
-    collSkin->SetTransform(mOldTransform, mTransform);
+    collSkin->SetTransform(OldTransform(), Transform());
 }
 
 //==============================================================
@@ -466,9 +281,19 @@ void tBody::EnableBody()
 {
   TRACE_METHOD_ONLY(ONCE_2);
   if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
+  EnableBody(*tPhysicsSystem::GetCurrentPhysicsSystem());
+}
+
+//==============================================================
+// Enable
+//==============================================================
+void tBody::EnableBody(tPhysicsSystem & physics)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
   if (true == mBodyEnabled) return;
   mBodyEnabled = true;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->AddBody(this);
+  mPhysicsSystem = &physics;
+  physics.AddBody(this);
 }
 
 //==============================================================
@@ -477,10 +302,10 @@ void tBody::EnableBody()
 void tBody::DisableBody()
 {
   TRACE_METHOD_ONLY(ONCE_2);
-  if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
   if (false == mBodyEnabled) return;
   mBodyEnabled = false;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->RemoveBody(this);
+  mPhysicsSystem->RemoveBody(this);
+  mPhysicsSystem = 0;
 }
 
 //==============================================================
@@ -508,8 +333,8 @@ void tBody::RemoveConstraint(class tConstraint * constraint)
 //==============================================================
 void tBody::SetImmovable(bool immovable)
 {
-  mImmovable = immovable; 
-  mOrigImmovable = mImmovable;
+  Immovable() = immovable; 
+  mOrigImmovable = Immovable();
   SetInvMass(SCALAR(0.0f)); 
   SetBodyInvInertia(SCALAR(0.0f), SCALAR(0.0f), SCALAR(0.0f));
 }
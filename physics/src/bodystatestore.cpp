@@ -0,0 +1,321 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file bodystatestore.cpp 
+//                     
+//==============================================================
+#include "bodystatestore.hpp"
+#include "body.hpp"
+#include "collisionskin.hpp"
+
+using namespace JigLib;
+using namespace std;
+
+// Helper to stop the velocities getting silly
+static const tScalar velMax = SCALAR(100.0f);
+static const tScalar angVelMax = SCALAR(50.0f);
+
+//==============================================================
+// tBodyStateStore
+//==============================================================
+tBodyStateStore::tBodyStateStore()
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+}
+
+//==============================================================
+// ~tBodyStateStore
+//==============================================================
+tBodyStateStore::~tBodyStateStore()
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+}
+
+//==============================================================
+// Resize
+//==============================================================
+void tBodyStateStore::Resize(unsigned num)
+{
+  mBodies.resize(num);
+  mTransforms.resize(num);
+  mTransformRates.resize(num);
+  mTransformRatesAux.resize(num);
+  mOldTransforms.resize(num);
+  mOldTransformRates.resize(num);
+  mStoredTransforms.resize(num);
+  mStoredTransformRates.resize(num);
+  mForces.resize(num);
+  mTorques.resize(num);
+  mInvMasses.resize(num);
+  mBodyInertias.resize(num);
+  mBodyInvInertias.resize(num);
+  mWorldInertias.resize(num);
+  mWorldInvInertias.resize(num);
+  mActive.resize(num);
+  mImmovable.resize(num);
+  mVelChanged.resize(num);
+}
+
+//==============================================================
+// CopySlot
+//==============================================================
+void tBodyStateStore::CopySlot(unsigned i, const tBodyStateStore & from, unsigned j)
+{
+  mBodies[i] = from.mBodies[j];
+  mTransforms[i] = from.mTransforms[j];
+  mTransformRates[i] = from.mTransformRates[j];
+  mTransformRatesAux[i] = from.mTransformRatesAux[j];
+  mOldTransforms[i] = from.mOldTransforms[j];
+  mOldTransformRates[i] = from.mOldTransformRates[j];
+  mStoredTransforms[i] = from.mStoredTransforms[j];
+  mStoredTransformRates[i] = from.mStoredTransformRates[j];
+  mForces[i] = from.mForces[j];
+  mTorques[i] = from.mTorques[j];
+  mInvMasses[i] = from.mInvMasses[j];
+  mBodyInertias[i] = from.mBodyInertias[j];
+  mBodyInvInertias[i] = from.mBodyInvInertias[j];
+  mWorldInertias[i] = from.mWorldInertias[j];
+  mWorldInvInertias[i] = from.mWorldInvInertias[j];
+  mActive[i] = from.mActive[j];
+  mImmovable[i] = from.mImmovable[j];
+  mVelChanged[i] = from.mVelChanged[j];
+}
+
+//==============================================================
+// AddBody
+//==============================================================
+unsigned tBodyStateStore::AddBody(tBody * body)
+{
+  const unsigned i = mBodies.size();
+  Resize(i + 1);
+  mBodies[i] = body;
+  mTransforms[i].position.SetTo(SCALAR(0.0f));
+  mTransforms[i].orientation = tMatrix33::Identity();
+  mTransformRates[i].SetToZero();
+  mTransformRatesAux[i].SetToZero();
+  mOldTransforms[i] = mTransforms[i];
+  mOldTransformRates[i] = mTransformRates[i];
+  mStoredTransforms[i] = mTransforms[i];
+  mStoredTransformRates[i] = mTransformRates[i];
+  mForces[i].SetTo(SCALAR(0.0f));
+  mTorques[i].SetTo(SCALAR(0.0f));
+  mInvMasses[i] = SCALAR(1.0f);
+  mBodyInertias[i] = tMatrix33::Identity();
+  mBodyInvInertias[i] = tMatrix33::Identity();
+  mWorldInertias[i] = tMatrix33::Identity();
+  mWorldInvInertias[i] = tMatrix33::Identity();
+  mActive[i] = true;
+  mImmovable[i] = false;
+  mVelChanged[i] = true;
+  return i;
+}
+
+//==============================================================
+// RemoveBody
+//==============================================================
+void tBodyStateStore::RemoveBody(unsigned index)
+{
+  Assert(index < mBodies.size());
+  const unsigned last = mBodies.size() - 1;
+  if (index != last)
+  {
+    CopySlot(index, *this, last);
+    mBodies[index]->mStateIndex = index;
+  }
+  Resize(last);
+}
+
+//==============================================================
+// MoveBody
+//==============================================================
+void tBodyStateStore::MoveBody(unsigned index, tBodyStateStore & other)
+{
+  Assert(&other != this);
+  tBody * body = mBodies[index];
+  unsigned newIndex = other.AddBody(body);
+  other.CopySlot(newIndex, *this, index);
+  RemoveBody(index);
+  body->mStateStore = &other;
+  body->mStateIndex = newIndex;
+}
+
+//==============================================================
+// UpdateWorldInertia
+//==============================================================
+void tBodyStateStore::UpdateWorldInertia(unsigned i)
+{
+  const tMatrix33 & orientation = mTransforms[i].orientation;
+  const tMatrix33 invOrientation = orientation.GetTranspose();
+  mWorldInvInertias[i] = orientation * mBodyInvInertias[i] * invOrientation;
+  mWorldInertias[i] = orientation * mBodyInertias[i] * invOrientation;
+}
+
+//==============================================================
+// CopyAllCurrentStatesToOld
+//==============================================================
+void tBodyStateStore::CopyAllCurrentStatesToOld()
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  const unsigned numBodies = mBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    if (mActive[i] || mVelChanged[i])
+    {
+      mOldTransforms[i] = mTransforms[i];
+      mOldTransformRates[i] = mTransformRates[i];
+    }
+  }
+}
+
+//==============================================================
+// UpdateVelocity
+//==============================================================
+inline void tBodyStateStore::UpdateVelocity(unsigned i, tScalar dt)
+{
+  tTransform3Rate & rate = mTransformRates[i];
+#ifdef CHECK_RIGID_BODY
+  tVector3 origVelocity = rate.velocity;
+  tVector3 origAngVel = rate.angVelocity;
+#endif
+
+  rate.velocity += (dt * mInvMasses[i]) * mForces[i];
+  // don't quite get this - calculating angMom from angVel, then applying torque to that, then
+  // converting back just results in the simple equation anyway. The extra term just produces
+  // weirdness...
+  rate.angVelocity += mWorldInvInertias[i] * (dt * mTorques[i]);
+
+  /// TODO implement rotational friction properly
+  tCollisionSkin * collSkin = mBodies[i]->GetCollisionSkin();
+  if (collSkin && collSkin->GetCollisions().size() >= 1)
+    rate.angVelocity *= SCALAR(0.99f);
+#ifdef CHECK_RIGID_BODY
+  // check the result, and roll-back if needed
+  if (!rate.velocity.IsSensible())
+  {
+    TRACE("Velocity is not sensible: body = %p\n", mBodies[i]);
+    origVelocity.Show("orig vel");
+    mForces[i].Show("force");
+    rate.velocity.Show("velocity");
+    while (1) {DummyFnForMSVC();}
+    rate.velocity = origVelocity;
+  }
+  if (!rate.angVelocity.IsSensible())
+  {
+    TRACE("rotation is not sensible: body = %p\n-", mBodies[i]);
+    rate.angVelocity.Show("rotation");
+    origAngVel.Show("orig");
+    mTorques[i].Show("torque");
+    mWorldInvInertias[i].Show("inv world inertia");
+    while (1) {DummyFnForMSVC();}
+    rate.angVelocity = origAngVel;
+  }
+#endif
+}
+
+//==============================================================
+// UpdateAllVelocities
+//==============================================================
+void tBodyStateStore::UpdateAllVelocities(tScalar dt)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  const unsigned numBodies = mBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    if (mActive[i] && !mImmovable[i])
+      UpdateVelocity(i, dt);
+  }
+}
+
+//==============================================================
+// UpdatePositionWithAux
+//==============================================================
+inline void tBodyStateStore::UpdatePositionWithAux(unsigned i, tScalar dt, int gravityAxis)
+{
+  tTransform3 & transform = mTransforms[i];
+  tTransform3Rate & rate = mTransformRates[i];
+  tTransform3Rate & rateAux = mTransformRatesAux[i];
+
+#ifdef CHECK_RIGID_BODY
+  // in case something goes wrong...
+  tVector3 origPosition = transform.position;
+  tMatrix33 origOrientation = transform.orientation;
+#endif
+
+  if (gravityAxis != -1)
+  {
+    rateAux.velocity[(gravityAxis+1)%3] *= 0.1f;
+    rateAux.velocity[(gravityAxis+2)%3] *= 0.1f;
+  }
+  tVector3 angMomBefore = mWorldInertias[i] * rate.angVelocity;
+  ApplyTransformRate(transform, rate + rateAux, dt);
+  rateAux.SetToZero();
+
+  UpdateWorldInertia(i);
+
+  // conservation of momentum
+  rate.angVelocity = mWorldInvInertias[i] * angMomBefore;
+
+#ifdef CHECK_RIGID_BODY
+  // check the result, and roll-back if needed
+  // hmmm probably due to velocity/rotation being screwed, so reset them
+  if (!transform.position.IsSensible() || !transform.orientation.IsSensible())
+  {
+    TRACE("Transform is not sensible: body = %p\n", mBodies[i]);
+    transform.position.Show("position");
+    origPosition.Show("orig position");
+    rate.velocity.Show("velocity");
+    rate.angVelocity.Show("ang vel");
+    while (1) {DummyFnForMSVC();}
+    transform.position = origPosition;
+    transform.orientation = origOrientation;
+    rate.velocity.SetTo(SCALAR(0.0f));
+    rate.angVelocity.SetTo(SCALAR(0.0f));
+  }
+#endif
+
+  tCollisionSkin * collSkin = mBodies[i]->GetCollisionSkin();
+  if (collSkin)
+    collSkin->SetTransform(mOldTransforms[i], transform);
+}
+
+//==============================================================
+// UpdateAllPositionsWithAux
+//==============================================================
+void tBodyStateStore::UpdateAllPositionsWithAux(tScalar dt, int gravityAxis)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  const unsigned numBodies = mBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    if (mActive[i] && !mImmovable[i])
+      UpdatePositionWithAux(i, dt, gravityAxis);
+    else
+      mTransformRatesAux[i].SetToZero();
+  }
+}
+
+//==============================================================
+// LimitAllVelocities
+//==============================================================
+void tBodyStateStore::LimitAllVelocities()
+{
+  const unsigned numBodies = mBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    if (!mActive[i] || mImmovable[i])
+      continue;
+    tTransform3Rate & rate = mTransformRates[i];
+    Limit(rate.velocity.x, -velMax, velMax);
+    Limit(rate.velocity.y, -velMax, velMax);
+    Limit(rate.velocity.z, -velMax, velMax);
+
+    tScalar fX = Abs(rate.angVelocity.x) / angVelMax;
+    tScalar fY = Abs(rate.angVelocity.y) / angVelMax;
+    tScalar fZ = Abs(rate.angVelocity.z) / angVelMax;
+    tScalar f = Max(fX, fY, fZ);
+    if (f > 1.0f)
+      rate.angVelocity /= f;
+  }
+}
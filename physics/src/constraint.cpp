@@ -19,6 +19,8 @@ tConstraint::tConstraint()
 {
   TRACE_METHOD_ONLY(ONCE_2);
   mConstraintEnabled = false;
+  mPhysicsSystem = 0;
+  mIslandNode = -1;
 }
 
 //==============================================================
@@ -38,9 +40,19 @@ void tConstraint::EnableConstraint()
 {
   TRACE_METHOD_ONLY(ONCE_2);
   if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
+  EnableConstraint(*tPhysicsSystem::GetCurrentPhysicsSystem());
+}
+
+//==============================================================
+// Enable
+//==============================================================
+void tConstraint::EnableConstraint(tPhysicsSystem & physics)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
   if (true == mConstraintEnabled) return;
   mConstraintEnabled = true;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->AddConstraint(this);
+  mPhysicsSystem = &physics;
+  physics.AddConstraint(this);
 }
 
 //==============================================================
@@ -49,10 +61,10 @@ void tConstraint::EnableConstraint()
 void tConstraint::DisableConstraint()
 {
   TRACE_METHOD_ONLY(ONCE_2);
-  if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
   if (false == mConstraintEnabled) return;
   mConstraintEnabled = false;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->RemoveConstraint(this);
+  mPhysicsSystem->RemoveConstraint(this);
+  mPhysicsSystem = 0;
 }
 
 
@@ -22,8 +22,9 @@ namespace JigLib
   {
   public:
     tBasicCollisionFunctor(
-      std::vector<tCollisionInfo *> & colls)
-      : mColls(colls) {}
+      std::vector<tCollisionInfo *> & colls,
+      tFrameArena & arena)
+      : mColls(colls), mArena(arena) {}
 
     void CollisionNotify(const tCollDetectInfo &collDetectInfo, 
                          const tVector3 & dirToBody0,
@@ -36,7 +37,8 @@ namespace JigLib
         // if more than one point, add another that is in the middle - collision
         if ( collDetectInfo.skin0 && (collDetectInfo.skin0->GetOwner() != 0) )
         {
-          info = &tCollisionInfo::GetCollisionInfo(
+          info = &tCollisionInfo::Create(
+            mArena,
             collDetectInfo,
             dirToBody0, 
             pointInfos, 
@@ -48,7 +50,8 @@ namespace JigLib
         }
         else if ( collDetectInfo.skin1 && (collDetectInfo.skin1->GetOwner() != 0) )
         {
-          info = &tCollisionInfo::GetCollisionInfo(
+          info = &tCollisionInfo::Create(
+            mArena,
             collDetectInfo,
             -dirToBody0, 
             pointInfos, 
@@ -65,6 +68,7 @@ namespace JigLib
         }
       }
     std::vector<tCollisionInfo *> & mColls;
+    tFrameArena & mArena;
   };
 
   class tFrozenCollisionPredicate : public tCollisionSkinPredicate2
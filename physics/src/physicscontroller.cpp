@@ -19,6 +19,7 @@ tPhysicsController::tPhysicsController()
 {
   TRACE_METHOD_ONLY(ONCE_2);
   mControllerEnabled = false;
+  mPhysicsSystem = 0;
 }
 
 //==============================================================
@@ -37,9 +38,19 @@ void tPhysicsController::EnableController()
 {
   TRACE_METHOD_ONLY(ONCE_2);
   if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
+  EnableController(*tPhysicsSystem::GetCurrentPhysicsSystem());
+}
+
+//==============================================================
+// Enable
+//==============================================================
+void tPhysicsController::EnableController(tPhysicsSystem & physics)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
   if (true == mControllerEnabled) return;
   mControllerEnabled = true;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->AddController(this);
+  mPhysicsSystem = &physics;
+  physics.AddController(this);
 }
 
 //==============================================================
@@ -48,8 +59,8 @@ void tPhysicsController::EnableController()
 void tPhysicsController::DisableController()
 {
   TRACE_METHOD_ONLY(ONCE_2);
-  if (0 == tPhysicsSystem::GetCurrentPhysicsSystem()) return;
   if (false == mControllerEnabled) return;
   mControllerEnabled = false;
-  tPhysicsSystem::GetCurrentPhysicsSystem()->RemoveController(this);
+  mPhysicsSystem->RemoveController(this);
+  mPhysicsSystem = 0;
 }
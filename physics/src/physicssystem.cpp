@@ -17,13 +17,14 @@
 #include "distance.hpp"
 
 #include "trace.hpp"
+#include "threadpool.hpp"
 
 #include <algorithm>
 
 using namespace JigLib;
 using namespace std;
 
-tPhysicsSystem * tPhysicsSystem::mCurrentPhysicsSystem = 0;
+thread_local tPhysicsSystem * tPhysicsSystem::mCurrentPhysicsSystem = 0;
 
 // limit the extra velocity during collision/penetration calculations
 static const tScalar maxVelMag = 0.5f;
@@ -32,7 +33,10 @@ static const tScalar minVelForProcessing = 0.001f;
 static const tScalar penetrationShockRelaxationTimesteps = 10;
 
 #define DO_FRICTION
-#define USE_OLD_IMPULSE
+
+// contact points that are closer than this (in body space) to a
+// cached contact take on its impulses
+static const tScalar contactCacheTolerance = 0.2f;
 
 //==============================================================
 // tPhysicsSystem
@@ -48,6 +52,7 @@ tPhysicsSystem::tPhysicsSystem()
   mAllowedPenetration = 0.01f;
   mDoShockStep = false;
   mCollToll = 0.05f;
+  mCCDMotionThreshold = 0.0f;
   mSolverType = SOLVER_COMBINED;
   mFreezingEnabled = true;
   SetGravity(-10.0f * tVector3::Up());
@@ -55,6 +60,12 @@ tPhysicsSystem::tPhysicsSystem()
   mTargetTime = 0.0f;
   mOldTime = 0.0f;
   mDoingIntegration = false;
+  mNumIslands = 0;
+  mLooseIsland = -1;
+  mNumConstraintPasses = 0;
+  mThreadPool = 0;
+  mContactCacheFrame = 0;
+  mNullUpdate = false;
 
   SetCollisionFns();
 }
@@ -83,7 +94,8 @@ tPhysicsSystem::~tPhysicsSystem()
       controllers[i]->DisableController();
   }
 
-  SetCurrentPhysicsSystem(0);
+  if (GetCurrentPhysicsSystem() == this)
+    SetCurrentPhysicsSystem(0);
 }
 
 //==============================================================
@@ -113,7 +125,10 @@ void tPhysicsSystem::AddBody(tBody * body)
   Assert(false == mDoingIntegration);
   Assert(body);
   if (mBodies.end() == find(mBodies.begin(), mBodies.end(), body))
+  {
     mBodies.push_back(body);
+    body->mStateStore->MoveBody(body->mStateIndex, mBodyStates);
+  }
   else
     TRACE("Warning: tried to add body %p to physics"
           " but it's already registered", body);
@@ -136,11 +151,28 @@ bool tPhysicsSystem::RemoveBody(tBody * body)
   if (mCollisionSystem && body->GetCollisionSkin())
     mCollisionSystem->RemoveCollisionSkin(body->GetCollisionSkin());
 
+  UnlinkSleepingBody(body);
+
+  // a new skin could end up at the same address
+  if (body->GetCollisionSkin())
+  {
+    size_t key = (size_t) body->GetCollisionSkin();
+    for (unsigned iSlot = 0 ; iSlot < mContactManifolds.GetNumSlots() ; )
+    {
+      if (mContactManifolds.IsUsed(iSlot) &&
+          (mContactManifolds.GetKey0(iSlot) == key || mContactManifolds.GetKey1(iSlot) == key))
+        mContactManifolds.RemoveSlot(iSlot);
+      else
+        ++iSlot;
+    }
+  }
+
   tBodies::iterator it = 
     find(mBodies.begin(), mBodies.end(), body);
   if (mBodies.end() == it)
     return false;
   mBodies.erase(it);
+  mBodyStates.MoveBody(body->mStateIndex, body->mOwnStateStore);
   return true;
 }
 
@@ -221,6 +253,9 @@ void tPhysicsSystem::ActivateObject(tBody * body)
 
   mActiveBodies.push_back(body);
 
+  // anything that went to sleep with it wakes up too
+  WakeSleepingIsland(body);
+
   if (!mCollisionSystem)
     return;
 
@@ -229,7 +264,7 @@ void tPhysicsSystem::ActivateObject(tBody * body)
 
   int orig_num = mCollisions.size();
 
-  tBasicCollisionFunctor functor(mCollisions);
+  tBasicCollisionFunctor functor(mCollisions, mCollisionArena);
   tFrozenCollisionPredicate predicate(body);
   mCollisionSystem->DetectCollisions(
     *body, 
@@ -286,7 +321,7 @@ void tPhysicsSystem::PreProcessCollision(tCollisionInfo * collision,
   const tVector3 & N = collision->mDirToBody0;
   const tScalar timescale = mNumPenetrationRelaxationTimesteps * dt;
 
-  for (unsigned iPos = 0 ; iPos < collision->mPointInfo.Size() ; ++iPos)
+  for (unsigned iPos = 0 ; iPos < collision->mNumPointInfos ; ++iPos)
   {
     tCollPointInfo& ptInfo = collision->mPointInfo[iPos];
 
@@ -351,13 +386,17 @@ void tPhysicsSystem::PreProcessCollisionAccumulated(tCollisionInfo * collision,
   const tVector3 & N = collision->mDirToBody0;
   const tScalar timescale = mNumPenetrationRelaxationTimesteps * dt;
 
-#ifdef USE_OLD_IMPULSE
-  tBodyPair bp(collision->mSkinInfo.skin0->GetOwner(), collision->mSkinInfo.skin1->GetOwner(), tVector3::Zero(), tVector3::Zero());
-  std::multimap<tBodyPair, tCachedImpulses>::iterator cacheItBegin = mCachedContacts.lower_bound(bp);
-  std::multimap<tBodyPair, tCachedImpulses>::iterator cacheItEnd   = mCachedContacts.upper_bound(bp);
-#endif
-
-  for (unsigned iPos = 0 ; iPos < collision->mPointInfo.Size() ; ++iPos)
+  // the manifold's first skin is the one with the higher address
+  const tCollisionSkin * skin0 = collision->mSkinInfo.skin0;
+  const tCollisionSkin * skin1 = collision->mSkinInfo.skin1;
+  const bool swapped = skin1 > skin0;
+  const tContactManifold * manifold = swapped ?
+    mContactManifolds.Find((size_t) skin1, (size_t) skin0) :
+    mContactManifolds.Find((size_t) skin0, (size_t) skin1);
+  const tMatrix33 invOrient0 = body0->GetOldOrientation().GetTranspose();
+  const tMatrix33 invOrient1 = body1 ? body1->GetOldOrientation().GetTranspose() : tMatrix33::Identity();
+
+  for (unsigned iPos = 0 ; iPos < collision->mNumPointInfos ; ++iPos)
   {
     tCollPointInfo& ptInfo = collision->mPointInfo[iPos];
 
@@ -399,29 +438,42 @@ void tPhysicsSystem::PreProcessCollisionAccumulated(tCollisionInfo * collision,
     ptInfo.mAccumulatedNormalImpulse = 0.0f;
     ptInfo.mAccumulatedNormalImpulseAux = 0.0f;
     ptInfo.mAccumulatedFrictionImpulse.SetToZero();
-#ifdef USE_OLD_IMPULSE
-    /// todo take this value from config or derive from the geometry (but don't reference the body in the cache as it
-    /// may be deleted)
-    static tScalar minDist = 0.2f;
-    tScalar bestDistSq = Sq(minDist);
-    for (std::multimap<tBodyPair, tCachedImpulses>::iterator it = cacheItBegin ; it != cacheItEnd ; ++it)
+
+    // warm start from the nearest cached contact. Only compare
+    // positions on bodies, so that sliding over static things still
+    // matches.
+    if (manifold)
     {
-      const tBodyPair &bp = it->first;
-      tScalar distSq = (bp.mBodyA == collision->mSkinInfo.skin0->GetOwner()) ? 
-        PointPointDistanceSq(bp.mRA, ptInfo.mR0) : PointPointDistanceSq(bp.mRA, ptInfo.mR1);
-      if (distSq < bestDistSq)
+      tVector3 localPos0 = invOrient0 * ptInfo.mR0;
+      tVector3 localPos1 = invOrient1 * ptInfo.mR1;
+      if (swapped)
+        std::swap(localPos0, localPos1);
+      const bool hasBody0 = (swapped ? body1 : body0) != 0;
+      const bool hasBody1 = (swapped ? body0 : body1) != 0;
+
+      tScalar bestDistSq = Sq(contactCacheTolerance);
+      const tCachedContact * best = 0;
+      for (unsigned iCached = 0 ; iCached < manifold->mContacts.Size() ; ++iCached)
+      {
+        const tCachedContact & cached = manifold->mContacts[iCached];
+        tScalar distSq = 0.0f;
+        if (hasBody0)
+          distSq = PointPointDistanceSq(cached.mLocalPos0, localPos0);
+        if (hasBody1)
+          distSq = Max(distSq, PointPointDistanceSq(cached.mLocalPos1, localPos1));
+        if (distSq < bestDistSq)
+        {
+          bestDistSq = distSq;
+          best = &cached;
+        }
+      }
+      if (best)
       {
-        bestDistSq = distSq;
-        ptInfo.mAccumulatedNormalImpulse = it->second.mNormalImpulse;
-        ptInfo.mAccumulatedNormalImpulseAux = it->second.mNormalImpulseAux;
-        ptInfo.mAccumulatedFrictionImpulse = (bp.mBodyA == collision->mSkinInfo.skin0->GetOwner()) ? 
-          it->second.mFrictionImpulse : -it->second.mFrictionImpulse;
+        ptInfo.mAccumulatedNormalImpulse = best->mNormalImpulse;
+        ptInfo.mAccumulatedNormalImpulseAux = best->mNormalImpulseAux;
+        ptInfo.mAccumulatedFrictionImpulse = swapped ? -best->mFrictionImpulse : best->mFrictionImpulse;
       }
     }
-    static tScalar oldScale = 1.f;
-    ptInfo.mAccumulatedNormalImpulse *= oldScale;
-    ptInfo.mAccumulatedFrictionImpulse *= oldScale;
-    ptInfo.mAccumulatedNormalImpulseAux *= oldScale;
     if (ptInfo.mAccumulatedNormalImpulse != 0.0f)
     {
       tVector3 impulse(ptInfo.mAccumulatedNormalImpulse, N);
@@ -437,11 +489,10 @@ void tPhysicsSystem::PreProcessCollisionAccumulated(tCollisionInfo * collision,
       if (body1)
         body1->ApplyNegativeBodyWorldImpulseAux(impulse, ptInfo.mR1);
     }
-#endif
   }
 /*
   std::sort(&collision->mPointInfo[0], 
-            1 + &collision->mPointInfo[collision->mPointInfo.Size() - 1], 
+            1 + &collision->mPointInfo[collision->mNumPointInfos - 1], 
             LessCollPtDenom);
             */
 }
@@ -474,16 +525,16 @@ void tPhysicsSystem::PreProcessCollisionFast(tCollisionInfo * collision,
 
   // only keep the best few collision points
   static unsigned keep = 3;
-  if (collision->mPointInfo.Size()  > keep)
+  if (collision->mNumPointInfos  > keep)
   {
     std::sort(&collision->mPointInfo[0], 
-              1 + &collision->mPointInfo[collision->mPointInfo.Size() - 1], 
+              1 + &collision->mPointInfo[collision->mNumPointInfos - 1], 
               MoreCollPtPenetration);
     // forget the rest
-    collision->mPointInfo.Resize(keep);
+    collision->mNumPointInfos = keep;
   }
   
-  for (unsigned iPos = 0 ; iPos < collision->mPointInfo.Size() ; ++iPos)
+  for (unsigned iPos = 0 ; iPos < collision->mNumPointInfos ; ++iPos)
   {
     tCollPointInfo& ptInfo = collision->mPointInfo[iPos];
     // some things we only calculate if there are bodies, and they are
@@ -542,7 +593,7 @@ bool tPhysicsSystem::ProcessCollision(tCollisionInfo * collision,
   const tVector3 & N = collision->mDirToBody0;
 
   bool gotOne = false;
-  for (unsigned iPos = 0 ; iPos < collision->mPointInfo.Size(); ++iPos)
+  for (unsigned iPos = 0 ; iPos < collision->mNumPointInfos; ++iPos)
   {
     tCollPointInfo & ptInfo = collision->mPointInfo[iPos];
     Assert(ptInfo.mDenominator >= SCALAR_TINY);
@@ -647,13 +698,13 @@ bool tPhysicsSystem::ProcessCollision(tCollisionInfo * collision,
 }
 
 //==============================================================
-// ProcessCollisionAccumulated
+// ApplyAccumulatedImpulses
+// The work of ProcessCollisionAccumulated, apart from marking the
+// other constraints/collisions on the bodies as unsatisfied. Only
+// touches the collision and its two bodies.
 //==============================================================
-bool tPhysicsSystem::ProcessCollisionAccumulated(tCollisionInfo * collision, 
-                                                 tScalar dt,
-                                                 bool firstContact)
+bool tPhysicsSystem::ApplyAccumulatedImpulses(tCollisionInfo * collision)
 {
-  TRACE_METHOD_ONLY(MULTI_FRAME_1);
   collision->mSatisfied = true;
 
   tBody * body0 = collision->mSkinInfo.skin0->GetOwner();
@@ -661,7 +712,7 @@ bool tPhysicsSystem::ProcessCollisionAccumulated(tCollisionInfo * collision,
 
   bool gotOne = false;
   
-  for (unsigned iPos = collision->mPointInfo.Size() ; iPos-- != 0 ; )
+  for (unsigned iPos = collision->mNumPointInfos ; iPos-- != 0 ; )
   {
 
     tCollPointInfo & ptInfo = collision->mPointInfo[iPos];
@@ -803,13 +854,24 @@ bool tPhysicsSystem::ProcessCollisionAccumulated(tCollisionInfo * collision,
     }
 #endif
   }
+  return gotOne;
+}
+
+//==============================================================
+// ProcessCollisionAccumulated
+//==============================================================
+bool tPhysicsSystem::ProcessCollisionAccumulated(tCollisionInfo * collision, 
+                                                 tScalar dt,
+                                                 bool firstContact)
+{
+  TRACE_METHOD_ONLY(MULTI_FRAME_1);
+  bool gotOne = ApplyAccumulatedImpulses(collision);
 
   if (gotOne)
   {
-    body0->SetConstraintsAndCollisionsUnsatisfied();
-    if (body1)
-      body1->SetConstraintsAndCollisionsUnsatisfied();
-    //collision->mSatisfied = true;
+    collision->mSkinInfo.skin0->GetOwner()->SetConstraintsAndCollisionsUnsatisfied();
+    if (collision->mSkinInfo.skin1->GetOwner())
+      collision->mSkinInfo.skin1->GetOwner()->SetConstraintsAndCollisionsUnsatisfied();
   }
   return gotOne;
 }
@@ -828,7 +890,7 @@ bool tPhysicsSystem::ProcessCollisionFast(tCollisionInfo * collision,
   tBody * body1 = collision->mSkinInfo.skin1->GetOwner();
 
   bool gotOne = false;
-  for (unsigned iPos = collision->mPointInfo.Size() ; 
+  for (unsigned iPos = collision->mNumPointInfos ; 
        iPos-- != 0 ; )
   {
     tCollPointInfo & ptInfo = collision->mPointInfo[iPos];
@@ -941,7 +1003,7 @@ bool tPhysicsSystem::ProcessCollisionCombined(tCollisionInfo * collision,
   tScalar avMinSeparationVel = 0.0f;
 
   tScalar impulses[tCollisionInfo::MAX_COLLISION_POINTS];
-  for (iPos = collision->mPointInfo.Size() ; iPos-- != 0  ; )
+  for (iPos = collision->mNumPointInfos ; iPos-- != 0  ; )
   {
     Assert(collision->mPointInfo[iPos].mDenominator >= SCALAR_TINY);
     tCollPointInfo & ptInfo = collision->mPointInfo[iPos];
@@ -987,7 +1049,7 @@ bool tPhysicsSystem::ProcessCollisionCombined(tCollisionInfo * collision,
 
   // apply all these impulses (as well as subsequently applying an
   // impulse at an averaged position)
-  for (iPos = collision->mPointInfo.Size() ; iPos-- != 0  ; )
+  for (iPos = collision->mNumPointInfos ; iPos-- != 0  ; )
   {
     if (impulses[iPos] > SCALAR_TINY)
     {
@@ -1052,7 +1114,7 @@ bool tPhysicsSystem::ProcessCollisionCombined(tCollisionInfo * collision,
   }
 #ifdef DO_FRICTION
   // now do friction point by point
-  for (iPos = collision->mPointInfo.Size() ; iPos-- != 0  ; )
+  for (iPos = collision->mNumPointInfos ; iPos-- != 0  ; )
   {
     // For friction, work out the impulse in the opposite direction to
     // the tangential velocity that would be required to bring this
@@ -1139,7 +1201,7 @@ bool tPhysicsSystem::ProcessCollisionForShock(tCollisionInfo * collision,
 
   unsigned iPos;
   const tScalar timescale = penetrationShockRelaxationTimesteps * dt;
-  for (iPos = 0 ; iPos < collision->mPointInfo.Size() ; ++iPos)
+  for (iPos = 0 ; iPos < collision->mNumPointInfos ; ++iPos)
   {
     tCollPointInfo& ptInfo = collision->mPointInfo[iPos];
 //    ptInfo.mAccumulatedNormalImpulseAux = 0.0f;
@@ -1159,7 +1221,7 @@ bool tPhysicsSystem::ProcessCollisionForShock(tCollisionInfo * collision,
 
   for (unsigned iteration = 0 ; iteration < iterations ; ++iteration)
   {
-    for (iPos = 0 ; iPos < collision->mPointInfo.Size() ; ++iPos)
+    for (iPos = 0 ; iPos < collision->mNumPointInfos ; ++iPos)
     {
       tCollPointInfo& ptInfo = collision->mPointInfo[iPos];
 
@@ -1218,27 +1280,27 @@ void tPhysicsSystem::DampAllActiveBodies()
 }
 
 //==============================================================
-// try_to_activate_all_frozen_objects
+// TryToActivateFrozenObjects
 //==============================================================
-void tPhysicsSystem::TryToActivateAllFrozenObjects()
+void tPhysicsSystem::TryToActivateFrozenObjects(const tBodies & bodies)
 {
   TRACE_METHOD_ONLY(FRAME_2);
-  unsigned numBodies = mBodies.size();
+  unsigned numBodies = bodies.size();
   for (unsigned i = 0 ; i < numBodies ; ++i)
   {
-    if (!mBodies[i]->IsActive())
+    if (!bodies[i]->IsActive())
     {
-      if (mBodies[i]->GetShouldBeActive())
+      if (bodies[i]->GetShouldBeActive())
       {
-        ActivateObject(mBodies[i]);
+        ActivateObject(bodies[i]);
       }
       else
       {
-        if (mBodies[i]->GetVelChanged())
+        if (bodies[i]->GetVelChanged())
         {
-          mBodies[i]->SetVelocity(tVector3::Zero());
-          mBodies[i]->SetAngVel(tVector3::Zero());
-          mBodies[i]->ClearVelChanged();
+          bodies[i]->SetVelocity(tVector3::Zero());
+          bodies[i]->SetAngVel(tVector3::Zero());
+          bodies[i]->ClearVelChanged();
         }
       }
     }
@@ -1278,8 +1340,8 @@ bool MoreCollisionDepth(const tCollisionInfo* info0, const tCollisionInfo* info1
 {
   tScalar avDepth0 = 0.0f;
   tScalar avDepth1 = 0.0f;
-  unsigned n0 = info0->mPointInfo.Size();
-  unsigned n1 = info1->mPointInfo.Size();
+  unsigned n0 = info0->mNumPointInfos;
+  unsigned n1 = info1->mNumPointInfos;
   unsigned count0 = 0;
   unsigned count1 = 0;
   for (unsigned i0 = 0 ; i0 < n0 ; ++i0)
@@ -1315,8 +1377,8 @@ bool LessCollisionDepth(const tCollisionInfo* info0, const tCollisionInfo* info1
 {
   tScalar avDepth0 = 0.0f;
   tScalar avDepth1 = 0.0f;
-  unsigned n0 = info0->mPointInfo.Size();
-  unsigned n1 = info1->mPointInfo.Size();
+  unsigned n0 = info0->mNumPointInfos;
+  unsigned n1 = info1->mNumPointInfos;
   unsigned count0 = 0;
   unsigned count1 = 0;
   for (unsigned i0 = 0 ; i0 < n0 ; ++i0)
@@ -1356,7 +1418,6 @@ void tPhysicsSystem::DetectAllCollisions(tScalar dt)
     return;
 
   unsigned numBodies = mBodies.size();
-  unsigned numColls = mCollisions.size();
   unsigned numActiveBodies = mActiveBodies.size();
 
   unsigned i;
@@ -1367,17 +1428,16 @@ void tPhysicsSystem::DetectAllCollisions(tScalar dt)
   UpdateAllVelocities(dt);
   UpdateAllPositions(dt);
 
-  for (i = 0 ; i < numColls ; ++i)
-    tCollisionInfo::FreeCollisionInfo(*mCollisions[i]);
   mCollisions.resize(0);
-
   for (i = 0 ; i < numBodies ; ++i)
   {
     if (mBodies[i]->GetCollisionSkin())
       mBodies[i]->GetCollisionSkin()->GetCollisions().resize(0);
   }
+  // nothing refers to last frame's collisions now
+  mCollisionArena.Reset();
 
-  tBasicCollisionFunctor functor(mCollisions);
+  tBasicCollisionFunctor functor(mCollisions, mCollisionArena);
   mCollisionSystem->DetectAllCollisions(
     mActiveBodies, 
     functor, 
@@ -1415,6 +1475,7 @@ void tPhysicsSystem::SetCollisionFns()
     mProcessCollisionFn = mProcessContactFn = &tPhysicsSystem::ProcessCollisionCombined;
     return;
   case SOLVER_ACCUMULATED:
+  case SOLVER_BATCHED:
     mPreProcessCollisionFn = &tPhysicsSystem::PreProcessCollision;
     mProcessCollisionFn = &tPhysicsSystem::ProcessCollision;
     mPreProcessContactFn = &tPhysicsSystem::PreProcessCollisionAccumulated;
@@ -1427,6 +1488,44 @@ void tPhysicsSystem::SetCollisionFns()
   mProcessCollisionFn = &tPhysicsSystem::ProcessCollision;
 }
 
+//==============================================================
+// tIslandJob
+//==============================================================
+class tPhysicsSystem::tIslandJob : public tThreadJob
+{
+public:
+  tIslandJob(tPhysicsSystem & physics, tScalar dt, unsigned iter, bool forceInelastic)
+    : mPhysics(physics), mDt(dt), mIter(iter), mForceInelastic(forceInelastic) {}
+
+  void Run(unsigned iTask, unsigned iThread)
+  {
+    tIsland & island = mPhysics.mIslands[mPhysics.mIslandOrder[iTask]];
+    mPhysics.HandleIslandConstraints(island, mDt, mIter, mForceInelastic, false);
+  }
+private:
+  tPhysicsSystem & mPhysics;
+  tScalar mDt;
+  unsigned mIter;
+  bool mForceInelastic;
+};
+
+//==============================================================
+// tMoreIslandWork
+//==============================================================
+struct tPhysicsSystem::tMoreIslandWork
+{
+  tMoreIslandWork(const std::vector<tIsland> & islands) : mIslands(islands) {}
+  bool operator()(unsigned i0, unsigned i1) const
+  {
+    return Work(mIslands[i0]) > Work(mIslands[i1]);
+  }
+  static unsigned Work(const tIsland & island)
+  {
+    return island.mCollisions.size() + island.mConstraints.size();
+  }
+  const std::vector<tIsland> & mIslands;
+};
+
 //==============================================================
 // handle_all_collisions
 //==============================================================
@@ -1434,14 +1533,93 @@ void tPhysicsSystem::HandleAllConstraints(tScalar dt, unsigned iter, bool forceI
 {
   TRACE_METHOD_ONLY(FRAME_1);
 
+  ++mNumConstraintPasses;
+
+  // wake up any previously stationary frozen objects that have been
+  // given a kick from outside. Bodies that aren't in an island won't
+  // get any impulses during the iterations, so once here is enough
+  // for them. Anything new this finds gets solved in the loose
+  // island.
+  if (mFreezingEnabled)
+  {
+    unsigned origNumCollisions = mCollisions.size();
+    TryToActivateFrozenObjects(mBodies);
+    unsigned numCollisions = mCollisions.size();
+    if (numCollisions > origNumCollisions)
+    {
+      tIsland & island = GetIsland(mLooseIsland);
+      for (unsigned i = origNumCollisions ; i < numCollisions ; ++i)
+        island.mCollisions.push_back(mCollisions[i]);
+    }
+  }
+
+  if (forceInelastic && mSolverType == SOLVER_BATCHED)
+  {
+    HandleAllContactsBatched(dt, iter);
+    return;
+  }
+
+  if (!mThreadPool || mThreadPool->GetNumThreads() < 2 || mNumIslands < 2)
+  {
+    for (unsigned iIsland = 0 ; iIsland < mNumIslands ; ++iIsland)
+      HandleIslandConstraints(mIslands[iIsland], dt, iter, forceInelastic, mFreezingEnabled);
+    return;
+  }
+
+  // The islands don't share any movable bodies, so they can all be
+  // solved at once. The loose island is the exception since it can
+  // pick up bodies from the others, so it gets done afterwards.
+  mIslandOrder.resize(0);
+  for (unsigned iIsland = 0 ; iIsland < mNumIslands ; ++iIsland)
+  {
+    if ((int) iIsland != mLooseIsland)
+      mIslandOrder.push_back(iIsland);
+  }
+  std::sort(mIslandOrder.begin(), mIslandOrder.end(), tMoreIslandWork(mIslands));
+
+  tIslandJob job(*this, dt, iter, forceInelastic);
+  mThreadPool->RunJob(job, mIslandOrder.size());
+
+  // Waking frozen bodies means detecting collisions and touching
+  // the global lists, so that got deferred until now. Any new
+  // collisions get solved with the loose island.
+  if (mFreezingEnabled)
+  {
+    unsigned origNumCollisions = mCollisions.size();
+    TryToActivateFrozenObjects(mBodies);
+    unsigned numCollisions = mCollisions.size();
+    if (numCollisions > origNumCollisions)
+    {
+      tIsland & island = GetIsland(mLooseIsland);
+      for (unsigned i = origNumCollisions ; i < numCollisions ; ++i)
+        island.mCollisions.push_back(mCollisions[i]);
+    }
+  }
+
+  if (mLooseIsland >= 0)
+    HandleIslandConstraints(mIslands[mLooseIsland], dt, iter, forceInelastic, mFreezingEnabled);
+}
+
+//==============================================================
+// HandleIslandConstraints
+//==============================================================
+void tPhysicsSystem::HandleIslandConstraints(tIsland & island, tScalar dt, unsigned iter, 
+                                             bool forceInelastic, bool activateFrozen)
+{
+  tCollisions & collisions = island.mCollisions;
+  tConstraints & constraints = island.mConstraints;
+
   unsigned i;
-  unsigned origNumCollisions = mCollisions.size();
-  const unsigned numConstraints = mConstraints.size();
+  unsigned origNumCollisions = collisions.size();
+  const unsigned numConstraints = constraints.size();
+
+  if (origNumCollisions == 0 && numConstraints == 0)
+    return;
 
   // prepare all the constraints
   for (i = 0 ; i < numConstraints ; ++i)
   {
-    mConstraints[i]->PreApply(dt);
+    constraints[i]->PreApply(dt);
   }
 
   // prepare all the collisions 
@@ -1449,68 +1627,74 @@ void tPhysicsSystem::HandleAllConstraints(tScalar dt, unsigned iter, bool forceI
   {
     for (i = 0 ; i < origNumCollisions ; ++i)
     {
-     (this->*mPreProcessContactFn)(mCollisions[i], dt);
-      mCollisions[i]->mMatPairProperties.mRestitution = 0.0f;
-      mCollisions[i]->mSatisfied = false;
+     (this->*mPreProcessContactFn)(collisions[i], dt);
+      collisions[i]->mMatPairProperties.mRestitution = 0.0f;
+      collisions[i]->mSatisfied = false;
     }
   }
   else
   {
     // prepare for the collisions
     for (i = 0 ; i < origNumCollisions ; ++i)
-      (this->*mPreProcessCollisionFn)(mCollisions[i], dt);
+      (this->*mPreProcessCollisionFn)(collisions[i], dt);
   }
   
-  // iterate over the collisions
-  static int dir = 1;
+  // iterate over the collisions, alternating the direction
+  bool dir = (mNumConstraintPasses & 1) != 0;
   for (unsigned step = 0 ; step < iter ; ++step)
   {
     bool gotOne = false;
     // step 6
-    unsigned numCollisions = mCollisions.size();
+    unsigned numCollisions = collisions.size();
     dir = !dir;
     for (i = dir ? 0 : numCollisions - 1; 
          i >= 0 && i < numCollisions; 
          dir ? ++i : --i)
     {
-      if (!mCollisions[i]->mSatisfied)
+      if (!collisions[i]->mSatisfied)
       {
         if (forceInelastic)
-          gotOne |= (this->*mProcessContactFn)(mCollisions[i], dt, step == 0);
+          gotOne |= (this->*mProcessContactFn)(collisions[i], dt, step == 0);
         else
-          gotOne |= (this->*mProcessCollisionFn)(mCollisions[i], dt, step == 0);
+          gotOne |= (this->*mProcessCollisionFn)(collisions[i], dt, step == 0);
       }
     }
     for (i = 0 ; i < numConstraints ; ++i)
     {
-      if (!mConstraints[i]->GetSatisfied())
+      if (!constraints[i]->GetSatisfied())
       {
-        gotOne |= mConstraints[i]->Apply(dt);
+        gotOne |= constraints[i]->Apply(dt);
       }
     }
     // wake up any previously stationary frozen objects that were
-    // frozen. 
-    if (mFreezingEnabled)
-      TryToActivateAllFrozenObjects();
+    // frozen. Any collisions they pick up get handled as part of
+    // this island.
+    if (activateFrozen)
+    {
+      unsigned origNumAllCollisions = mCollisions.size();
+      TryToActivateFrozenObjects(island.mBodies);
+      for (i = origNumAllCollisions ; i < mCollisions.size() ; ++i)
+        collisions.push_back(mCollisions[i]);
+    }
 
     // number of collisions may have increased...
-    numCollisions = mCollisions.size();
+    numCollisions = collisions.size();
 
     // preprocess any new collisions.
     if (forceInelastic)
     {
       for (i = origNumCollisions ; i < numCollisions ; ++i)
       {
-        mCollisions[i]->mMatPairProperties.mRestitution = 0.0f;
-        mCollisions[i]->mSatisfied = false;
-        (this->*mPreProcessContactFn)(mCollisions[i], dt);
+        collisions[i]->mMatPairProperties.mRestitution = 0.0f;
+        collisions[i]->mSatisfied = false;
+        (this->*mPreProcessContactFn)(collisions[i], dt);
       }
     }
     else
     {
       for (i = origNumCollisions ; i < numCollisions ; ++i)
       {
-        (this->*mPreProcessCollisionFn)(mCollisions[i], dt);
+        (this->*mPreProcessCollisionFn)(collisions[i], dt);
       }
     }
     
@@ -1644,12 +1828,7 @@ void tPhysicsSystem::GetAllExternalForces(tScalar dt)
 void tPhysicsSystem::UpdateAllVelocities(tScalar dt)
 {
   TRACE_METHOD_ONLY(FRAME_1);
-  int numBodies = mBodies.size();
-  for (int i = 0 ; i < numBodies ; ++i)
-  {
-    if (mBodies[i]->IsActive() || mBodies[i]->GetVelChanged())
-      mBodies[i]->UpdateVelocity(dt);
-  }
+  mBodyStates.UpdateAllVelocities(dt);
 }
 
 //==============================================================
@@ -1658,9 +1837,7 @@ void tPhysicsSystem::UpdateAllVelocities(tScalar dt)
 void tPhysicsSystem::UpdateAllPositions(tScalar dt)
 {
   TRACE_METHOD_ONLY(FRAME_1);
-  int numBodies = mActiveBodies.size();
-  for (int i = 0 ; i < numBodies ; ++i)
-    mActiveBodies[i]->UpdatePositionWithAux(dt);
+  mBodyStates.UpdateAllPositionsWithAux(dt, GetMainGravityAxis());
 }
 
 //==============================================================
@@ -1679,104 +1856,7 @@ void tPhysicsSystem::NotifyAllPostPhysics(tScalar dt)
 //==============================================================
 void tPhysicsSystem::CopyAllCurrentStatesToOld()
 {
-  int numBodies = mBodies.size();
-  int i;
-  for (i = 0 ; i < numBodies ; ++i)
-  {
-    if (mBodies[i]->IsActive() || mBodies[i]->GetVelChanged())
-      mBodies[i]->CopyCurrentStateToOld();
-  }
-}
-
-//==============================================================
-// try_to_freeze_all_objects
-//==============================================================
-void tPhysicsSystem::TryToFreezeAllObjects(tScalar dt)
-{
-  TRACE_METHOD_ONLY(FRAME_1);
-  int numBodies = mActiveBodies.size();
-  int i;
-  for (i = 0 ; i < numBodies ; ++i)
-    mActiveBodies[i]->TryToFreeze(dt);
-}
-
-//==============================================================
-// activate_all_frozen_objects_left_hanging
-//==============================================================
-void tPhysicsSystem::ActivateAllFrozenObjectsLeftHanging()
-{
-  TRACE_METHOD_ONLY(FRAME_1);
-  const unsigned numBodies = mBodies.size();
-  for (unsigned i = 0 ; i < numBodies ; ++i)
-  {
-    tBody * thisBody = mBodies[i];
-    if ( thisBody->IsActive() &&
-         thisBody->GetCollisionSkin() )
-    {
-      // first activate any bodies due to the movement of this body
-      thisBody->DoMovementActivations();
-
-      // now record any movement notifications that are needed
-      vector<tCollisionInfo *> & collisions = 
-        mBodies[i]->GetCollisionSkin()->GetCollisions();
-      if (!collisions.empty())
-      {
-        // walk through the object's contact list
-        unsigned j;
-        const unsigned numCollisions = collisions.size();
-        for (j = 0 ; j < numCollisions ; ++j)
-        {
-          const tCollisionInfo & coll = *collisions[j];
-          Assert(coll.mSkinInfo.skin1);
-          // must be a body-body interaction to be interesting
-          if (coll.mSkinInfo.skin1->GetOwner())
-          {
-            tBody * other_body = coll.mSkinInfo.skin0->GetOwner();
-//            tVector3 dirToOther = coll.mDirToBody0;
-
-            if (other_body == thisBody)
-            {
-              other_body = coll.mSkinInfo.skin1->GetOwner();
-//              dirToOther.Negate();
-            }
-            if (!other_body->IsActive())
-            {
-              // only wake up objects that would "fall" against this
-              // one...  actually don't do this because it breaks if
-              // an object below should rotate (e.g. removing a top
-              // block from a wall)
-//              if (Dot(dirToOther, other_body->GetForce()) < -SCALAR_TINY)
-              {
-                thisBody->AddMovementActivation(
-                  thisBody->GetPosition(), 
-                  other_body);
-              }
-            }
-          }
-        }
-      }
-    }
-  }
-}
-
-
-//==============================================================
-// enable_freezing
-//==============================================================
-void tPhysicsSystem::EnableFreezing(bool freeze)
-{
-  TRACE_METHOD_ONLY(ONCE_2);
-  mFreezingEnabled = freeze;
-
-  if (!mFreezingEnabled)
-  {
-    int numBodies = mBodies.size();
-    int i;
-    for (i = 0 ; i < numBodies ; ++i)
-    {
-      mBodies[i]->SetActive();
-    }
-  }
+  mBodyStates.CopyAllCurrentStatesToOld();
 }
 
 //==============================================================
@@ -1805,12 +1885,7 @@ void tPhysicsSystem::FindAllActiveBodies()
 //========================================================
 void tPhysicsSystem::LimitAllVelocities()
 {
-  int numActiveBodies = mActiveBodies.size();
-  for (int i = 0 ; i < numActiveBodies ; ++i)
-  {
-    mActiveBodies[i]->LimitVel();
-    mActiveBodies[i]->LimitAngVel();
-  }
+  mBodyStates.LimitAllVelocities();
 }
 
 //========================================================
@@ -1818,23 +1893,58 @@ void tPhysicsSystem::LimitAllVelocities()
 //========================================================
 void tPhysicsSystem::UpdateContactCache()
 {
-  mCachedContacts.clear();
+  ++mContactCacheFrame;
 
-  for (unsigned i = mCollisions.size() ; i-- != 0 ; )
+  for (unsigned i = 0 ; i < mCollisions.size() ; ++i)
   {
-    tCollisionInfo * collInfo = mCollisions[i];
-    for (unsigned iPos = 0 ; iPos < collInfo->mPointInfo.Size() ; ++iPos)
+    const tCollisionInfo * collInfo = mCollisions[i];
+    const tCollisionSkin * skin0 = collInfo->mSkinInfo.skin0;
+    const tCollisionSkin * skin1 = collInfo->mSkinInfo.skin1;
+    const tBody * body0 = skin0->GetOwner();
+    const tBody * body1 = skin1->GetOwner();
+    const bool swapped = skin1 > skin0;
+
+    bool isNew;
+    tContactManifold & manifold = swapped ?
+      mContactManifolds.Insert((size_t) skin1, (size_t) skin0, isNew) :
+      mContactManifolds.Insert((size_t) skin0, (size_t) skin1, isNew);
+    // there can be more than one collision per pair of skins
+    if (manifold.mFrame != mContactCacheFrame)
+    {
+      manifold.mFrame = mContactCacheFrame;
+      manifold.mContacts.Clear();
+    }
+
+    const tMatrix33 invOrient0 = body0->GetOldOrientation().GetTranspose();
+    const tMatrix33 invOrient1 = body1 ? body1->GetOldOrientation().GetTranspose() : tMatrix33::Identity();
+    for (unsigned iPos = 0 ; iPos < collInfo->mNumPointInfos ; ++iPos)
     {
-      tCollPointInfo& ptInfo = collInfo->mPointInfo[iPos];
-      mCachedContacts.insert(
-        make_pair(tBodyPair(collInfo->mSkinInfo.skin0->GetOwner(), 
-                            collInfo->mSkinInfo.skin1->GetOwner(), ptInfo.mR0, ptInfo.mR1), 
-                  tCachedImpulses(ptInfo.mAccumulatedNormalImpulse,
-                                  ptInfo.mAccumulatedNormalImpulseAux,
-                                  collInfo->mSkinInfo.skin0->GetOwner() > collInfo->mSkinInfo.skin1->GetOwner() ? 
-                                    ptInfo.mAccumulatedFrictionImpulse : -ptInfo.mAccumulatedFrictionImpulse)));
+      const tCollPointInfo& ptInfo = collInfo->mPointInfo[iPos];
+      tCachedContact cached;
+      cached.mLocalPos0 = invOrient0 * ptInfo.mR0;
+      cached.mLocalPos1 = invOrient1 * ptInfo.mR1;
+      cached.mNormalImpulse = ptInfo.mAccumulatedNormalImpulse;
+      cached.mNormalImpulseAux = ptInfo.mAccumulatedNormalImpulseAux;
+      cached.mFrictionImpulse = ptInfo.mAccumulatedFrictionImpulse;
+      if (swapped)
+      {
+        std::swap(cached.mLocalPos0, cached.mLocalPos1);
+        cached.mFrictionImpulse = -cached.mFrictionImpulse;
+      }
+      // ignored if it's full
+      manifold.mContacts.PushBack(cached);
     }
   }
+
+  // forget about pairs that aren't touching any more
+  for (unsigned iSlot = 0 ; iSlot < mContactManifolds.GetNumSlots() ; )
+  {
+    if (mContactManifolds.IsUsed(iSlot) &&
+        mContactManifolds.GetValue(iSlot).mFrame != mContactCacheFrame)
+      mContactManifolds.RemoveSlot(iSlot);
+    else
+      ++iSlot;
+  }
 }
 
 //==============================================================
@@ -1843,6 +1953,11 @@ void tPhysicsSystem::UpdateContactCache()
 void tPhysicsSystem::Integrate(tScalar dt)
 {
   TRACE_METHOD_ONLY(FRAME_1);
+  // anything called back during the update that still uses the
+  // current system should get us, even if this thread normally
+  // looks after a different one.
+  tPhysicsSystem * oldCurrent = GetCurrentPhysicsSystem();
+  SetCurrentPhysicsSystem(this);
   mDoingIntegration = true;
 
   mOldTime = mTargetTime;
@@ -1858,6 +1973,8 @@ void tPhysicsSystem::Integrate(tScalar dt)
 
   DetectAllCollisions(dt);
 
+  FormAllIslands();
+
   HandleAllConstraints(dt, mNumCollisionIterations, false);
 
   UpdateAllVelocities(dt);
@@ -1880,12 +1997,12 @@ void tPhysicsSystem::Integrate(tScalar dt)
 
   UpdateAllPositions(dt);
 
+  HandleAllFastBodies();
+
   NotifyAllPostPhysics(dt);
 
-#ifdef USE_OLD_IMPULSE
-  if (mSolverType == SOLVER_ACCUMULATED)
+  if (mSolverType == SOLVER_ACCUMULATED || mSolverType == SOLVER_BATCHED)
     UpdateContactCache();
-#endif
 
   if (mNullUpdate)
   {
@@ -1894,5 +2011,6 @@ void tPhysicsSystem::Integrate(tScalar dt)
   }
 
   mDoingIntegration = false;
+  SetCurrentPhysicsSystem(oldCurrent);
 }
 
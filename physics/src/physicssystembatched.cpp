@@ -0,0 +1,269 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file physicssystembatched.cpp 
+//                     
+//==============================================================
+#include "physicssystem.hpp"
+#include "body.hpp"
+#include "constraint.hpp"
+
+#include "collisionskin.hpp"
+#include "collisioninfo.hpp"
+
+#include "trace.hpp"
+#include "threadpool.hpp"
+
+using namespace JigLib;
+using namespace std;
+
+// Contacts are solved in tasks of this many when a batch is split
+// over the thread pool
+static const unsigned contactsPerTask = 8;
+
+//==============================================================
+// tContactBatchJob
+//==============================================================
+class tPhysicsSystem::tContactBatchJob : public tThreadJob
+{
+public:
+  tContactBatchJob(tPhysicsSystem & physics, unsigned begin, unsigned end, 
+                   tScalar dt, bool preProcess)
+    : mPhysics(physics), mBegin(begin), mEnd(end), mDt(dt), mPreProcess(preProcess) {}
+
+  void Run(unsigned iTask, unsigned iThread)
+  {
+    unsigned begin = mBegin + iTask * contactsPerTask;
+    unsigned end = Min(begin + contactsPerTask, mEnd);
+    for (unsigned i = begin ; i < end ; ++i)
+      mPhysics.ProcessBatchedContact(i, mDt, mPreProcess);
+  }
+private:
+  tPhysicsSystem & mPhysics;
+  unsigned mBegin;
+  unsigned mEnd;
+  tScalar mDt;
+  bool mPreProcess;
+};
+
+//==============================================================
+// ColourContacts
+// Greedy colouring - each contact gets the lowest colour that isn't
+// already used by one of its bodies. Immovable bodies don't get
+// changed by the solver, so they can be shared.
+//==============================================================
+void tPhysicsSystem::ColourContacts()
+{
+  const unsigned numContacts = mContactsToBatch.size();
+  mBodyColours.assign(mBodies.size(), 0);
+  mContactColours.resize(numContacts);
+
+  unsigned numColours = 0;
+  unsigned i;
+  for (i = 0 ; i < numContacts ; ++i)
+  {
+    const tCollisionInfo * info = mContactsToBatch[i];
+    const tBody * body0 = info->mSkinInfo.skin0->GetOwner();
+    const tBody * body1 = info->mSkinInfo.skin1->GetOwner();
+    int node0 = GetIslandNode(body0);
+    int node1 = GetIslandNode(body1);
+
+    unsigned colour = MAX_CONTACT_COLOURS;
+    // movable bodies that aren't ours can't be tracked, so anything
+    // touching them gets done serially
+    if ( (node0 >= 0 || !body0 || body0->GetImmovable()) &&
+         (node1 >= 0 || !body1 || body1->GetImmovable()) )
+    {
+      unsigned long long used = 0;
+      if (node0 >= 0)
+        used |= mBodyColours[node0];
+      if (node1 >= 0)
+        used |= mBodyColours[node1];
+
+      colour = 0;
+      while (colour < MAX_CONTACT_COLOURS && (used & (1ULL << colour)))
+        ++colour;
+      if (colour < MAX_CONTACT_COLOURS)
+      {
+        if (node0 >= 0)
+          mBodyColours[node0] |= 1ULL << colour;
+        if (node1 >= 0)
+          mBodyColours[node1] |= 1ULL << colour;
+      }
+    }
+    mContactColours[i] = colour;
+    numColours = Max(numColours, colour + 1);
+  }
+
+  // counting sort into the batches, keeping the original order in
+  // each
+  mBatchStarts.assign(numColours + 1, 0);
+  for (i = 0 ; i < numContacts ; ++i)
+    ++mBatchStarts[mContactColours[i] + 1];
+  for (i = 0 ; i < numColours ; ++i)
+    mBatchStarts[i + 1] += mBatchStarts[i];
+
+  mBatchedContacts.resize(numContacts);
+  mBatchedContactResults.resize(numContacts);
+  for (i = 0 ; i < numContacts ; ++i)
+    mBatchedContacts[mBatchStarts[mContactColours[i]]++] = mContactsToBatch[i];
+  // that moved each start on to the end of its batch
+  for (i = numColours ; i-- != 0 ; )
+    mBatchStarts[i + 1] = mBatchStarts[i];
+  mBatchStarts[0] = 0;
+}
+
+//==============================================================
+// ProcessBatchedContact
+//==============================================================
+void tPhysicsSystem::ProcessBatchedContact(unsigned i, tScalar dt, bool preProcess)
+{
+  tCollisionInfo * collision = mBatchedContacts[i];
+  if (preProcess)
+  {
+    (this->*mPreProcessContactFn)(collision, dt);
+    collision->mMatPairProperties.mRestitution = 0.0f;
+    collision->mSatisfied = false;
+    mBatchedContactResults[i] = false;
+  }
+  else
+  {
+    mBatchedContactResults[i] = !collision->mSatisfied && ApplyAccumulatedImpulses(collision);
+  }
+}
+
+//==============================================================
+// RunContactBatch
+//==============================================================
+bool tPhysicsSystem::RunContactBatch(unsigned iBatch, tScalar dt, bool preProcess)
+{
+  const unsigned begin = mBatchStarts[iBatch];
+  const unsigned end = mBatchStarts[iBatch + 1];
+  unsigned i;
+
+  // contacts that didn't get a colour can share bodies, so they have
+  // to be done one after the other
+  if (iBatch == MAX_CONTACT_COLOURS)
+  {
+    bool gotOne = false;
+    for (i = begin ; i < end ; ++i)
+    {
+      if (preProcess)
+        ProcessBatchedContact(i, dt, true);
+      else if (!mBatchedContacts[i]->mSatisfied)
+        gotOne |= ProcessCollisionAccumulated(mBatchedContacts[i], dt, false);
+    }
+    return gotOne;
+  }
+
+  const unsigned numTasks = (end - begin + contactsPerTask - 1) / contactsPerTask;
+  if (mThreadPool && mThreadPool->GetNumThreads() > 1 && numTasks > 1)
+  {
+    tContactBatchJob job(*this, begin, end, dt, preProcess);
+    mThreadPool->RunJob(job, numTasks);
+  }
+  else
+  {
+    for (i = begin ; i < end ; ++i)
+      ProcessBatchedContact(i, dt, preProcess);
+  }
+
+  if (preProcess)
+    return false;
+
+  // Marking the neighbours as unsatisfied touches other contacts (and
+  // constraints), so it's left until the batch is done. Nothing else
+  // in the batch would have been affected anyway, since they don't
+  // share bodies.
+  bool gotOne = false;
+  for (i = begin ; i < end ; ++i)
+  {
+    if (!mBatchedContactResults[i])
+      continue;
+    gotOne = true;
+    tCollisionInfo * collision = mBatchedContacts[i];
+    collision->mSkinInfo.skin0->GetOwner()->SetConstraintsAndCollisionsUnsatisfied();
+    if (collision->mSkinInfo.skin1->GetOwner())
+      collision->mSkinInfo.skin1->GetOwner()->SetConstraintsAndCollisionsUnsatisfied();
+  }
+  return gotOne;
+}
+
+//==============================================================
+// HandleAllContactsBatched
+// The contact iterations for SOLVER_BATCHED. Rather than going
+// island by island, the contacts from all the islands get coloured
+// into batches that don't share movable bodies, and each batch is
+// spread over the thread pool - so big islands (stacks etc) get
+// split up too. The results don't depend on the number of threads.
+//==============================================================
+void tPhysicsSystem::HandleAllContactsBatched(tScalar dt, unsigned iter)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  mContactsToBatch.resize(0);
+  mBatchedConstraints.resize(0);
+  unsigned i;
+  for (i = 0 ; i < mNumIslands ; ++i)
+  {
+    const tIsland & island = mIslands[i];
+    mContactsToBatch.insert(mContactsToBatch.end(), 
+                            island.mCollisions.begin(), island.mCollisions.end());
+    mBatchedConstraints.insert(mBatchedConstraints.end(), 
+                               island.mConstraints.begin(), island.mConstraints.end());
+  }
+  const unsigned numConstraints = mBatchedConstraints.size();
+  if (mContactsToBatch.empty() && numConstraints == 0)
+    return;
+
+  // prepare all the constraints
+  for (i = 0 ; i < numConstraints ; ++i)
+    mBatchedConstraints[i]->PreApply(dt);
+
+  ColourContacts();
+  unsigned numBatches = mBatchStarts.size() - 1;
+  for (i = 0 ; i < numBatches ; ++i)
+    RunContactBatch(i, dt, true);
+
+  // iterate over the batches, alternating the direction
+  bool dir = (mNumConstraintPasses & 1) != 0;
+  for (unsigned step = 0 ; step < iter ; ++step)
+  {
+    bool gotOne = false;
+    dir = !dir;
+    for (i = 0 ; i < numBatches ; ++i)
+      gotOne |= RunContactBatch(dir ? i : numBatches - 1 - i, dt, false);
+
+    for (i = 0 ; i < numConstraints ; ++i)
+    {
+      if (!mBatchedConstraints[i]->GetSatisfied())
+        gotOne |= mBatchedConstraints[i]->Apply(dt);
+    }
+
+    // wake up any frozen objects that got knocked. Any collisions
+    // they bring in mean the batches have to be redone.
+    if (mFreezingEnabled)
+    {
+      unsigned origNumCollisions = mCollisions.size();
+      TryToActivateFrozenObjects(mBodies);
+      unsigned numCollisions = mCollisions.size();
+      if (numCollisions > origNumCollisions)
+      {
+        for (i = origNumCollisions ; i < numCollisions ; ++i)
+        {
+          tCollisionInfo * collision = mCollisions[i];
+          (this->*mPreProcessContactFn)(collision, dt);
+          collision->mMatPairProperties.mRestitution = 0.0f;
+          collision->mSatisfied = false;
+          mContactsToBatch.push_back(collision);
+        }
+        ColourContacts();
+        numBatches = mBatchStarts.size() - 1;
+      }
+    }
+
+    if (!gotOne)
+      break;
+  }
+}
@@ -0,0 +1,202 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file physicssystemfastbodies.cpp 
+//                     
+//==============================================================
+#include "physicssystem.hpp"
+#include "body.hpp"
+
+#include "collisionskin.hpp"
+#include "collisionsystem.hpp"
+
+#include "trace.hpp"
+
+#include <algorithm>
+
+using namespace JigLib;
+using namespace std;
+
+//==============================================================
+// tFastBodySkinPredicate
+// Stops a fast body being swept against itself, or against things it
+// isn't allowed to collide with
+//==============================================================
+class tFastBodySkinPredicate : public tCollisionSkinPredicate1
+{
+public:
+  tFastBodySkinPredicate(const tCollisionSkin * skin) : mSkin(skin) {}
+
+  virtual bool ConsiderSkin(tCollisionSkin * skin) const
+  {
+    if (skin == mSkin || skin->GetOwner() == mSkin->GetOwner())
+      return false;
+    const vector<const tCollisionSkin *> & nonCollidables = mSkin->GetNonCollidables();
+    if (find(nonCollidables.begin(), nonCollidables.end(), skin) != nonCollidables.end())
+      return false;
+    const vector<const tCollisionSkin *> & otherNonCollidables = skin->GetNonCollidables();
+    return find(otherNonCollidables.begin(), otherNonCollidables.end(), mSkin) == 
+      otherNonCollidables.end();
+  }
+private:
+  const tCollisionSkin * mSkin;
+};
+
+//==============================================================
+// GetFastBodySize
+// The radius of the thinnest primitive - or SCALAR_HUGE (so it's
+// never fast) if there are primitives that can't be swept.
+//==============================================================
+static tScalar GetFastBodySize(const tCollisionSkin & skin)
+{
+  tScalar size = SCALAR_HUGE;
+  const unsigned numPrims = skin.GetNumPrimitives();
+  for (unsigned iPrim = 0 ; iPrim < numPrims ; ++iPrim)
+  {
+    const tPrimitive * prim = skin.GetPrimitiveLocal(iPrim);
+    switch (prim->GetType())
+    {
+    case tPrimitive::SPHERE:
+      size = Min(size, prim->GetSphere().GetRadius());
+      break;
+    case tPrimitive::CAPSULE:
+      size = Min(size, prim->GetCapsule().GetRadius());
+      break;
+    case tPrimitive::BOX:
+    {
+      const tVector3 & sides = prim->GetBox().GetSideLengths();
+      size = Min(size, SCALAR(0.5f) * Min(sides.x, sides.y, sides.z));
+      break;
+    }
+    default:
+      return SCALAR_HUGE;
+    }
+  }
+  return size;
+}
+
+//==============================================================
+// HandleAllFastBodies
+//==============================================================
+void tPhysicsSystem::HandleAllFastBodies()
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  if (!mCollisionSystem || mCCDMotionThreshold <= SCALAR(0.0f))
+    return;
+
+  const unsigned numBodies = mActiveBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    tBody * body = mActiveBodies[i];
+    tCollisionSkin * skin = body->GetCollisionSkin();
+    if (!skin || body->GetImmovable())
+      continue;
+    const tScalar size = GetFastBodySize(*skin);
+    const tScalar moved = (body->GetPosition() - body->GetOldPosition()).GetLengthSq();
+    if (moved > Sq(mCCDMotionThreshold * size))
+      HandleFastBody(*body, SCALAR(0.5f) * size);
+  }
+}
+
+//==============================================================
+// HandleFastBody
+// Sweeps the primitives from where they were at the start of the
+// step, shrunk by shrink so that resting/sliding contacts (which the
+// normal collision handles) don't count. If anything gets hit the
+// body is moved back to that point, and stopped moving into it.
+//==============================================================
+void tPhysicsSystem::HandleFastBody(tBody & body, tScalar shrink)
+{
+  tCollisionSkin & skin = *body.GetCollisionSkin();
+  const tVector3 delta = body.GetPosition() - body.GetOldPosition();
+  tFastBodySkinPredicate predicate(&skin);
+
+  tScalar bestFrac = SCALAR_HUGE;
+  tCollisionSkin * bestSkin = 0;
+  tVector3 bestPos(SCALAR(0.0f));
+  tVector3 bestNormal(SCALAR(0.0f));
+  tScalar frac;
+  tCollisionSkin * hitSkin;
+  tVector3 pos, normal;
+
+  const unsigned numPrims = skin.GetNumPrimitives();
+  for (unsigned iPrim = 0 ; iPrim < numPrims ; ++iPrim)
+  {
+    const tPrimitive * prim = skin.GetPrimitiveOldWorld(iPrim);
+    bool hit = false;
+    switch (prim->GetType())
+    {
+    case tPrimitive::SPHERE:
+    {
+      const tSphere & sphere = prim->GetSphere();
+      hit = mCollisionSystem->ShapeCast(frac, hitSkin, pos, normal, 
+                                        tSphere(sphere.GetPos(), sphere.GetRadius() - shrink),
+                                        delta, &predicate);
+      break;
+    }
+    case tPrimitive::CAPSULE:
+    {
+      const tCapsule & capsule = prim->GetCapsule();
+      hit = mCollisionSystem->ShapeCast(frac, hitSkin, pos, normal, 
+                                        tCapsule(capsule.GetPos(), capsule.GetOrient(),
+                                                 capsule.GetRadius() - shrink, 
+                                                 capsule.GetLength()),
+                                        delta, &predicate);
+      break;
+    }
+    case tPrimitive::BOX:
+    {
+      const tBox & box = prim->GetBox();
+      const tMatrix33 & orient = box.GetOrient();
+      const tVector3 inset = shrink * (orient[0] + orient[1] + orient[2]);
+      hit = mCollisionSystem->ShapeCast(frac, hitSkin, pos, normal,
+                                        tBox(box.GetPos() + inset, orient, 
+                                             box.GetSideLengths() - tVector3(SCALAR(2.0f) * shrink)),
+                                        delta, &predicate);
+      break;
+    }
+    default:
+      break;
+    }
+    if (hit && frac < bestFrac)
+    {
+      bestFrac = frac;
+      bestSkin = hitSkin;
+      bestPos = pos;
+      bestNormal = normal;
+    }
+  }
+  if (!bestSkin)
+    return;
+
+  body.SetPosition(body.GetOldPosition() + bestFrac * delta);
+  skin.SetTransform(body.GetOldTransform(), body.GetTransform());
+
+  // Now take out the velocity into whatever we hit - as an inelastic
+  // collision. Things that aren't moving are treated as immovable
+  // (they'll get activated by the normal collision next step).
+  tBody * other = bestSkin->GetOwner();
+  if (other && (other->GetImmovable() || !other->IsActive()))
+    other = 0;
+
+  const tVector3 r0 = bestPos - body.GetPosition();
+  tVector3 relVel = body.GetVelocity(r0);
+  tScalar denominator = body.GetInvMass() + 
+    Dot(bestNormal, Cross(body.GetWorldInvInertia() * Cross(r0, bestNormal), r0));
+  if (other)
+  {
+    const tVector3 r1 = bestPos - other->GetPosition();
+    relVel -= other->GetVelocity(r1);
+    denominator += other->GetInvMass() + 
+      Dot(bestNormal, Cross(other->GetWorldInvInertia() * Cross(r1, bestNormal), r1));
+  }
+  const tScalar normalVel = Dot(relVel, bestNormal);
+  if (normalVel >= SCALAR(0.0f) || denominator < SCALAR_TINY)
+    return;
+  const tVector3 impulse = (-normalVel / denominator) * bestNormal;
+  body.ApplyWorldImpulse(impulse, bestPos);
+  if (other)
+    other->ApplyNegativeWorldImpulse(impulse, bestPos);
+}
@@ -0,0 +1,351 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file physicssystemislands.cpp 
+//                     
+//==============================================================
+#include "physicssystem.hpp"
+#include "body.hpp"
+#include "constraint.hpp"
+
+#include "collisionskin.hpp"
+#include "collisioninfo.hpp"
+
+#include "trace.hpp"
+
+#include <algorithm>
+
+using namespace JigLib;
+using namespace std;
+
+//==============================================================
+// try_to_freeze_all_objects
+// Islands only freeze when every body in them is ready to
+//==============================================================
+void tPhysicsSystem::TryToFreezeAllObjects(tScalar dt)
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  for (unsigned iIsland = 0 ; iIsland < mNumIslands ; ++iIsland)
+  {
+    tIsland & island = mIslands[iIsland];
+    const unsigned numBodies = island.mBodies.size();
+    if (numBodies == 0)
+      continue;
+    // don't stop early - every body needs its timer updating
+    bool freeze = true;
+    for (unsigned i = 0 ; i < numBodies ; ++i)
+    {
+      if (!island.mBodies[i]->TryToFreeze(dt))
+        freeze = false;
+    }
+    if (freeze)
+      FreezeIsland(island);
+  }
+}
+
+//==============================================================
+// FreezeIsland
+//==============================================================
+void tPhysicsSystem::FreezeIsland(tIsland & island)
+{
+  const unsigned numBodies = island.mBodies.size();
+  unsigned i;
+  // some of the bodies may already be asleep in other islands
+  for (i = 0 ; i < numBodies ; ++i)
+    UnlinkSleepingBody(island.mBodies[i]);
+  for (i = 0 ; i < numBodies ; ++i)
+  {
+    tBody * body = island.mBodies[i];
+    body->mNextSleepingBody = island.mBodies[(i + 1) % numBodies];
+    body->Freeze();
+  }
+}
+
+//==============================================================
+// WakeSleepingIsland
+//==============================================================
+void tPhysicsSystem::WakeSleepingIsland(tBody * body)
+{
+  if (body->mNextSleepingBody == body)
+    return;
+
+  // break the ring up before activating anything, since each
+  // activation will come back here
+  std::vector<tBody *> bodies;
+  tBody * next = body->mNextSleepingBody;
+  body->mNextSleepingBody = body;
+  while (next != body)
+  {
+    tBody * other = next;
+    next = other->mNextSleepingBody;
+    other->mNextSleepingBody = other;
+    bodies.push_back(other);
+  }
+
+  for (unsigned i = 0 ; i < bodies.size() ; ++i)
+    ActivateObject(bodies[i]);
+}
+
+//==============================================================
+// UnlinkSleepingBody
+//==============================================================
+void tPhysicsSystem::UnlinkSleepingBody(tBody * body)
+{
+  if (body->mNextSleepingBody == body)
+    return;
+  tBody * prev = body->mNextSleepingBody;
+  while (prev->mNextSleepingBody != body)
+    prev = prev->mNextSleepingBody;
+  prev->mNextSleepingBody = body->mNextSleepingBody;
+  body->mNextSleepingBody = body;
+}
+
+//==============================================================
+// activate_all_frozen_objects_left_hanging
+//==============================================================
+void tPhysicsSystem::ActivateAllFrozenObjectsLeftHanging()
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  const unsigned numBodies = mBodies.size();
+  for (unsigned i = 0 ; i < numBodies ; ++i)
+  {
+    tBody * thisBody = mBodies[i];
+    if ( thisBody->IsActive() &&
+         thisBody->GetCollisionSkin() )
+    {
+      // first activate any bodies due to the movement of this body
+      thisBody->DoMovementActivations();
+
+      // now record any movement notifications that are needed
+      vector<tCollisionInfo *> & collisions = 
+        mBodies[i]->GetCollisionSkin()->GetCollisions();
+      if (!collisions.empty())
+      {
+        // walk through the object's contact list
+        unsigned j;
+        const unsigned numCollisions = collisions.size();
+        for (j = 0 ; j < numCollisions ; ++j)
+        {
+          const tCollisionInfo & coll = *collisions[j];
+          Assert(coll.mSkinInfo.skin1);
+          // must be a body-body interaction to be interesting
+          if (coll.mSkinInfo.skin1->GetOwner())
+          {
+            tBody * other_body = coll.mSkinInfo.skin0->GetOwner();
+//            tVector3 dirToOther = coll.mDirToBody0;
+
+            if (other_body == thisBody)
+            {
+              other_body = coll.mSkinInfo.skin1->GetOwner();
+//              dirToOther.Negate();
+            }
+            if (!other_body->IsActive())
+            {
+              // only wake up objects that would "fall" against this
+              // one...  actually don't do this because it breaks if
+              // an object below should rotate (e.g. removing a top
+              // block from a wall)
+//              if (Dot(dirToOther, other_body->GetForce()) < -SCALAR_TINY)
+              {
+                thisBody->AddMovementActivation(
+                  thisBody->GetPosition(), 
+                  other_body);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+
+//==============================================================
+// enable_freezing
+//==============================================================
+void tPhysicsSystem::EnableFreezing(bool freeze)
+{
+  TRACE_METHOD_ONLY(ONCE_2);
+  mFreezingEnabled = freeze;
+
+  if (!mFreezingEnabled)
+  {
+    int numBodies = mBodies.size();
+    int i;
+    for (i = 0 ; i < numBodies ; ++i)
+    {
+      mBodies[i]->SetActive();
+    }
+  }
+}
+
+//==============================================================
+// GetIslandNode
+//==============================================================
+int tPhysicsSystem::GetIslandNode(const tBody * body) const
+{
+  // the collision system may know about skins whose bodies aren't
+  // ours, so check the index is really for this body
+  if (!body || body->mIslandNode < 0)
+    return -1;
+  if ((unsigned) body->mIslandNode >= mBodies.size() || 
+      mBodies[body->mIslandNode] != body)
+    return -1;
+  return body->mIslandNode;
+}
+
+//==============================================================
+// FindIslandRoot
+//==============================================================
+int tPhysicsSystem::FindIslandRoot(int node)
+{
+  int root = node;
+  while (mIslandParents[root] != root)
+    root = mIslandParents[root];
+  // compress the path
+  while (mIslandParents[node] != root)
+  {
+    int next = mIslandParents[node];
+    mIslandParents[node] = root;
+    node = next;
+  }
+  return root;
+}
+
+//==============================================================
+// JoinIslandNodes
+//==============================================================
+void tPhysicsSystem::JoinIslandNodes(int node0, int node1)
+{
+  int root0 = FindIslandRoot(node0);
+  int root1 = FindIslandRoot(node1);
+  if (root0 == root1)
+    return;
+  // keep the lower index as the root so the island order follows the
+  // body order
+  if (root0 < root1)
+    mIslandParents[root1] = root0;
+  else
+    mIslandParents[root0] = root1;
+}
+
+//==============================================================
+// GetIsland
+// Returns the island at islandIndex, first setting up a new one 
+// if islandIndex is -1
+//==============================================================
+tPhysicsSystem::tIsland & tPhysicsSystem::GetIsland(int & islandIndex)
+{
+  if (islandIndex < 0)
+  {
+    islandIndex = mNumIslands++;
+    if (mNumIslands > mIslands.size())
+      mIslands.resize(mNumIslands);
+    tIsland & island = mIslands[islandIndex];
+    island.mBodies.resize(0);
+    island.mCollisions.resize(0);
+    island.mConstraints.resize(0);
+  }
+  return mIslands[islandIndex];
+}
+
+//==============================================================
+// FormAllIslands
+// Union-find over the bodies, joining them through the collisions
+// and constraints. Immovable bodies (and skins without bodies) don't
+// join anything together, since nothing is transmitted through them.
+//==============================================================
+void tPhysicsSystem::FormAllIslands()
+{
+  TRACE_METHOD_ONLY(FRAME_1);
+  mNumIslands = 0;
+  mLooseIsland = -1;
+
+  const unsigned numBodies = mBodies.size();
+  const unsigned numCollisions = mCollisions.size();
+  const unsigned numConstraints = mConstraints.size();
+  unsigned i;
+
+  mIslandParents.resize(numBodies);
+  mIslandOfRoot.resize(numBodies);
+  for (i = 0 ; i < numBodies ; ++i)
+  {
+    mIslandParents[i] = i;
+    mIslandOfRoot[i] = -1;
+    mBodies[i]->mIslandNode = mBodies[i]->GetImmovable() ? -1 : (int) i;
+  }
+
+  // join bodies that are touching
+  for (i = 0 ; i < numCollisions ; ++i)
+  {
+    const tCollisionInfo * info = mCollisions[i];
+    int node0 = GetIslandNode(info->mSkinInfo.skin0->GetOwner());
+    int node1 = GetIslandNode(info->mSkinInfo.skin1->GetOwner());
+    if (node0 >= 0 && node1 >= 0)
+      JoinIslandNodes(node0, node1);
+  }
+
+  // and bodies that share a constraint. Constraints don't tell us
+  // about their bodies, but the bodies know about their constraints.
+  for (i = 0 ; i < numConstraints ; ++i)
+    mConstraints[i]->mIslandNode = -1;
+  for (i = 0 ; i < numBodies ; ++i)
+  {
+    if (mBodies[i]->mIslandNode < 0)
+      continue;
+    const tConstraints & constraints = mBodies[i]->mConstraints;
+    for (unsigned j = constraints.size() ; j-- != 0 ; )
+    {
+      tConstraint * constraint = constraints[j];
+      if (!constraint->GetConstraintEnabled())
+        continue;
+      if (constraint->mIslandNode < 0)
+        constraint->mIslandNode = i;
+      else
+        JoinIslandNodes(constraint->mIslandNode, i);
+    }
+  }
+
+  // Only make islands for active bodies and for things that need
+  // solving - lone frozen bodies can be left alone.
+  for (i = 0 ; i < numBodies ; ++i)
+  {
+    if (mBodies[i]->mIslandNode >= 0 && mBodies[i]->IsActive())
+      GetIsland(mIslandOfRoot[FindIslandRoot(i)]);
+  }
+
+  for (i = 0 ; i < numCollisions ; ++i)
+  {
+    tCollisionInfo * info = mCollisions[i];
+    int node = GetIslandNode(info->mSkinInfo.skin0->GetOwner());
+    if (node < 0)
+      node = GetIslandNode(info->mSkinInfo.skin1->GetOwner());
+    if (node < 0)
+      GetIsland(mLooseIsland).mCollisions.push_back(info);
+    else
+      GetIsland(mIslandOfRoot[FindIslandRoot(node)]).mCollisions.push_back(info);
+  }
+
+  for (i = 0 ; i < numConstraints ; ++i)
+  {
+    tConstraint * constraint = mConstraints[i];
+    if (constraint->mIslandNode < 0)
+      GetIsland(mLooseIsland).mConstraints.push_back(constraint);
+    else
+      GetIsland(mIslandOfRoot[FindIslandRoot(constraint->mIslandNode)]).mConstraints.push_back(constraint);
+  }
+
+  for (i = 0 ; i < numBodies ; ++i)
+  {
+    if (mBodies[i]->mIslandNode < 0)
+      continue;
+    int island = mIslandOfRoot[FindIslandRoot(i)];
+    if (island >= 0)
+      mIslands[island].mBodies.push_back(mBodies[i]);
+  }
+
+  TRACE_FILE_IF(FRAME_2)
+    TRACE("%d islands\n", mNumIslands);
+}
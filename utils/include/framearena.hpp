@@ -0,0 +1,111 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file framearena.hpp 
+//                     
+//==============================================================
+#ifndef JIGFRAMEARENA_HPP
+#define JIGFRAMEARENA_HPP
+
+#include "../utils/include/assert.hpp"
+
+#include <vector>
+#include <cstdlib>
+#include <cstddef>
+
+namespace JigLib
+{
+  /// Hands out memory for things that only last until the end of the
+  /// frame by bumping a pointer along a block. When the block runs
+  /// out another is started, and Reset makes everything available
+  /// again. If a frame needed more than one block they get replaced
+  /// by a single one big enough for all of it, so after the first
+  /// few frames there's just one block and nothing gets allocated.
+  ///
+  /// Nothing gets destructed, so only use it for things that don't
+  /// need to be.
+  class tFrameArena
+  {
+  public:
+    tFrameArena(size_t blockSize = 64 * 1024)
+      : mBlockSize(blockSize), mCurrent(0), mUsed(0), mTotalUsed(0) {}
+
+    ~tFrameArena() {FreeBlocks();}
+
+    /// Returns uninitialised memory, aligned to align (which should
+    /// be a power of two), for numBytes.
+    void * Alloc(size_t numBytes, size_t align = sizeof(void *))
+    {
+      size_t offset = (mUsed + align - 1) & ~(align - 1);
+      if (mCurrent >= mBlocks.size() || offset + numBytes > mBlocks[mCurrent].mSize)
+      {
+        NewBlock(numBytes + align);
+        offset = (mUsed + align - 1) & ~(align - 1);
+      }
+      mTotalUsed += offset + numBytes - mUsed;
+      mUsed = offset + numBytes;
+      return mBlocks[mCurrent].mData + offset;
+    }
+
+    /// Uninitialised space for num of T
+    template<typename T>
+    T * Alloc(unsigned num = 1)
+    {
+      return static_cast<T *>(Alloc(num * sizeof(T), alignof(T)));
+    }
+
+    /// Makes all the memory available again - anything allocated
+    /// before must not be used after this.
+    void Reset()
+    {
+      if (mBlocks.size() > 1)
+      {
+        size_t size = mTotalUsed > mBlockSize ? mTotalUsed : mBlockSize;
+        FreeBlocks();
+        mBlocks.push_back(tBlock(size));
+      }
+      mCurrent = 0;
+      mUsed = 0;
+      mTotalUsed = 0;
+    }
+
+    /// How much has been handed out since the last Reset
+    size_t GetNumBytesUsed() const {return mTotalUsed;}
+
+  private:
+    tFrameArena(const tFrameArena &);
+    tFrameArena & operator=(const tFrameArena &);
+
+    struct tBlock
+    {
+      tBlock(size_t size) : mData(static_cast<char *>(malloc(size))), mSize(size) {Assert(mData);}
+      char * mData;
+      size_t mSize;
+    };
+
+    void NewBlock(size_t minSize)
+    {
+      mBlocks.push_back(tBlock(minSize > mBlockSize ? minSize : mBlockSize));
+      mCurrent = mBlocks.size() - 1;
+      mUsed = 0;
+    }
+
+    void FreeBlocks()
+    {
+      for (unsigned i = 0 ; i < mBlocks.size() ; ++i)
+        free(mBlocks[i].mData);
+      mBlocks.clear();
+    }
+
+    size_t mBlockSize;
+    std::vector<tBlock> mBlocks;
+    unsigned mCurrent;
+    /// used in the current block
+    size_t mUsed;
+    size_t mTotalUsed;
+  };
+}
+
+#endif
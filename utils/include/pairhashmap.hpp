@@ -0,0 +1,185 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file pairhashmap.hpp 
+//                     
+//==============================================================
+#ifndef JIGPAIRHASHMAP_HPP
+#define JIGPAIRHASHMAP_HPP
+
+#include "../utils/include/assert.hpp"
+
+#include <vector>
+#include <cstddef>
+
+namespace JigLib
+{
+  /// Maps a pair of keys (indices or pointers cast to size_t) to a
+  /// value. Uses open addressing in a single array, so lookups don't
+  /// allocate and entries are next to each other in memory. The pair
+  /// is ordered - if (a, b) should be the same as (b, a) then the
+  /// caller needs to sort them first.
+  ///
+  /// Pointers to values are only valid until the next Insert or
+  /// Remove.
+  template<typename T>
+  class tPairHashMap
+  {
+  public:
+    tPairHashMap() : mNumEntries(0) {}
+
+    /// returns the value for the pair, or 0 if it's not there
+    T * Find(size_t key0, size_t key1)
+    {
+      if (mNumEntries == 0)
+        return 0;
+      unsigned mask = mEntries.size() - 1;
+      for (unsigned i = Hash(key0, key1) & mask ; mEntries[i].mUsed ; i = (i + 1) & mask)
+      {
+        if (mEntries[i].mKey0 == key0 && mEntries[i].mKey1 == key1)
+          return &mEntries[i].mValue;
+      }
+      return 0;
+    }
+
+    const T * Find(size_t key0, size_t key1) const
+    {
+      return const_cast<tPairHashMap *>(this)->Find(key0, key1);
+    }
+
+    /// returns the value for the pair, adding a default one if it's
+    /// not there yet. isNew indicates which happened.
+    T & Insert(size_t key0, size_t key1, bool & isNew)
+    {
+      if (2 * (mNumEntries + 1) > mEntries.size())
+        Grow();
+      unsigned mask = mEntries.size() - 1;
+      unsigned i = Hash(key0, key1) & mask;
+      for ( ; mEntries[i].mUsed ; i = (i + 1) & mask)
+      {
+        if (mEntries[i].mKey0 == key0 && mEntries[i].mKey1 == key1)
+        {
+          isNew = false;
+          return mEntries[i].mValue;
+        }
+      }
+      tEntry & entry = mEntries[i];
+      entry.mKey0 = key0;
+      entry.mKey1 = key1;
+      entry.mValue = T();
+      entry.mUsed = true;
+      ++mNumEntries;
+      isNew = true;
+      return entry.mValue;
+    }
+
+    /// returns false if the pair wasn't there
+    bool Remove(size_t key0, size_t key1)
+    {
+      if (mNumEntries == 0)
+        return false;
+      unsigned mask = mEntries.size() - 1;
+      unsigned i = Hash(key0, key1) & mask;
+      for ( ; mEntries[i].mUsed ; i = (i + 1) & mask)
+      {
+        if (mEntries[i].mKey0 == key0 && mEntries[i].mKey1 == key1)
+          break;
+      }
+      if (!mEntries[i].mUsed)
+        return false;
+      RemoveEntry(i);
+      return true;
+    }
+
+    void Clear()
+    {
+      for (unsigned i = mEntries.size() ; i-- != 0 ; )
+        mEntries[i].mUsed = false;
+      mNumEntries = 0;
+    }
+
+    unsigned GetNumEntries() const {return mNumEntries;}
+
+    /// For iterating over the entries - use IsUsed on each slot
+    /// index up to GetNumSlots
+    unsigned GetNumSlots() const {return mEntries.size();}
+    bool IsUsed(unsigned iSlot) const {return mEntries[iSlot].mUsed;}
+    size_t GetKey0(unsigned iSlot) const {return mEntries[iSlot].mKey0;}
+    size_t GetKey1(unsigned iSlot) const {return mEntries[iSlot].mKey1;}
+    T & GetValue(unsigned iSlot) {return mEntries[iSlot].mValue;}
+    const T & GetValue(unsigned iSlot) const {return mEntries[iSlot].mValue;}
+
+    /// Removes the entry in the slot. Note that this can move a later
+    /// entry into this slot, so when removing whilst iterating, check
+    /// the same slot again.
+    void RemoveSlot(unsigned iSlot) {Assert(mEntries[iSlot].mUsed); RemoveEntry(iSlot);}
+
+    static unsigned Hash(size_t key0, size_t key1)
+    {
+      // mix the bits, so that indices and aligned pointers both spread
+      // out
+      unsigned long long h = (unsigned long long) key0 * 0x9E3779B97F4A7C15ULL;
+      h ^= (unsigned long long) key1 + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+      h ^= h >> 29;
+      h *= 0xBF58476D1CE4E5B9ULL;
+      h ^= h >> 32;
+      return (unsigned) h;
+    }
+
+  private:
+    struct tEntry
+    {
+      tEntry() : mKey0(0), mKey1(0), mUsed(false) {}
+      size_t mKey0;
+      size_t mKey1;
+      T mValue;
+      bool mUsed;
+    };
+
+    /// Empties slot i, then moves back any entries after it that would
+    /// otherwise not be found (rather than leaving a marker).
+    void RemoveEntry(unsigned i)
+    {
+      unsigned mask = mEntries.size() - 1;
+      mEntries[i].mUsed = false;
+      --mNumEntries;
+      for (unsigned j = (i + 1) & mask ; mEntries[j].mUsed ; j = (j + 1) & mask)
+      {
+        unsigned home = Hash(mEntries[j].mKey0, mEntries[j].mKey1) & mask;
+        // can the entry at j stay where it is? Only if its home is
+        // cyclically in (i, j]
+        bool stay = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (stay)
+          continue;
+        mEntries[i] = mEntries[j];
+        mEntries[j].mUsed = false;
+        i = j;
+      }
+    }
+
+    void Grow()
+    {
+      std::vector<tEntry> oldEntries;
+      oldEntries.swap(mEntries);
+      unsigned newSize = oldEntries.empty() ? 16 : 2 * oldEntries.size();
+      mEntries.resize(newSize);
+      unsigned mask = newSize - 1;
+      for (unsigned iOld = oldEntries.size() ; iOld-- != 0 ; )
+      {
+        if (!oldEntries[iOld].mUsed)
+          continue;
+        unsigned i = Hash(oldEntries[iOld].mKey0, oldEntries[iOld].mKey1) & mask;
+        while (mEntries[i].mUsed)
+          i = (i + 1) & mask;
+        mEntries[i] = oldEntries[iOld];
+      }
+    }
+
+    std::vector<tEntry> mEntries;
+    unsigned mNumEntries;
+  };
+}
+
+#endif
@@ -0,0 +1,101 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file threadpool.hpp 
+//                     
+//==============================================================
+#ifndef JIGTHREADPOOL_HPP
+#define JIGTHREADPOOL_HPP
+
+#include "../include/jiglibconfig.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace JigLib
+{
+  /// A job that can be split into a number of independent tasks
+  class tThreadJob
+  {
+  public:
+    virtual ~tThreadJob() {}
+    /// Gets called once for every task in the job. iThread is in the
+    /// range [0, tThreadPool::GetNumThreads()) so can be used to index
+    /// per-thread scratch. Tasks may run in any order, and at the same
+    /// time as each other.
+    virtual void Run(unsigned iTask, unsigned iThread) = 0;
+  };
+
+  /// Runs jobs over a fixed set of worker threads. The tasks of a job
+  /// are dealt out to the threads as contiguous ranges, and a thread
+  /// that runs out of work steals half of what's left in another
+  /// thread's range - so it's fine to pass tasks of wildly different
+  /// sizes, though it helps to put the big ones first.
+  ///
+  /// The pool is owned by the user, and can be shared between the
+  /// physics and collision systems, and between physics systems
+  /// running on different threads - but only one job runs at a time,
+  /// so RunJob calls from different threads take turns.
+  class tThreadPool
+  {
+  public:
+    /// numThreads includes the thread that calls RunJob. If it's zero
+    /// then the number of hardware threads gets used.
+    tThreadPool(unsigned numThreads = 0);
+    ~tThreadPool();
+
+    /// number of threads (including the calling thread) that jobs get
+    /// split over
+    unsigned GetNumThreads() const {return mNumThreads;}
+
+    /// Runs all the tasks in the job, returning once they're all
+    /// done. The calling thread does work too (as thread 0). If
+    /// another thread is running a job this waits for it to finish
+    /// first - so a task mustn't call RunJob on the pool running it.
+    void RunJob(tThreadJob & job, unsigned numTasks);
+
+  private:
+    /// disallow copying
+    tThreadPool(const tThreadPool &);
+    tThreadPool & operator=(const tThreadPool &);
+
+    /// range of tasks belonging to one thread
+    struct tTaskRange
+    {
+      std::mutex mMutex;
+      unsigned mBegin;
+      unsigned mEnd;
+    };
+
+    void WorkerLoop(unsigned iThread);
+    /// runs tasks until there are none left that we can get at
+    void DoTasks(unsigned iThread);
+    /// takes the next task from our own range
+    bool PopTask(unsigned iThread, unsigned & iTask);
+    /// steals half the remaining range from another thread, and puts
+    /// it in ours. Returns false if there was nothing to steal.
+    bool StealTasks(unsigned iThread);
+
+    unsigned mNumThreads;
+    std::vector<std::thread> mThreads;
+    tTaskRange * mRanges;
+
+    /// held for the whole of RunJob, since there's only one job slot
+    std::mutex mRunMutex;
+    std::mutex mMutex;
+    std::condition_variable mStartCondition;
+    std::condition_variable mDoneCondition;
+    tThreadJob * mJob;
+    /// incremented for each job so the workers know there's a new one
+    unsigned mJobCount;
+    /// number of workers still working on the current job
+    unsigned mNumBusy;
+    bool mQuit;
+  };
+}
+
+#endif
@@ -222,13 +222,9 @@ TRACE_FILE_IF(level) {TRACE_METHOD_STATIC(); TRACE("\n");}
     }
   }
   
-  
-  inline bool CheckTraceString(const char * traceString)
-  {
-    return (std::binary_search(traceStrings.begin(), 
-                               traceStrings.end(),
-                               std::string(traceString)));
-  }
+/// is trace enabled for traceString? Not inline, since it gets used
+/// in every traced function
+  bool CheckTraceString(const char * traceString);
   
 }
 
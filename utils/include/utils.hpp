@@ -9,4 +9,6 @@
 #include "../utils/include/timer.hpp"
 #include "../utils/include/fixedvector.hpp"
 #include "../utils/include/array2d.hpp"
+#include "../utils/include/threadpool.hpp"
+#include "../utils/include/pairhashmap.hpp"
 #endif
@@ -0,0 +1,186 @@
+//==============================================================
+// Copyright (C) 2004 Danny Chapman 
+//               danny@rowlhouse.freeserve.co.uk
+//--------------------------------------------------------------
+//               
+/// @file threadpool.cpp 
+//                     
+//==============================================================
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+using namespace JigLib;
+using namespace std;
+
+//==============================================================
+// tThreadPool
+//==============================================================
+tThreadPool::tThreadPool(unsigned numThreads)
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  if (numThreads == 0)
+    numThreads = thread::hardware_concurrency();
+  if (numThreads == 0)
+    numThreads = 1;
+  mNumThreads = numThreads;
+  mRanges = new tTaskRange[mNumThreads];
+  for (unsigned i = 0 ; i < mNumThreads ; ++i)
+    mRanges[i].mBegin = mRanges[i].mEnd = 0;
+  mJob = 0;
+  mJobCount = 0;
+  mNumBusy = 0;
+  mQuit = false;
+
+  // thread 0 is whoever calls RunJob
+  for (unsigned i = 1 ; i < mNumThreads ; ++i)
+    mThreads.push_back(thread(&tThreadPool::WorkerLoop, this, i));
+
+  TRACE_FILE_IF(ONCE_2)
+    TRACE("Thread pool using %d threads\n", mNumThreads);
+}
+
+//==============================================================
+// ~tThreadPool
+//==============================================================
+tThreadPool::~tThreadPool()
+{
+  TRACE_METHOD_ONLY(ONCE_1);
+  {
+    lock_guard<mutex> lock(mMutex);
+    mQuit = true;
+  }
+  mStartCondition.notify_all();
+  for (unsigned i = 0 ; i < mThreads.size() ; ++i)
+    mThreads[i].join();
+  delete [] mRanges;
+}
+
+//==============================================================
+// RunJob
+//==============================================================
+void tThreadPool::RunJob(tThreadJob & job, unsigned numTasks)
+{
+  TRACE_METHOD_ONLY(FRAME_2);
+  if (numTasks == 0)
+    return;
+
+  if (mNumThreads == 1 || numTasks == 1)
+  {
+    for (unsigned iTask = 0 ; iTask < numTasks ; ++iTask)
+      job.Run(iTask, 0);
+    return;
+  }
+
+  lock_guard<mutex> runLock(mRunMutex);
+  {
+    lock_guard<mutex> lock(mMutex);
+    // deal the tasks out evenly - the workers can't be looking at
+    // the ranges at the moment, but take the locks anyway so it's
+    // all visible to them
+    for (unsigned i = 0 ; i < mNumThreads ; ++i)
+    {
+      lock_guard<mutex> rangeLock(mRanges[i].mMutex);
+      mRanges[i].mBegin = (numTasks * i) / mNumThreads;
+      mRanges[i].mEnd = (numTasks * (i + 1)) / mNumThreads;
+    }
+    mJob = &job;
+    mNumBusy = mNumThreads - 1;
+    ++mJobCount;
+  }
+  mStartCondition.notify_all();
+
+  DoTasks(0);
+
+  unique_lock<mutex> lock(mMutex);
+  while (mNumBusy != 0)
+    mDoneCondition.wait(lock);
+  mJob = 0;
+}
+
+//==============================================================
+// WorkerLoop
+//==============================================================
+void tThreadPool::WorkerLoop(unsigned iThread)
+{
+  unsigned lastJobCount = 0;
+  while (true)
+  {
+    {
+      unique_lock<mutex> lock(mMutex);
+      while (!mQuit && mJobCount == lastJobCount)
+        mStartCondition.wait(lock);
+      if (mQuit)
+        return;
+      lastJobCount = mJobCount;
+    }
+
+    DoTasks(iThread);
+
+    bool lastOne;
+    {
+      lock_guard<mutex> lock(mMutex);
+      lastOne = (--mNumBusy == 0);
+    }
+    if (lastOne)
+      mDoneCondition.notify_one();
+  }
+}
+
+//==============================================================
+// DoTasks
+//==============================================================
+void tThreadPool::DoTasks(unsigned iThread)
+{
+  unsigned iTask;
+  while (true)
+  {
+    while (PopTask(iThread, iTask))
+      mJob->Run(iTask, iThread);
+    if (!StealTasks(iThread))
+      return;
+  }
+}
+
+//==============================================================
+// PopTask
+//==============================================================
+bool tThreadPool::PopTask(unsigned iThread, unsigned & iTask)
+{
+  tTaskRange & range = mRanges[iThread];
+  lock_guard<mutex> lock(range.mMutex);
+  if (range.mBegin == range.mEnd)
+    return false;
+  iTask = range.mBegin++;
+  return true;
+}
+
+//==============================================================
+// StealTasks
+// Take from the back half of the victim's range, since the owner is
+// working from the front.
+//==============================================================
+bool tThreadPool::StealTasks(unsigned iThread)
+{
+  for (unsigned i = 1 ; i < mNumThreads ; ++i)
+  {
+    tTaskRange & victim = mRanges[(iThread + i) % mNumThreads];
+    unsigned begin, end;
+    {
+      lock_guard<mutex> lock(victim.mMutex);
+      unsigned numLeft = victim.mEnd - victim.mBegin;
+      if (numLeft == 0)
+        continue;
+      end = victim.mEnd;
+      begin = victim.mEnd - (numLeft + 1) / 2;
+      victim.mEnd = begin;
+    }
+    // nobody else will put anything into our (empty) range, and
+    // thieves just find it empty
+    tTaskRange & range = mRanges[iThread];
+    lock_guard<mutex> lock(range.mMutex);
+    range.mBegin = begin;
+    range.mEnd = end;
+    return true;
+  }
+  return false;
+}
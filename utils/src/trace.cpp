@@ -23,6 +23,13 @@ namespace JigLib
 /// If this flag is set, all trace strings are enabled
   bool traceAllStrings = false;
   
+  bool CheckTraceString(const char * traceString)
+  {
+    return (std::binary_search(traceStrings.begin(), 
+                               traceStrings.end(),
+                               std::string(traceString)));
+  }
+  
   void TracePrintf(const char *fmt, ...)
   {
     va_list ap;
@@ -94,18 +94,19 @@ bool tWheel::AddForcesToCar(tScalar dt)
   tVector3 wheelRayEnd = worldPos - mRadius * worldAxis;
   tSegment wheelRay(wheelRayEnd + rayLen * worldAxis, -rayLen * worldAxis);
   
-  Assert(tPhysicsSystem::GetCurrentPhysicsSystem());
-  tCollisionSystem * collSystem = tPhysicsSystem::GetCurrentPhysicsSystem()->GetCollisionSystem();
+  Assert(carBody.GetPhysicsSystem());
+  tCollisionSystem * collSystem = carBody.GetPhysicsSystem()->GetCollisionSystem();
   Assert(collSystem);
   
   // do a number of rays, and choose the deepest penetration
   const int maxNumRays = 32;
   const int numRays = Min(mNumRays, maxNumRays);
-  static tScalar fracs[maxNumRays];
-  static tCollisionSkin * otherSkins[maxNumRays];
-  static tVector3 groundPositions[maxNumRays];
-  static tVector3 groundNormals[maxNumRays];
-  static tSegment segments[maxNumRays];
+  tScalar fracs[maxNumRays];
+  tCollisionSkin * otherSkins[maxNumRays];
+  tVector3 groundPositions[maxNumRays];
+  tVector3 groundNormals[maxNumRays];
+  tSegment segments[maxNumRays];
+  const tCollisionSkinPredicate1 * preds[maxNumRays];
   
   // adjust the start position of the ray - divide the wheel into numRays+2 
   // rays, but don't use the first/last.
@@ -113,27 +114,29 @@ bool tWheel::AddForcesToCar(tScalar dt)
   tScalar deltaFwdStart = deltaFwd;
   
   tWheelPred pred(carBody.GetCollisionSkin());
-  mLastOnFloor = false;
-  int bestIRay = 0;
   int iRay;
   for (iRay = 0 ; iRay < numRays ; ++iRay)
   {
-    fracs[iRay] = SCALAR_HUGE;
     // work out the offset relative to the middle ray
     tScalar distFwd = (deltaFwdStart + iRay * deltaFwd) - mRadius;
     tScalar zOffset = mRadius * (1.0f - CosDeg( 90.0f * (distFwd / mRadius) ) );
     segments[iRay] = wheelRay;
     segments[iRay].mOrigin += distFwd * wheelFwd + zOffset * wheelUp;
-    if (collSystem->SegmentIntersect(fracs[iRay], otherSkins[iRay], 
-                                     groundPositions[iRay], groundNormals[iRay], segments[iRay], &pred))
-    {
-      mLastOnFloor = true;
-      if (fracs[iRay] < fracs[bestIRay])
-        bestIRay = iRay;
-    }
+    preds[iRay] = &pred;
   }
+
+  // the rays are close together, so do them all at once
+  mLastOnFloor = collSystem->SegmentIntersectBatch(fracs, otherSkins, groundPositions, groundNormals,
+                                                   segments, numRays, preds) > 0;
   if (!mLastOnFloor)
     return false;
+
+  int bestIRay = 0;
+  for (iRay = 1 ; iRay < numRays ; ++iRay)
+  {
+    if (fracs[iRay] < fracs[bestIRay])
+      bestIRay = iRay;
+  }
   Assert(bestIRay < numRays);
   
   // use the best one